@@ -1,21 +1,67 @@
 // Copyright (c) 2018 The atendb Authors. All rights reserved.
 
+#include <stdint.h>
+#include <chrono>
 #include <iostream>
+#include <sstream>
 #include <thread>
 
 #include "KV/Bitcask/BitcaskImpl.h"
+#include "KV/Bitcask/DBIter.h"
+#include "KV/Bitcask/HintFile.h"
 #include "KV/Util/Coding.h"
 #include "KV/Util/Hash.h"
 
 namespace atendb {
 
+// Index files are replayed in reads of at least this size.
+static const size_t kRecoveryReadBytes = 1 << 20;
+
+// The value size of a delete in the index files. The record keeps the key
+// size, unlike the in-memory tombstone, so the key can be decoded.
+static const uint32_t kTombstoneValueSize = UINT32_MAX;
+
+// A Put() waiting in a CommitQueue.
+struct DBImpl::Writer {
+  Writer(const std::string& k, const std::string& v) :
+    key(k),
+    value(v),
+    ok(false),
+    done(false) { }
+
+  const std::string& key;
+  const std::string& value;
+  bool ok;
+  bool done;
+  std::condition_variable cv;
+};
+
 DBImpl::DBImpl(const std::string& dbname, const Options& options) :
   dbname_(dbname),
   options_(options),
   cursor_(0),
-  max_file_(0) { }
+  max_file_(0),
+  shutting_down_(false),
+  recovered_from_hint_(false),
+  hint_entries_(0),
+  replayed_records_(0),
+  recovery_micros_(0) { }
 
 DBImpl::~DBImpl() {
+  if (sync_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> l(sync_mu_);
+      shutting_down_ = true;
+    }
+    sync_cv_.notify_one();
+    sync_thread_.join();
+  }
+  if (options_.use_hint_file_ && !data_dir_.empty()) {
+    WriteHint();
+  }
+  for (auto queue : queues_) {
+    delete queue;
+  }
   for (auto file : data_files_) {
     delete file;
   }
@@ -30,6 +76,11 @@ DBImpl::~DBImpl() {
 bool DBImpl::Put(const std::string& key, const std::string& value) {
   uint32_t cursor = cursor_++;
   uint8_t file_index = (cursor & (max_file_ - 1));
+  if (options_.group_commit_) {
+    Writer w(key, value);
+    return GroupCommit(file_index, &w);
+  }
+
   File* data_file = data_files_[file_index];
   uint64_t file_offset;
   auto s = data_file->AppendData(key, value, &file_offset);
@@ -37,15 +88,141 @@ bool DBImpl::Put(const std::string& key, const std::string& value) {
     File* index_file = index_files_[file_index];
     s = index_file->AppendIndex(key, file_index, file_offset,
 				key.size(), value.size());
+    if (likely(s) && options_.sync_policy_ == kSyncEveryBatch) {
+      s = SyncFiles(file_index);
+    }
     if (likely(s)) {
       Index index(key, file_index, file_offset, key.size(), value.size());
-      int32_t slot = (Hash(key.c_str()) & (table_size_ - 1));
-      tables_[slot]->Insert(index);
+      InsertIndex(index);
     }
   }
   return s;
 }
 
+bool DBImpl::GroupCommit(uint32_t file_index, Writer* w) {
+  CommitQueue* queue = queues_[file_index];
+  std::unique_lock<std::mutex> l(queue->mu);
+  queue->writers.push_back(w);
+  while (!w->done && w != queue->writers.front()) {
+    w->cv.wait(l);
+  }
+  if (w->done) {
+    // A leader committed this write for us.
+    return w->ok;
+  }
+
+  // We are the leader: take everyone queued behind us, up to the limit.
+  std::vector<Writer*> batch;
+  size_t batch_bytes = 0;
+  for (auto writer : queue->writers) {
+    size_t bytes = writer->key.size() + writer->value.size();
+    if (!batch.empty() && batch_bytes + bytes > options_.max_batch_bytes_) {
+      break;
+    }
+    batch.push_back(writer);
+    batch_bytes += bytes;
+  }
+
+  // Writers arriving meanwhile queue up behind the batch and wait.
+  l.unlock();
+  bool ok = WriteBatch(file_index, batch);
+  l.lock();
+
+  for (auto writer : batch) {
+    queue->writers.pop_front();
+    writer->ok = ok;
+    writer->done = true;
+    if (writer != w) {
+      writer->cv.notify_one();
+    }
+  }
+
+  // Hand leadership to the next batch.
+  if (!queue->writers.empty()) {
+    queue->writers.front()->cv.notify_one();
+  }
+  return ok;
+}
+
+bool DBImpl::WriteBatch(uint32_t file_index,
+			const std::vector<Writer*>& batch) {
+  std::vector<struct iovec> data_iov;
+  data_iov.reserve(batch.size() * 2);
+  size_t index_bytes = 0;
+  for (auto w : batch) {
+    data_iov.push_back({const_cast<char*>(w->key.data()), w->key.size()});
+    data_iov.push_back({const_cast<char*>(w->value.data()), w->value.size()});
+    index_bytes += w->key.size() + sizeof(uint32_t) * 4 + sizeof(uint64_t);
+  }
+
+  uint64_t data_offset;
+  auto s = data_files_[file_index]->AppendV(data_iov.data(),
+                                            data_iov.size(),
+                                            &data_offset);
+  if (unlikely(!s)) {
+    return s;
+  }
+
+  // The index records carry the data offsets, so they are encoded once the
+  // data file has handed out its range.
+  std::string index_buf(index_bytes, '\0');
+  uint64_t file_offset = data_offset;
+  size_t pos = 0;
+  for (auto w : batch) {
+    EncodeIndex(&index_buf[pos], w->key, file_index, file_offset,
+		w->key.size(), w->value.size());
+    pos += w->key.size() + sizeof(uint32_t) * 4 + sizeof(uint64_t);
+    file_offset += w->key.size() + w->value.size();
+  }
+
+  struct iovec index_iov = {&index_buf[0], index_buf.size()};
+  uint64_t index_offset;
+  s = index_files_[file_index]->AppendV(&index_iov, 1, &index_offset);
+  if (likely(s) && options_.sync_policy_ == kSyncEveryBatch) {
+    s = SyncFiles(file_index);
+  }
+  if (unlikely(!s)) {
+    return s;
+  }
+
+  // Publish in queue order so the last write of a key wins.
+  file_offset = data_offset;
+  for (auto w : batch) {
+    Index index(w->key, file_index, file_offset,
+		w->key.size(), w->value.size());
+    InsertIndex(index);
+    file_offset += w->key.size() + w->value.size();
+  }
+  return true;
+}
+
+bool DBImpl::SyncFiles(uint32_t file_index) {
+  auto s = data_files_[file_index]->Sync();
+  if (likely(s)) {
+    s = index_files_[file_index]->Sync();
+  }
+  return s;
+}
+
+void DBImpl::SyncLoop() {
+  std::unique_lock<std::mutex> l(sync_mu_);
+  while (!shutting_down_) {
+    sync_cv_.wait_for(l, std::chrono::milliseconds(options_.sync_interval_ms_));
+    for (uint32_t i = 0; i < max_file_; i++) {
+      SyncFiles(i);
+    }
+  }
+}
+
+void DBImpl::InsertIndex(const Index& index) {
+  int32_t slot = (Hash(index.key_.data()) & (table_size_ - 1));
+  if (options_.concurrent_index_) {
+    tables_[slot]->InsertConcurrently(index);
+  } else {
+    tables_[slot]->Insert(index);
+  }
+}
+
 bool DBImpl::Get(const std::string& key, std::string* value) {
   int32_t slot = (Hash(key.data()) & (table_size_ - 1));
   Index search_index(key), internal_index;
@@ -80,54 +257,182 @@ bool DBImpl::Delete(const std::string& key) {
   Index search_index(key), internal_index;
   auto s = tables_[slot]->Get(search_index, &internal_index);
   if (likely(s)) {
-    internal_index.SetDeleted();
-    tables_[slot]->Insert(internal_index);
+    if (internal_index.KeySize() == 0 && internal_index.ValueSize() == 0) {
+      return true;
+    }
+    // The tombstone goes to the index file of the entry it deletes, so it is
+    // replayed after that entry.
+    uint32_t file_index = internal_index.FileIndex();
+    s = index_files_[file_index]->AppendIndex(key, file_index,
+                                              internal_index.FileOffset(),
+                                              key.size(), kTombstoneValueSize);
+    if (likely(s) && options_.sync_policy_ == kSyncEveryBatch) {
+      s = index_files_[file_index]->Sync();
+    }
+    if (likely(s)) {
+      internal_index.SetDeleted();
+      InsertIndex(internal_index);
+    }
     return s;
   } else {
     return s;
   }
 }
 
-void DBImpl::IndexCallback(File* file) {
+Iterator* DBImpl::NewIterator(const ReadOptions& options) {
+  return new DBIter(options_.comparator_, tables_, data_files_, options);
+}
+
+bool DBImpl::GetProperty(const std::string& property, std::string* value) {
+  if (property == "atendb.recovery-micros") {
+    *value = std::to_string(recovery_micros_);
+    return true;
+  } else if (property == "atendb.recovery-stats") {
+    std::ostringstream out;
+    out << "micros: " << recovery_micros_ << "\n"
+        << "from_hint: " << (recovered_from_hint_ ? "yes" : "no") << "\n"
+        << "hint_entries: " << hint_entries_ << "\n"
+        << "replayed_records: " << replayed_records_ << "\n";
+    *value = out.str();
+    return true;
+  }
+  return false;
+}
+
+void DBImpl::IndexCallback(File* file, uint64_t pos) {
   uint64_t file_offset = file->FileOffset();
-  if (file_offset != 0) { // Load index files into skiplist
-    uint64_t pos = 0;
-    while(pos < file_offset) {
-      char size_buf[sizeof(uint32_t)];
-      auto s = file->Read(pos, sizeof(uint32_t), size_buf);
+  size_t chunk = kRecoveryReadBytes;
+  std::string buf;
+  while (pos < file_offset) { // Load index files into skiplist
+    uint64_t n = std::min<uint64_t>(chunk, file_offset - pos);
+    buf.resize(n);
+    if (!file->Read(pos, n, &buf[0])) {
+      return;
+    }
+
+    uint64_t used = 0;
+    while (used + sizeof(uint32_t) <= n) {
+      uint32_t index_size = DecodeFixed32(&buf[used]);
+      if (used + sizeof(uint32_t) + index_size > n) {
+        break;
+      }
+      Index index;
+      DecodeIndex(&buf[used + sizeof(uint32_t)],
+		  &index.key_,
+		  &index.file_index_,
+		  &index.file_offset_,
+		  &index.key_size_,
+		  &index.value_size_);
+      if (index.value_size_ == kTombstoneValueSize) {
+        index.SetDeleted();
+      }
+      InsertIndex(index);
+      replayed_records_++;
+      used += sizeof(uint32_t) + index_size;
+    }
+
+    if (used == 0) {
+      if (n == file_offset - pos) {
+        // A torn record at the end of the file.
+        return;
+      }
+      // The record does not fit in one chunk.
+      chunk *= 2;
+    }
+    pos += used;
+  }
+}
+
+bool DBImpl::LoadHint(std::vector<uint64_t>* replay_from) {
+  HintFile hint;
+  if (!hint.Open(data_dir_ + HintFileName) || hint.NumFiles() != max_file_) {
+    return false;
+  }
+  for (uint32_t i = 0; i < max_file_; i++) {
+    // An index file shorter than the snapshot has been lost or replaced.
+    if (hint.CoveredOffset(i) > index_files_[i]->FileOffset()) {
+      return false;
+    }
+  }
+
+  // Sections are sorted, so when they map one to one onto the tables each
+  // table is built bottom-up without searching. Otherwise fall back to
+  // rehashing every entry.
+  bool same_layout = (hint.NumTables() == table_size_);
+  std::vector<std::thread> threads;
+  std::vector<char> loaded(hint.NumTables(), 0);
+  for (uint32_t i = 0; i < hint.NumTables(); i++) {
+    threads.push_back(std::thread([this, &hint, &loaded, same_layout, i]() {
+      bool s;
+      if (same_layout) {
+        Table::Builder builder(tables_[i]);
+        s = hint.Load(i, [&builder](const Index& index) {
+          builder.Add(index);
+        });
+      } else {
+        s = hint.Load(i, [this](const Index& index) {
+          InsertIndex(index);
+        });
+      }
       if (s) {
-	      pos += sizeof(uint32_t);
-	      uint32_t index_size = DecodeFixed32(size_buf);
-	      char index_buf[index_size];
-	      auto s = file->Read(pos, index_size, index_buf);
-	      if (s) {
-	        pos += index_size;
-		Index index;
-		DecodeIndex(index_buf,
-			    &index.key_,
-			    &index.file_index_,
-			    &index.file_offset_,
-			    &index.key_size_,
-			    &index.value_size_);
-	  int32_t slot = (Hash(index.key_.data()) & (table_size_ - 1));
-	  tables_[slot]->Insert(index);
-        }
+        hint_entries_ += hint.NumEntries(i);
       }
+      loaded[i] = s;
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto s : loaded) {
+    if (!s) {
+      // Whatever was loaded is overwritten by the full replay.
+      return false;
+    }
+  }
+
+  for (uint32_t i = 0; i < max_file_; i++) {
+    (*replay_from)[i] = hint.CoveredOffset(i);
+  }
+  return true;
+}
+
+bool DBImpl::WriteHint() {
+  std::vector<uint64_t> covered;
+  for (uint32_t i = 0; i < max_file_; i++) {
+    // The snapshot must never be more durable than what it points at.
+    if (!SyncFiles(i)) {
+      return false;
     }
+    covered.push_back(index_files_[i]->FileOffset());
   }
+  return HintFile::Write(data_dir_ + HintFileName, covered, tables_);
 }
 
 bool DBImpl::Recover() {
-  // Recover
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<uint64_t> replay_from(max_file_, 0);
+  if (options_.use_hint_file_) {
+    recovered_from_hint_ = LoadHint(&replay_from);
+    if (!recovered_from_hint_) {
+      std::fill(replay_from.begin(), replay_from.end(), 0);
+    }
+  }
+
+  // Replay what the hint does not cover, one thread per index file
   std::vector<std::thread > threads;
   for (uint32_t i = 0; i < max_file_; i++) {
-    std::thread recover(&DBImpl::IndexCallback, this, index_files_[i]);
+    std::thread recover(&DBImpl::IndexCallback, this, index_files_[i],
+                        replay_from[i]);
     threads.push_back(std::move(recover));
   }
 
   for (uint32_t i = 0; i < max_file_; i++) {
     threads[i].join();
   }
+
+  recovery_micros_ = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start).count();
   return true;
 }
 
@@ -145,7 +450,9 @@ bool DB::Open(const std::string& dbname,
   }
 
   impl->max_file_ = num_processor * 2;
-  impl->table_size_ = num_processor;
+  // A concurrent skiplist scales writers by itself, so keep all keys in
+  // one ordered table instead of sharding them by hash.
+  impl->table_size_ = options.concurrent_index_ ? 1 : num_processor;
   // Create skiplist tables
   for (uint32_t i = 0; i < impl->table_size_; ++i) {
     Table* table = new Table(Compare(options.comparator_));
@@ -159,6 +466,7 @@ bool DB::Open(const std::string& dbname,
   }
 
   std::string data_dir = current_dir + "/" + dbname;
+  impl->data_dir_ = data_dir;
   if (!Env::FileExists(data_dir)) {
     auto s = Env::CreateDir(data_dir);
     if (!s) {
@@ -190,8 +498,16 @@ bool DB::Open(const std::string& dbname,
     }
   }
 
+  for (uint32_t i = 0; i < impl->max_file_; i++) {
+    impl->queues_.push_back(new DBImpl::CommitQueue);
+  }
+
   // Recover
   impl->Recover();
+
+  if (options.sync_policy_ == kSyncInterval) {
+    impl->sync_thread_ = std::thread(&DBImpl::SyncLoop, impl);
+  }
  
   *db = impl;
   return true;
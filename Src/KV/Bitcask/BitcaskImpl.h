@@ -5,6 +5,10 @@
 
 #include <atomic>
 #include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include "KV/Include/Db.h"
 #include "KV/Include/Options.h"
@@ -18,6 +22,7 @@ namespace atendb {
 
 const std::string IndexFileName = "/INDEX-";
 const std::string DataFileName = "/DATA-";
+const std::string HintFileName = "/HINT";
 
 typedef SkipList<Index, Compare> Table;
 
@@ -33,14 +38,47 @@ class DBImpl : public DB {
 
   virtual bool Delete(const std::string& key);
 
-  void IndexCallback(File* file);
+  virtual Iterator* NewIterator(const ReadOptions& options);
+
+  virtual bool GetProperty(const std::string& property, std::string* value);
+
+  // Replay the index records of "file" from offset "pos" to its end.
+  void IndexCallback(File* file, uint64_t pos);
 
   bool Recover();
 
  private:
   friend DB;
 
+  struct Writer;
+
+  // Writers waiting to be appended to one data/index file pair. The writer
+  // at the front is the leader and commits on behalf of the whole batch.
+  struct CommitQueue {
+    std::mutex mu;
+    std::deque<Writer*> writers;
+  };
+
+  bool GroupCommit(uint32_t file_index, Writer* w);
+
+  // Append "batch" to the data and index file of "file_index" with one
+  // vectored write each and publish the new indexes.
+  bool WriteBatch(uint32_t file_index, const std::vector<Writer*>& batch);
+
+  bool SyncFiles(uint32_t file_index);
+
+  void InsertIndex(const Index& index);
+
+  void SyncLoop();
+
+  // Bulk load the tables from the hint file. On success "replay_from" holds
+  // the index file offsets the hint does not cover.
+  bool LoadHint(std::vector<uint64_t>* replay_from);
+
+  bool WriteHint();
+
   std::string dbname_;
+  std::string data_dir_;
   Options options_;
   std::atomic<uint32_t> cursor_;
 
@@ -52,6 +90,20 @@ class DBImpl : public DB {
   uint32_t table_size_;
   std::vector<Table *> tables_;
 
+  std::vector<CommitQueue* > queues_;
+
+  // Background syncing for kSyncInterval
+  std::mutex sync_mu_;
+  std::condition_variable sync_cv_;
+  bool shutting_down_;
+  std::thread sync_thread_;
+
+  // Filled in by Recover()
+  bool recovered_from_hint_;
+  std::atomic<uint64_t> hint_entries_;
+  std::atomic<uint64_t> replayed_records_;
+  uint64_t recovery_micros_;
+
   // No copying allowed
   void operator=(const DBImpl&);
   DBImpl(const DBImpl&);
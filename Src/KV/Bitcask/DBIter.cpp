@@ -0,0 +1,162 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <algorithm>
+#include <numeric>
+
+#include "KV/Bitcask/DBIter.h"
+#include "KV/Util/Coding.h"
+
+namespace atendb {
+
+// Records closer than this are fetched with one read, including the gap.
+static const uint64_t kMaxReadGap = 4096;
+// Upper bound of a single coalesced read.
+static const uint64_t kMaxReadBytes = 4 << 20;
+
+bool DBIter::SourceLess::operator()(uint32_t a, uint32_t b) const {
+  const Table::Iterator& ia = iter_->iters_[a];
+  const Table::Iterator& ib = iter_->iters_[b];
+  if (!ia.Valid()) {
+    return false;
+  }
+  if (!ib.Valid()) {
+    return true;
+  }
+  int r = iter_->comparator_->compare(ia.key().Key(), ib.key().Key());
+  return r < 0 || (r == 0 && a < b);
+}
+
+DBIter::DBIter(const Comparator* comparator,
+               const std::vector<Table* >& tables,
+               const std::vector<File* >& data_files,
+               const ReadOptions& options) :
+  comparator_(comparator),
+  data_files_(data_files),
+  options_(options),
+  tree_(tables.size(), SourceLess(this)),
+  pos_(0),
+  done_(true),
+  ok_(true) {
+  for (auto table : tables) {
+    iters_.push_back(Table::Iterator(table));
+  }
+}
+
+void DBIter::SeekToFirst() {
+  if (!options_.prefix_.empty()) {
+    Seek(options_.prefix_);
+    return;
+  }
+  for (auto& it : iters_) {
+    it.SeekToFirst();
+  }
+  tree_.Build();
+  done_ = false;
+  FillBatch();
+}
+
+void DBIter::Seek(const std::string& target) {
+  const std::string& start =
+      (!options_.prefix_.empty() &&
+       comparator_->compare(target, options_.prefix_) < 0) ?
+      options_.prefix_ : target;
+  Index search_index(start);
+  for (auto& it : iters_) {
+    it.Seek(search_index);
+  }
+  tree_.Build();
+  done_ = false;
+  FillBatch();
+}
+
+void DBIter::Next() {
+  assert(Valid());
+  pos_++;
+  if (pos_ == batch_.size() && !done_) {
+    FillBatch();
+  }
+}
+
+bool DBIter::InPrefix(const std::string& key) const {
+  return key.compare(0, options_.prefix_.size(), options_.prefix_) == 0;
+}
+
+void DBIter::FillBatch() {
+  batch_.clear();
+  pos_ = 0;
+  uint32_t batch_size = std::max<uint32_t>(options_.batch_size_, 1);
+  while (batch_.size() < batch_size) {
+    if (iters_.empty() || !iters_[tree_.Winner()].Valid()) {
+      done_ = true;
+      break;
+    }
+    Table::Iterator& it = iters_[tree_.Winner()];
+    // Copy the entry: the node may be pointed at a newer one meanwhile.
+    Index index = it.key();
+    if (!options_.prefix_.empty() && !InPrefix(index.Key())) {
+      done_ = true;
+      break;
+    }
+    if (index.KeySize() != 0 || index.ValueSize() != 0) {
+      Entry entry;
+      entry.key = index.Key();
+      entry.file_index = index.FileIndex();
+      entry.file_offset = index.FileOffset();
+      entry.key_size = index.KeySize();
+      entry.value_size = index.ValueSize();
+      batch_.push_back(std::move(entry));
+    }
+    it.Next();
+    tree_.Replay();
+  }
+  ReadValues();
+}
+
+void DBIter::ReadValues() {
+  std::vector<size_t> order(batch_.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    const Entry& ea = batch_[a];
+    const Entry& eb = batch_[b];
+    if (ea.file_index != eb.file_index) {
+      return ea.file_index < eb.file_index;
+    }
+    return ea.file_offset < eb.file_offset;
+  });
+
+  size_t i = 0;
+  while (i < order.size()) {
+    const Entry& first = batch_[order[i]];
+    uint64_t start = first.file_offset;
+    uint64_t end = start + first.key_size + first.value_size;
+    size_t j = i + 1;
+    while (j < order.size()) {
+      const Entry& entry = batch_[order[j]];
+      uint64_t entry_end = entry.file_offset + entry.key_size + entry.value_size;
+      if (entry.file_index != first.file_index ||
+          entry.file_offset > end + kMaxReadGap ||
+          entry_end - start > kMaxReadBytes) {
+        break;
+      }
+      end = std::max(end, entry_end);
+      j++;
+    }
+
+    buf_.resize(end - start);
+    auto s = data_files_[first.file_index]->Read(start, end - start, &buf_[0]);
+    for (size_t k = i; k < j; k++) {
+      Entry& entry = batch_[order[k]];
+      if (likely(s)) {
+        DecodeData(&buf_[entry.file_offset - start],
+                   entry.key_size,
+                   entry.value_size,
+                   &entry.value);
+      } else {
+        ok_ = false;
+      }
+    }
+    i = j;
+  }
+}
+
+} // namespace atendb
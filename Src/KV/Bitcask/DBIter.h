@@ -0,0 +1,94 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#ifndef ATENDB_DB_DB_ITER_H_
+#define ATENDB_DB_DB_ITER_H_
+
+#include <vector>
+
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Iterator.h"
+#include "KV/Include/Options.h"
+#include "KV/Include/Skiplist.h"
+#include "KV/File/File.h"
+#include "KV/Util/LoserTree.h"
+
+namespace atendb {
+
+// Iterates over the union of the per-shard skiplists of a DBImpl.
+//
+// The shard iterators are k-way merged with a loser tree and tombstones
+// are dropped. Values are not read one key at a time: the iterator
+// collects up to ReadOptions::batch_size_ live indexes, sorts them by
+// (file, offset), reads adjacent records with a single Read() and then
+// serves the batch in key order.
+class DBIter : public Iterator {
+ public:
+  typedef SkipList<Index, Compare> Table;
+
+  DBIter(const Comparator* comparator,
+         const std::vector<Table* >& tables,
+         const std::vector<File* >& data_files,
+         const ReadOptions& options);
+
+  virtual ~DBIter() {}
+
+  virtual bool Valid() const { return pos_ < batch_.size(); }
+
+  virtual void SeekToFirst();
+
+  virtual void Seek(const std::string& target);
+
+  virtual void Next();
+
+  virtual const std::string& key() const { return batch_[pos_].key; }
+
+  virtual const std::string& value() const { return batch_[pos_].value; }
+
+  virtual bool ok() const { return ok_; }
+
+ private:
+  struct Entry {
+    std::string key;
+    uint32_t file_index;
+    uint64_t file_offset;
+    uint32_t key_size;
+    uint32_t value_size;
+    std::string value;
+  };
+
+  class SourceLess {
+   public:
+    explicit SourceLess(const DBIter* iter) : iter_(iter) { }
+    bool operator()(uint32_t a, uint32_t b) const;
+   private:
+    const DBIter* iter_;
+  };
+
+  // Refill batch_ from the merged shard iterators.
+  void FillBatch();
+
+  // Read the values of batch_ in (file, offset) order.
+  void ReadValues();
+
+  bool InPrefix(const std::string& key) const;
+
+  const Comparator* comparator_;
+  const std::vector<File* >& data_files_;
+  const ReadOptions options_;
+
+  std::vector<Table::Iterator> iters_;
+  LoserTree<SourceLess> tree_;
+
+  std::vector<Entry> batch_;
+  size_t pos_;
+  // Set once the merged input is exhausted or left the prefix.
+  bool done_;
+  bool ok_;
+
+  // Scratch buffer for coalesced reads.
+  std::string buf_;
+};
+
+} // namespace atendb
+
+#endif // ATENDB_DB_DB_ITER_H_
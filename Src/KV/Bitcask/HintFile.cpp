@@ -0,0 +1,236 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <cstring>
+
+#include <crc32c/crc32c.h>
+
+#include "KV/Bitcask/HintFile.h"
+#include "KV/Util/Coding.h"
+
+namespace atendb {
+
+static const uint32_t kHintMagic = 0x31485441; // "ATH1"
+static const uint32_t kHintVersion = 1;
+static const size_t kWriteBufferBytes = 1 << 20;
+
+static size_t HeaderSize(uint32_t num_files, uint32_t num_tables) {
+  return sizeof(uint32_t) * 4 +
+         sizeof(uint64_t) * num_files +
+         sizeof(uint64_t) * 2 * num_tables +
+         sizeof(uint32_t);
+}
+
+static void PutFixed32(std::string* dst, uint32_t value) {
+  dst->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void PutFixed64(std::string* dst, uint64_t value) {
+  dst->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static bool WriteAll(int fd, const std::string& buf, uint64_t offset) {
+  size_t cnt = 0;
+  while (cnt < buf.size()) {
+    ssize_t n = pwrite(fd, buf.data() + cnt, buf.size() - cnt, offset + cnt);
+    if (n > 0) {
+      cnt += n;
+    } else if (n < 0 && errno == EINTR) {
+      continue;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+HintFile::HintFile() :
+  base_(nullptr),
+  size_(0),
+  num_files_(0),
+  num_tables_(0),
+  covered_offsets_(nullptr),
+  section_bytes_(nullptr),
+  section_entries_(nullptr) { }
+
+HintFile::~HintFile() {
+  if (base_ != nullptr) {
+    munmap(const_cast<char*>(base_), size_);
+  }
+}
+
+bool HintFile::Write(const std::string& fname,
+                     const std::vector<uint64_t>& covered_offsets,
+                     const std::vector<Table* >& tables) {
+  std::string tmp_fname = fname + ".tmp";
+  int fd = ::open(tmp_fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  uint32_t num_files = covered_offsets.size();
+  uint32_t num_tables = tables.size();
+  std::vector<uint64_t> section_bytes(num_tables, 0);
+  std::vector<uint64_t> section_entries(num_tables, 0);
+
+  // Sections are streamed behind the header, which is written last.
+  uint64_t offset = HeaderSize(num_files, num_tables);
+  std::string buf;
+  bool ok = true;
+  for (uint32_t t = 0; t < num_tables && ok; t++) {
+    uint64_t section_start = offset;
+    uint32_t crc = 0;
+    auto flush = [&]() {
+      crc = crc32c::Extend(crc, reinterpret_cast<const uint8_t*>(buf.data()),
+                           buf.size());
+      ok = ok && WriteAll(fd, buf, offset);
+      offset += buf.size();
+      buf.clear();
+    };
+
+    Table::Iterator it(tables[t]);
+    for (it.SeekToFirst(); it.Valid() && ok; it.Next()) {
+      const Index& index = it.key();
+      std::string key = index.Key();
+      PutFixed32(&buf, key.size());
+      buf.append(key);
+      PutFixed32(&buf, index.FileIndex());
+      PutFixed64(&buf, index.FileOffset());
+      PutFixed32(&buf, index.KeySize());
+      PutFixed32(&buf, index.ValueSize());
+      section_entries[t]++;
+      if (buf.size() >= kWriteBufferBytes) {
+        flush();
+      }
+    }
+    flush();
+    section_bytes[t] = offset - section_start;
+
+    PutFixed32(&buf, crc);
+    ok = ok && WriteAll(fd, buf, offset);
+    offset += buf.size();
+    buf.clear();
+  }
+
+  std::string header;
+  PutFixed32(&header, kHintMagic);
+  PutFixed32(&header, kHintVersion);
+  PutFixed32(&header, num_files);
+  PutFixed32(&header, num_tables);
+  for (auto covered : covered_offsets) {
+    PutFixed64(&header, covered);
+  }
+  for (auto bytes : section_bytes) {
+    PutFixed64(&header, bytes);
+  }
+  for (auto entries : section_entries) {
+    PutFixed64(&header, entries);
+  }
+  PutFixed32(&header, crc32c::Crc32c(header.data(), header.size()));
+  ok = ok && WriteAll(fd, header, 0);
+  ok = ok && (::fsync(fd) == 0);
+  ::close(fd);
+
+  if (ok && ::rename(tmp_fname.c_str(), fname.c_str()) == 0) {
+    return true;
+  }
+  ::unlink(tmp_fname.c_str());
+  return false;
+}
+
+bool HintFile::Open(const std::string& fname) {
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat sbuf;
+  if (fstat(fd, &sbuf) != 0 ||
+      static_cast<size_t>(sbuf.st_size) < HeaderSize(0, 0)) {
+    ::close(fd);
+    return false;
+  }
+  size_ = sbuf.st_size;
+  void* base = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  // The whole file is consumed front to back exactly once.
+  madvise(base, size_, MADV_SEQUENTIAL);
+  madvise(base, size_, MADV_WILLNEED);
+  base_ = static_cast<const char*>(base);
+
+  if (DecodeFixed32(base_) != kHintMagic ||
+      DecodeFixed32(base_ + 4) != kHintVersion) {
+    return false;
+  }
+  num_files_ = DecodeFixed32(base_ + 8);
+  num_tables_ = DecodeFixed32(base_ + 12);
+  size_t header_size = HeaderSize(num_files_, num_tables_);
+  if (size_ < header_size) {
+    return false;
+  }
+  size_t crc_pos = header_size - sizeof(uint32_t);
+  if (crc32c::Crc32c(base_, crc_pos) != DecodeFixed32(base_ + crc_pos)) {
+    return false;
+  }
+  covered_offsets_ = base_ + 16;
+  section_bytes_ = covered_offsets_ + sizeof(uint64_t) * num_files_;
+  section_entries_ = section_bytes_ + sizeof(uint64_t) * num_tables_;
+
+  uint64_t offset = header_size;
+  for (uint32_t i = 0; i < num_tables_; i++) {
+    section_starts_.push_back(offset);
+    offset += DecodeFixed64(section_bytes_ + sizeof(uint64_t) * i) +
+              sizeof(uint32_t);
+  }
+  return offset == size_;
+}
+
+uint64_t HintFile::CoveredOffset(uint32_t file_index) const {
+  assert(file_index < num_files_);
+  return DecodeFixed64(covered_offsets_ + sizeof(uint64_t) * file_index);
+}
+
+uint64_t HintFile::NumEntries(uint32_t section) const {
+  assert(section < num_tables_);
+  return DecodeFixed64(section_entries_ + sizeof(uint64_t) * section);
+}
+
+bool HintFile::Load(uint32_t section,
+                    const std::function<void(const Index&)>& fn) const {
+  assert(section < num_tables_);
+  const char* p = base_ + section_starts_[section];
+  const char* limit = p + DecodeFixed64(section_bytes_ + sizeof(uint64_t) * section);
+  if (crc32c::Crc32c(p, limit - p) != DecodeFixed32(limit)) {
+    return false;
+  }
+
+  const size_t kFixedBytes = sizeof(uint32_t) * 4 + sizeof(uint64_t);
+  while (p < limit) {
+    if (static_cast<size_t>(limit - p) < kFixedBytes) {
+      return false;
+    }
+    uint32_t key_length = DecodeFixed32(p);
+    if (static_cast<size_t>(limit - p) < kFixedBytes + key_length) {
+      return false;
+    }
+    p += sizeof(uint32_t);
+    std::string key(p, key_length);
+    p += key_length;
+    uint32_t file_index = DecodeFixed32(p);
+    uint64_t file_offset = DecodeFixed64(p + 4);
+    uint32_t key_size = DecodeFixed32(p + 12);
+    uint32_t value_size = DecodeFixed32(p + 16);
+    p += kFixedBytes - sizeof(uint32_t);
+    fn(Index(std::move(key), file_index, file_offset, key_size, value_size));
+  }
+  return true;
+}
+
+} // namespace atendb
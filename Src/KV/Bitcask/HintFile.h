@@ -0,0 +1,82 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#ifndef ATENDB_DB_HINT_FILE_H_
+#define ATENDB_DB_HINT_FILE_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Index.h"
+#include "KV/Include/Skiplist.h"
+
+namespace atendb {
+
+typedef SkipList<Index, Compare> Table;
+
+// A hint file is a snapshot of the in-memory index, written when the
+// database is closed, so that Open() can skip replaying the index files.
+//
+// Layout (fixed-width fields in host byte order):
+//
+//   header:  magic | version | num_files | num_tables
+//            covered_offset[num_files]      index file bytes the snapshot
+//                                           includes; newer records are
+//                                           replayed from there
+//            section_bytes[num_tables]
+//            section_entries[num_tables]
+//            crc32c of the header
+//   section: one per table, entries in key order, followed by its crc32c
+//   entry:   key_length | key | file_index | file_offset | key_size |
+//            value_size
+//
+// Tombstones are kept, so a delete survives a clean restart.
+class HintFile {
+ public:
+  HintFile();
+  ~HintFile();
+
+  // Atomically replace "fname" with a snapshot of "tables".
+  // REQUIRES: no concurrent writers.
+  static bool Write(const std::string& fname,
+                    const std::vector<uint64_t>& covered_offsets,
+                    const std::vector<Table* >& tables);
+
+  // Map "fname" into memory and verify its header.
+  bool Open(const std::string& fname);
+
+  uint32_t NumFiles() const { return num_files_; }
+
+  uint64_t CoveredOffset(uint32_t file_index) const;
+
+  uint32_t NumTables() const { return num_tables_; }
+
+  uint64_t NumEntries(uint32_t section) const;
+
+  // Verify the checksum of "section" and pass each of its entries, in key
+  // order, to "fn". Returns false if the section is corrupt: on a checksum
+  // mismatch before calling "fn" at all, on a truncated entry after "fn"
+  // has seen the entries in front of it.
+  bool Load(uint32_t section,
+            const std::function<void(const Index&)>& fn) const;
+
+ private:
+  const char* base_;
+  size_t size_;
+
+  uint32_t num_files_;
+  uint32_t num_tables_;
+  const char* covered_offsets_;
+  const char* section_bytes_;
+  const char* section_entries_;
+  std::vector<uint64_t> section_starts_;
+
+  // No copying allowed
+  void operator=(const HintFile&);
+  HintFile(const HintFile&);
+};
+
+} // namespace atendb
+
+#endif // ATENDB_DB_HINT_FILE_H_
@@ -4,6 +4,7 @@
 #define ATENDB_FILE_FILE_H_
 
 #include <string>
+#include <sys/uio.h>
 
 namespace atendb {
 
@@ -24,6 +25,15 @@ class File {
 			   uint32_t key_size_,
 			   uint32_t value_size_) = 0;
 
+  // Append the buffers in "iov" as one contiguous record. On success
+  // "*file_offset" is set to the offset of the first byte written.
+  virtual bool AppendV(const struct iovec* iov,
+		       int iovcnt,
+		       uint64_t* file_offset) = 0;
+
+  // Flush appended data to stable storage.
+  virtual bool Sync() = 0;
+
   virtual bool Close() = 0; 
 
   virtual uint64_t FileOffset() = 0;
@@ -6,7 +6,11 @@
 #include <unistd.h>
 #include <stdio.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <cstring>
+#include <algorithm>
+#include <vector>
 
 #include "KV/File/PosixFile.h"
 
@@ -98,6 +102,54 @@ bool PosixFile::AppendIndex(const std::string& key,
   }
 }
 
+bool PosixFile::AppendV(const struct iovec* iov,
+			int iovcnt,
+			uint64_t* file_offset) {
+  uint64_t total = 0;
+  for (int i = 0; i < iovcnt; i++) {
+    total += iov[i].iov_len;
+  }
+  *file_offset = file_offset_.fetch_add(total);
+
+  // pwritev() may write less than asked for, so work on a copy of the
+  // vector that can be advanced past the bytes already written.
+  std::vector<struct iovec> vec(iov, iov + iovcnt);
+  size_t first = 0;
+  uint64_t cnt = 0;
+  while (cnt < total) {
+    int n_vec = std::min<size_t>(vec.size() - first, IOV_MAX);
+    ssize_t n = pwritev(fd_, &vec[first], n_vec, *file_offset + cnt);
+    if (n < 0) {
+      if (errno == EINTR) {
+	continue;
+      }
+      return false;
+    } else if (n == 0) {
+      return false;
+    }
+    cnt += n;
+    while (n > 0 && first < vec.size()) {
+      if (static_cast<size_t>(n) >= vec[first].iov_len) {
+	n -= vec[first].iov_len;
+	first++;
+      } else {
+	vec[first].iov_base = static_cast<char*>(vec[first].iov_base) + n;
+	vec[first].iov_len -= n;
+	n = 0;
+      }
+    }
+  }
+  return true;
+}
+
+bool PosixFile::Sync() {
+#if defined(__APPLE__)
+  return ::fsync(fd_) == 0;
+#else
+  return ::fdatasync(fd_) == 0;
+#endif
+}
+
 bool PosixFile::Close() {
   ::close(fd_);
   fd_ = -1;
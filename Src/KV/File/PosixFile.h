@@ -37,6 +37,10 @@ class PosixFile : public File {
 		   uint32_t key_size_,
 		   uint32_t value_size_);
 
+  bool AppendV(const struct iovec* iov, int iovcnt, uint64_t* file_offset);
+
+  bool Sync();
+
   bool Close();
 
   inline uint64_t FileOffset() { return file_offset_; }
@@ -6,6 +6,7 @@
 #include "KV/Include/Options.h"
 #include "KV/Include/Env.h"
 #include "KV/Include/Comparator.h"
+#include "KV/Include/Iterator.h"
 
 namespace atendb {
 
@@ -22,6 +23,18 @@ class DB {
 
   virtual bool Delete(const std::string& key) = 0;
 
+  // Return an iterator over the live keys of the database in comparator
+  // order. The result is initially invalid; the caller must call one of
+  // the Seek methods before using it and delete it when done.
+  virtual Iterator* NewIterator(const ReadOptions& options) = 0;
+
+  // If "property" is a property understood by this implementation, set
+  // "*value" to its current value and return true. Valid properties:
+  //
+  //  "atendb.recovery-micros" - time Open() spent rebuilding the index.
+  //  "atendb.recovery-stats" - multi-line summary of the last recovery.
+  virtual bool GetProperty(const std::string& property, std::string* value) = 0;
+
  private:
   // No copying allowed
   void operator=(const DB&);
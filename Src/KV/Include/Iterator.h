@@ -0,0 +1,45 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#ifndef ATENDB_INCLUDE_ITERATOR_H_
+#define ATENDB_INCLUDE_ITERATOR_H_
+
+#include <string>
+
+namespace atendb {
+
+class Iterator {
+ public:
+  Iterator() { }
+  virtual ~Iterator() {}
+
+  // Returns true iff the iterator is positioned at a live key.
+  virtual bool Valid() const = 0;
+
+  // Position at the first key in the source.
+  virtual void SeekToFirst() = 0;
+
+  // Position at the first key in the source that is at or past target.
+  virtual void Seek(const std::string& target) = 0;
+
+  // Moves to the next entry in the source.
+  // REQUIRES: Valid()
+  virtual void Next() = 0;
+
+  // REQUIRES: Valid()
+  virtual const std::string& key() const = 0;
+
+  // REQUIRES: Valid()
+  virtual const std::string& value() const = 0;
+
+  // Returns false if reading a value from a data file failed.
+  virtual bool ok() const = 0;
+
+ private:
+  // No copying allowed
+  void operator=(const Iterator&);
+  Iterator(const Iterator&);
+};
+
+} // namespace atendb
+
+#endif // ATENDB_INCLUDE_ITERATOR_H_
@@ -8,14 +8,66 @@
 
 namespace atendb {
 
+// When appended records are forced to stable storage.
+enum SyncPolicy {
+  // Leave flushing to the page cache.
+  kSyncNone = 0,
+  // A background thread syncs every file each sync_interval_ms_.
+  kSyncInterval = 1,
+  // Every write batch is synced before its writers return.
+  kSyncEveryBatch = 2
+};
+
 class Options {
  public:
   Options() :
-    comparator_(nullptr) { }
+    comparator_(nullptr),
+    group_commit_(false),
+    max_batch_bytes_(1 << 20),
+    sync_policy_(kSyncNone),
+    sync_interval_ms_(1000),
+    concurrent_index_(false),
+    use_hint_file_(false) { }
 
   ~Options() {}
 
   Comparator* comparator_;
+
+  // If true, concurrent Put() calls that land on the same file are queued
+  // and a single leader writes the whole batch with one pwritev per file.
+  bool group_commit_;
+
+  // Upper bound of key+value bytes a leader coalesces into one batch.
+  size_t max_batch_bytes_;
+
+  SyncPolicy sync_policy_;
+
+  // Only used by kSyncInterval.
+  uint32_t sync_interval_ms_;
+
+  // If true, the in-memory index is a single skiplist that writers insert
+  // into lock-free, instead of one spin-locked skiplist per processor.
+  bool concurrent_index_;
+
+  // If true, a snapshot of the index is written when the database is
+  // closed and used by the next Open() instead of replaying index files.
+  // Off by default.
+  bool use_hint_file_;
+};
+
+class ReadOptions {
+ public:
+  ReadOptions() :
+    batch_size_(256) { }
+
+  ~ReadOptions() {}
+
+  // If not empty, iterators only return keys that start with prefix_.
+  std::string prefix_;
+
+  // Number of entries an iterator collects before reading their values,
+  // which are then fetched in file/offset order.
+  uint32_t batch_size_;
 };
 
 } // namespace atendb
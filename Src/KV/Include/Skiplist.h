@@ -8,10 +8,12 @@
 // Thread safety
 // -------------
 //
-// Writes require external synchronization, most likely a mutex.
-// Reads require a guarantee that the SkipList will not be destroyed
+// Insert() serializes writers on an internal spin lock.
+// InsertConcurrently() links nodes with compare-and-swap and may be called
+// from any number of threads at once; the two must not be mixed on the
+// same list. Reads require a guarantee that the SkipList will not be destroyed
 // while the read is in progress.  Apart from that, reads progress
-// without any internal locking or synchronization.
+// without any internal locking; they only pin a reader epoch, see (3).
 //
 // Invariants:
 //
@@ -19,38 +21,78 @@
 // destroyed.  This is trivially guaranteed by the code since we
 // never delete any skip list nodes.
 //
-// (2) The contents of a Node except for the next/prev pointers are
-// immutable after the Node has been linked into the SkipList.
-// Only Insert() modifies the list, and it is careful to initialize
-// a node and use release-stores to publish the nodes in one or
-// more lists.
+// (2) The ordering part of a Node's key and its next/prev pointers'
+// targets are immutable after the Node has been linked into the SkipList.
+// Insert() overwrites the key of an existing Node in place, under the
+// writer lock. InsertConcurrently() instead publishes a new copy of the
+// key through the node's value pointer, so readers see either the old or
+// the new entry, never a torn one.
+//
+// (3) Entries superseded by InsertConcurrently() are recycled with
+// epoch-based reclamation. Every reader pins the current epoch while it
+// may hold an entry (Get() for its copy, an Iterator for its lifetime),
+// and a retired entry is only reused once all readers that pinned an
+// epoch up to its retirement are gone. Memory therefore stays bounded by
+// the live entries plus those retired while the oldest reader is pinned.
 //
 // ... prev vs. next pointer ordering ...
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdlib.h>
-#include "KV/Util/Arena.h"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include "KV/Util/ConcurrentArena.h"
+#include "KV/Util/Lock.h"
 #include "KV/Util/Random.h"
 
 namespace atendb {
 
-class Arena;
-
 template<typename Key, class Comparator>
 class SkipList {
  private:
   struct Node;
 
+  enum { kMaxHeight = 12 };
+
  public:
-  // Create a new SkipList object that will use "cmp" for comparing keys,
-  // and will allocate memory using "*arena".  Objects allocated in the arena
-  // must remain allocated for the lifetime of the skiplist object.
+  // Create a new SkipList object that will use "cmp" for comparing keys.
+  // Nodes live in an internal arena for the lifetime of the skiplist.
   explicit SkipList(Comparator cmp);
 
-  // Insert key into the list.
-  // REQUIRES: nothing that compares equal to key is currently in the list.
+  // Destroys the keys of all the nodes and the replaced entries.
+  // REQUIRES: no Iterator over the list is alive.
+  ~SkipList();
+
+  // Insert key into the list, overwriting in place an entry that compares
+  // equal.
   void Insert(const Key& key);
 
+  // Like Insert(), but safe to call from many threads at once without
+  // any external synchronization.
+  void InsertConcurrently(const Key& key);
+
+  // Returns an estimate of the memory used by the nodes of the list.
+  size_t MemoryUsage() const { return arena_.MemoryUsage(); }
+
+  // Builds a list bottom-up from keys that arrive in ascending order.
+  // Every key is linked behind the last node of each level, so no search
+  // is needed.
+  // REQUIRES: the list is empty and nothing else writes to it while the
+  // Builder is in use.
+  class Builder {
+   public:
+    explicit Builder(SkipList* list);
+
+    // REQUIRES: key is greater than every key added before.
+    void Add(const Key& key);
+
+   private:
+    SkipList* list_;
+    Node* last_[kMaxHeight];
+  };
+
   // Returns true iff an entry that compares equal to key is in the list.
   bool Contains(const Key& key) const;
 
@@ -63,6 +105,13 @@ class SkipList {
     // The returned iterator is not valid.
     explicit Iterator(const SkipList* list);
 
+    // An iterator pins a reader epoch of the list until it is destroyed.
+    Iterator(const Iterator& other);
+    Iterator(Iterator&& other);
+    Iterator& operator=(const Iterator& other);
+    Iterator& operator=(Iterator&& other);
+    ~Iterator();
+
     // Returns true iff the iterator is positioned at a valid node.
     bool Valid() const;
 
@@ -92,19 +141,42 @@ class SkipList {
    private:
     const SkipList* list_;
     Node* node_;
+    int slot_;
     // Intentionally copyable
   };
 
  private:
-  enum { kMaxHeight = 12 };
-
   // Immutable after construction
   Comparator const compare_;
-  Arena arena_;
+  ConcurrentArena arena_;
   SpinLock lock_;
 
   Node* const head_;
 
+  // Copies of keys published by InsertConcurrently() for a key that was
+  // already present.
+  struct Replaced;
+
+  // Epoch-based reclamation of superseded entries, see invariant (3).
+  // A reader slot holds the epoch its reader pinned, or 0 when unused.
+  enum { kReaderSlots = 32 };
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch{0};
+  };
+  mutable ReaderSlot readers_[kReaderSlots];
+  // Readers that found every slot taken. Nothing is reclaimed while any
+  // of them is pinned.
+  mutable std::atomic<uint64_t> overflow_readers_;
+  std::atomic<uint64_t> epoch_;
+
+  // Guards the lists below.
+  SpinLock reclaim_lock_;
+  // Entries waiting for their readers to drain, oldest first.
+  Replaced* retired_head_;
+  Replaced* retired_tail_;
+  // Entries ready to be reused.
+  Replaced* free_;
+
   // Modified only by Insert().  Read racily by readers, but stale
   // values are ok.
   port::AtomicPointer max_height_;   // Height of the entire list
@@ -118,7 +190,27 @@ class SkipList {
   Random rnd_;
 
   Node* NewNode(const Key& key, int height);
-  int RandomHeight();
+  int RandomHeight(Random* rnd);
+
+  // Point the existing node "x" at a fresh copy of "key" and retire the
+  // entry it replaces.
+  void Replace(Node* x, const Key& key);
+
+  // Returns a recycled entry set to "key", or a new one from the arena.
+  Replaced* NewReplaced(const Key& key);
+
+  // Moves retired entries no reader can see anymore to free_.
+  // REQUIRES: reclaim_lock_ is held.
+  void ReclaimRetired();
+
+  // Pins the current epoch for a reader and returns its slot, or -1 if
+  // it was counted in overflow_readers_.
+  int Pin() const;
+  void Unpin(int slot) const;
+
+  // Starting at "before", find the nodes surrounding "key" on "level".
+  void FindSpliceForLevel(const Key& key, Node* before, int level,
+                          Node** out_prev, Node** out_next) const;
   bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
 
   // Return true if key is greater than the data stored in "n"
@@ -145,12 +237,39 @@ class SkipList {
 };
 
 // Implementation details follow
+template<typename Key, class Comparator>
+struct SkipList<Key,Comparator>::Replaced {
+  explicit Replaced(const Key& k) : key(k), epoch(0), next(nullptr) { }
+
+  Key key;
+  // Epoch the entry was retired in.
+  uint64_t epoch;
+  Replaced* next;
+};
+
 template<typename Key, class Comparator>
 struct SkipList<Key,Comparator>::Node {
-  explicit Node(const Key& k) : key(k) { }
+  explicit Node(const Key& k) : key(k), value_(nullptr) { }
 
+  // Used for ordering, its ordering part never changes.
   Key key;
 
+  // The current entry for key: "key" itself until InsertConcurrently()
+  // publishes a replacement.
+  // Sequentially consistent, so that a reader whose pin was missed by
+  // ReclaimRetired() is guaranteed to see the newer entry.
+  const Key& Value() const {
+    Replaced* r = value_.load(std::memory_order_seq_cst);
+    return r == nullptr ? key : r->key;
+  }
+  Replaced* Replacement() const {
+    return value_.load(std::memory_order_relaxed);
+  }
+  // Publishes "r" and returns the replacement it supersedes, if any.
+  Replaced* ExchangeValue(Replaced* r) {
+    return value_.exchange(r, std::memory_order_seq_cst);
+  }
+
   // Accessors/mutators for links.  Wrapped in methods so we can
   // add the appropriate barriers as necessary.
   Node* Next(int n) {
@@ -176,7 +295,14 @@ struct SkipList<Key,Comparator>::Node {
     next_[n].NoBarrier_Store(x);
   }
 
+  bool CASNext(int n, Node* expected, Node* x) {
+    assert(n >= 0);
+    return next_[n].CompareAndSwap(expected, x);
+  }
+
  private:
+  std::atomic<Replaced*> value_;
+
   // Array of length equal to the node height.  next_[0] is lowest level link.
   port::AtomicPointer next_[1];
 };
@@ -189,10 +315,159 @@ SkipList<Key,Comparator>::NewNode(const Key& key, int height) {
   return new (mem) Node(key);
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::Replace(Node* x, const Key& key) {
+  Replaced* old = x->ExchangeValue(NewReplaced(key));
+  if (old == nullptr) {
+    // The node's own key is not recycled.
+    return;
+  }
+  reclaim_lock_.Lock();
+  // Readers that pin an epoch after this increment cannot observe "old"
+  // anymore, it was unlinked from the node before.
+  old->epoch = epoch_.fetch_add(1, std::memory_order_seq_cst);
+  old->next = nullptr;
+  if (retired_tail_ == nullptr) {
+    retired_head_ = old;
+  } else {
+    retired_tail_->next = old;
+  }
+  retired_tail_ = old;
+  reclaim_lock_.Unlock();
+}
+
+template<typename Key, class Comparator>
+typename SkipList<Key,Comparator>::Replaced*
+SkipList<Key,Comparator>::NewReplaced(const Key& key) {
+  reclaim_lock_.Lock();
+  if (free_ == nullptr) {
+    ReclaimRetired();
+  }
+  Replaced* r = free_;
+  if (r != nullptr) {
+    free_ = r->next;
+  }
+  reclaim_lock_.Unlock();
+
+  if (r == nullptr) {
+    char* mem = arena_.AllocateAligned(sizeof(Replaced));
+    return new (mem) Replaced(key);
+  }
+  r->key = key;
+  r->next = nullptr;
+  return r;
+}
+
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::ReclaimRetired() {
+  // All of the loads below are ordered after the ExchangeValue() that
+  // retired an entry, and every pin before the reader's Value(): either
+  // the pin is visible here, or the reader sees the newer entry.
+  if (overflow_readers_.load(std::memory_order_seq_cst) != 0) {
+    return;
+  }
+  uint64_t min_epoch = UINT64_MAX;
+  for (int i = 0; i < kReaderSlots; i++) {
+    uint64_t e = readers_[i].epoch.load(std::memory_order_seq_cst);
+    if (e != 0 && e < min_epoch) {
+      min_epoch = e;
+    }
+  }
+  while (retired_head_ != nullptr && retired_head_->epoch < min_epoch) {
+    Replaced* r = retired_head_;
+    retired_head_ = r->next;
+    r->next = free_;
+    free_ = r;
+  }
+  if (retired_head_ == nullptr) {
+    retired_tail_ = nullptr;
+  }
+}
+
+template<typename Key, class Comparator>
+int SkipList<Key,Comparator>::Pin() const {
+  int slot = -1;
+  size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+  for (int i = 0; i < kReaderSlots; i++) {
+    int s = static_cast<int>((start + i) % kReaderSlots);
+    uint64_t expected = 0;
+    if (readers_[s].epoch.load(std::memory_order_relaxed) == 0 &&
+        readers_[s].epoch.compare_exchange_strong(
+            expected, epoch_.load(std::memory_order_seq_cst),
+            std::memory_order_seq_cst)) {
+      slot = s;
+      break;
+    }
+  }
+  if (slot < 0) {
+    overflow_readers_.fetch_add(1, std::memory_order_seq_cst);
+  }
+  return slot;
+}
+
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::Unpin(int slot) const {
+  if (slot < 0) {
+    overflow_readers_.fetch_sub(1, std::memory_order_release);
+  } else {
+    readers_[slot].epoch.store(0, std::memory_order_release);
+  }
+}
+
 template<typename Key, class Comparator>
 inline SkipList<Key,Comparator>::Iterator::Iterator(const SkipList* list) {
   list_ = list;
   node_ = nullptr;
+  slot_ = list_->Pin();
+}
+
+template<typename Key, class Comparator>
+inline SkipList<Key,Comparator>::Iterator::Iterator(const Iterator& other)
+    : list_(other.list_), node_(other.node_), slot_(list_->Pin()) {
+}
+
+template<typename Key, class Comparator>
+inline SkipList<Key,Comparator>::Iterator::Iterator(Iterator&& other)
+    : list_(other.list_), node_(other.node_), slot_(other.slot_) {
+  other.list_ = nullptr;
+}
+
+template<typename Key, class Comparator>
+inline typename SkipList<Key,Comparator>::Iterator&
+SkipList<Key,Comparator>::Iterator::operator=(const Iterator& other) {
+  if (this != &other) {
+    // Pin before unpinning so entries held through "other" stay valid.
+    int slot = other.list_->Pin();
+    if (list_ != nullptr) {
+      list_->Unpin(slot_);
+    }
+    list_ = other.list_;
+    node_ = other.node_;
+    slot_ = slot;
+  }
+  return *this;
+}
+
+template<typename Key, class Comparator>
+inline typename SkipList<Key,Comparator>::Iterator&
+SkipList<Key,Comparator>::Iterator::operator=(Iterator&& other) {
+  if (this != &other) {
+    if (list_ != nullptr) {
+      list_->Unpin(slot_);
+    }
+    list_ = other.list_;
+    node_ = other.node_;
+    slot_ = other.slot_;
+    other.list_ = nullptr;
+  }
+  return *this;
+}
+
+template<typename Key, class Comparator>
+inline SkipList<Key,Comparator>::Iterator::~Iterator() {
+  if (list_ != nullptr) {
+    list_->Unpin(slot_);
+  }
 }
 
 template<typename Key, class Comparator>
@@ -203,7 +478,7 @@ inline bool SkipList<Key,Comparator>::Iterator::Valid() const {
 template<typename Key, class Comparator>
 inline const Key& SkipList<Key,Comparator>::Iterator::key() const {
   assert(Valid());
-  return node_->key;
+  return node_->Value();
 }
 
 template<typename Key, class Comparator>
@@ -242,11 +517,33 @@ inline void SkipList<Key,Comparator>::Iterator::SeekToLast() {
 }
 
 template<typename Key, class Comparator>
-int SkipList<Key,Comparator>::RandomHeight() {
+SkipList<Key,Comparator>::Builder::Builder(SkipList* list) : list_(list) {
+  for (int i = 0; i < kMaxHeight; i++) {
+    last_[i] = list_->head_;
+  }
+}
+
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::Builder::Add(const Key& key) {
+  assert(last_[0] == list_->head_ || list_->compare_(last_[0]->key, key) < 0);
+  int height = list_->RandomHeight(&list_->rnd_);
+  if (height > list_->GetMaxHeight()) {
+    list_->max_height_.NoBarrier_Store(reinterpret_cast<void*>(height));
+  }
+  Node* x = list_->NewNode(key, height);
+  for (int i = 0; i < height; i++) {
+    x->NoBarrier_SetNext(i, nullptr);
+    last_[i]->SetNext(i, x);
+    last_[i] = x;
+  }
+}
+
+template<typename Key, class Comparator>
+int SkipList<Key,Comparator>::RandomHeight(Random* rnd) {
   // Increase height with probability 1 in kBranching
   static const unsigned int kBranching = 4;
   int height = 1;
-  while (height < kMaxHeight && ((rnd_.Next() % kBranching) == 0)) {
+  while (height < kMaxHeight && ((rnd->Next() % kBranching) == 0)) {
     height++;
   }
   assert(height > 0);
@@ -282,6 +579,23 @@ typename SkipList<Key,Comparator>::Node* SkipList<Key,Comparator>::FindGreaterOr
   }
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::FindSpliceForLevel(const Key& key,
+                                                  Node* before, int level,
+                                                  Node** out_prev,
+                                                  Node** out_next) const {
+  while (true) {
+    Node* next = before->Next(level);
+    if (KeyIsAfterNode(key, next)) {
+      before = next;
+    } else {
+      *out_prev = before;
+      *out_next = next;
+      return;
+    }
+  }
+}
+
 template<typename Key, class Comparator>
 typename SkipList<Key,Comparator>::Node*
 SkipList<Key,Comparator>::FindLessThan(const Key& key) const {
@@ -327,6 +641,11 @@ template<typename Key, class Comparator>
 SkipList<Key,Comparator>::SkipList(Comparator cmp)
     : compare_(cmp),
       head_(NewNode(Key() /* any key will do */, kMaxHeight)),
+      overflow_readers_(0),
+      epoch_(1),
+      retired_head_(nullptr),
+      retired_tail_(nullptr),
+      free_(nullptr),
       max_height_(reinterpret_cast<void*>(1)),
       rnd_(0xdeadbeef) {
   for (int i = 0; i < kMaxHeight; i++) {
@@ -334,6 +653,28 @@ SkipList<Key,Comparator>::SkipList(Comparator cmp)
   }
 }
 
+template<typename Key, class Comparator>
+SkipList<Key,Comparator>::~SkipList() {
+  // Nodes and entries live in the arena, only the heap memory owned by
+  // the keys has to be released.
+  Node* x = head_;
+  while (x != nullptr) {
+    Node* next = x->NoBarrier_Next(0);
+    if (x->Replacement() != nullptr) {
+      x->Replacement()->key.~Key();
+    }
+    x->key.~Key();
+    x = next;
+  }
+  for (Replaced* list : { retired_head_, free_ }) {
+    while (list != nullptr) {
+      Replaced* next = list->next;
+      list->key.~Key();
+      list = next;
+    }
+  }
+}
+
 template<typename Key, class Comparator>
 void SkipList<Key,Comparator>::Insert(const Key& key) {
   // TODO(opt): We can use a barrier-free variant of FindGreaterOrEqual()
@@ -343,7 +684,7 @@ void SkipList<Key,Comparator>::Insert(const Key& key) {
   lock_.Lock();
   Node* x = FindGreaterOrEqual(key, prev);
 
-  int height = RandomHeight();
+  int height = RandomHeight(&rnd_);
   if (height > GetMaxHeight()) {
     for (int i = GetMaxHeight(); i < height; i++) {
       prev[i] = head_;
@@ -376,6 +717,56 @@ void SkipList<Key,Comparator>::Insert(const Key& key) {
   lock_.Unlock();
 }
 
+template<typename Key, class Comparator>
+void SkipList<Key,Comparator>::InsertConcurrently(const Key& key) {
+  int height = RandomHeight(Random::GetTLSInstance());
+
+  // Raise the list height first so the search below records a
+  // predecessor for every level the new node will occupy.
+  int max_height = GetMaxHeight();
+  while (height > max_height) {
+    if (max_height_.CompareAndSwap(reinterpret_cast<void*>(max_height),
+                                   reinterpret_cast<void*>(height))) {
+      max_height = height;
+      break;
+    }
+    max_height = GetMaxHeight();
+  }
+
+  Node* prev[kMaxHeight];
+  Node* next[kMaxHeight];
+  Node* before = head_;
+  for (int i = max_height - 1; i >= 0; i--) {
+    FindSpliceForLevel(key, before, i, &prev[i], &next[i]);
+    before = prev[i];
+  }
+
+  if (next[0] != nullptr && Equal(key, next[0]->key)) {
+    Replace(next[0], key);
+    return;
+  }
+
+  Node* x = NewNode(key, height);
+  for (int i = 0; i < height; i++) {
+    while (true) {
+      x->NoBarrier_SetNext(i, next[i]);
+      if (prev[i]->CASNext(i, next[i], x)) {
+        break;
+      }
+      // Somebody linked a node into our splice, search again from the
+      // old predecessor, which still precedes key.
+      FindSpliceForLevel(key, prev[i], i, &prev[i], &next[i]);
+      if (i == 0 && next[0] != nullptr && Equal(key, next[0]->key)) {
+        // Lost a race against an insert of the same key. "x" is not
+        // reachable yet, so it is simply abandoned in the arena.
+        x->key.~Key();
+        Replace(next[0], key);
+        return;
+      }
+    }
+  }
+}
+
 template<typename Key, class Comparator>
 bool SkipList<Key,Comparator>::Contains(const Key& key) const {
   Node* x = FindGreaterOrEqual(key, nullptr);
@@ -390,7 +781,9 @@ template<typename Key, class Comparator>
 bool SkipList<Key,Comparator>::Get(const Key& key, Key* result) const {
   Node* x = FindGreaterOrEqual(key, nullptr);
   if (x != nullptr && Equal(key, x->key)) {
-    *result = x->key;
+    int slot = Pin();
+    *result = x->Value();
+    Unpin(slot);
     return true;
   } else {
     return false;
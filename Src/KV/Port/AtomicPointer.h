@@ -139,6 +139,11 @@ class AtomicPointer {
     MemoryBarrier();
     rep_ = v;
   }
+  // Atomically replace "expected" with "v". Acts as a full barrier.
+  inline bool CompareAndSwap(void* expected, void* v) {
+    return __atomic_compare_exchange_n(&rep_, &expected, v, false,
+                                       __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  }
 };
 
 // AtomicPointer based on C++11 <atomic>.
@@ -161,6 +166,9 @@ class AtomicPointer {
   inline void NoBarrier_Store(void* v) {
     rep_.store(v, std::memory_order_relaxed);
   }
+  inline bool CompareAndSwap(void* expected, void* v) {
+    return rep_.compare_exchange_strong(expected, v);
+  }
 };
 
 #endif
@@ -0,0 +1,56 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <assert.h>
+
+#include "KV/Util/ConcurrentArena.h"
+
+namespace atendb {
+
+static std::atomic<uint32_t> next_shard(0);
+
+ConcurrentArena::ConcurrentArena(size_t chunk_bytes) :
+  chunk_bytes_(chunk_bytes) { }
+
+ConcurrentArena::Shard* ConcurrentArena::CurrentShard() {
+  // Threads are spread round-robin over the shards the first time they
+  // allocate, so the first kShards threads each get a shard of their own.
+  static thread_local uint32_t tls_shard = next_shard++;
+  return &shards_[tls_shard % kShards];
+}
+
+char* ConcurrentArena::AllocateFromArena(size_t bytes) {
+  std::lock_guard<std::mutex> l(mu_);
+  return arena_.AllocateAligned(bytes);
+}
+
+char* ConcurrentArena::AllocateAligned(size_t bytes) {
+  const int align = (sizeof(void*) > 8) ? sizeof(void*) : 8;
+  assert((align & (align-1)) == 0);   // Pointer size should be a power of 2
+
+  if (bytes > chunk_bytes_ / 4) {
+    // Large objects would waste too much of a chunk.
+    return AllocateFromArena(bytes);
+  }
+
+  Shard* shard = CurrentShard();
+  shard->lock.Lock();
+  size_t current_mod = reinterpret_cast<uintptr_t>(shard->alloc_ptr) & (align-1);
+  size_t slop = (current_mod == 0 ? 0 : align - current_mod);
+  size_t needed = bytes + slop;
+  char* result;
+  if (needed <= shard->alloc_bytes_remaining) {
+    result = shard->alloc_ptr + slop;
+    shard->alloc_ptr += needed;
+    shard->alloc_bytes_remaining -= needed;
+  } else {
+    // We waste the remaining space in the current chunk.
+    result = AllocateFromArena(chunk_bytes_);
+    shard->alloc_ptr = result + bytes;
+    shard->alloc_bytes_remaining = chunk_bytes_ - bytes;
+  }
+  shard->lock.Unlock();
+  assert((reinterpret_cast<uintptr_t>(result) & (align-1)) == 0);
+  return result;
+}
+
+}  // namespace atendb
@@ -0,0 +1,64 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#ifndef ATENDB_UTIL_CONCURRENT_ARENA_H_
+#define ATENDB_UTIL_CONCURRENT_ARENA_H_
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "KV/Util/Arena.h"
+#include "KV/Util/Lock.h"
+
+namespace atendb {
+
+// An Arena that may be used by several threads at once.
+//
+// Each thread is bound to one of kShards shards and bump-allocates from
+// the chunk its shard currently owns. Only refilling a shard with a new
+// chunk goes through the central Arena and its mutex, so with fewer
+// threads than shards allocations never contend.
+class ConcurrentArena {
+ public:
+  explicit ConcurrentArena(size_t chunk_bytes = kChunkBytes);
+  ~ConcurrentArena() {}
+
+  // Allocate memory with the normal alignment guarantees provided by malloc
+  char* AllocateAligned(size_t bytes);
+
+  // Returns an estimate of the total memory usage of data allocated
+  // by the arena.
+  size_t MemoryUsage() const { return arena_.MemoryUsage(); }
+
+ private:
+  enum { kShards = 32 };
+  static const size_t kChunkBytes = 16 * 1024;
+
+  struct alignas(64) Shard {
+    Shard() : alloc_ptr(nullptr), alloc_bytes_remaining(0) { }
+
+    SpinLock lock;
+    char* alloc_ptr;
+    size_t alloc_bytes_remaining;
+  };
+
+  Shard* CurrentShard();
+
+  char* AllocateFromArena(size_t bytes);
+
+  const size_t chunk_bytes_;
+
+  std::mutex mu_;
+  Arena arena_;
+
+  Shard shards_[kShards];
+
+  // No copying allowed
+  ConcurrentArena(const ConcurrentArena&);
+  void operator=(const ConcurrentArena&);
+};
+
+}  // namespace atendb
+
+#endif  // ATENDB_UTIL_CONCURRENT_ARENA_H_
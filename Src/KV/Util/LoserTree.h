@@ -0,0 +1,78 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#ifndef ATENDB_UTIL_LOSER_TREE_H_
+#define ATENDB_UTIL_LOSER_TREE_H_
+
+#include <assert.h>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace atendb {
+
+// Tournament tree for merging k sorted sources.
+//
+// Sources are numbered [0, k). "Less(a, b)" must return true iff the
+// current head of source a sorts before the head of source b, treating an
+// exhausted source as larger than everything else. Internal node n keeps
+// the loser of the match played there, so after the head of the winning
+// source changes only the log2(k) matches on its path are replayed.
+template<class Less>
+class LoserTree {
+ public:
+  LoserTree(uint32_t k, Less less) :
+    k_(k),
+    less_(less),
+    tree_(k > 0 ? k : 1, 0) { }
+
+  // (Re)play every match. Required after all sources were repositioned.
+  void Build() {
+    if (k_ > 0) {
+      tree_[0] = Build(1);
+    }
+  }
+
+  // Source whose head is the smallest.
+  // REQUIRES: k > 0
+  uint32_t Winner() const {
+    assert(k_ > 0);
+    return tree_[0];
+  }
+
+  // Replay the matches of Winner() after its head changed.
+  void Replay() {
+    uint32_t winner = tree_[0];
+    for (uint32_t n = (winner + k_) / 2; n >= 1; n /= 2) {
+      if (less_(tree_[n], winner)) {
+        std::swap(tree_[n], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+
+ private:
+  // Nodes [1, k) are internal, nodes [k, 2k) are the sources. Returns the
+  // winner of the subtree rooted at n.
+  uint32_t Build(uint32_t n) {
+    if (n >= k_) {
+      return n - k_;
+    }
+    uint32_t left = Build(2 * n);
+    uint32_t right = Build(2 * n + 1);
+    if (less_(right, left)) {
+      tree_[n] = left;
+      return right;
+    } else {
+      tree_[n] = right;
+      return left;
+    }
+  }
+
+  const uint32_t k_;
+  Less less_;
+  std::vector<uint32_t> tree_;
+};
+
+}  // namespace atendb
+
+#endif  // ATENDB_UTIL_LOSER_TREE_H_
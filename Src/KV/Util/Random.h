@@ -9,6 +9,9 @@
 
 #include <stdint.h>
 
+#include <functional>
+#include <thread>
+
 namespace atendb {
 
 // A very simple random number generator.  Not especially good at
@@ -59,6 +62,14 @@ namespace atendb {
         uint32_t Skewed(int max_log) {
             return Uniform(1 << Uniform(max_log + 1));
         }
+
+        // Returns a generator owned by the calling thread, for callers that
+        // cannot share one instance without synchronization.
+        static Random* GetTLSInstance() {
+            static thread_local Random tls_instance(static_cast<uint32_t>(
+                std::hash<std::thread::id>()(std::this_thread::get_id())));
+            return &tls_instance;
+        }
     };
 
 }  // namespace atendb
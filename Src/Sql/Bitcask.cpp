@@ -15,6 +15,7 @@
 #include <iostream>
 #include <time.h>
 #include <sstream>
+#include <iomanip>
 
 // 纳秒时间戳
 #include <ctime>
@@ -97,7 +98,9 @@ std::string GetCurrentTimeStamp(int time_stamp_type = 0) {
 				> (now.time_since_epoch()) % 1000000;
 		ns = std::chrono::duration_cast < std::chrono::nanoseconds
 				> (now.time_since_epoch()) % 1000000000;
-		ss << buffer << ms.count() << cs.count() % 1000 << ns.count() % 1000;
+		// 定宽, 文件名按字典序即按时间排序
+		ss << buffer << std::setw(3) << ms.count() << std::setw(3)
+				<< cs.count() % 1000 << std::setw(3) << ns.count() % 1000;
 		break;
 	default:
 		ss << buffer;
@@ -156,13 +159,42 @@ void DiskValueObject::print() {
 			<< " value:" << value << endl;
 }
 
-void MemoryValueObject::print() {
-	cout << "[MemoryValueObject::print] file_id:" << file_id << " value_pos:"
-			<< value_pos << " timestamp:" << timestamp\
- << " key_length:"
-			<< key_length << " value_length:" << value_length << " key:"
-			<< key\
- << " value:" << value << endl;
+// 读写日志使用的缓冲区大小
+static const size_t kLogBufferBytes = 1 << 20;
+
+static void encodeRecord(const string &key, const string &value,
+		uint32_t timestamp, string *record) {
+	// int数据块总长度 int时间戳 int:keysize char:key int:valuesize char:value
+	uint32_t data_buf_size = 4 * sizeof(uint32_t) + key.size() + value.size();
+	uint32_t key_length = key.size();
+	uint32_t value_length = value.size();
+	record->reserve(data_buf_size);
+	record->append((char*) &data_buf_size, sizeof(uint32_t));
+	record->append((char*) &timestamp, sizeof(uint32_t));
+	record->append((char*) &key_length, sizeof(uint32_t));
+	record->append(key);
+	record->append((char*) &value_length, sizeof(uint32_t));
+	record->append(value);
+}
+
+static bool writeAll(int fd, const char *buf, size_t size, uint64_t offset) {
+	size_t cnt = 0;
+	while (cnt < size) {
+		ssize_t n = pwrite(fd, buf + cnt, size - cnt, offset + cnt);
+		if (n > 0) {
+			cnt += n;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool endsWith(const string &s, const string &suffix) {
+	return s.size() >= suffix.size()
+			&& s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
 
 bool KvStore::open() {
@@ -171,12 +203,11 @@ bool KvStore::open() {
 	// open(m_cur_fd)
 	// m_file_list.add(m_cur_fd)
 	// m_offset=0
+	// ; 启动后台compaction线程
 
 	recover();
 
 	string filename = m_data_dir + "KvStore_" + GetCurrentTimeStamp(3) + ".log";
-	//m_cur_file.open(m_cur_filename, ios::out| ios::in);
-	//m_cur_file.open(m_cur_filename);
 	int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0645);
 	if (fd < 0) {
 		cout << "[open] file open error" << endl;
@@ -186,543 +217,495 @@ bool KvStore::open() {
 	m_cur_file.m_fd = fd;
 
 	m_file_list.push_back(m_cur_file);
+	m_file_stats[fd] = FileStats();
 
 	m_offset = 0;
 	m_value_count = 0;
-//    m_cur_file.seekp(0, ios::end);
+
+	m_stop = false;
+	m_compaction_thread = std::thread(&KvStore::compactionLoop, this);
+	return true;
 }
 
 bool KvStore::close() {
+	stopCompactionThread();
 	for (auto file : m_file_list) {
 		::close(file.m_fd);
 	}
-
+	m_file_list.clear();
+	m_file_stats.clear();
+	return true;
 }
 
-int KvStore::set(string key, string value) {
-//	i: k,v
-//	; 写入日志文件
-//	MemoryValueObject=crc 时间戳 key长度 value长度 k v
-//	m_cur_fd.append(MemoryValueObject=crc 时间戳 key长度 value长度 k v) 追加日志文件
-//		;写入文件
-//			int数据块总长度 int时间戳 int:keysize char:key int:valuesize char:value
-//		;
-//			MemoryValueObject先序列化为string
-//			然后string顺序写入m_cur_file
-//		; 文件偏移
-//		value位置= m_offset
-//		m_offset=m_offset+MemoryValueObject.size
-//	; 写入内存
-//	m_keydir.set(k,(file_id=m_fd, value长度, value位置, 时间戳)) 写入内存
-//	m_value_count++
-//
-//	; 文件切换
-//	-value位置m_value_count>=100
-//		//m_cur_fd.close 不能关闭 m_keydir还有数据需要使用
-//		m_cur_fd.open(新的日志文件)
-//		m_file_list.add(m_cur_fd)
-//		m_offset=0
-
-	auto iter = m_keydir.find(key);
-	if (iter != m_keydir.end()) {
-//	key已经存在 替换value的值
-		m_keydir.erase(key);
-//		return -1;
+void KvStore::stopCompactionThread() {
+	if (!m_compaction_thread.joinable()) {
+		return;
 	}
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_compaction_cv.notify_one();
+	m_compaction_thread.join();
+}
 
-	uint32_t timestamp = timestamp_now();
-	uint32_t key_length = key.length();
-	uint32_t value_length = value.length();
-
-	//写入日志
-	uint32_t data_buf_size = 4 * sizeof(uint32_t) + key.size() + value.size();
-	char data_buf[data_buf_size];
-	int pos = 0;
-//    sprintf(data_buf+pos, "%d", data_buf_size);
-	memcpy(data_buf + pos, (char*) &data_buf_size, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-//    sprintf(data_buf+pos, "%d", timestamp);
-	memcpy(data_buf + pos, (char*) &timestamp, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-//    sprintf(data_buf+pos, "%d", key_length);
-	memcpy(data_buf + pos, (char*) &key_length, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-	memcpy(data_buf + pos, key.data(), key.size());
-	pos += key.size();
-//    sprintf(data_buf+pos, "%d", value_length);
-	memcpy(data_buf + pos, (char*) &value_length, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-	memcpy(data_buf + pos, value.data(), value.size());
-	pos += value.size();
-	// m_cur_file<< output<<endl;
-	//!?fd_
-//	int offset= m_offset;
-	int file_offset = m_offset;
-	int64_t cnt = 0;
-	while (cnt < data_buf_size) {
-		ssize_t n = pwrite(m_cur_file.m_fd, data_buf, data_buf_size - cnt,
-				file_offset + cnt);
-		if (n > 0) {
-			cnt += n;
-		} else if (n < 0) {
-			if (errno != EINTR) {
-				cnt = -1;
-				break;
-			}
-		} else {
-			break;
+bool KvStore::appendRecord(const string &record, uint64_t *file_offset) {
+	// ; 文件切换
+	// 当前文件写满后打开新的日志文件, 旧文件不再写入, 可以被compaction
+	// KeyDirEntry中的偏移是32位的, 文件也不能超过4GB
+	string filename = m_data_dir + "KvStore_" + GetCurrentTimeStamp(3) + ".log";
+	bool full = m_offset >= m_max_file_bytes
+			|| m_offset + record.size() > UINT32_MAX;
+	if (full && filename != m_cur_file.m_file_name) {
+		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0645);
+		if (fd < 0) {
+			return false;
 		}
+		m_cur_file.m_file_name = filename;
+		m_cur_file.m_fd = fd;
+		m_file_list.push_back(m_cur_file);
+		m_file_stats[fd] = FileStats();
+		m_offset = 0;
 	}
-	m_offset.fetch_add(data_buf_size);
-
-	// 写入内存
-	MemoryValueObject memory_value_object;
-	memory_value_object.file_id = m_cur_file.m_fd;
-	memory_value_object.value_length = data_buf_size;
-	memory_value_object.timestamp = timestamp;
-	memory_value_object.value_pos = file_offset;
-	m_keydir.insert(make_pair(key, memory_value_object));
-	m_value_count++;
-//	memory_value_object.print();
-
 
-	// 切换文件
-	if (m_value_count > 500) {
-
-		compaction();
-		m_value_count =0;
+	*file_offset = m_offset;
+	if (!writeAll(m_cur_file.m_fd, record.data(), record.size(), *file_offset)) {
+		return false;
 	}
-//	if (m_value_count > 100) {
-//		// close(m_fd);
-//		// 重命名老文件
-////        string filename="./KvStore_current.log";
-////        string new_filename="./KvStore_current"+GetCurrentTimeStamp(3)+".log";
-//		string filename = m_data_dir + "KvStore_" + GetCurrentTimeStamp(3)
-//				+ ".log";
-//		;
-////        rename(filename.c_str(), new_filename.c_str());
-//
-//		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0645);
-//		m_cur_file.m_file_name = filename;
-//		m_cur_file.m_fd = fd;
-//
-//		m_file_list.push_back(m_cur_file);
-//		m_offset = 0;
-//
-//		compaction();
-//	}
+	m_offset.fetch_add(record.size());
+	return true;
+}
 
-	return 0;
+void KvStore::markDead(const KeyDirEntry &object) {
+	FileStats &stats = m_file_stats[object.file_id];
+	stats.live_bytes -= std::min<uint64_t>(stats.live_bytes,
+			object.value_length);
+	stats.dead_bytes += object.value_length;
+}
+
+int KvStore::set(string key, string value) {
+	return put(key, value, true);
 }
 
-// 没有切换文件 没有compaction 用于测试 @test_compaction
+// 没有compaction 用于测试 @test_compaction
 int KvStore::set_no_compaction(string key, string value) {
+	return put(key, value, false);
+}
+
+int KvStore::put(string key, string value, bool notify_compaction) {
 //	i: k,v
 //	; 写入日志文件
 //	MemoryValueObject=crc 时间戳 key长度 value长度 k v
 //	m_cur_fd.append(MemoryValueObject=crc 时间戳 key长度 value长度 k v) 追加日志文件
 //		;写入文件
 //			int数据块总长度 int时间戳 int:keysize char:key int:valuesize char:value
-//		;
-//			MemoryValueObject先序列化为string
-//			然后string顺序写入m_cur_file
 //		; 文件偏移
 //		value位置= m_offset
 //		m_offset=m_offset+MemoryValueObject.size
 //	; 写入内存
 //	m_keydir.set(k,(file_id=m_fd, value长度, value位置, 时间戳)) 写入内存
+//	旧值所在文件的死数据增加
 //	m_value_count++
 //
-//	; 文件切换
-//	-value位置m_value_count>=100
-//		//m_cur_fd.close 不能关闭 m_keydir还有数据需要使用
-//		m_cur_fd.open(新的日志文件)
-//		m_file_list.add(m_cur_fd)
-//		m_offset=0
+//	; compaction
+//	-m_value_count>500
+//		唤醒后台compaction线程, 不在写线程上做compaction
 	uint32_t timestamp = timestamp_now();
-	uint32_t key_length = key.length();
-	uint32_t value_length = value.length();
+	string record;
+	encodeRecord(key, value, timestamp, &record);
 
-	//写入日志
-	uint32_t data_buf_size = 4 * sizeof(uint32_t) + key.size() + value.size();
-	char data_buf[data_buf_size];
-	int pos = 0;
-//    sprintf(data_buf+pos, "%d", data_buf_size);
-	memcpy(data_buf + pos, (char*) &data_buf_size, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-//    sprintf(data_buf+pos, "%d", timestamp);
-	memcpy(data_buf + pos, (char*) &timestamp, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-//    sprintf(data_buf+pos, "%d", key_length);
-	memcpy(data_buf + pos, (char*) &key_length, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-	memcpy(data_buf + pos, key.data(), key.size());
-	pos += key.size();
-//    sprintf(data_buf+pos, "%d", value_length);
-	memcpy(data_buf + pos, (char*) &value_length, sizeof(uint32_t));
-	pos += sizeof(uint32_t);
-	memcpy(data_buf + pos, value.data(), value.size());
-	pos += value.size();
-	// m_cur_file<< output<<endl;
-	//!?fd_
-	int file_offset = m_offset.fetch_add(data_buf_size);
-	int64_t cnt = 0;
-	while (cnt < data_buf_size) {
-		ssize_t n = pwrite(m_cur_file.m_fd, data_buf, data_buf_size - cnt,
-				file_offset + cnt);
-		if (n > 0) {
-			cnt += n;
-		} else if (n < 0) {
-			if (errno != EINTR) {
-				cnt = -1;
-				break;
-			}
-		} else {
-			break;
-		}
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t file_offset;
+	if (!appendRecord(record, &file_offset)) {
+		return -1;
+	}
+
+	KeyDirEntry *old_entry = m_keydir.find(key);
+	if (old_entry != nullptr) {
+//	key已经存在 替换value的值
+		markDead(*old_entry);
 	}
 
 	// 写入内存
-	MemoryValueObject memory_value_object;
-	memory_value_object.file_id = m_cur_file.m_fd;
-	memory_value_object.value_length = data_buf_size;
-	memory_value_object.timestamp = timestamp;
-	memory_value_object.value_pos = m_offset;
-	m_keydir.insert(make_pair(key, memory_value_object));
+	KeyDirEntry entry;
+	entry.file_id = m_cur_file.m_fd;
+	entry.value_length = record.size();
+	entry.timestamp = timestamp;
+	entry.value_pos = file_offset;
+	m_keydir.set(key, entry);
+	m_file_stats[m_cur_file.m_fd].live_bytes += record.size();
 	m_value_count++;
 
-	// 切换文件
-//		if (m_value_count > 100) {
-//
-//			compaction();
-//		}
-
-//	if (m_value_count > 100) {
-//		// close(m_fd);
-//		// 重命名老文件
-////        string filename="./KvStore_current.log";
-////        string new_filename="./KvStore_current"+GetCurrentTimeStamp(3)+".log";
-//		string filename = m_data_dir + "KvStore_" + GetCurrentTimeStamp(3)
-//				+ ".log";
-//		;
-////        rename(filename.c_str(), new_filename.c_str());
-//
-//		int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_APPEND, 0645);
-//		m_cur_file.m_file_name = filename;
-//		m_cur_file.m_fd = fd;
-//
-//		m_file_list.push_back(m_cur_file);
-//		m_offset = 0;
-//
-//		compaction();
-//	}
+	if (notify_compaction && m_value_count > 500) {
+		m_value_count = 0;
+		m_compaction_pending = true;
+		m_compaction_cv.notify_one();
+	}
 
 	return 0;
 }
 
 int KvStore::get(string key, string &value) {
-	auto iter = m_keydir.find(key);
-	if (iter == m_keydir.end()) {
+	// 持有锁读取, compaction不会在读取过程中关闭文件
+	std::lock_guard<std::mutex> lock(m_mutex);
+	KeyDirEntry *entry = m_keydir.find(key);
+	if (entry == nullptr) {
 		return -1;
 	}
-	auto disk_object = iter->second;
 
-	int file_id = disk_object.file_id;
-	int value_pos = disk_object.value_pos;
-	int value_length = disk_object.value_length;
+	int file_id = entry->file_id;
+	off_t value_pos = entry->value_pos;
+	uint32_t value_length = entry->value_length;
 
-	char data_buf[value_length];
-	pread(file_id, data_buf, value_length, value_pos);
+	std::vector<char> data_buf(value_length);
+	if (pread(file_id, data_buf.data(), value_length, value_pos)
+			!= (ssize_t) value_length) {
+		return -1;
+	}
 
-//	cout<<"[get] -------- value_pos" << value_pos <<endl;
-	int pos = 0;
-	uint32_t data_size;
-//    char data_size_buf[sizeof(int)];
-	memcpy(&data_size, data_buf + pos, sizeof(uint32_t));
-//    data_size=atoi(data_size_buf);
-	pos += sizeof(uint32_t);
-//	cout<<"[get] data_size" << data_size <<endl;
-	uint32_t timestamp;
-//    char timestamp_buf[sizeof(int)];
-	memcpy(&timestamp, data_buf + pos, sizeof(uint32_t));
-//    timestamp= atoi(timestamp_buf);
-	pos += sizeof(uint32_t);
-//	cout<<"[get] timestamp" << timestamp <<endl;
+	// int数据块总长度 int时间戳 int:keysize char:key int:valuesize char:value
+	size_t pos = 3 * sizeof(uint32_t);
 	uint32_t key_size;
-//    char key_size_buf[sizeof(int)];
-	memcpy(&key_size, data_buf + pos, sizeof(uint32_t));
-//    key_size= atoi(key_size_buf);
-	pos += sizeof(uint32_t);
-//	cout<<"[get] key_size" << key_size <<endl;
-	// std::shared_ptr<char> key_buf(new char);
-	// memcpy(key_buf, data_buf+pos, key_size);
-	string key_buf = string(data_buf + pos, key_size);
+	memcpy(&key_size, data_buf.data() + 2 * sizeof(uint32_t), sizeof(uint32_t));
 	pos += key_size;
-//	cout<<"[get] key_buf" << key_buf <<endl;
 	uint32_t value_size;
-//    char value_size_buf[sizeof(int)];
-	memcpy(&value_size, data_buf + pos, sizeof(uint32_t));
-//    value_size=atoi(value_size_buf);
+	memcpy(&value_size, data_buf.data() + pos, sizeof(uint32_t));
 	pos += sizeof(uint32_t);
-//	cout<<"[get] value_size" << value_size <<endl;
-	// std::shared_ptr<char> value_buf(new char);
-	// memcpy(value_buf, data_buf+pos, value_size);
-	string value_buf = string(data_buf + pos, value_size);
-	pos += value_size;
-//	cout<<"[get] value_buf" << value_buf <<endl;
-
-//	cout << "[get] data_size:"<<data_size << " timestamp:" << timestamp << " key_size:" << key_size << " key_buf:" << key_buf
-//			<< " value_size:" << value_size << " value_buf:" << value_buf << endl;
 
-	value = value_buf;
+	value = string(data_buf.data() + pos, value_size);
 	return 0;
 }
 
 int KvStore::rm(string key) {
-	auto iter = m_keydir.find(key);
-	if (iter != m_keydir.end()) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	KeyDirEntry *entry = m_keydir.find(key);
+	if (entry != nullptr) {
 		//存在
+		markDead(*entry);
 		m_keydir.erase(key);
 
-		int timestamp = 0;
-		int key_length = key.length();
-		// int value_length= value.length();
-		int value_length = 0;
-
-		//写入日志
-		int data_buf_size = 4 * sizeof(uint32_t) + key_length + value_length;
-		char data_buf[data_buf_size];
-		int pos = 0;
-		memcpy(data_buf + pos, (uint32_t*) &data_buf_size, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, (uint32_t*) &timestamp, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, (uint32_t*) &key_length, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, key.data(), key.size());
-		pos += key.size();
-		memcpy(data_buf + pos, (uint32_t*) &value_length, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-//		 memcpy(data_buf+pos, value.data(), value.size());
-//		 pos+=value.size();
-		// m_cur_file<< output<<endl;
-		int file_offset = m_offset.fetch_add(data_buf_size);
-		int64_t cnt = 0;
-		while (cnt < data_buf_size) {
-			ssize_t n = pwrite(m_cur_file.m_fd, data_buf, data_buf_size - cnt,
-					file_offset + cnt);
-			if (n > 0) {
-				cnt += n;
-			} else if (n < 0) {
-				if (errno != EINTR) {
-					cnt = -1;
-					break;
-				}
-			} else {
-				break;
-			}
+		//写入日志 时间戳为0表示删除
+		string record;
+		encodeRecord(key, "", 0, &record);
+		uint64_t file_offset;
+		if (!appendRecord(record, &file_offset)) {
+			return -1;
 		}
-
-	} else {
-		return 0;
+		// 删除标记要一直保留到key被重新写入, 按存活数据统计
+		FileStats &stats = m_file_stats[m_cur_file.m_fd];
+		stats.live_bytes += record.size();
+		stats.tombstone_bytes += record.size();
 	}
 
 	return 0;
 }
 
 int KvStore::compaction() {
-	// log_list 写入新的日志文件的数组
-	vector<DiskValueObject> log_list;
-	// merged_data_file 新的日志文件
-	string merged_data_file_name = m_data_dir + "KvStore_"
-			+ GetCurrentTimeStamp(3) + ".log";
-	int merged_data_file_id = ::open(merged_data_file_name.c_str(),
-			O_RDWR | O_CREAT | O_APPEND, 0645);
-	//m_cur_file.open(m_cur_filename, ios::out| ios::in);
-	//m_cur_file.open(m_cur_filename);
-	m_cur_file.m_file_name = merged_data_file_name;
-	m_cur_file.m_fd = merged_data_file_id;
-	m_offset=0;
-//	m_file_list.push_back(m_cur_file);
-	if (merged_data_file_id < 0) {
-		return false;
-	}
-	// m_fd= merged_data_file_id;
-
-	// for data_file in m_file_list:
-	//     for (crc 时间戳 key长度 value长度 key value) in data_file: 遍历每个条目
-	//         -key不在m_keydir存在 -> key已经被删除
-	//         -key在m_keydir存在
-	//             -时间戳==m_key_dir[key].时间戳
-	//                 ;追加入队列
-	//                 log_list.add(crc 时间戳 key长度 value长度 key value)
-	//             -时间戳!=m_key_dir[key].时间戳 ->老数据
-	for (auto file : m_file_list) {
-		vector<DiskValueObject> entryList;
-		readLogEntry(file, entryList);
-		for (auto entry : entryList) {
-			auto foundKey = m_keydir.find(entry.key);
-			if (foundKey == m_keydir.end()) {
-				//         -key不在m_keydir存在 -> key已经被删除
-				cout<<"key:"<<entry.key<<"key不在m_keydir存在: 被删除"<<endl;
-				continue;
-			} else {
-				if (entry.timestamp == foundKey->second.timestamp) {
-					log_list.push_back(entry);
-					cout<<"key:"<<entry.key<<"内存时间:"<<foundKey->second.timestamp<<"磁盘时间:"<<entry.timestamp<<"key在m_keydir存在 时间相同: 新数据"<<endl;
-				}else{
-					cout<<"key:"<<entry.key<<"内存时间:"<<foundKey->second.timestamp<<"磁盘时间:"<<entry.timestamp<<"key在m_keydir存在 时间不同: 老数据"<<endl;
+	// 每轮选择死数据比例最高的非活跃文件, 直到没有文件超过m_compaction_dead_ratio
+	// m_file_list按恢复顺序排列, 第一个文件中的删除标记没有更旧的记录要屏蔽, 也算死数据
+	std::lock_guard<std::mutex> compaction_lock(m_compaction_mutex);
+	int compacted = 0;
+	while (true) {
+		CFile victim;
+		double victim_ratio = 0;
+		bool victim_oldest = false;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_stop) {
+				break;
+			}
+			for (size_t i = 0; i < m_file_list.size(); i++) {
+				CFile &file = m_file_list[i];
+				if (file.m_fd == m_cur_file.m_fd) {
+					continue;
+				}
+				FileStats &stats = m_file_stats[file.m_fd];
+				uint64_t dead = stats.dead_bytes
+						+ (i == 0 ? stats.tombstone_bytes : 0);
+				uint64_t total = stats.live_bytes + stats.dead_bytes;
+				if (dead == 0 || total == 0) {
+					continue;
+				}
+				double ratio = (double) dead / total;
+				if (ratio >= m_compaction_dead_ratio && ratio > victim_ratio) {
+					victim = file;
+					victim_ratio = ratio;
+					victim_oldest = (i == 0);
 				}
-
 			}
 		}
+		if (victim_ratio == 0 || !compactFile(victim, victim_oldest)) {
+			break;
+		}
+		compacted++;
+	}
+	return compacted;
+}
 
+bool KvStore::compactFile(CFile file, bool drop_tombstones) {
+	// for (crc 时间戳 key长度 value长度 key value) in file: 按块遍历
+	//     -时间戳不为0 且 m_keydir[key]仍指向这条记录 -> 存活, 追加入新文件
+	//     -时间戳为0 且 key不在m_keydir 且 !drop_tombstones -> 删除标记仍然有效, 追加入新文件
+	//     -其它 -> 老数据
+	// ; 新文件写完后 rename 覆盖旧文件, 文件在恢复时的顺序不变
+	// ; 没有记录留下时直接删除旧文件, 没有key指向它
+	// ; 加锁更新m_keydir中仍指向旧文件的条目
+	auto start = std::chrono::steady_clock::now();
+	string tmp_name = file.m_file_name + ".compacting";
+	int out_fd = ::open(tmp_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0645);
+	if (out_fd < 0) {
+		return false;
 	}
-	// ; 将log_list序列化入磁盘
-	// for log in log_list:
-	//     new_value_pos= merged_data_file.append(log)
-	//     ; 更新m_keydir
-	//     m_keydir[log.key].value位置= new_value_pos
-	//     m_keydir[log.key].file_id= new_file_id
-	// => merged_data_file
-//	int file_offset = 0;
-	for (auto entry : log_list) {
-		uint32_t timestamp = timestamp_now();
-		uint32_t key_length = entry.key_length;
-		uint32_t value_length = entry.value_length;
-
-		//写入日志
-		uint32_t data_buf_size = 4 * sizeof(uint32_t) + key_length + value_length;
-		char data_buf[data_buf_size];
-		uint32_t pos = 0;
-		memcpy(data_buf + pos, (uint32_t*) &data_buf_size, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, (uint32_t*) &timestamp, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, (int*) &key_length, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, entry.key.data(), entry.key.size());
-		pos += entry.key.size();
-		memcpy(data_buf + pos, (uint32_t*) &value_length, sizeof(uint32_t));
-		pos += sizeof(uint32_t);
-		memcpy(data_buf + pos, entry.value.data(), entry.value.size());
-		pos += entry.value.size();
-		// m_cur_file<< output<<endl;
-		int file_offset = m_offset;
-		int64_t cnt = 0;
-		while (cnt < data_buf_size) {
-			ssize_t n = pwrite(m_cur_file.m_fd, data_buf, data_buf_size - cnt,
-					file_offset + cnt);
-			if (n > 0) {
-				cnt += n;
-			} else if (n < 0) {
-				if (errno != EINTR) {
-					cnt = -1;
-					break;
+
+	struct Moved {
+		string key;
+		uint64_t old_pos;
+		uint64_t new_pos;
+		uint32_t length;
+	};
+	vector<Moved> moved;
+	uint64_t tombstone_bytes = 0;
+	uint64_t bytes_read = 0;
+	string out_buf;
+	uint64_t out_offset = 0;
+	bool ok = true;
+	vector<char> live;
+
+	ok = scanLogFile(file, [&](vector<LogRecord> &records) {
+		live.assign(records.size(), 0);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (size_t i = 0; i < records.size(); i++) {
+				KeyDirEntry *found = m_keydir.find(records[i].key);
+				if (records[i].timestamp == 0) {
+					live[i] = (!drop_tombstones && found == nullptr);
+				} else {
+					live[i] = (found != nullptr
+							&& (int) found->file_id == file.m_fd
+							&& found->value_pos == records[i].pos);
 				}
+			}
+		}
+		for (size_t i = 0; i < records.size(); i++) {
+			LogRecord &record = records[i];
+			bytes_read += record.length;
+			if (!live[i]) {
+				continue;
+			}
+			uint64_t new_pos = out_offset + out_buf.size();
+			out_buf.append(record.data, record.length);
+			if (record.timestamp == 0) {
+				tombstone_bytes += record.length;
 			} else {
-				break;
+				moved.push_back(Moved { record.key, record.pos, new_pos,
+						record.length });
 			}
 		}
+		if (out_buf.size() >= kLogBufferBytes) {
+			ok = ok && writeAll(out_fd, out_buf.data(), out_buf.size(), out_offset);
+			out_offset += out_buf.size();
+			out_buf.clear();
+		}
+	}) && ok;
+	ok = ok && writeAll(out_fd, out_buf.data(), out_buf.size(), out_offset);
+	out_offset += out_buf.size();
+	bool drop_file = ok && out_offset == 0;
+	if (drop_file) {
+		::close(out_fd);
+		out_fd = -1;
+		remove(tmp_name.c_str());
+		ok = remove(file.m_file_name.c_str()) == 0;
+	} else {
+		ok = ok && fsync(out_fd) == 0;
+		ok = ok && rename(tmp_name.c_str(), file.m_file_name.c_str()) == 0;
+	}
+	if (!ok) {
+		if (out_fd >= 0) {
+			::close(out_fd);
+		}
+		remove(tmp_name.c_str());
+		return false;
+	}
 
-
-
-		//     ; 更新m_keydir
-		//     m_keydir[log.key].value位置= new_value_pos
-		//     m_keydir[log.key].file_id= new_file_id
-		auto found_key = m_keydir.find(entry.key);
-		if (found_key != m_keydir.end()) {
-			found_key->second.value_pos = file_offset;
-			found_key->second.file_id = m_cur_file.m_fd;
-			found_key->second.timestamp = timestamp;
-		} else {
-			MemoryValueObject memory_value_object;
-			memory_value_object.file_id = m_cur_file.m_fd;
-			memory_value_object.value_length = data_buf_size;
-			memory_value_object.timestamp = timestamp;
-			memory_value_object.value_pos = file_offset;
-			m_keydir.insert(make_pair(entry.key, memory_value_object));
-//			m_value_count++;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_file_stats.erase(file.m_fd);
+	if (drop_file) {
+		m_file_list.erase(
+				std::remove_if(m_file_list.begin(), m_file_list.end(),
+						[&file](const CFile &f) {
+							return f.m_fd == file.m_fd;
+						}), m_file_list.end());
+		m_compaction_stats.deleted_files++;
+	} else {
+		FileStats out_stats;
+		out_stats.live_bytes = tombstone_bytes;
+		out_stats.tombstone_bytes = tombstone_bytes;
+		for (auto &m : moved) {
+			KeyDirEntry *found = m_keydir.find(m.key);
+			if (found != nullptr && (int) found->file_id == file.m_fd
+					&& found->value_pos == m.old_pos) {
+				found->file_id = out_fd;
+				found->value_pos = m.new_pos;
+				out_stats.live_bytes += m.length;
+			} else {
+				// compaction期间被覆盖或删除
+				out_stats.dead_bytes += m.length;
+			}
 		}
+		m_file_stats[out_fd] = out_stats;
+		for (auto &f : m_file_list) {
+			if (f.m_fd == file.m_fd) {
+				f.m_fd = out_fd;
+			}
+		}
+	}
+	::close(file.m_fd);
+
+	m_compaction_stats.compacted_files++;
+	m_compaction_stats.bytes_read += bytes_read;
+	m_compaction_stats.bytes_written += out_offset;
+	m_compaction_stats.micros += std::chrono::duration_cast<
+			std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	return true;
+}
 
-		m_offset.fetch_add(data_buf_size);
+void KvStore::compactionLoop() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stop) {
+		m_compaction_cv.wait(lock, [this] {
+			return m_stop || m_compaction_pending;
+		});
+		if (m_stop) {
+			break;
+		}
+		m_compaction_pending = false;
+		lock.unlock();
+		compaction();
+		lock.lock();
+	}
+}
 
+map<string, FileStats> KvStore::fileStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	map<string, FileStats> result;
+	for (auto file : m_file_list) {
+		result[file.m_file_name] = m_file_stats[file.m_fd];
 	}
+	return result;
+}
 
+CompactionStats KvStore::compactionStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_compaction_stats;
+}
 
+KeyDirMemory KvStore::keyDirMemory() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_keydir.memoryUsage();
+}
 
-	// !? 删除旧文件 关闭m_file_list对应项
-	for (auto file : m_file_list) {
-//		if (file.m_fd != m_cur_file.m_fd) {
-//			::close(file.m_fd);
-//			remove(file.m_file_name.c_str());
-//		}
-		::close(file.m_fd);
-		remove(file.m_file_name.c_str());
+void KvStore::printStats() {
+	for (auto &item : fileStats()) {
+		cout << "[KvStore::printStats] file:" << item.first << " live_bytes:"
+				<< item.second.live_bytes << " dead_bytes:"
+				<< item.second.dead_bytes << endl;
 	}
-	m_file_list.clear();
-	m_file_list.push_back(m_cur_file);
-
+	CompactionStats stats = compactionStats();
+	double seconds = stats.micros / 1e6;
+	cout << "[KvStore::printStats] compacted_files:" << stats.compacted_files
+			<< " deleted_files:" << stats.deleted_files << " bytes_read:" << stats.bytes_read << " bytes_written:"
+			<< stats.bytes_written << " MB/s:"
+			<< (seconds > 0 ? stats.bytes_read / seconds / (1 << 20) : 0)
+			<< endl;
+	KeyDirMemory memory = keyDirMemory();
+	cout << "[KvStore::printStats] keydir keys:" << memory.keys
+			<< " slot_bytes:" << memory.slot_bytes << " record_bytes:"
+			<< memory.record_bytes << " key_bytes:"
+			<< memory.key_bytes << " dead_key_bytes:" << memory.dead_key_bytes
+			<< " bytes_per_key:"
+			<< (memory.keys > 0 ? memory.total_bytes / memory.keys : 0) << endl;
 }
 
-void KvStore::readLogEntry(CFile file, vector<DiskValueObject> &result) {
+bool KvStore::scanLogFile(CFile file,
+		const std::function<void(vector<LogRecord>&)> &on_records) {
 	// 读取数据长度
 	// 读取数据
 	// 移动下一个偏移 >>读取数据长度
+	// 每次读取一大块, 解析其中完整的记录, 不完整的记录留到下一块
+	vector<char> buf(kLogBufferBytes);
+	vector<LogRecord> records;
+	uint64_t file_offset = 0;
+	while (true) {
+		ssize_t n = pread(file.m_fd, buf.data(), buf.size(), file_offset);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (n == 0) {
+			return true;
+		}
 
-	// 读取数据长度
-	int file_offset = 0;
-	char data_size_buf[sizeof(uint32_t)];
-	int n_char = 0;
-	while ((n_char = pread(file.m_fd, data_size_buf, sizeof(uint32_t),
-			file_offset)) && n_char > 0) {
-		int offset = 0;
-		uint32_t data_size;
-		memcpy(&data_size, data_size_buf, sizeof(uint32_t));
-		char data_buf[data_size];
-		pread(file.m_fd, data_buf, data_size, file_offset);
-		offset += sizeof(uint32_t);
-
-		// 读取数据
-		// int data_size;
-		// memcpy(&data_size, data_buf+pos, sizeof(int));
-		// offset+=sizeof(int);
-		uint32_t timestamp;
-//        char timestamp_buf[sizeof(int)];
-		memcpy(&timestamp, data_buf + offset, sizeof(uint32_t));
-//        timestamp= atoi(timestamp_buf);
-		offset += sizeof(uint32_t);
-		uint32_t key_size;
-//        char key_size_buf[sizeof(uint32_t)];
-		memcpy(&key_size, data_buf + offset, sizeof(uint32_t));
-//        key_size= atoi(key_size_buf);
-		offset += sizeof(uint32_t);
-		// std::shared_ptr<char> key_buf(new char);
-		// memcpy(key_buf, data_buf+pos, key_size);
-		string key_buf = string(data_buf + offset, key_size);
-		offset += key_size;
-		uint32_t value_size;
-//        char value_size_buf[sizeof(uint32_t)];
-		memcpy(&value_size, data_buf + offset, sizeof(uint32_t));
-//        value_size=atoi(value_size_buf);
-		offset += sizeof(uint32_t);
-		// std::shared_ptr<char> value_buf(new char);
-		// memcpy(value_buf, data_buf+pos, value_size);
-		string value_buf = string(data_buf + offset, value_size);
-		offset += value_size;
-
-		DiskValueObject disk_value_object;
-		disk_value_object.timestamp = timestamp;
-		disk_value_object.key_length = key_size;
-		disk_value_object.key = key_buf;
-		disk_value_object.value_length = value_size;
-		disk_value_object.value = value_buf;
-		disk_value_object.data_length = offset;
-		result.push_back(disk_value_object);
-
-		file_offset += data_size;
+		records.clear();
+		size_t used = 0;
+		while (used + sizeof(uint32_t) <= (size_t) n) {
+			uint32_t data_size;
+			memcpy(&data_size, buf.data() + used, sizeof(uint32_t));
+			if (data_size < 4 * sizeof(uint32_t)) {
+				// 损坏的记录
+				return false;
+			}
+			if (used + data_size > (size_t) n) {
+				break;
+			}
+			const char *data = buf.data() + used;
+			LogRecord record;
+			record.pos = file_offset + used;
+			record.length = data_size;
+			memcpy(&record.timestamp, data + sizeof(uint32_t), sizeof(uint32_t));
+			uint32_t key_size;
+			memcpy(&key_size, data + 2 * sizeof(uint32_t), sizeof(uint32_t));
+			record.key = string(data + 3 * sizeof(uint32_t), key_size);
+			record.data = data;
+			records.push_back(record);
+			used += data_size;
+		}
+
+		if (used == 0) {
+			if ((size_t) n < buf.size()) {
+				// 文件末尾不完整的记录
+				return true;
+			}
+			// 记录比缓冲区大
+			buf.resize(buf.size() * 2);
+			continue;
+		}
+		on_records(records);
+		file_offset += used;
 	}
+}
 
+void KvStore::readLogEntry(CFile file, vector<DiskValueObject> &result) {
+	scanLogFile(file, [&result](vector<LogRecord> &records) {
+		for (auto &record : records) {
+			uint32_t key_size = record.key.size();
+			const char *value_data = record.data + 3 * sizeof(uint32_t)
+					+ key_size;
+			uint32_t value_size;
+			memcpy(&value_size, value_data, sizeof(uint32_t));
+
+			DiskValueObject disk_value_object;
+			disk_value_object.timestamp = record.timestamp;
+			disk_value_object.key_length = key_size;
+			disk_value_object.key = record.key;
+			disk_value_object.value_length = value_size;
+			disk_value_object.value = string(value_data + sizeof(uint32_t),
+					value_size);
+			disk_value_object.data_length = record.length;
+			result.push_back(disk_value_object);
+		}
+	});
 }
 
 void KvStore::recover() {
@@ -739,79 +722,62 @@ void KvStore::recover() {
 //					m_keydir删除
 //				-时间戳不为0
 //					更新m_keydir
+//	; 根据m_keydir统计每个文件的存活/死数据
 	vector < string > filename_list;
 	getAllFilenameFromPath(m_data_dir, filename_list);
+	std::sort(filename_list.begin(), filename_list.end());
+	// key -> (file_id, 长度) 最后一个删除标记
+	map<string, pair<int, uint32_t> > tombstones;
+	map<int, uint64_t> file_bytes;
 	for (auto filename : filename_list) {
-
-		std::size_t found = filename.find("KvStore_");
-		if (found != string::npos) {
-//			cout << "[recover] recover file:" << filename << endl;
-			//		data_file= open(fd)
-			//		m_fd_list.add(fd)
-			string fullpath_filename = m_data_dir + filename;
-			int file_id = ::open(fullpath_filename.c_str(),
-					O_RDWR | O_CREAT | O_APPEND, 0645);
-			CFile file;
-			file.m_file_name = fullpath_filename;
-			file.m_fd = file_id;
-			m_file_list.push_back(file);
-
-			vector<DiskValueObject> entryList;
-			readLogEntry(file, entryList);
-			int offset = 0;
-			for (auto entry : entryList) {
-//				cout << "[recover] read entry" << endl;
-//				entry.print();
-				auto foundKey = m_keydir.find(entry.key);
-				if (foundKey == m_keydir.end()) {
-					//			-key不在m_keydir存在
-					//				-时间戳为0
-					//				-时间戳不为0
-					//					添加入m_keydir
-					if (foundKey->second.timestamp == 0) {
-
-					} else {
-						MemoryValueObject memory_value_object;
-						memory_value_object.file_id = file_id;
-						memory_value_object.value_length = entry.data_length;
-						memory_value_object.timestamp = entry.timestamp;
-						memory_value_object.value_pos = offset;
-//						cout << "[recover] key不在m_keydir 添加key" << endl;
-//						memory_value_object.print();
-						m_keydir.insert(
-								make_pair(entry.key, memory_value_object));
-//						m_value_count++;
-					}
-				} else {
-					//			-key在m_keydir存在
-					//				-时间戳为0
-					//					m_keydir删除
-					//				-时间戳不为0
-					//					更新m_keydir
-					if (entry.timestamp == 0) {
-//						cout << "key在m_keydir存在 时间戳为0 删除key" << entry.key
-//								<< endl;
-						m_keydir.erase(entry.key);
-					} else {
-//						cout << "key在m_keydir存在 时间戳不为0 更新key" << entry.key
-//								<< endl;
-						MemoryValueObject memory_value_object;
-						memory_value_object.file_id = file_id;
-						memory_value_object.value_length = entry.data_length;
-						memory_value_object.timestamp = entry.timestamp;
-						memory_value_object.value_pos = offset;
-						//memory_value_object.print();
-						foundKey->second = memory_value_object;
-//						m_keydir.insert(make_pair(foundKey->first, memory_value_object));
-//						m_value_count++;
-					}
-
+		string fullpath_filename = m_data_dir + filename;
+		if (endsWith(filename, ".compacting")) {
+			// compaction中途退出留下的文件
+			remove(fullpath_filename.c_str());
+			continue;
+		}
+		if (filename.find("KvStore_") == string::npos
+				|| !endsWith(filename, ".log")) {
+			continue;
+		}
+		int file_id = ::open(fullpath_filename.c_str(),
+				O_RDWR | O_CREAT | O_APPEND, 0645);
+		CFile file;
+		file.m_file_name = fullpath_filename;
+		file.m_fd = file_id;
+		m_file_list.push_back(file);
+
+		scanLogFile(file, [&](vector<LogRecord> &records) {
+			for (auto &entry : records) {
+				file_bytes[file_id] += entry.length;
+				if (entry.timestamp == 0) {
+					m_keydir.erase(entry.key);
+					tombstones[entry.key] = make_pair(file_id, entry.length);
+					continue;
 				}
-				offset += entry.data_length;
-
+				KeyDirEntry keydir_entry;
+				keydir_entry.file_id = file_id;
+				keydir_entry.value_length = entry.length;
+				keydir_entry.timestamp = entry.timestamp;
+				keydir_entry.value_pos = entry.pos;
+				m_keydir.set(entry.key, keydir_entry);
 			}
-		}
+		});
+	}
 
+	m_keydir.forEach([this](const char*, uint32_t, KeyDirEntry &entry) {
+		m_file_stats[entry.file_id].live_bytes += entry.value_length;
+	});
+	for (auto &item : tombstones) {
+		if (m_keydir.find(item.first) == nullptr) {
+			FileStats &stats = m_file_stats[item.second.first];
+			stats.live_bytes += item.second.second;
+			stats.tombstone_bytes += item.second.second;
+		}
+	}
+	for (auto &item : file_bytes) {
+		FileStats &stats = m_file_stats[item.first];
+		stats.dead_bytes = item.second - stats.live_bytes;
 	}
 }
 
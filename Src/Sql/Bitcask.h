@@ -45,6 +45,14 @@ recover()
 // generate_n
 #include <algorithm>
 
+// 后台compaction
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "KeyDir.h"
+
 using namespace std;
 
 std::string random_string(size_t length);
@@ -63,24 +71,47 @@ public:
 	string value;
 };
 
-class MemoryValueObject {
+class CFile {
 public:
-	void print();
+	int m_fd;
+	string m_file_name;
+};
 
-	int file_id;
-	int value_pos;
-	int timestamp;
-	int key_length;
-	int value_length;
+// 日志中的一条记录, data指向读缓冲区, 只在回调期间有效
+class LogRecord {
+public:
+	uint64_t pos; // 记录在文件中的偏移
+	uint32_t length; // 整条记录的长度
+	uint32_t timestamp; // 0表示删除标记
 	string key;
-	string value;
+	const char *data;
 };
 
+// 单个日志文件的存活/死数据字节数
+class FileStats {
+public:
+	FileStats() :
+			live_bytes(0), dead_bytes(0), tombstone_bytes(0) {
+	}
 
-class CFile {
+	uint64_t live_bytes;
+	uint64_t dead_bytes;
+	// live_bytes中删除标记的字节数, 最旧文件中的删除标记不再需要
+	uint64_t tombstone_bytes;
+};
+
+// 累计的compaction统计
+class CompactionStats {
 public:
-	int m_fd;
-	string m_file_name;
+	CompactionStats() :
+			compacted_files(0), deleted_files(0), bytes_read(0), bytes_written(0), micros(0) {
+	}
+
+	uint64_t compacted_files;
+	uint64_t deleted_files; // 压缩后没有记录留下而被删除的文件
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	uint64_t micros;
 };
 
 class KvStore {
@@ -91,20 +122,34 @@ public:
 	int set_no_compaction(string key, string value);
 	int get(string key, string &value);
 	int rm(string key);
+	// 压缩所有死数据比例超过m_compaction_dead_ratio的非活跃文件, 返回压缩的文件数
 	int compaction();
 	void recover();
 	void readLogEntry(CFile file, vector<DiskValueObject> &result);
+	// 以大块顺序读遍历日志文件, 每读一块回调一次
+	bool scanLogFile(CFile file,
+			const std::function<void(vector<LogRecord>&)> &on_records);
+	// key: 文件名
+	map<string, FileStats> fileStats();
+	CompactionStats compactionStats();
+	// 内存索引占用
+	KeyDirMemory keyDirMemory();
+	void printStats();
 	KvStore() {
 		m_data_dir = "./KvStore/";
+		m_max_file_bytes = 4 << 20;
+		m_compaction_dead_ratio = 0.5;
+		m_compaction_pending = false;
+		m_stop = false;
 	}
 	;
 	~KvStore() {
 		// m_cur_file.close();
-
+		stopCompactionThread();
 	}
 	;
 //private:
-	map<string, MemoryValueObject> m_keydir;
+	KeyDir m_keydir;
 	// char* m_cur_filename;// 文件名称 >> m_cur_file
 	// ofstream m_cur_file;
 	vector<CFile> m_file_list;
@@ -113,4 +158,33 @@ public:
 	// int m_fd; // 文件句柄 >> m_cur_file
 	int m_value_count;
 	std::atomic<uint64_t> m_offset;
+
+	// 当前日志文件超过该大小后切换到新文件, 旧文件才能被compaction
+	uint64_t m_max_file_bytes;
+	// 死数据比例超过该值的文件会被compaction
+	double m_compaction_dead_ratio;
+
+	// 保护m_keydir m_file_list m_cur_file m_file_stats
+	std::mutex m_mutex;
+	// key: file_id
+	map<int, FileStats> m_file_stats;
+	CompactionStats m_compaction_stats;
+
+	// 后台线程和compaction()的调用者同一时间只有一个在压缩
+	std::mutex m_compaction_mutex;
+	std::thread m_compaction_thread;
+	std::condition_variable m_compaction_cv;
+	bool m_compaction_pending;
+	bool m_stop;
+
+private:
+	// 需持有m_mutex
+	bool appendRecord(const string &record, uint64_t *file_offset);
+	void markDead(const KeyDirEntry &object);
+	int put(string key, string value, bool notify_compaction);
+
+	// drop_tombstones: 文件是最旧的日志, 没有更旧的记录需要删除标记屏蔽
+	bool compactFile(CFile file, bool drop_tombstones);
+	void compactionLoop();
+	void stopCompactionThread();
 };
@@ -0,0 +1,240 @@
+#include "KeyDir.h"
+
+#include <cstring>
+#include <functional>
+
+// 初始槽位数, 必须是2的幂
+static const size_t kInitialCapacity = 16;
+// 已删除的key超过该大小且超过存活key时回收
+static const uint64_t kMinKeyGarbageBytes = 1 << 20;
+
+// key长度用varint编码, 短key只占1字节
+static uint32_t varintLength(uint32_t v) {
+	uint32_t n = 1;
+	while (v >= 128) {
+		v >>= 7;
+		n++;
+	}
+	return n;
+}
+
+static char* encodeVarint(char *p, uint32_t v) {
+	while (v >= 128) {
+		*(p++) = (char) (v | 128);
+		v >>= 7;
+	}
+	*(p++) = (char) v;
+	return p;
+}
+
+static const char* decodeKey(const char *p, uint32_t *key_length) {
+	uint32_t v = 0;
+	for (uint32_t shift = 0;; shift += 7) {
+		uint32_t byte = (unsigned char) *(p++);
+		v |= (byte & 127) << shift;
+		if (byte < 128) {
+			break;
+		}
+	}
+	*key_length = v;
+	return p;
+}
+
+const uint32_t KeyDir::kEmpty;
+
+KeyDir::KeyDir(uint32_t key_block_bytes) :
+		m_key_block_bytes(key_block_bytes) {
+	clear();
+}
+
+void KeyDir::clear() {
+	m_slots.assign(kInitialCapacity, kEmpty);
+	m_mask = kInitialCapacity - 1;
+	m_size = 0;
+	m_records.clear();
+	m_key_blocks.clear();
+	m_key_block_sizes.clear();
+	m_key_block_used = 0;
+	m_key_bytes = 0;
+	m_dead_key_bytes = 0;
+}
+
+uint32_t KeyDir::hashKey(const string &key) {
+	uint64_t h = std::hash<string>()(key);
+	return (uint32_t) (h ^ (h >> 32));
+}
+
+const char* KeyDir::keyAt(uint64_t key_ref, uint32_t *key_length) const {
+	const char *block = m_key_blocks[key_ref >> kKeyBlockShift].get();
+	return decodeKey(block + (key_ref & ((1 << kKeyBlockShift) - 1)),
+			key_length);
+}
+
+uint64_t KeyDir::internKey(const string &key) {
+	uint32_t bytes = varintLength(key.size()) + key.size();
+	if (m_key_blocks.empty()
+			|| m_key_block_used + bytes > m_key_block_sizes.back()) {
+		// 超过块大小的key单独占一块
+		uint32_t block_bytes =
+				bytes > m_key_block_bytes ? bytes : m_key_block_bytes;
+		m_key_blocks.push_back(unique_ptr<char[]>(new char[block_bytes]));
+		m_key_block_sizes.push_back(block_bytes);
+		m_key_block_used = 0;
+		m_key_bytes += block_bytes;
+	}
+	uint64_t key_ref = ((uint64_t) (m_key_blocks.size() - 1) << kKeyBlockShift)
+			| m_key_block_used;
+	char *p = m_key_blocks.back().get() + m_key_block_used;
+	p = encodeVarint(p, key.size());
+	memcpy(p, key.data(), key.size());
+	m_key_block_used += bytes;
+	return key_ref;
+}
+
+size_t KeyDir::probe(uint32_t hash, const string &key) const {
+	size_t i = hash & m_mask;
+	while (m_slots[i] != kEmpty) {
+		const Record &record = recordAt(m_slots[i]);
+		if (record.hash == hash) {
+			uint32_t key_length;
+			const char *data = keyAt(record.key_ref, &key_length);
+			if (key_length == key.size()
+					&& memcmp(data, key.data(), key_length) == 0) {
+				break;
+			}
+		}
+		i = (i + 1) & m_mask;
+	}
+	return i;
+}
+
+size_t KeyDir::slotOf(uint32_t index) const {
+	size_t i = recordAt(index).hash & m_mask;
+	while (m_slots[i] != index) {
+		i = (i + 1) & m_mask;
+	}
+	return i;
+}
+
+KeyDirEntry* KeyDir::find(const string &key) {
+	size_t i = probe(hashKey(key), key);
+	if (m_slots[i] == kEmpty) {
+		return nullptr;
+	}
+	return &recordAt(m_slots[i]).entry;
+}
+
+void KeyDir::set(const string &key, const KeyDirEntry &entry) {
+	uint32_t hash = hashKey(key);
+	size_t i = probe(hash, key);
+	if (m_slots[i] != kEmpty) {
+		recordAt(m_slots[i]).entry = entry;
+		return;
+	}
+
+	// 负载因子不超过0.75
+	if (((size_t) m_size + 1) * 4 > m_slots.size() * 3) {
+		resize(m_slots.size() * 2);
+		i = probe(hash, key);
+	}
+	if (m_size == m_records.size() << kRecordBlockShift) {
+		m_records.push_back(
+				unique_ptr<Record[]>(new Record[1 << kRecordBlockShift]));
+	}
+	Record &record = recordAt(m_size);
+	record.entry = entry;
+	record.key_ref = internKey(key);
+	record.hash = hash;
+	m_slots[i] = m_size;
+	m_size++;
+}
+
+void KeyDir::removeSlot(size_t i) {
+	m_slots[i] = kEmpty;
+	// 把后续探测链上的槽位前移, 填补空位
+	size_t j = i;
+	while (true) {
+		j = (j + 1) & m_mask;
+		if (m_slots[j] == kEmpty) {
+			break;
+		}
+		size_t ideal = recordAt(m_slots[j]).hash & m_mask;
+		if (((j - ideal) & m_mask) >= ((j - i) & m_mask)) {
+			m_slots[i] = m_slots[j];
+			m_slots[j] = kEmpty;
+			i = j;
+		}
+	}
+}
+
+bool KeyDir::erase(const string &key) {
+	size_t i = probe(hashKey(key), key);
+	if (m_slots[i] == kEmpty) {
+		return false;
+	}
+	uint32_t index = m_slots[i];
+	m_dead_key_bytes += varintLength(key.size()) + key.size();
+	removeSlot(i);
+
+	// 最后一条记录移入空位, 记录保持紧凑
+	uint32_t last = m_size - 1;
+	if (index != last) {
+		m_slots[slotOf(last)] = index;
+		recordAt(index) = recordAt(last);
+	}
+	m_size--;
+	if (m_records.size() > 1
+			&& m_size + (1 << kRecordBlockShift)
+					< (m_records.size() - 1) << kRecordBlockShift) {
+		m_records.pop_back();
+	}
+
+	if (m_dead_key_bytes > kMinKeyGarbageBytes
+			&& m_dead_key_bytes > m_key_bytes - m_dead_key_bytes) {
+		compactKeys();
+	}
+	return true;
+}
+
+void KeyDir::resize(size_t capacity) {
+	m_slots.assign(capacity, kEmpty);
+	m_mask = capacity - 1;
+	for (uint32_t index = 0; index < m_size; index++) {
+		size_t i = recordAt(index).hash & m_mask;
+		while (m_slots[i] != kEmpty) {
+			i = (i + 1) & m_mask;
+		}
+		m_slots[i] = index;
+	}
+}
+
+void KeyDir::compactKeys() {
+	vector<unique_ptr<char[]> > old_blocks;
+	old_blocks.swap(m_key_blocks);
+	m_key_block_sizes.clear();
+	m_key_block_used = 0;
+	m_key_bytes = 0;
+	m_dead_key_bytes = 0;
+	for (uint32_t index = 0; index < m_size; index++) {
+		Record &record = recordAt(index);
+		const char *block = old_blocks[record.key_ref >> kKeyBlockShift].get();
+		uint32_t key_length;
+		const char *data = decodeKey(
+				block + (record.key_ref & ((1 << kKeyBlockShift) - 1)),
+				&key_length);
+		record.key_ref = internKey(string(data, key_length));
+	}
+}
+
+KeyDirMemory KeyDir::memoryUsage() const {
+	KeyDirMemory usage;
+	usage.keys = m_size;
+	usage.slot_bytes = m_slots.capacity() * sizeof(uint32_t);
+	usage.record_bytes = (m_records.size() << kRecordBlockShift)
+			* sizeof(Record);
+	usage.key_bytes = m_key_bytes;
+	usage.dead_key_bytes = m_dead_key_bytes;
+	usage.total_bytes = sizeof(*this) + usage.slot_bytes + usage.record_bytes
+			+ usage.key_bytes;
+	return usage;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+/*
+KeyDir: key -> (file_id, value_pos, value_length, timestamp)
+
+m_slots: 开放寻址哈希表, 线性探测, 每个槽位只存4字节的记录下标
+m_records: 按插入顺序紧凑存放的记录, 分块分配, 删除时用最后一条记录填补
+m_key_blocks: key只存一份, varint长度 + key, 按64KB块分配
+删除不留删除标记: 后续探测链上的槽位前移
+
+每个key占用: 32字节记录 + key长度和1字节varint + 槽位(负载0.75~0.375时5.3~10.7字节)
+1M个19字节的key实测60字节/key, 见benchmark/Sql/keydir_benchmark.cpp
+*/
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 固定16字节
+class KeyDirEntry {
+public:
+	uint32_t file_id;
+	uint32_t value_pos;
+	uint32_t value_length; // 整条记录的长度
+	uint32_t timestamp;
+};
+
+class KeyDirMemory {
+public:
+	uint64_t keys; // key个数
+	uint64_t slot_bytes; // 哈希表槽位
+	uint64_t record_bytes; // 记录
+	uint64_t key_bytes; // key块(含已删除的key)
+	uint64_t dead_key_bytes; // 已删除未回收的key
+	uint64_t total_bytes;
+};
+
+class KeyDir {
+public:
+	// key块大小, 不能超过1 << kKeyBlockShift
+	explicit KeyDir(uint32_t key_block_bytes = 1 << kKeyBlockShift);
+
+	// 返回指向条目的指针, 下一次set/erase之前有效
+	KeyDirEntry* find(const string &key);
+	// 插入或覆盖
+	void set(const string &key, const KeyDirEntry &entry);
+	bool erase(const string &key);
+	void clear();
+
+	size_t size() const {
+		return m_size;
+	}
+
+	KeyDirMemory memoryUsage() const;
+
+	// fn(const char* key, uint32_t key_length, KeyDirEntry& entry)
+	template<class Fn>
+	void forEach(Fn fn) {
+		for (uint32_t i = 0; i < m_size; i++) {
+			Record &record = recordAt(i);
+			uint32_t key_length;
+			const char *key = keyAt(record.key_ref, &key_length);
+			fn(key, key_length, record.entry);
+		}
+	}
+
+private:
+	static const uint32_t kEmpty = UINT32_MAX;
+	static const uint32_t kRecordBlockShift = 10;
+	static const uint32_t kKeyBlockShift = 16;
+
+	class Record {
+	public:
+		KeyDirEntry entry;
+		uint64_t key_ref; // 块号 << kKeyBlockShift | 块内偏移, 块数不受32位限制
+		uint32_t hash;
+	};
+
+	static uint32_t hashKey(const string &key);
+
+	Record& recordAt(uint32_t index) const {
+		return m_records[index >> kRecordBlockShift][index
+				& ((1 << kRecordBlockShift) - 1)];
+	}
+	const char* keyAt(uint64_t key_ref, uint32_t *key_length) const;
+	uint64_t internKey(const string &key);
+
+	// 返回key所在或应插入的槽位
+	size_t probe(uint32_t hash, const string &key) const;
+	// 返回指向记录index的槽位
+	size_t slotOf(uint32_t index) const;
+	void removeSlot(size_t i);
+	void resize(size_t capacity);
+	// 回收已删除的key占用的空间
+	void compactKeys();
+
+	vector<uint32_t> m_slots;
+	size_t m_mask;
+	uint32_t m_size;
+	vector<unique_ptr<Record[]> > m_records;
+	const uint32_t m_key_block_bytes;
+	vector<unique_ptr<char[]> > m_key_blocks;
+	vector<uint32_t> m_key_block_sizes;
+	uint32_t m_key_block_used; // 最后一个key块已使用的字节数
+	uint64_t m_key_bytes;
+	uint64_t m_dead_key_bytes;
+};
@@ -4,6 +4,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <span>
 #include <string>
 
 namespace leanstore {
@@ -142,6 +143,7 @@ using ValCallback = std::function<void(Slice val)>;
 using MutValCallback = std::function<void(MutableSlice val)>;
 using ScanCallback = std::function<bool(Slice key, Slice val)>;
 using PrefixLookupCallback = std::function<void(Slice key, Slice val)>;
+using MultiValCallback = std::function<void(uint64_t idx, Slice val)>;
 
 class KVInterface {
 public:
@@ -162,6 +164,23 @@ public:
 
   virtual OpCode Lookup(Slice key, ValCallback valCallback) = 0;
 
+  //! Looks up a batch of keys, the value of keys[i] is passed to valCallback together with i, the
+  //! result of keys[i] is stored in results[i].
+  virtual void MultiLookup(std::span<const Slice> keys, MultiValCallback valCallback,
+                           std::span<OpCode> results) {
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      results[i] = Lookup(keys[i], [&](Slice val) { valCallback(i, val); });
+    }
+  }
+
+  //! Inserts a batch of key-value pairs, the result of keys[i] is stored in results[i].
+  virtual void MultiInsert(std::span<const Slice> keys, std::span<const Slice> vals,
+                           std::span<OpCode> results) {
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      results[i] = Insert(keys[i], vals[i]);
+    }
+  }
+
   virtual OpCode PrefixLookup(Slice, PrefixLookupCallback) = 0;
 
   virtual OpCode PrefixLookupForPrev(Slice, PrefixLookupCallback) = 0;
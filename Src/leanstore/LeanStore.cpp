@@ -20,6 +20,7 @@
 #include <rapidjson/stringbuffer.h>
 #include <tabulate/table.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <expected>
 #include <filesystem>
@@ -28,6 +29,7 @@
 #include <iostream>
 #include <memory>
 
+#include <fcntl.h>
 #include <linux/fs.h>
 #include <resolv.h>
 #include <stdio.h>
@@ -86,14 +88,23 @@ LeanStore::LeanStore(StoreOption* option) : mStoreOption(option) {
       Log::Info("All pages up-to-date, skip resovering");
       // TODO: truncate wal files
     }
+
+    // pages are modified from now on, a crash before the next checkpoint recovers from the WAL
+    SerializeCheckpointLsn(mBufferManager->mCheckpointLsns);
   }
+
+  // flush dirty pages in the background after recovery
+  mBufferManager->StartCheckpointer();
 }
 
 void LeanStore::initPageAndWalFd() {
   SCOPED_DEFER({
     LS_DCHECK(fcntl(mPageFd, F_GETFL) != -1);
-    LS_DCHECK(fcntl(mWalFd, F_GETFL) != -1);
+    for (auto walFd [[maybe_unused]] : mWalFds) {
+      LS_DCHECK(fcntl(walFd, F_GETFL) != -1);
+    }
   });
+  const uint64_t numWalFiles = std::max<uint64_t>(mStoreOption->mNumWalFiles, 1);
 
   // Create a new instance on the specified DB file
   if (mStoreOption->mCreateFromScratch) {
@@ -106,12 +117,15 @@ void LeanStore::initPageAndWalFd() {
     }
     Log::Info("Init page fd succeed, pageFd={}, pageFile={}", mPageFd, dbFilePath);
 
-    auto walFilePath = GetWalFilePath();
-    mWalFd = open(walFilePath.c_str(), flags, 0666);
-    if (mWalFd == -1) {
-      Log::Fatal("Could not open file at: {}", walFilePath);
+    for (uint64_t walId = 0; walId < numWalFiles; walId++) {
+      auto walFilePath = GetWalFilePath(walId);
+      auto walFd = open(walFilePath.c_str(), flags, 0666);
+      if (walFd == -1) {
+        Log::Fatal("Could not open file at: {}", walFilePath);
+      }
+      mWalFds.push_back(walFd);
+      Log::Info("Init wal fd succeed, walFd={}, walFile={}", walFd, walFilePath);
     }
-    Log::Info("Init wal fd succeed, walFd={}, walFile={}", mWalFd, walFilePath);
     return;
   }
 
@@ -128,14 +142,17 @@ void LeanStore::initPageAndWalFd() {
   }
   Log::Info("Init page fd succeed, pageFd={}, pageFile={}", mPageFd, dbFilePath);
 
-  auto walFilePath = GetWalFilePath();
-  mWalFd = open(walFilePath.c_str(), flags, 0666);
-  if (mWalFd == -1) {
-    Log::Fatal("Recover failed, could not open file at: {}. The data is lost, "
-               "please create a new WAL file and start a new instance from it",
-               walFilePath);
+  for (uint64_t walId = 0; walId < numWalFiles; walId++) {
+    auto walFilePath = GetWalFilePath(walId);
+    auto walFd = open(walFilePath.c_str(), flags, 0666);
+    if (walFd == -1) {
+      Log::Fatal("Recover failed, could not open file at: {}. The data is lost, "
+                 "please create a new WAL file and start a new instance from it",
+                 walFilePath);
+    }
+    mWalFds.push_back(walFd);
+    Log::Info("Init wal fd succeed, walFd={}, walFile={}", walFd, walFilePath);
   }
-  Log::Info("Init wal fd succeed, walFd={}, walFile={}", mWalFd, walFilePath);
 }
 
 LeanStore::~LeanStore() {
@@ -186,17 +203,17 @@ LeanStore::~LeanStore() {
     Log::Info("Page file closed");
   }
 
-  {
-    auto walFilePath = GetWalFilePath();
+  for (uint64_t walId = 0; walId < mWalFds.size(); walId++) {
+    auto walFilePath = GetWalFilePath(walId);
     struct stat st;
     if (stat(walFilePath.c_str(), &st) == 0) {
       LS_DLOG("The size of {} is {} bytes", walFilePath, st.st_size);
     }
-  }
-  if (close(mWalFd) == -1) {
-    perror("Failed to close WAL file: ");
-  } else {
-    Log::Info("WAL file closed");
+    if (close(mWalFds[walId]) == -1) {
+      perror("Failed to close WAL file: ");
+    } else {
+      Log::Info("WAL file closed, walFile={}", walFilePath);
+    }
   }
 }
 
@@ -219,6 +236,14 @@ void LeanStore::WaitAll() {
   }
 }
 
+void LeanStore::ExecQueued(uint64_t workerId, std::function<void()> job) {
+  mCRManager->mWorkerThreads[workerId]->AddJob(std::move(job));
+}
+
+void LeanStore::WaitQueued(WORKERID workerId) {
+  mCRManager->mWorkerThreads[workerId]->WaitJobs();
+}
+
 constexpr char kMetaKeyCrManager[] = "cr_manager";
 constexpr char kMetaKeyBufferManager[] = "buffer_manager";
 constexpr char kMetaKeyBTrees[] = "leanstore/btrees";
@@ -320,6 +345,96 @@ void LeanStore::serializeMeta(bool allPagesUpToDate) {
   metaFile << sb.GetString();
 }
 
+void LeanStore::SerializeCheckpointLsn(const std::vector<uint64_t>& checkpointLsns) {
+  auto checkpointLsn = utils::JoinNumbers(checkpointLsns);
+  std::ifstream metaFile;
+  metaFile.open(GetMetaFilePath());
+  if (!metaFile.is_open()) {
+    LS_DLOG("No meta file to update, checkpointLsn={}", checkpointLsn);
+    return;
+  }
+  rapidjson::IStreamWrapper isw(metaFile);
+  rapidjson::Document doc;
+  doc.ParseStream(isw);
+  metaFile.close();
+  if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember(kMetaKeyBufferManager)) {
+    Log::Warn("Failed to parse meta file, skip updating checkpointLsn={}", checkpointLsn);
+    return;
+  }
+
+  auto& allocator = doc.GetAllocator();
+  auto& bmJsonObj = doc[kMetaKeyBufferManager];
+  rapidjson::Value v;
+  v.SetString(checkpointLsn.data(), checkpointLsn.size(), allocator);
+  if (bmJsonObj.HasMember("checkpoint_lsn")) {
+    bmJsonObj["checkpoint_lsn"] = v;
+  } else {
+    bmJsonObj.AddMember("checkpoint_lsn", v, allocator);
+  }
+
+  // the store is running, pages are not up-to-date, the WAL has grown at least to the checkpoint
+  if (doc.HasMember("pages_up_to_date")) {
+    doc["pages_up_to_date"] = false;
+  }
+  if (doc.HasMember(kMetaKeyCrManager) && doc[kMetaKeyCrManager].HasMember("wal_size")) {
+    auto& walSizeObj = doc[kMetaKeyCrManager]["wal_size"];
+    auto walSizes = utils::SplitNumbers(walSizeObj.GetString());
+    walSizes.resize(std::max(walSizes.size(), checkpointLsns.size()), 0);
+    for (uint64_t walId = 0; walId < checkpointLsns.size(); walId++) {
+      walSizes[walId] = std::max(walSizes[walId], checkpointLsns[walId]);
+    }
+    auto walSize = utils::JoinNumbers(walSizes);
+    walSizeObj.SetString(walSize.data(), walSize.size(), allocator);
+  }
+
+  // write to a tmp file and rename, the meta file is never partially written. The tmp file is
+  // synced before the rename, the directory after it, the checkpoint LSN is durable once returned
+  rapidjson::StringBuffer sb;
+  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(sb);
+  doc.Accept(writer);
+  auto tmpFilePath = GetMetaFilePath() + ".tmp";
+  auto fd = open(tmpFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    Log::Error("Failed to open tmp meta file, checkpointLsn={}, errno={}", checkpointLsn, errno);
+    return;
+  }
+  const char* data = sb.GetString();
+  uint64_t bytesLeft = sb.GetSize();
+  while (bytesLeft > 0) {
+    auto bytesWritten = write(fd, data, bytesLeft);
+    if (bytesWritten < 0 && errno == EINTR) {
+      continue;
+    }
+    if (bytesWritten < 0) {
+      Log::Error("Failed to write tmp meta file, checkpointLsn={}, errno={}", checkpointLsn, errno);
+      close(fd);
+      return;
+    }
+    data += bytesWritten;
+    bytesLeft -= bytesWritten;
+  }
+  if (fsync(fd) != 0) {
+    Log::Error("Failed to sync tmp meta file, checkpointLsn={}, errno={}", checkpointLsn, errno);
+    close(fd);
+    return;
+  }
+  close(fd);
+
+  if (rename(tmpFilePath.c_str(), GetMetaFilePath().c_str()) != 0) {
+    Log::Error("Failed to update meta file, checkpointLsn={}, errno={}", checkpointLsn, errno);
+    return;
+  }
+  auto dirPath = std::filesystem::path(GetMetaFilePath()).parent_path();
+  auto dirFd = open(dirPath.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dirFd < 0 || fsync(dirFd) != 0) {
+    Log::Error("Failed to sync meta file directory, checkpointLsn={}, errno={}", checkpointLsn,
+               errno);
+  }
+  if (dirFd >= 0) {
+    close(dirFd);
+  }
+}
+
 void LeanStore::serializeFlags(uint8_t* dest) {
   rapidjson::Document& doc = *reinterpret_cast<rapidjson::Document*>(dest);
   Log::Info("serializeFlags started");
@@ -11,6 +11,7 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
 
 //! forward declarations
 namespace leanstore::storage::btree {
@@ -52,8 +53,9 @@ public:
   //! The file descriptor for pages
   int32_t mPageFd;
 
-  //! The file descriptor for write-ahead log
-  int32_t mWalFd;
+  //! The file descriptors for write-ahead log, one for each WAL file, see
+  //! StoreOption::mNumWalFiles.
+  std::vector<int32_t> mWalFds;
 
   //! The tree registry
   std::unique_ptr<storage::TreeRegistry> mTreeRegistry;
@@ -136,6 +138,19 @@ public:
   //! Waits for all Workers to complete.
   void WaitAll();
 
+  //! Queue a custom user function to a worker thread without waiting for the previous ones. Up to
+  //! StoreOption::mJobsPerWorker queued functions are interleaved on the worker thread, a function
+  //! waiting for a page read is parked meanwhile.
+  void ExecQueued(uint64_t workerId, std::function<void()> fn);
+
+  //! Waits for all the functions queued to the worker to complete.
+  void WaitQueued(WORKERID workerId);
+
+  //! Updates the checkpoint LSNs, one for each WAL file, in the meta file written by the last
+  //! shutdown, so that recovery after a crash starts from them. The pages are marked as not
+  //! up-to-date. Called by the fuzzy checkpointer, and when an existing store is opened.
+  void SerializeCheckpointLsn(const std::vector<uint64_t>& checkpointLsns);
+
   std::string GetMetaFilePath() const {
     return std::string(mStoreOption->mStoreDir) + "/db.meta.json";
   }
@@ -144,8 +159,10 @@ public:
     return std::string(mStoreOption->mStoreDir) + "/db.pages";
   }
 
-  std::string GetWalFilePath() const {
-    return std::string(mStoreOption->mStoreDir) + "/db.wal";
+  //! The first WAL file is db.wal, the others are db.wal.1, db.wal.2, ...
+  std::string GetWalFilePath(uint64_t walId = 0) const {
+    auto walFilePath = std::string(mStoreOption->mStoreDir) + "/db.wal";
+    return walId == 0 ? walFilePath : walFilePath + "." + std::to_string(walId);
   }
 
 private:
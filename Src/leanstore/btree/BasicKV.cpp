@@ -10,7 +10,9 @@
 #include "leanstore/utils/Log.hpp"
 #include "leanstore/utils/Misc.hpp"
 
+#include <algorithm>
 #include <format>
+#include <numeric>
 
 using namespace std;
 using namespace leanstore::storage;
@@ -74,6 +76,88 @@ OpCode BasicKV::Lookup(Slice key, ValCallback valCallback) {
   return lookupPessimistic(std::move(key), std::move(valCallback));
 }
 
+void BasicKV::MultiLookup(std::span<const Slice> keys, MultiValCallback valCallback,
+                          std::span<OpCode> results) {
+  LS_DCHECK(results.size() >= keys.size());
+  multiLookup(
+      keys,
+      [&](uint64_t idx, const Slice* val) {
+        if (val != nullptr) {
+          valCallback(idx, *val);
+          results[idx] = OpCode::kOK;
+        } else {
+          results[idx] = OpCode::kNotFound;
+        }
+        return true;
+      },
+      [&](uint64_t idx) {
+        results[idx] = lookupPessimistic(keys[idx], [&](Slice val) { valCallback(idx, val); });
+      });
+}
+
+std::vector<uint64_t> BasicKV::sortedOrder(std::span<const Slice> keys) {
+  std::vector<uint64_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](uint64_t lhs, uint64_t rhs) { return keys[lhs] < keys[rhs]; });
+  return order;
+}
+
+void BasicKV::multiLookup(std::span<const Slice> keys, const LeafLookupFunc& lookupInLeaf,
+                          const std::function<void(uint64_t idx)>& lookupOne) {
+  auto order = sortedOrder(keys);
+  std::vector<Slice> sortedKeys;
+  sortedKeys.reserve(order.size());
+  for (auto idx : order) {
+    sortedKeys.push_back(keys[idx]);
+  }
+  ReadAheadLeaves(sortedKeys);
+
+  uint64_t pos = 0;
+  while (pos < order.size()) {
+    auto next = lookupInLeafOptimistic(keys, order, pos, lookupInLeaf);
+    if (next == pos) {
+      // the leaf is modified by others, or the key can not be looked up in the leaf
+      lookupOne(order[pos]);
+      next = pos + 1;
+    }
+    pos = next;
+  }
+}
+
+uint64_t BasicKV::lookupInLeafOptimistic(std::span<const Slice> keys,
+                                         const std::vector<uint64_t>& order, uint64_t begin,
+                                         const LeafLookupFunc& lookupInLeaf) {
+  volatile uint64_t next = begin;
+  JUMPMU_TRY() {
+    GuardedBufferFrame<BTreeNode> guardedLeaf;
+    FindLeafCanJump(keys[order[begin]], guardedLeaf, LatchMode::kOptimisticOrJump);
+    for (auto pos = begin; pos < order.size(); pos++) {
+      auto idx = order[pos];
+      if (pos > begin && guardedLeaf->CompareKeyWithBoundaries(keys[idx]) != 0) {
+        break;
+      }
+
+      bool determined = false;
+      auto slotId = guardedLeaf->LowerBound<true>(keys[idx]);
+      if (slotId != -1) {
+        auto val = guardedLeaf->Value(slotId);
+        determined = lookupInLeaf(idx, &val);
+      } else {
+        determined = lookupInLeaf(idx, nullptr);
+      }
+      guardedLeaf.JumpIfModifiedByOthers();
+      if (!determined) {
+        break;
+      }
+      next = pos + 1;
+    }
+  }
+  JUMPMU_CATCH() {
+  }
+  return next;
+}
+
 bool BasicKV::IsRangeEmpty(Slice startKey, Slice endKey) {
   while (true) {
     JUMPMU_TRY() {
@@ -108,6 +192,7 @@ bool BasicKV::IsRangeEmpty(Slice startKey, Slice endKey) {
 OpCode BasicKV::ScanAsc(Slice startKey, ScanCallback callback) {
   JUMPMU_TRY() {
     auto iter = GetIterator();
+    iter.EnableReadAhead(mStore->mStoreOption->mMaxScanReadAheadPages);
     if (iter.SeekToFirstGreaterEqual(startKey); !iter.Valid()) {
       JUMPMU_RETURN OpCode::kNotFound;
     }
@@ -131,6 +216,7 @@ OpCode BasicKV::ScanAsc(Slice startKey, ScanCallback callback) {
 OpCode BasicKV::ScanDesc(Slice scanKey, ScanCallback callback) {
   JUMPMU_TRY() {
     auto iter = GetIterator();
+    iter.EnableReadAhead(mStore->mStoreOption->mMaxScanReadAheadPages);
     if (iter.SeekToLastLessEqual(scanKey); !iter.Valid()) {
       JUMPMU_RETURN OpCode::kNotFound;
     }
@@ -154,26 +240,55 @@ OpCode BasicKV::ScanDesc(Slice scanKey, ScanCallback callback) {
 OpCode BasicKV::Insert(Slice key, Slice val) {
   JUMPMU_TRY() {
     auto xIter = GetExclusiveIterator();
-    auto ret = xIter.InsertKV(key, val);
+    auto ret = insert(xIter, key, val);
+    JUMPMU_RETURN ret;
+  }
+  JUMPMU_CATCH() {
+  }
+  return OpCode::kOK;
+}
 
-    if (ret == OpCode::kDuplicated) {
-      Log::Info("Insert duplicated, workerId={}, key={}, treeId={}",
-                cr::WorkerContext::My().mWorkerId, key.ToString(), mTreeId);
-      JUMPMU_RETURN OpCode::kDuplicated;
+void BasicKV::MultiInsert(std::span<const Slice> keys, std::span<const Slice> vals,
+                          std::span<OpCode> results) {
+  LS_DCHECK(vals.size() >= keys.size() && results.size() >= keys.size());
+  auto order = sortedOrder(keys);
+  volatile uint64_t pos = 0;
+  while (pos < order.size()) {
+    JUMPMU_TRY() {
+      // the iterator stays on the leaf of the last key, it is reused if the next key falls in
+      auto xIter = GetExclusiveIterator();
+      for (; pos < order.size(); pos = pos + 1) {
+        auto idx = order[pos];
+        results[idx] = insert(xIter, keys[idx], vals[idx]);
+      }
     }
-
-    if (ret != OpCode::kOK) {
-      Log::Info("Insert failed, workerId={}, key={}, ret={}", cr::WorkerContext::My().mWorkerId,
-                key.ToString(), ToString(ret));
-      JUMPMU_RETURN ret;
+    JUMPMU_CATCH() {
     }
+  }
+}
 
-    if (mConfig.mEnableWal) {
-      auto walSize = key.length() + val.length();
-      xIter.mGuardedLeaf.WriteWal<WalInsert>(walSize, key, val);
-    }
+std::unique_ptr<BTreeBulkLoader> BasicKV::NewBulkLoader(double fillFactor) {
+  return std::make_unique<BTreeBulkLoader>(*this, fillFactor);
+}
+
+OpCode BasicKV::insert(PessimisticExclusiveIterator& xIter, Slice key, Slice val) {
+  auto ret = xIter.InsertKV(key, val);
+
+  if (ret == OpCode::kDuplicated) {
+    Log::Info("Insert duplicated, workerId={}, key={}, treeId={}",
+              cr::WorkerContext::My().mWorkerId, key.ToString(), mTreeId);
+    return OpCode::kDuplicated;
   }
-  JUMPMU_CATCH() {
+
+  if (ret != OpCode::kOK) {
+    Log::Info("Insert failed, workerId={}, key={}, ret={}", cr::WorkerContext::My().mWorkerId,
+              key.ToString(), ToString(ret));
+    return ret;
+  }
+
+  if (mConfig.mEnableWal) {
+    auto walSize = key.length() + val.length();
+    xIter.mGuardedLeaf.WriteWal<WalInsert>(walSize, key, val);
   }
   return OpCode::kOK;
 }
@@ -1,8 +1,14 @@
 #pragma once
 
 #include "leanstore/KVInterface.hpp"
+#include "leanstore/btree/core/BTreeBulkLoader.hpp"
 #include "leanstore/btree/core/BTreeGeneric.hpp"
 
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
 namespace leanstore {
 
 class LeanStore;
@@ -11,6 +17,8 @@ class LeanStore;
 
 namespace leanstore::storage::btree {
 
+class PessimisticExclusiveIterator;
+
 class BasicKV : public KVInterface, public BTreeGeneric {
 public:
   BasicKV() {
@@ -21,6 +29,20 @@ public:
 
   virtual OpCode Insert(Slice key, Slice val) override;
 
+  //! Looks up the keys in sorted order. The evicted leaves are read ahead in batches, consecutive
+  //! keys in the same leaf are looked up with one traversal.
+  virtual void MultiLookup(std::span<const Slice> keys, MultiValCallback valCallback,
+                           std::span<OpCode> results) override;
+
+  //! Inserts the keys in sorted order, consecutive keys in the same leaf are inserted with one
+  //! traversal.
+  virtual void MultiInsert(std::span<const Slice> keys, std::span<const Slice> vals,
+                           std::span<OpCode> results) override;
+
+  //! Creates a bulk loader to build the empty tree from keys in ascending order, the nodes are
+  //! filled up to the fill factor.
+  virtual std::unique_ptr<BTreeBulkLoader> NewBulkLoader(double fillFactor);
+
   virtual OpCode UpdatePartial(Slice key, MutValCallback updateCallBack,
                                UpdateDesc& updateDesc) override;
 
@@ -95,9 +117,31 @@ public:
     }
   }
 
+protected:
+  //! Looks up the key in a leaf, the value is nullptr if the key is not found. Returns false if
+  //! the result is not determined in the leaf, the key is then looked up alone.
+  using LeafLookupFunc = std::function<bool(uint64_t idx, const Slice* val)>;
+
+  //! Positions of the keys in sorted order. Equal keys keep their original order.
+  static std::vector<uint64_t> sortedOrder(std::span<const Slice> keys);
+
+  //! Looks up the keys in sorted order, the leaves are read ahead. Consecutive keys in the same
+  //! leaf are looked up with lookupInLeaf in one optimistic traversal, keys failed to be looked up
+  //! optimistically are looked up with lookupOne.
+  void multiLookup(std::span<const Slice> keys, const LeafLookupFunc& lookupInLeaf,
+                   const std::function<void(uint64_t idx)>& lookupOne);
+
 private:
   OpCode lookupOptimistic(Slice key, ValCallback valCallback);
   OpCode lookupPessimistic(Slice key, ValCallback valCallback);
+
+  //! Looks up the keys from order[begin] in the leaf of the first one optimistically, until a key
+  //! falls out of the leaf. Returns the position of the first key not looked up.
+  uint64_t lookupInLeafOptimistic(std::span<const Slice> keys, const std::vector<uint64_t>& order,
+                                  uint64_t begin, const LeafLookupFunc& lookupInLeaf);
+
+  //! Inserts the key with the iterator, which stays on the leaf for the next key.
+  OpCode insert(PessimisticExclusiveIterator& xIter, Slice key, Slice val);
 };
 
 } // namespace leanstore::storage::btree
@@ -189,10 +189,64 @@ OpCode TransactionKV::UpdatePartial(Slice key, MutValCallback updateCallBack,
 
 OpCode TransactionKV::Insert(Slice key, Slice val) {
   LS_DCHECK(cr::WorkerContext::My().IsTxStarted());
+  auto xIter = GetExclusiveIterator();
+  return insert(xIter, key, val);
+}
+
+void TransactionKV::MultiLookup(std::span<const Slice> keys, MultiValCallback valCallback,
+                                std::span<OpCode> results) {
+  LS_DCHECK(cr::WorkerContext::My().IsTxStarted());
+  LS_DCHECK(results.size() >= keys.size());
+  // removed tuples may be moved to the graveyard, which is only checked by Lookup()
+  const bool isLongRunning = cr::ActiveTx().IsLongRunning();
+  multiLookup(
+      keys,
+      [&](uint64_t idx, const Slice* val) {
+        if (val == nullptr) {
+          results[idx] = OpCode::kNotFound;
+          return !isLongRunning;
+        }
+        auto [ret, versionsRead] =
+            getVisibleTuple(*val, [&](Slice visibleVal) { valCallback(idx, visibleVal); });
+        results[idx] = ret;
+        return ret == OpCode::kOK || !isLongRunning;
+      },
+      [&](uint64_t idx) {
+        results[idx] = Lookup(keys[idx], [&](Slice val) { valCallback(idx, val); });
+      });
+}
+
+void TransactionKV::MultiInsert(std::span<const Slice> keys, std::span<const Slice> vals,
+                                std::span<OpCode> results) {
+  LS_DCHECK(cr::WorkerContext::My().IsTxStarted());
+  LS_DCHECK(vals.size() >= keys.size() && results.size() >= keys.size());
+  auto order = sortedOrder(keys);
+
+  // the iterator stays on the leaf of the last key, it is reused if the next key falls in
+  auto xIter = GetExclusiveIterator();
+  uint64_t pos = 0;
+  for (; pos < order.size(); pos++) {
+    auto idx = order[pos];
+    results[idx] = insert(xIter, keys[idx], vals[idx]);
+    if (results[idx] == OpCode::kAbortTx) {
+      break;
+    }
+  }
+  for (pos++; pos < order.size(); pos++) {
+    results[order[pos]] = OpCode::kAbortTx;
+  }
+}
+
+std::unique_ptr<BTreeBulkLoader> TransactionKV::NewBulkLoader(double fillFactor) {
+  return std::make_unique<BTreeBulkLoader>(
+      *this, fillFactor, sizeof(ChainedTuple),
+      [](Slice val, uint8_t* dest) { new (dest) ChainedTuple(0, 0, val); });
+}
+
+OpCode TransactionKV::insert(PessimisticExclusiveIterator& xIter, Slice key, Slice val) {
   uint16_t payloadSize = val.size() + sizeof(ChainedTuple);
 
   while (true) {
-    auto xIter = GetExclusiveIterator();
     auto ret = xIter.SeekToInsert(key);
 
     if (ret == OpCode::kDuplicated) {
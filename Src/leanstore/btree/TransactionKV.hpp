@@ -12,6 +12,7 @@
 #include "leanstore/utils/Result.hpp"
 
 #include <expected>
+#include <span>
 #include <string>
 #include <tuple>
 
@@ -56,6 +57,17 @@ public:
 
   OpCode Insert(Slice key, Slice val) override;
 
+  void MultiLookup(std::span<const Slice> keys, MultiValCallback valCallback,
+                   std::span<OpCode> results) override;
+
+  //! Inserts the keys in sorted order. Stops at the first conflict, the keys not inserted yet get
+  //! kAbortTx.
+  void MultiInsert(std::span<const Slice> keys, std::span<const Slice> vals,
+                   std::span<OpCode> results) override;
+
+  //! The values are loaded as tuples visible to all the transactions.
+  std::unique_ptr<BTreeBulkLoader> NewBulkLoader(double fillFactor) override;
+
   OpCode UpdatePartial(Slice key, MutValCallback updateCallBack, UpdateDesc& updateDesc) override;
 
   OpCode Remove(Slice key) override;
@@ -88,6 +100,9 @@ private:
 
   std::tuple<OpCode, uint16_t> getVisibleTuple(Slice payload, ValCallback callback);
 
+  //! Inserts the key with the iterator, which stays on the leaf for the next key.
+  OpCode insert(PessimisticExclusiveIterator& xIter, Slice key, Slice val);
+
   void insertAfterRemove(PessimisticExclusiveIterator& xIter, Slice key, Slice val);
 
   void undoLastInsert(const WalTxInsert* walInsert);
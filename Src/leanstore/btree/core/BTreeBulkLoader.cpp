@@ -0,0 +1,297 @@
+#include "leanstore/btree/core/BTreeBulkLoader.hpp"
+
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/btree/core/BTreeGeneric.hpp"
+#include "leanstore/btree/core/BTreeNode.hpp"
+#include "leanstore/btree/core/BTreeWalPayload.hpp"
+#include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/buffer-manager/GuardedBufferFrame.hpp"
+#include "leanstore/utils/JumpMU.hpp"
+#include "leanstore/utils/Log.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <expected>
+#include <utility>
+
+namespace leanstore::storage::btree {
+
+BTreeBulkLoader::BTreeBulkLoader(BTreeGeneric& btree, double fillFactor, uint16_t valOverhead,
+                                 ValWriter valWriter)
+    : mStore(btree.mStore),
+      mBTree(btree),
+      mTargetSize(static_cast<uint64_t>(BTreeNode::Size() * std::clamp(fillFactor, 0.0, 1.0))),
+      mValOverhead(valOverhead),
+      mValWriter(std::move(valWriter)),
+      mLevels(1),
+      mWriteBuffer(btree.mStore->mStoreOption->mPageSize *
+                   btree.mStore->mStoreOption->mBufferWriteBatchSize),
+      mAio(btree.mStore->mStoreOption->mBufferWriteBatchSize,
+           btree.mStore->mStoreOption->mIoBackend) {
+  LS_DCHECK(fillFactor > 0 && fillFactor <= 1, "Invalid fill factor {}", fillFactor);
+  mAio.RegisterBuffers(
+      {iovec{mWriteBuffer.Get(),
+             mStore->mStoreOption->mPageSize * mStore->mStoreOption->mBufferWriteBatchSize}});
+  mAio.RegisterFiles({mStore->mPageFd});
+}
+
+Result<void> BTreeBulkLoader::Add(Slice key, Slice val) {
+  // fail before any page is written if the btree can't be bulk loaded
+  if (mNumKeys == 0) {
+    if (auto res = checkEmpty(); !res) {
+      return std::unexpected(res.error());
+    }
+  }
+
+  const uint64_t valSize = mValOverhead + val.size();
+  auto& entries = mLevels[0].mEntries;
+  if (!entries.empty() && mLevels[0].Key(entries.back()).compare(key) >= 0) {
+    return std::unexpected(
+        utils::Error::General("Keys of bulk load must be unique and in ascending order"));
+  }
+
+  // the leaf is written when the next key is known, which bounds the separator
+  if (!entries.empty() && !fits(mLevels[0], key.size(), valSize, key.size(), mTargetSize)) {
+    auto lastKey = mLevels[0].Key(entries.back());
+    uint64_t prefixSize =
+        std::mismatch(lastKey.begin(), lastKey.end(), key.begin(), key.end()).first -
+        lastKey.begin();
+
+    // the shortest prefix of the key larger than the last key, if it's not longer than the last key
+    std::string separator = lastKey.ToString();
+    if (prefixSize + 1 <= lastKey.size() && prefixSize + 1 < key.size()) {
+      separator = Slice(key.data(), prefixSize + 1).ToString();
+    }
+    if (auto res = flushLeaf(Slice(separator)); !res) {
+      return std::unexpected(res.error());
+    }
+  }
+
+  auto& leaves = mLevels[0];
+  if (leaves.mEntries.empty() &&
+      !fits(leaves, key.size(), valSize, key.size(), BTreeNode::Size())) {
+    return std::unexpected(utils::Error::General("Key-value pair is too large for a leaf"));
+  }
+
+  auto* valDest = append(leaves, key, valSize);
+  if (mValWriter) {
+    mValWriter(val, valDest);
+  } else {
+    std::memcpy(valDest, val.data(), val.size());
+  }
+  mNumKeys++;
+  return {};
+}
+
+Result<void> BTreeBulkLoader::Finish() {
+  if (mNumKeys == 0) {
+    return {};
+  }
+
+  // write the right-most node of each level, until a level has a single child, i.e. the root
+  PID rootPageId = 0;
+  uint64_t height = 0;
+  for (uint64_t levelId = 0; levelId < mLevels.size(); levelId++) {
+    auto& level = mLevels[levelId];
+    if (levelId > 0 && level.mNumNodes == 0 && level.mEntries.size() == 1) {
+      Swip rootSwip;
+      std::memcpy(&rootSwip, level.Val(level.mEntries[0]).data(), sizeof(Swip));
+      rootPageId = rootSwip.AsPageId();
+      height = levelId;
+      break;
+    }
+
+    auto res = levelId == 0 ? flushLeaf(Slice())
+                            : flushInner(levelId, level.mEntries.size(), true);
+    if (!res) {
+      return std::unexpected(res.error());
+    }
+  }
+
+  if (auto res = writeBatch(); !res) {
+    return std::unexpected(res.error());
+  }
+  mStore->mBufferManager->SyncAllPageWrites();
+  return installRoot(rootPageId, height);
+}
+
+bool BTreeBulkLoader::fits(const Level& level, uint64_t keySize, uint64_t valSize,
+                           uint64_t fenceSize, uint64_t nodeSize) const {
+  auto spaceNeeded = sizeof(BTreeNode) + level.mLowerFence.size() + fenceSize + level.mSpaceUsed +
+                     sizeof(BTreeNodeSlot) + keySize + valSize;
+  return spaceNeeded <= nodeSize;
+}
+
+uint8_t* BTreeBulkLoader::append(Level& level, Slice key, uint16_t valSize) {
+  auto offset = level.mData.size();
+  level.mData.resize(offset + key.size() + valSize);
+  std::copy(key.begin(), key.end(), level.mData.begin() + offset);
+  level.mEntries.push_back(Entry{static_cast<uint32_t>(offset), static_cast<uint16_t>(key.size()),
+                                 valSize});
+  level.mSpaceUsed += BTreeNode::SpaceNeeded(key.size(), valSize, 0);
+  return level.mData.data() + offset + key.size();
+}
+
+Result<void> BTreeBulkLoader::flushLeaf(Slice upperFence) {
+  auto page = nextPage();
+  if (!page) {
+    return std::unexpected(page.error());
+  }
+
+  auto& leaves = mLevels[0];
+  auto* node = BTreeNode::New(page.value()->mPayload, true, leaves.LowerFence(), upperFence);
+  for (const auto& entry : leaves.mEntries) {
+    node->Insert(leaves.Key(entry), leaves.Val(entry));
+  }
+  auto pageId = writePage(page.value());
+
+  leaves.mNumNodes++;
+  leaves.mLowerFence = upperFence.ToString();
+  leaves.mData.clear();
+  leaves.mEntries.clear();
+  leaves.mSpaceUsed = 0;
+  return addChild(1, upperFence, pageId);
+}
+
+Result<void> BTreeBulkLoader::flushInner(uint64_t levelId, uint64_t numChildren, bool rightMost) {
+  auto page = nextPage();
+  if (!page) {
+    return std::unexpected(page.error());
+  }
+
+  Level flushed = std::exchange(mLevels[levelId], Level());
+  auto& lastChild = flushed.mEntries[numChildren - 1];
+  auto upperFence = rightMost ? Slice() : flushed.Key(lastChild);
+  auto* node = BTreeNode::New(page.value()->mPayload, false, flushed.LowerFence(), upperFence);
+  for (uint64_t i = 0; i + 1 < numChildren; i++) {
+    node->Insert(flushed.Key(flushed.mEntries[i]), flushed.Val(flushed.mEntries[i]));
+  }
+  std::memcpy(&node->mRightMostChildSwip, flushed.Val(lastChild).data(), sizeof(Swip));
+  auto pageId = writePage(page.value());
+
+  // the children left belong to the next node on this level
+  auto& level = mLevels[levelId];
+  level.mNumNodes = flushed.mNumNodes + 1;
+  level.mLowerFence = upperFence.ToString();
+  for (uint64_t i = numChildren; i < flushed.mEntries.size(); i++) {
+    auto& entry = flushed.mEntries[i];
+    auto* valDest = append(level, flushed.Key(entry), entry.mValSize);
+    std::memcpy(valDest, flushed.Val(entry).data(), entry.mValSize);
+  }
+  return addChild(levelId + 1, upperFence, pageId);
+}
+
+Result<void> BTreeBulkLoader::addChild(uint64_t levelId, Slice upperFence, PID pageId) {
+  if (levelId == mLevels.size()) {
+    mLevels.emplace_back();
+  }
+
+  // the last child is kept for the next node, so that each inner node has at least one slot
+  if (mLevels[levelId].mEntries.size() >= 2 &&
+      !fits(mLevels[levelId], upperFence.size(), sizeof(Swip), upperFence.size(), mTargetSize)) {
+    auto res = flushInner(levelId, mLevels[levelId].mEntries.size() - 1, false);
+    if (!res) {
+      return std::unexpected(res.error());
+    }
+  }
+
+  Swip childSwip;
+  childSwip.Evict(pageId);
+  auto* valDest = append(mLevels[levelId], upperFence, sizeof(Swip));
+  std::memcpy(valDest, &childSwip, sizeof(Swip));
+  return {};
+}
+
+Result<Page*> BTreeBulkLoader::nextPage() {
+  if (mNumBatchPages == mStore->mStoreOption->mBufferWriteBatchSize) {
+    if (auto res = writeBatch(); !res) {
+      return std::unexpected(res.error());
+    }
+  }
+
+  const auto pageSize = mStore->mStoreOption->mPageSize;
+  auto* buf = mWriteBuffer.Get() + mNumBatchPages * pageSize;
+  std::memset(buf, 0, pageSize);
+  auto* page = new (buf) Page();
+  page->mBTreeId = mBTree.mTreeId;
+  mNumBatchPages++;
+  return page;
+}
+
+PID BTreeBulkLoader::writePage(Page* page) {
+  const auto pageSize = mStore->mStoreOption->mPageSize;
+  auto pageId = mStore->mBufferManager->RandomPartition().NextPageId();
+  page->mMagicDebugging = pageId;
+  mAio.PrepareWrite(mStore->mPageFd, page, pageSize, pageId * pageSize);
+  return pageId;
+}
+
+Result<void> BTreeBulkLoader::writeBatch() {
+  if (mNumBatchPages == 0) {
+    return {};
+  }
+  mNumBatchPages = 0;
+
+  if (auto res = mAio.SubmitAll(); !res) {
+    return std::unexpected(res.error());
+  }
+  if (auto res = mAio.WaitAll(); !res) {
+    return std::unexpected(res.error());
+  }
+  return {};
+}
+
+Result<void> BTreeBulkLoader::checkEmpty() {
+  auto* bufferManager = mStore->mBufferManager.get();
+  while (true) {
+    JUMPMU_TRY() {
+      GuardedBufferFrame<BTreeNode> guardedMeta(bufferManager, mBTree.mMetaNodeSwip);
+      GuardedBufferFrame<BTreeNode> guardedRoot(bufferManager, guardedMeta,
+                                                guardedMeta->mRightMostChildSwip);
+      bool isEmpty = guardedRoot->mIsLeaf && guardedRoot->mNumSlots == 0;
+      guardedRoot.JumpIfModifiedByOthers();
+      if (!isEmpty) {
+        JUMPMU_RETURN std::unexpected(
+            utils::Error::General("Bulk load is only supported on empty btrees"));
+      }
+      JUMPMU_RETURN {};
+    }
+    JUMPMU_CATCH() {
+    }
+  }
+}
+
+Result<void> BTreeBulkLoader::installRoot(PID rootPageId, uint64_t height) {
+  auto* bufferManager = mStore->mBufferManager.get();
+  while (true) {
+    JUMPMU_TRY() {
+      GuardedBufferFrame<BTreeNode> guardedMeta(bufferManager, mBTree.mMetaNodeSwip);
+      GuardedBufferFrame<BTreeNode> guardedOldRoot(bufferManager, guardedMeta,
+                                                   guardedMeta->mRightMostChildSwip);
+      if (!guardedOldRoot->mIsLeaf || guardedOldRoot->mNumSlots > 0) {
+        guardedOldRoot.JumpIfModifiedByOthers();
+        JUMPMU_RETURN std::unexpected(
+            utils::Error::General("Bulk load is only supported on empty btrees"));
+      }
+
+      auto xGuardedMeta = ExclusiveGuardedBufferFrame(std::move(guardedMeta));
+      auto xGuardedOldRoot = ExclusiveGuardedBufferFrame(std::move(guardedOldRoot));
+      if (mBTree.mConfig.mEnableWal) {
+        TXID sysTxId = mStore->AllocSysTxTs();
+        xGuardedMeta.SyncSystemTxId(sysTxId);
+        xGuardedMeta.WriteWal<WalBulkLoad>(0, sysTxId, rootPageId, height);
+      }
+      xGuardedMeta->mRightMostChildSwip.Evict(rootPageId);
+      mBTree.mHeight = height;
+      xGuardedOldRoot.Reclaim();
+      Log::Info("Bulk loaded btree, treeId={}, numKeys={}, height={}, rootPageId={}",
+                mBTree.mTreeId, mNumKeys, height, rootPageId);
+      JUMPMU_RETURN {};
+    }
+    JUMPMU_CATCH() {
+    }
+  }
+}
+
+} // namespace leanstore::storage::btree
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "leanstore/Slice.hpp"
+#include "leanstore/Units.hpp"
+#include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/buffer-manager/Swip.hpp"
+#include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/Result.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace leanstore {
+
+class LeanStore;
+
+} // namespace leanstore
+
+namespace leanstore::storage::btree {
+
+class BTreeGeneric;
+
+//! Builds a btree bottom-up from keys added in ascending order, much cheaper than inserting them
+//! one by one:
+//! - leaves are filled up to the fill factor in a local buffer, inner nodes are built from the
+//!   separators of their children, level by level,
+//! - the nodes bypass the buffer pool, they are written to the page file with batched async io,
+//! - nothing is logged for the loaded keys, the pages are persisted before Finish() installs the
+//!   new root, which is logged with a single WalBulkLoad.
+//!
+//! The btree must be empty, and not accessed by others before Finish() returns. Should be used in
+//! a worker thread, inside a transaction if the btree writes WAL.
+class BTreeBulkLoader {
+public:
+  //! Writes the value of a key to the leaf, valSize bytes are reserved at dest.
+  using ValWriter = std::function<void(Slice val, uint8_t* dest)>;
+
+private:
+  //! A key-value pair of the node being built, stored in Level::mData.
+  struct Entry {
+    uint32_t mOffset;
+
+    uint16_t mKeySize;
+
+    uint16_t mValSize;
+  };
+
+  //! The node being built on a level of the btree. Values of the inner levels are child swips.
+  struct Level {
+    std::vector<uint8_t> mData;
+
+    std::vector<Entry> mEntries;
+
+    //! Sum of the slot, key and value sizes of mEntries.
+    uint64_t mSpaceUsed = 0;
+
+    //! Upper fence of the last node written on this level.
+    std::string mLowerFence;
+
+    uint64_t mNumNodes = 0;
+
+    //! The left-most node of a level has an infinite lower fence.
+    Slice LowerFence() const {
+      return mNumNodes == 0 ? Slice() : Slice(mLowerFence);
+    }
+
+    Slice Key(const Entry& entry) const {
+      return Slice(mData.data() + entry.mOffset, entry.mKeySize);
+    }
+
+    Slice Val(const Entry& entry) const {
+      return Slice(mData.data() + entry.mOffset + entry.mKeySize, entry.mValSize);
+    }
+  };
+
+  leanstore::LeanStore* mStore;
+
+  BTreeGeneric& mBTree;
+
+  //! Bytes of a node to fill, derived from the fill factor.
+  uint64_t mTargetSize;
+
+  //! Extra bytes of a value stored in the leaf, e.g. the tuple header of TransactionKV.
+  uint16_t mValOverhead;
+
+  ValWriter mValWriter;
+
+  //! Levels from the leaves to the root.
+  std::vector<Level> mLevels;
+
+  uint64_t mNumKeys = 0;
+
+  utils::AlignedBuffer<512> mWriteBuffer;
+
+  uint64_t mNumBatchPages = 0;
+
+  utils::AsyncIo mAio;
+
+public:
+  //! @param fillFactor: fraction of each node to fill, in (0, 1].
+  //! @param valOverhead, valWriter: how values are stored in the leaves, plain copies by default.
+  BTreeBulkLoader(BTreeGeneric& btree, double fillFactor, uint16_t valOverhead = 0,
+                  ValWriter valWriter = nullptr);
+
+  ~BTreeBulkLoader() = default;
+
+  // no copy and assign
+  BTreeBulkLoader(const BTreeBulkLoader&) = delete;
+  BTreeBulkLoader& operator=(const BTreeBulkLoader&) = delete;
+
+  //! Adds a key-value pair. Keys must be unique and added in ascending order. The first call fails
+  //! if the btree is not empty.
+  [[nodiscard]] Result<void> Add(Slice key, Slice val);
+
+  //! Writes the remaining nodes, persists all the written pages, and installs the new root.
+  [[nodiscard]] Result<void> Finish();
+
+  uint64_t NumKeys() const {
+    return mNumKeys;
+  }
+
+private:
+  //! Whether an entry can be added to the node of the level, with an upper fence of fenceSize.
+  bool fits(const Level& level, uint64_t keySize, uint64_t valSize, uint64_t fenceSize,
+            uint64_t nodeSize) const;
+
+  //! Appends an entry to the level, reserves the value space and returns its address.
+  uint8_t* append(Level& level, Slice key, uint16_t valSize);
+
+  //! Writes all the entries of the leaf level as a leaf with the upper fence.
+  Result<void> flushLeaf(Slice upperFence);
+
+  //! Writes the first numChildren entries of an inner level as an inner node, the last of them is
+  //! the right-most child, its key is the upper fence of the node. The right-most node of a level
+  //! has an infinite upper fence.
+  Result<void> flushInner(uint64_t levelId, uint64_t numChildren, bool rightMost);
+
+  //! Adds a written node as a child to the next level, the upper fence of the node is the
+  //! separator.
+  Result<void> addChild(uint64_t levelId, Slice upperFence, PID pageId);
+
+  //! Returns the next page in the write buffer, the batch is written first if it's full.
+  Result<Page*> nextPage();
+
+  //! Allocates a page id for the page and prepares the write.
+  PID writePage(Page* page);
+
+  Result<void> writeBatch();
+
+  //! Whether the btree is empty, i.e. the root is an empty leaf.
+  Result<void> checkEmpty();
+
+  //! Points the meta node to the new root, reclaims the old empty root. Checks the btree is still
+  //! empty, in case it was modified after the first Add().
+  Result<void> installRoot(PID rootPageId, uint64_t height);
+};
+
+} // namespace leanstore::storage::btree
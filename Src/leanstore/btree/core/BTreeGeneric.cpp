@@ -17,6 +17,7 @@
 
 #include <cstdint>
 #include <format>
+#include <vector>
 
 using namespace leanstore::storage;
 
@@ -172,6 +173,8 @@ void BTreeGeneric::splitRootMayJump(TXID sysTxId, GuardedBufferFrame<BTreeNode>&
     xGuardedOldRoot.WriteWal<WalSplitRoot>(0, sysTxId, xGuardedNewLeft.bf()->mHeader.mPageId,
                                            xGuardedNewRoot.bf()->mHeader.mPageId,
                                            xGuardedMeta.bf()->mHeader.mPageId, sepInfo);
+    xGuardedNewLeft.SyncGsn(xGuardedOldRoot.bf()->mPage.mGSN);
+    xGuardedNewRoot.SyncGsn(xGuardedOldRoot.bf()->mPage.mGSN);
   }
 
   // 3.2. move half of the old root to the new left,
@@ -217,6 +220,8 @@ void BTreeGeneric::splitNonRootMayJump(TXID sysTxId, GuardedBufferFrame<BTreeNod
     xGuardedChild.SyncSystemTxId(sysTxId);
     xGuardedChild.WriteWal<WalSplitNonRoot>(0, sysTxId, xGuardedParent.bf()->mHeader.mPageId,
                                             xGuardedNewLeft.bf()->mHeader.mPageId, sepInfo);
+    xGuardedParent.SyncGsn(xGuardedChild.bf()->mPage.mGSN);
+    xGuardedNewLeft.SyncGsn(xGuardedChild.bf()->mPage.mGSN);
   }
 
   // 2.2. make room for separator key in parent node
@@ -526,6 +531,56 @@ BTreeGeneric::XMergeReturnCode BTreeGeneric::XMerge(GuardedBufferFrame<BTreeNode
 // -------------------------------------------------------------------------------------
 // Helpers
 // -------------------------------------------------------------------------------------
+void BTreeGeneric::ReadAheadLeaves(std::span<const Slice> sortedKeys) {
+  auto* bufferManager = mStore->mBufferManager.get();
+  std::vector<Swip*> swips;
+  uint64_t pos = 0;
+  while (pos < sortedKeys.size()) {
+    volatile uint64_t next = pos + 1;
+    swips.clear();
+    JUMPMU_TRY() {
+      // find the parent of the leaf
+      GuardedBufferFrame<BTreeNode> guardedParent(bufferManager, mMetaNodeSwip,
+                                                  LatchMode::kOptimisticSpin);
+      GuardedBufferFrame<BTreeNode> guardedNode(bufferManager, guardedParent,
+                                                guardedParent->mRightMostChildSwip,
+                                                LatchMode::kOptimisticSpin);
+      volatile uint16_t level = 0;
+      while (!guardedNode->mIsLeaf && level + 2 < mHeight) {
+        auto& childSwip = guardedNode->LookupInner(sortedKeys[pos]);
+        guardedParent = std::move(guardedNode);
+        guardedNode = GuardedBufferFrame<BTreeNode>(bufferManager, guardedParent, childSwip,
+                                                    LatchMode::kOptimisticSpin);
+        level = level + 1;
+      }
+      if (guardedNode->mIsLeaf) {
+        // the root is a leaf, nothing to read
+        guardedNode.JumpIfModifiedByOthers();
+        JUMPMU_RETURN;
+      }
+      guardedParent.unlock();
+
+      // the leaves of the following keys under the same parent
+      auto end = pos;
+      for (; end < sortedKeys.size(); end++) {
+        if (end > pos && guardedNode->CompareKeyWithBoundaries(sortedKeys[end]) != 0) {
+          break;
+        }
+        auto* swip = &guardedNode->LookupInner(sortedKeys[end]);
+        if (swips.empty() || swips.back() != swip) {
+          swips.push_back(swip);
+        }
+      }
+      guardedNode.JumpIfModifiedByOthers();
+      next = end;
+      bufferManager->ReadAhead(guardedNode.mGuard, swips);
+    }
+    JUMPMU_CATCH() {
+    }
+    pos = next;
+  }
+}
+
 int64_t BTreeGeneric::iterateAllPages(BTreeNodeCallback inner, BTreeNodeCallback leaf) {
   while (true) {
     JUMPMU_TRY() {
@@ -13,6 +13,7 @@
 
 #include <atomic>
 #include <limits>
+#include <span>
 
 namespace leanstore::storage::btree {
 
@@ -108,6 +109,11 @@ public:
   //! NOTE: The source buffer frame should be shared latched
   virtual void Checkpoint(BufferFrame& bf, void* dest) override;
 
+  //! Compacts a copy of the leaf and zeroes its free space, only leaves are compressed
+  ///
+  //! NOTE: The source buffer frame should be exclusively latched
+  virtual bool PrepareCompression(BufferFrame& bf, void* dest) override;
+
   virtual void undo(const uint8_t*, const uint64_t) override {
     Log::Fatal("undo is unsupported");
   }
@@ -173,6 +179,11 @@ public:
   inline void FindLeafCanJump(Slice key, GuardedBufferFrame<BTreeNode>& guardedTarget,
                               LatchMode mode = LatchMode::kPessimisticShared);
 
+  //! Reads the evicted leaves of the sorted keys ahead, with one batch of async reads for the
+  //! leaves under the same parent, so that the keys looked up one by one later do not wait for IO.
+  //! Best effort, parents modified by others meanwhile are skipped.
+  void ReadAheadLeaves(std::span<const Slice> sortedKeys);
+
 public:
   //! Note on Synchronization: it is called by the page provide thread which are not allowed to
   //! block. Therefore, we jump whenever we encounter a latched node on our way Moreover, we jump if
@@ -296,6 +307,25 @@ inline void BTreeGeneric::Checkpoint(BufferFrame& bf, void* dest) {
   }
 }
 
+inline bool BTreeGeneric::PrepareCompression(BufferFrame& bf, void* dest) {
+  auto* node = reinterpret_cast<BTreeNode*>(bf.mPage.mPayload);
+  if (!node->mIsLeaf) {
+    return false;
+  }
+
+  std::memcpy(dest, &bf.mPage, mStore->mStoreOption->mPageSize);
+  auto* destPage = reinterpret_cast<Page*>(dest);
+  auto* destNode = reinterpret_cast<BTreeNode*>(destPage->mPayload);
+
+  // keys are already stored without the common prefix of the node, remove the garbage left by
+  // removed and shrunk entries, and zero the free space between slots and data for LZ4
+  if (destNode->FreeSpace() < destNode->FreeSpaceAfterCompaction()) {
+    destNode->Compactify();
+  }
+  std::memset(destNode->mSlot + destNode->mNumSlots, 0, destNode->FreeSpace());
+  return true;
+}
+
 inline void BTreeGeneric::FindLeafCanJump(Slice key, GuardedBufferFrame<BTreeNode>& guardedTarget,
                                           LatchMode mode) {
   guardedTarget.unlock();
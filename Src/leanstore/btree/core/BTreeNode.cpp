@@ -7,8 +7,13 @@
 #include "leanstore/utils/Log.hpp"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
 namespace leanstore::storage::btree {
 
 void BTreeNode::UpdateHint(uint16_t slotId) {
@@ -23,31 +28,140 @@ void BTreeNode::UpdateHint(uint16_t slotId) {
     assert(mHint[i] == mSlot[dist * (i + 1)].mHead);
 }
 
+namespace {
+
+//! Compares the hints with the key head, sets bit i of geMask if mHint[i] >= keyHead, and bit i of
+//! eqMask if mHint[i] == keyHead.
+using HintCmpFunc = void (*)(const uint32_t* hints, HeadType keyHead, uint32_t& geMask,
+                             uint32_t& eqMask);
+
+//! Counts the heads less than and not greater than the key head, heads are non-decreasing in the
+//! slot array. numHeads is a multiple of 8.
+using HeadCountFunc = void (*)(const BTreeNodeSlot* slots, uint16_t numHeads, HeadType keyHead,
+                               uint16_t& numLess, uint16_t& numNotGreater);
+
+void hintCmpSerial(const uint32_t* hints, HeadType keyHead, uint32_t& geMask, uint32_t& eqMask) {
+  geMask = 0;
+  eqMask = 0;
+  for (uint32_t i = 0; i < BTreeNode::sHintCount; i++) {
+    geMask |= static_cast<uint32_t>(hints[i] >= keyHead) << i;
+    eqMask |= static_cast<uint32_t>(hints[i] == keyHead) << i;
+  }
+}
+
+#ifdef __x86_64__
+
+__attribute__((target("sse4.2"))) void hintCmpSse42(const uint32_t* hints, HeadType keyHead,
+                                                    uint32_t& geMask, uint32_t& eqMask) {
+  const __m128i keyHeadReg = _mm_set1_epi32(keyHead);
+  geMask = 0;
+  eqMask = 0;
+  for (uint32_t i = 0; i < BTreeNode::sHintCount; i += 4) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hints + i));
+    // unsigned hint >= keyHead iff max(hint, keyHead) == hint
+    __m128i ge = _mm_cmpeq_epi32(_mm_max_epu32(chunk, keyHeadReg), chunk);
+    __m128i eq = _mm_cmpeq_epi32(chunk, keyHeadReg);
+    geMask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(ge))) << i;
+    eqMask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+  }
+}
+
+__attribute__((target("avx2"))) void hintCmpAvx2(const uint32_t* hints, HeadType keyHead,
+                                                 uint32_t& geMask, uint32_t& eqMask) {
+  const __m256i keyHeadReg = _mm256_set1_epi32(keyHead);
+  geMask = 0;
+  eqMask = 0;
+  for (uint32_t i = 0; i < BTreeNode::sHintCount; i += 8) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(hints + i));
+    __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(chunk, keyHeadReg), chunk);
+    __m256i eq = _mm256_cmpeq_epi32(chunk, keyHeadReg);
+    geMask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(ge))) << i;
+    eqMask |= static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))) << i;
+  }
+}
+
+__attribute__((target("avx512f"))) void hintCmpAvx512(const uint32_t* hints, HeadType keyHead,
+                                                      uint32_t& geMask, uint32_t& eqMask) {
+  static_assert(BTreeNode::sHintCount == 16);
+  const __m512i keyHeadReg = _mm512_set1_epi32(keyHead);
+  __m512i chunk = _mm512_loadu_si512(hints);
+  geMask = _mm512_cmpge_epu32_mask(chunk, keyHeadReg);
+  eqMask = _mm512_cmpeq_epu32_mask(chunk, keyHeadReg);
+}
+
+//! The heads are 10 bytes apart in the packed slot array, gathered 8 at a time.
+__attribute__((target("avx2"))) void headCountAvx2(const BTreeNodeSlot* slots, uint16_t numHeads,
+                                                   HeadType keyHead, uint16_t& numLess,
+                                                   uint16_t& numNotGreater) {
+  static_assert(sizeof(BTreeNodeSlot) == 10 && offsetof(BTreeNodeSlot, mHead) == 6);
+  const __m256i keyHeadReg = _mm256_set1_epi32(keyHead);
+  const __m256i offsets = _mm256_setr_epi32(0, 10, 20, 30, 40, 50, 60, 70);
+  numLess = 0;
+  numNotGreater = 0;
+  for (uint16_t i = 0; i < numHeads; i += 8) {
+    auto* base = reinterpret_cast<const int*>(reinterpret_cast<const uint8_t*>(slots + i) +
+                                              offsetof(BTreeNodeSlot, mHead));
+    __m256i heads = _mm256_i32gather_epi32(base, offsets, 1);
+    __m256i ge = _mm256_cmpeq_epi32(_mm256_max_epu32(heads, keyHeadReg), heads);
+    __m256i le = _mm256_cmpeq_epi32(_mm256_min_epu32(heads, keyHeadReg), heads);
+    auto geMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(ge)));
+    auto leMask = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(le)));
+    numLess += 8 - __builtin_popcount(geMask);
+    numNotGreater += __builtin_popcount(leMask);
+  }
+}
+
+#endif
+
+HintCmpFunc resolveHintCmp() {
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return hintCmpAvx512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return hintCmpAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return hintCmpSse42;
+  }
+#endif
+  return hintCmpSerial;
+}
+
+HeadCountFunc resolveHeadCount() {
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return headCountAvx2;
+  }
+#endif
+  return nullptr;
+}
+
+//! The kernels supported by the cpu, resolved once at startup.
+const HintCmpFunc kHintCmp = resolveHintCmp();
+const HeadCountFunc kHeadCount = resolveHeadCount();
+
+} // namespace
+
 void BTreeNode::SearchHint(HeadType keyHead, uint16_t& lowerOut, uint16_t& upperOut) {
   if (mNumSlots > sHintCount * 2) {
     if (utils::tlsStore->mStoreOption->mBTreeHints == 2) {
-#ifdef __AVX512F__
       const uint16_t dist = mNumSlots / (sHintCount + 1);
-      uint16_t pos, pos2;
-      __m512i key_head_reg = _mm512_set1_epi32(keyHead);
-      __m512i chunk = _mm512_loadu_si512(hint);
-      __mmask16 compareMask = _mm512_cmpge_epu32_mask(chunk, key_head_reg);
-      if (compareMask == 0)
-        return;
-      pos = __builtin_ctz(compareMask);
+      uint32_t geMask, eqMask;
+      kHintCmp(mHint, keyHead, geMask, eqMask);
+
+      // the first hint not less than the key head, and the first one after it not equal to it
+      const uint32_t allMask = (1u << sHintCount) - 1;
+      const uint16_t pos = geMask == 0 ? sHintCount : __builtin_ctz(geMask);
+      const uint32_t neMask = ~eqMask & allMask & (allMask << pos);
+      const uint16_t pos2 = neMask == 0 ? sHintCount : __builtin_ctz(neMask);
+
       lowerOut = pos * dist;
-      // -------------------------------------------------------------------------------------
-      for (pos2 = pos; pos2 < sHintCount; pos2++) {
-        if (mHint[pos2] != keyHead) {
-          break;
-        }
-      }
       if (pos2 < sHintCount) {
         upperOut = (pos2 + 1) * dist;
       }
-#else
-      Log::Error("Search hint with AVX512 failed: __AVX512F__ not found");
-#endif
     } else if (utils::tlsStore->mStoreOption->mBTreeHints == 1) {
       const uint16_t dist = mNumSlots / (sHintCount + 1);
       uint16_t pos, pos2;
@@ -72,6 +186,23 @@ void BTreeNode::SearchHint(HeadType keyHead, uint16_t& lowerOut, uint16_t& upper
   }
 }
 
+void BTreeNode::SearchHeads(HeadType keyHead, uint16_t& lower, uint16_t& upper) {
+  uint16_t numLess = 0;
+  uint16_t numNotGreater = 0;
+  const uint16_t numSimdHeads = (upper - lower) & ~uint16_t(7);
+  if (kHeadCount != nullptr && numSimdHeads > 0) {
+    kHeadCount(mSlot + lower, numSimdHeads, keyHead, numLess, numNotGreater);
+  }
+  for (uint16_t i = lower + numSimdHeads; i < upper; i++) {
+    numLess += mSlot[i].mHead < keyHead;
+    numNotGreater += mSlot[i].mHead <= keyHead;
+  }
+
+  // slots with smaller heads have smaller keys, slots with larger heads have larger keys
+  upper = lower + numNotGreater;
+  lower = lower + numLess;
+}
+
 int16_t BTreeNode::InsertDoNotCopyPayload(Slice key, uint16_t valSize, int32_t pos) {
   LS_DCHECK(CanInsert(key.size(), valSize));
   PrepareInsert(key.size(), valSize);
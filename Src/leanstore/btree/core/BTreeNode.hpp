@@ -17,6 +17,10 @@ class BTreeNodeHeader {
 public:
   static const uint16_t sHintCount = 16;
 
+  //! Max number of slots in the search range to compare all their heads at once, instead of the
+  //! binary search.
+  static const uint16_t sHeadScanThreshold = 64;
+
   struct SeparatorInfo {
     //! The full length of the separator key.
     uint16_t mSize;
@@ -323,8 +327,14 @@ public:
 
   int32_t CompareKeyWithBoundaries(Slice key);
 
+  //! Narrows the search range [lowerOut, upperOut) with the hints, the hints are compared with
+  //! SIMD instructions when mBTreeHints is 2.
   void SearchHint(HeadType keyHead, uint16_t& lowerOut, uint16_t& upperOut);
 
+  //! Narrows the search range [lower, upper) to the slots whose heads equal to the key head,
+  //! the heads are compared with SIMD instructions when supported by the cpu.
+  void SearchHeads(HeadType keyHead, uint16_t& lower, uint16_t& upper);
+
   template <bool equality_only = false>
   int16_t LinearSearchWithBias(Slice key, uint16_t startPos, bool higher = true);
 
@@ -548,6 +558,11 @@ inline int16_t BTreeNode::LowerBound(Slice key, bool* isEqual) {
   uint16_t upper = mNumSlots;
   HeadType keyHead = Head(key);
   SearchHint(keyHead, lower, upper);
+  if (utils::tlsStore->mStoreOption->mBTreeHints == 2 &&
+      utils::tlsStore->mStoreOption->mEnableHeadOptimization &&
+      upper - lower <= sHeadScanThreshold) {
+    SearchHeads(keyHead, lower, upper);
+  }
   while (lower < upper) {
     bool foundEqual(false);
     if (utils::tlsStore->mStoreOption->mEnableHeadOptimization) {
@@ -45,6 +45,9 @@ void WalPayload::ToJson(const WalPayload* wal, rapidjson::Document* doc) {
   case Type::kWalSplitNonRoot: {
     return toJson(reinterpret_cast<const WalSplitNonRoot*>(wal), doc);
   }
+  case Type::kWalBulkLoad: {
+    return toJson(reinterpret_cast<const WalBulkLoad*>(wal), doc);
+  }
   default:
     break;
   }
@@ -253,4 +256,25 @@ void WalPayload::toJson(const WalSplitNonRoot* wal, rapidjson::Document* doc) {
     doc->AddMember("mNewLeft", member, doc->GetAllocator());
   }
 }
+
+void WalPayload::toJson(const WalBulkLoad* wal, rapidjson::Document* doc) {
+  {
+    rapidjson::Value member;
+    member.SetUint64(wal->mSysTxId);
+    doc->AddMember("mSysTxId", member, doc->GetAllocator());
+  }
+
+  {
+    rapidjson::Value member;
+    member.SetUint64(wal->mRootPageId);
+    doc->AddMember("mRootPageId", member, doc->GetAllocator());
+  }
+
+  {
+    rapidjson::Value member;
+    member.SetUint64(wal->mHeight);
+    doc->AddMember("mHeight", member, doc->GetAllocator());
+  }
+}
+
 } // namespace leanstore::storage::btree
\ No newline at end of file
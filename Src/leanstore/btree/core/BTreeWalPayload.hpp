@@ -23,6 +23,7 @@ class WalTxRemove;
 class WalInitPage;
 class WalSplitRoot;
 class WalSplitNonRoot;
+class WalBulkLoad;
 
 #define DO_WITH_TYPES(ACTION, ...)                                                                 \
   ACTION(kWalInsert, 1, "kWalInsert", __VA_ARGS__)                                                 \
@@ -34,6 +35,7 @@ class WalSplitNonRoot;
   ACTION(kWalInitPage, 10, "kWalInitPage", __VA_ARGS__)                                            \
   ACTION(kWalSplitRoot, 11, "kWalSplitRoot", __VA_ARGS__)                                          \
   ACTION(kWalSplitNonRoot, 12, "kWalSplitNonRoot", __VA_ARGS__)                                    \
+  ACTION(kWalBulkLoad, 13, "kWalBulkLoad", __VA_ARGS__)                                            \
   ACTION(kWalUndefined, 100, "kWalUndefined", __VA_ARGS__)
 
 #define DECR_TYPE(type, type_value, type_name, ...) type = type_value,
@@ -80,6 +82,7 @@ private:
   static void toJson(const WalInitPage* wal, rapidjson::Document* doc);
   static void toJson(const WalSplitRoot* wal, rapidjson::Document* doc);
   static void toJson(const WalSplitNonRoot* wal, rapidjson::Document* doc);
+  static void toJson(const WalBulkLoad* wal, rapidjson::Document* doc);
 };
 
 #undef TYPE_NAME
@@ -340,4 +343,22 @@ public:
   }
 };
 
+//! Logged on the meta node when a bulk loaded tree is installed, the loaded pages are persisted
+//! before, only the new root needs to be redone.
+class WalBulkLoad : public WalPayload {
+public:
+  TXID mSysTxId;
+
+  PID mRootPageId;
+
+  uint64_t mHeight;
+
+  WalBulkLoad(TXID sysTxId, PID rootPageId, uint64_t height)
+      : WalPayload(Type::kWalBulkLoad),
+        mSysTxId(sysTxId),
+        mRootPageId(rootPageId),
+        mHeight(height) {
+  }
+};
+
 } // namespace leanstore::storage::btree
\ No newline at end of file
@@ -10,7 +10,9 @@
 #include "leanstore/utils/Log.hpp"
 #include "leanstore/utils/UserThread.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 #include <sys/syscall.h>
 
@@ -65,6 +67,21 @@ public:
   //! Tndicates whether the mFenceSize is for lower or upper fence key.
   bool mIsUsingUpperFence;
 
+  //! The maximum number of leaves read ahead at once, 0 disables read-ahead.
+  uint32_t mMaxReadAhead;
+
+  //! The number of sibling leaves to keep read ahead, 0 until the scan moves to another leaf.
+  uint32_t mReadAheadDepth;
+
+  //! The parent node whose children have been read ahead.
+  BufferFrame* mReadAheadParent;
+
+  //! The first child position in mReadAheadParent not read ahead yet, in the scan direction.
+  int32_t mReadAheadPos;
+
+  //! The initial read-ahead depth.
+  static constexpr uint32_t kMinReadAhead = 4;
+
 public:
   PessimisticIterator(BTreeGeneric& tree, const LatchMode mode = LatchMode::kPessimisticShared)
       : mBTree(tree),
@@ -79,7 +96,11 @@ public:
         mLeafPosInParent(-1),
         mBuffer(),
         mFenceSize(0),
-        mIsUsingUpperFence(false) {
+        mIsUsingUpperFence(false),
+        mMaxReadAhead(0),
+        mReadAheadDepth(0),
+        mReadAheadParent(nullptr),
+        mReadAheadPos(-1) {
   }
 
   //! move constructor
@@ -96,19 +117,25 @@ public:
         mLeafPosInParent(other.mLeafPosInParent),
         mBuffer(std::move(other.mBuffer)),
         mFenceSize(other.mFenceSize),
-        mIsUsingUpperFence(other.mIsUsingUpperFence) {
+        mIsUsingUpperFence(other.mIsUsingUpperFence),
+        mMaxReadAhead(other.mMaxReadAhead),
+        mReadAheadDepth(other.mReadAheadDepth),
+        mReadAheadParent(other.mReadAheadParent),
+        mReadAheadPos(other.mReadAheadPos) {
     other.SetToInvalid();
     other.mLeafPosInParent = -1;
   }
 
   //! Seek to the position of the key which = the given key
   void SeekToEqual(Slice key) override {
+    resetReadAhead();
     seekToTargetPageOnDemand(key);
     mSlotId = mGuardedLeaf->LowerBound<true>(key);
   }
 
   //! Seek to the position of the first key
   void SeekToFirst() override {
+    resetReadAhead();
     seekToTargetPage([](GuardedBufferFrame<BTreeNode>&) { return 0; });
     if (mGuardedLeaf->mNumSlots == 0) {
       SetToInvalid();
@@ -119,6 +146,7 @@ public:
 
   //! Seek to the position of the first key which >= the given key
   void SeekToFirstGreaterEqual(Slice key) override {
+    resetReadAhead();
     seekToTargetPageOnDemand(key);
 
     mSlotId = mGuardedLeaf->LowerBound<false>(key);
@@ -155,6 +183,7 @@ public:
 
   //! Seek to the position of the last key
   void SeekToLast() override {
+    resetReadAhead();
     seekToTargetPage([](GuardedBufferFrame<BTreeNode>& parent) { return parent->mNumSlots; });
     if (mGuardedLeaf->mNumSlots == 0) {
       SetToInvalid();
@@ -166,6 +195,7 @@ public:
 
   //! Seek to the position of the last key which <= the given key
   void SeekToLastLessEqual(Slice key) override {
+    resetReadAhead();
     seekToTargetPageOnDemand(key);
 
     bool isEqual = false;
@@ -241,6 +271,12 @@ public:
     mFuncCleanUp = cb;
   }
 
+  //! Read the evicted sibling leaves ahead with batched async reads when Next() or Prev() moves to
+  //! another leaf, up to maxPages leaves at once. 0 disables read-ahead.
+  void EnableReadAhead(uint32_t maxPages) {
+    mMaxReadAhead = maxPages;
+  }
+
   //! Experimental API
   OpCode SeekExactWithHint(Slice key, bool higher = true) {
     if (!Valid()) {
@@ -303,7 +339,22 @@ protected:
 
   //! Seek to the target page of the BTree
   //! @param childPosGetter a function to get the child position in the parent node
-  void seekToTargetPage(std::function<int32_t(GuardedBufferFrame<BTreeNode>&)> childPosGetter);
+  //! @param beforeLatchLeaf called with the parent of the target leaf latched optimistically and
+  //! mLeafPosInParent set, before the leaf is latched
+  void seekToTargetPage(std::function<int32_t(GuardedBufferFrame<BTreeNode>&)> childPosGetter,
+                        std::function<void()> beforeLatchLeaf = nullptr);
+
+  //! The iterator is positioned by a seek, read-ahead starts over on the next leaf change.
+  void resetReadAhead() {
+    mReadAheadDepth = 0;
+    mReadAheadParent = nullptr;
+  }
+
+  //! Called before the scan moves to the next (forward) or previous leaf, with no leaf latched so
+  //! that no latch is held during the IO. Doubles the read-ahead depth and reads the evicted
+  //! siblings of the leaf at mLeafPosInParent ahead in the scan direction, in batches of at least
+  //! half the depth.
+  void readAhead(bool forward);
 
   void assembleUpperFence() {
     mFenceSize = mGuardedLeaf->mUpperFence.mSize + 1;
@@ -357,6 +408,7 @@ inline void PessimisticIterator::Next() {
     if (utils::tlsStore->mStoreOption->mEnableOptimisticScan && mLeafPosInParent != -1) {
       JUMPMU_TRY() {
         if ((mLeafPosInParent + 1) <= mGuardedParent->mNumSlots) {
+          readAhead(true);
           int32_t nextLeafPos = mLeafPosInParent + 1;
           auto* nextLeafSwip = mGuardedParent->ChildSwipIncludingRightMost(nextLeafPos);
           GuardedBufferFrame<BTreeNode> guardedNextLeaf(mBTree.mStore->mBufferManager.get(),
@@ -390,9 +442,11 @@ inline void PessimisticIterator::Next() {
 
     mGuardedParent.unlock();
     Slice fenceKey = assembedFence();
-    seekToTargetPage([&fenceKey](GuardedBufferFrame<BTreeNode>& guardedNode) {
-      return guardedNode->LowerBound<false>(fenceKey);
-    });
+    seekToTargetPage(
+        [&fenceKey](GuardedBufferFrame<BTreeNode>& guardedNode) {
+          return guardedNode->LowerBound<false>(fenceKey);
+        },
+        [&]() { readAhead(true); });
 
     if (mGuardedLeaf->mNumSlots == 0) {
       SetCleanUpCallback([&, toMerge = mGuardedLeaf.mBf]() {
@@ -455,6 +509,7 @@ inline void PessimisticIterator::Prev() {
     if (utils::tlsStore->mStoreOption->mEnableOptimisticScan && mLeafPosInParent != -1) {
       JUMPMU_TRY() {
         if ((mLeafPosInParent - 1) >= 0) {
+          readAhead(false);
           int32_t nextLeafPos = mLeafPosInParent - 1;
           auto* nextLeafSwip = mGuardedParent->ChildSwip(nextLeafPos);
           GuardedBufferFrame<BTreeNode> guardedNextLeaf(mBTree.mStore->mBufferManager.get(),
@@ -487,9 +542,11 @@ inline void PessimisticIterator::Prev() {
 
     // Construct the next key (lower bound)
     Slice fenceKey = assembedFence();
-    seekToTargetPage([&fenceKey](GuardedBufferFrame<BTreeNode>& guardedNode) {
-      return guardedNode->LowerBound<false>(fenceKey);
-    });
+    seekToTargetPage(
+        [&fenceKey](GuardedBufferFrame<BTreeNode>& guardedNode) {
+          return guardedNode->LowerBound<false>(fenceKey);
+        },
+        [&]() { readAhead(false); });
 
     if (mGuardedLeaf->mNumSlots == 0) {
       continue;
@@ -509,7 +566,8 @@ inline void PessimisticIterator::Prev() {
 }
 
 inline void PessimisticIterator::seekToTargetPage(
-    std::function<int32_t(GuardedBufferFrame<BTreeNode>&)> childPosGetter) {
+    std::function<int32_t(GuardedBufferFrame<BTreeNode>&)> childPosGetter,
+    std::function<void()> beforeLatchLeaf) {
   if (mMode != LatchMode::kPessimisticShared && mMode != LatchMode::kPessimisticExclusive) {
     Log::Fatal("Unsupported latch mode: {}", uint64_t(mMode));
   }
@@ -532,6 +590,9 @@ inline void PessimisticIterator::seekToTargetPage(
 
         mGuardedParent = std::move(mGuardedLeaf);
         if (level == mBTree.mHeight - 1) {
+          if (beforeLatchLeaf != nullptr) {
+            beforeLatchLeaf();
+          }
           mGuardedLeaf = GuardedBufferFrame<BTreeNode>(mBTree.mStore->mBufferManager.get(),
                                                        mGuardedParent, *childSwip, mMode);
         } else {
@@ -560,4 +621,40 @@ inline void PessimisticIterator::seekToTargetPage(
   }
 }
 
+inline void PessimisticIterator::readAhead(bool forward) {
+  if (mMaxReadAhead == 0 || mLeafPosInParent == -1) {
+    return;
+  }
+  mReadAheadDepth = std::min(mReadAheadDepth == 0 ? kMinReadAhead : mReadAheadDepth * 2,
+                             mMaxReadAhead);
+
+  JUMPMU_TRY() {
+    // children are in [0, mNumSlots], the last one is the right most child
+    const int32_t step = forward ? 1 : -1;
+    const int32_t numChildren = mGuardedParent->mNumSlots + 1;
+    const int32_t depth = mReadAheadDepth;
+    const int32_t end = forward ? std::min(mLeafPosInParent + 1 + depth, numChildren)
+                                : std::max(mLeafPosInParent - 1 - depth, -1);
+    int32_t pos = mLeafPosInParent + step;
+    if (mReadAheadParent == mGuardedParent.mBf) {
+      pos = forward ? std::max(pos, mReadAheadPos) : std::min(pos, mReadAheadPos);
+    }
+    if ((end - pos) * step < std::max(depth / 2, 1)) {
+      JUMPMU_RETURN;
+    }
+
+    std::vector<Swip*> swips;
+    swips.reserve((end - pos) * step);
+    for (; pos != end; pos += step) {
+      swips.push_back(mGuardedParent->ChildSwipIncludingRightMost(pos));
+    }
+    mGuardedParent.JumpIfModifiedByOthers();
+    mBTree.mStore->mBufferManager->ReadAhead(mGuardedParent.mGuard, swips);
+    mReadAheadParent = mGuardedParent.mBf;
+    mReadAheadPos = end;
+  }
+  JUMPMU_CATCH() {
+  }
+}
+
 } // namespace leanstore::storage::btree
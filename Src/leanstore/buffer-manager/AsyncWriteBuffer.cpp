@@ -1,17 +1,34 @@
 #include "leanstore/buffer-manager/AsyncWriteBuffer.hpp"
 
 #include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/buffer-manager/PageCompression.hpp"
 #include "leanstore/utils/Log.hpp"
+#include "leanstore/utils/Misc.hpp"
 #include "leanstore/utils/Result.hpp"
 
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
 namespace leanstore::storage {
 
-AsyncWriteBuffer::AsyncWriteBuffer(int fd, uint64_t pageSize, uint64_t maxBatchSize)
+AsyncWriteBuffer::AsyncWriteBuffer(int fd, uint64_t pageSize, uint64_t maxBatchSize,
+                                   IoBackend ioBackend)
     : mFd(fd),
       mPageSize(pageSize),
-      mAIo(maxBatchSize),
+      mBlockSize(pageSize),
+      mAIo(maxBatchSize, ioBackend),
       mWriteBuffer(pageSize * maxBatchSize),
       mWriteCommands(maxBatchSize) {
+  mAIo.RegisterBuffers({iovec{mWriteBuffer.Get(), pageSize * maxBatchSize}});
+  mAIo.RegisterFiles({fd});
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == 0 && fileStat.st_blksize > 0) {
+    mBlockSize = fileStat.st_blksize;
+  }
 }
 
 AsyncWriteBuffer::~AsyncWriteBuffer() {
@@ -27,7 +44,7 @@ void AsyncWriteBuffer::Add(const BufferFrame& bf) {
   // record the written buffer frame and page id for later use
   auto pageId = bf.mHeader.mPageId;
   auto slot = mAIo.GetNumRequests();
-  mWriteCommands[slot].Reset(&bf, pageId);
+  mWriteCommands[slot].Reset(&bf, pageId, bf.mPage.mPsn, mPageSize);
 
   // copy the page content to write buffer
   auto* buffer = copyToBuffer(&bf.mPage, slot);
@@ -35,6 +52,22 @@ void AsyncWriteBuffer::Add(const BufferFrame& bf) {
   mAIo.PrepareWrite(mFd, buffer, mPageSize, mPageSize * pageId);
 }
 
+void AsyncWriteBuffer::AddCompressed(const BufferFrame& bf, const void* image) {
+  LS_DCHECK(uint64_t(&bf) % 512 == 0, "BufferFrame is not aligned to 512 bytes");
+
+  auto pageId = bf.mHeader.mPageId;
+  auto slot = mAIo.GetNumRequests();
+  auto* buffer = getWriteBuffer(slot);
+  auto writeSize = PageCompression::Compress(image, mPageSize, buffer);
+  if (writeSize == 0) {
+    Add(bf);
+    return;
+  }
+
+  mWriteCommands[slot].Reset(&bf, pageId, bf.mPage.mPsn, writeSize);
+  mAIo.PrepareWrite(mFd, buffer, writeSize, mPageSize * pageId);
+}
+
 Result<uint64_t> AsyncWriteBuffer::SubmitAll() {
   return mAIo.SubmitAll();
 }
@@ -47,13 +80,30 @@ void AsyncWriteBuffer::IterateFlushedBfs(
     std::function<void(BufferFrame& flushedBf, uint64_t flushedPsn)> callback,
     uint64_t numFlushedBfs) {
   for (uint64_t i = 0; i < numFlushedBfs; i++) {
-    const auto slot = (reinterpret_cast<uint64_t>(mAIo.GetIoEvent(i)->data) -
+    const auto slot = (reinterpret_cast<uint64_t>(mAIo.GetCompletedData(i)) -
                        reinterpret_cast<uint64_t>(mWriteBuffer.Get())) /
                       mPageSize;
-    auto* flushedPage = reinterpret_cast<Page*>(getWriteBuffer(slot));
-    auto flushedPsn = flushedPage->mPsn;
-    auto* flushedBf = mWriteCommands[slot].mBf;
-    callback(*const_cast<BufferFrame*>(flushedBf), flushedPsn);
+    auto& command = mWriteCommands[slot];
+    if (command.mWriteSize < mPageSize) {
+      punchHole(command);
+    }
+    callback(*const_cast<BufferFrame*>(command.mBf), command.mPsn);
+  }
+}
+
+void AsyncWriteBuffer::punchHole(const WriteCommand& command) {
+  const uint64_t slotBegin = mPageSize * command.mPageId;
+  const uint64_t holeBegin = utils::AlignUp(slotBegin + command.mWriteSize, mBlockSize);
+  const uint64_t holeEnd = utils::AlignDown(slotBegin + mPageSize, mBlockSize);
+  if (holeBegin >= holeEnd) {
+    return;
+  }
+
+  // the stale bytes are never read, failing to punch them only wastes space
+  if (fallocate(mFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, holeBegin,
+                holeEnd - holeBegin) != 0) {
+    Log::Warn("Failed to punch hole in page file, pageId={}, errno={}, error={}",
+              command.mPageId, errno, strerror(errno));
   }
 }
 
@@ -35,21 +35,34 @@ private:
     const BufferFrame* mBf;
     PID mPageId;
 
-    void Reset(const BufferFrame* bf, PID pageId) {
+    //! The psn of the written page, the write buffer may hold the compressed page.
+    uint64_t mPsn;
+
+    //! Bytes written for the page, less than the page size if it's compressed.
+    uint64_t mWriteSize;
+
+    void Reset(const BufferFrame* bf, PID pageId, uint64_t psn, uint64_t writeSize) {
       mBf = bf;
       mPageId = pageId;
+      mPsn = psn;
+      mWriteSize = writeSize;
     }
   };
 
   int mFd;
   uint64_t mPageSize;
+
+  //! The block size of the page file, the unit of hole punching.
+  uint64_t mBlockSize;
   utils::AsyncIo mAIo;
 
   utils::AlignedBuffer<512> mWriteBuffer;
   std::vector<WriteCommand> mWriteCommands;
 
 public:
-  AsyncWriteBuffer(int fd, uint64_t pageSize, uint64_t maxBatchSize);
+  //! With io_uring, the write buffer and fd are registered to the ring as fixed buffer and file.
+  AsyncWriteBuffer(int fd, uint64_t pageSize, uint64_t maxBatchSize,
+                   IoBackend ioBackend = kLibaio);
 
   ~AsyncWriteBuffer();
 
@@ -62,6 +75,11 @@ public:
   //! - prepare the io request
   void Add(const BufferFrame& bf);
 
+  //! Like Add(), but writes the LZ4 compressed page image instead of the page content, see
+  //! StoreOption::mEnablePageCompression. Falls back to Add() if the image is not compressible.
+  //! The image is the page prepared by BufferManagedTree::PrepareCompression().
+  void AddCompressed(const BufferFrame& bf, const void* image);
+
   //! Submit the write buffer to the AIO context to be written to the disk
   Result<uint64_t> SubmitAll();
 
@@ -72,10 +90,15 @@ public:
     return mAIo.GetNumRequests();
   }
 
+  //! The blocks of a compressed page's slot after the written bytes are punched out of the page
+  //! file once the write is done.
   void IterateFlushedBfs(std::function<void(BufferFrame& flushedBf, uint64_t flushedPsn)> callback,
                          uint64_t numFlushedBfs);
 
 private:
+  //! Deallocates the file system blocks of the page slot beyond the written bytes.
+  void punchHole(const WriteCommand& command);
+
   void* copyToBuffer(const Page* page, size_t slot) {
     void* dest = getWriteBuffer(slot);
     std::memcpy(dest, page, mPageSize);
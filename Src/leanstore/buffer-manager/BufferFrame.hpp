@@ -128,9 +128,8 @@ public:
 //! explicitly.
 class Page {
 public:
-  //! Short for "global sequence number", increased when a page is modified.
-  //! It's used to check whether the page has been read or written by
-  //! transactions in other workers.
+  //! Short for "global sequence number", the number of the last WalEntry of the page. Increased
+  //! when a WalEntry is written for the page, see Logging::NextGsn().
   uint64_t mGSN = 0;
 
   //! Short for "system transaction id", increased when a system transaction modifies the page.
@@ -3,59 +3,70 @@
 #include "leanstore/LeanStore.hpp"
 #include "leanstore/Units.hpp"
 #include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/buffer-manager/PageCompression.hpp"
 #include "leanstore/buffer-manager/TreeRegistry.hpp"
 #include "leanstore/concurrency/CRManager.hpp"
 #include "leanstore/concurrency/GroupCommitter.hpp"
 #include "leanstore/concurrency/Recovery.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/concurrency/WorkerThread.hpp"
 #include "leanstore/sync/HybridLatch.hpp"
 #include "leanstore/sync/ScopedHybridGuard.hpp"
 #include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
 #include "leanstore/utils/DebugFlags.hpp"
 #include "leanstore/utils/Defer.hpp"
 #include "leanstore/utils/Error.hpp"
 #include "leanstore/utils/JumpMU.hpp"
 #include "leanstore/utils/Log.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/Numa.hpp"
 #include "leanstore/utils/Parallelize.hpp"
 #include "leanstore/utils/UserThread.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cerrno>
 #include <cstdint>
 #include <cstring>
 #include <expected>
 #include <format>
+#include <memory>
+#include <utility>
 #include <vector>
 
 #include <fcntl.h>
 #include <linux/perf_event.h>
 #include <sys/resource.h>
+#include <sys/stat.h>
 #include <sys/time.h>
 #include <unistd.h>
 
 namespace leanstore::storage {
 
-BufferManager::BufferManager(leanstore::LeanStore* store) : mStore(store) {
+static std::atomic<uint64_t> sNextBufferManagerId = 1;
+
+//! The explicit huge page sizes supported by StoreOption::mHugePageSize.
+static constexpr uint64_t kHugePageSize2MB = 2ull << 20;
+static constexpr uint64_t kHugePageSize1GB = 1ull << 30;
+
+BufferManager::BufferManager(leanstore::LeanStore* store)
+    : mStore(store),
+      mInstanceId(sNextBufferManagerId.fetch_add(1)) {
   auto bpSize = mStore->mStoreOption->mBufferPoolSize;
   auto bfSize = mStore->mStoreOption->mBufferFrameSize;
   mNumBfs = bpSize / bfSize;
-  const uint64_t totalMemSize = bfSize * (mNumBfs + mNumSaftyBfs);
-
-  // Init buffer pool with zero-initialized buffer frames. Use mmap with flags
-  // MAP_PRIVATE and MAP_ANONYMOUS, no underlying file descriptor to allocate
-  // totalmemSize buffer pool with zero-initialized contents.
-  void* underlyingBuf =
-      mmap(NULL, totalMemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-  if (underlyingBuf == MAP_FAILED) {
-    Log::Fatal("Failed to allocate memory for the buffer pool, bufferPoolSize={}, totalMemSize={}",
-               mStore->mStoreOption->mBufferPoolSize, totalMemSize);
-  }
 
-  mBufferPool = reinterpret_cast<uint8_t*>(underlyingBuf);
-  madvise(mBufferPool, totalMemSize, MADV_HUGEPAGE);
-  madvise(mBufferPool, totalMemSize, MADV_DONTFORK);
+  // Init buffer pool with zero-initialized buffer frames.
+  allocBufferPool();
 
   // Initialize mPartitions
   mNumPartitions = mStore->mStoreOption->mNumPartitions;
   mPartitionsMask = mNumPartitions - 1;
+
+  // Bind the buffer frames of each NUMA node before they are touched
+  initNumaNodes();
   const uint64_t freeBfsLimitPerPartition =
       std::ceil((mStore->mStoreOption->mFreePct * 1.0 * mNumBfs / 100.0) / mNumPartitions);
   for (uint64_t i = 0; i < mNumPartitions; i++) {
@@ -64,18 +75,96 @@ BufferManager::BufferManager(leanstore::LeanStore* store) : mStore(store) {
   Log::Info("Init buffer manager, IO partitions={}, freeBfsLimitPerPartition={}", mNumPartitions,
             freeBfsLimitPerPartition);
 
-  // spread these buffer frames to all the partitions
+  // spread these buffer frames to all the partitions, buffer frames of a NUMA node only to the
+  // partitions of that node
   utils::Parallelize::ParallelRange(mNumBfs, [&](uint64_t begin, uint64_t end) {
-    uint64_t partitionId = 0;
+    uint64_t nth = 0;
     for (uint64_t i = begin; i < end; i++) {
-      auto& partition = GetPartition(partitionId);
       auto* bfAddr = &mBufferPool[i * mStore->mStoreOption->mBufferFrameSize];
-      partition.mFreeBfList.PushFront(*new (bfAddr) BufferFrame());
-      partitionId = (partitionId + 1) % mNumPartitions;
+      auto* bf = new (bfAddr) BufferFrame();
+      auto node = GetNumaNode(*bf);
+      auto numPartitionsOfNode = (mNumPartitions - node + mNumNumaNodes - 1) / mNumNumaNodes;
+      auto& partition = GetPartition(node + (nth % numPartitionsOfNode) * mNumNumaNodes);
+      partition.mFreeBfList.PushFront(*bf);
+      nth++;
     }
   });
 }
 
+void BufferManager::allocBufferPool() {
+  const uint64_t totalMemSize = mStore->mStoreOption->mBufferFrameSize * (mNumBfs + mNumSaftyBfs);
+  const auto hugePageSize = mStore->mStoreOption->mHugePageSize;
+  const bool explicitHugePages =
+      hugePageSize == kHugePageSize2MB || hugePageSize == kHugePageSize1GB;
+
+  // Use mmap with flags MAP_PRIVATE and MAP_ANONYMOUS, no underlying file descriptor to allocate
+  // totalmemSize buffer pool with zero-initialized contents. Explicit huge pages need the size to
+  // be a multiple of the huge page size.
+  void* underlyingBuf = MAP_FAILED;
+  if (explicitHugePages) {
+    mBufferPoolMemSize = utils::AlignUp(totalMemSize, hugePageSize);
+    mBufferPoolPageSize = hugePageSize;
+    const int hugePageFlags = MAP_HUGETLB | (std::countr_zero(hugePageSize) << MAP_HUGE_SHIFT);
+    underlyingBuf = mmap(NULL, mBufferPoolMemSize, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | hugePageFlags, -1, 0);
+    if (underlyingBuf == MAP_FAILED) {
+      Log::Warn("Failed to allocate huge pages for the buffer pool, fallback to transparent huge "
+                "pages, hugePageSize={}, totalMemSize={}, errno={}",
+                hugePageSize, mBufferPoolMemSize, errno);
+    }
+  }
+
+  if (underlyingBuf == MAP_FAILED) {
+    mBufferPoolMemSize = totalMemSize;
+    mBufferPoolPageSize = sysconf(_SC_PAGESIZE);
+    underlyingBuf =
+        mmap(NULL, mBufferPoolMemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (underlyingBuf == MAP_FAILED) {
+      Log::Fatal("Failed to allocate memory for the buffer pool, bufferPoolSize={}, "
+                 "totalMemSize={}",
+                 mStore->mStoreOption->mBufferPoolSize, totalMemSize);
+    }
+    auto advice = (hugePageSize == 0 || explicitHugePages) ? MADV_HUGEPAGE : MADV_NOHUGEPAGE;
+    madvise(underlyingBuf, mBufferPoolMemSize, advice);
+  }
+
+  mBufferPool = reinterpret_cast<uint8_t*>(underlyingBuf);
+  madvise(mBufferPool, mBufferPoolMemSize, MADV_DONTFORK);
+  Log::Info("Init buffer pool, totalMemSize={}, pageSize={}", mBufferPoolMemSize,
+            mBufferPoolPageSize);
+}
+
+void BufferManager::initNumaNodes() {
+  mNumNumaNodes = 1;
+  mNumBfsPerNumaNode = mNumBfs;
+  if (!mStore->mStoreOption->mEnableNuma) {
+    return;
+  }
+
+  auto numNodes = std::min<uint64_t>(utils::NumNumaNodes(), LEANSTORE_PERF_MAX_NUMA_NODES);
+  if (numNodes <= 1) {
+    Log::Info("NUMA disabled, only one NUMA node available");
+    return;
+  }
+  if (mNumPartitions < numNodes) {
+    Log::Warn("NUMA disabled, fewer partitions than NUMA nodes, numPartitions={}, numNodes={}",
+              mNumPartitions, numNodes);
+    return;
+  }
+
+  mNumNumaNodes = numNodes;
+  mNumBfsPerNumaNode = mNumBfs / mNumNumaNodes;
+  const auto bfSize = mStore->mStoreOption->mBufferFrameSize;
+  for (uint64_t node = 0; node < mNumNumaNodes; node++) {
+    auto begin = node * mNumBfsPerNumaNode;
+    auto end = node + 1 == mNumNumaNodes ? mNumBfs + mNumSaftyBfs : begin + mNumBfsPerNumaNode;
+    utils::BindToNumaNode(&mBufferPool[begin * bfSize], (end - begin) * bfSize, node,
+                          mBufferPoolPageSize);
+  }
+  Log::Info("Init buffer manager, NUMA nodes={}, buffer frames per node={}", mNumNumaNodes,
+            mNumBfsPerNumaNode);
+}
+
 void BufferManager::StartPageEvictors() {
   auto numBufferProviders = mStore->mStoreOption->mNumBufferProviders;
   // make it optional for pure in-memory experiments
@@ -84,6 +173,16 @@ void BufferManager::StartPageEvictors() {
   }
 
   LS_DCHECK(numBufferProviders <= mNumPartitions);
+
+  // With NUMA, page evictor i serves node i % numNodes, if there are enough page evictors for all
+  // the nodes. Otherwise every page evictor serves all the nodes.
+  const bool evictorsPerNode = mNumNumaNodes > 1 && numBufferProviders >= mNumNumaNodes;
+  if (mNumNumaNodes > 1 && !evictorsPerNode) {
+    Log::Warn("Page evictors are not bound to NUMA nodes, numBufferProviders={}, numNodes={}",
+              numBufferProviders, mNumNumaNodes);
+  }
+  const uint64_t numEvictorNodes = evictorsPerNode ? mNumNumaNodes : 1;
+
   mPageEvictors.reserve(numBufferProviders);
   for (auto i = 0u; i < numBufferProviders; ++i) {
     std::string threadName = "PageEvictor";
@@ -91,10 +190,26 @@ void BufferManager::StartPageEvictors() {
       threadName += std::to_string(i);
     }
 
-    auto runningCPU = mStore->mStoreOption->mWorkerThreads + mStore->mStoreOption->mEnableWal + i;
-    mPageEvictors.push_back(std::make_unique<PageEvictor>(mStore, threadName, runningCPU, mNumBfs,
-                                                          mBufferPool, mNumPartitions,
-                                                          mPartitionsMask, mPartitions));
+    // each page evictor sweeps its own slice of the buffer frames of its node with kEvictionClock
+    const uint64_t node = i % numEvictorNodes;
+    const uint64_t nodeBegin = evictorsPerNode ? node * mNumBfsPerNumaNode : 0;
+    const uint64_t nodeEnd =
+        evictorsPerNode && node + 1 < mNumNumaNodes ? nodeBegin + mNumBfsPerNumaNode : mNumBfs;
+    const uint64_t numEvictorsOfNode =
+        (numBufferProviders - node + numEvictorNodes - 1) / numEvictorNodes;
+    const uint64_t nth = i / numEvictorNodes;
+    auto clockBegin = nodeBegin + (nodeEnd - nodeBegin) * nth / numEvictorsOfNode;
+    auto clockEnd = nodeBegin + (nodeEnd - nodeBegin) * (nth + 1) / numEvictorsOfNode;
+
+    // page evictors bound to a node are pinned to all the CPUs of the node
+    int runningCPU = -1;
+    if (!evictorsPerNode) {
+      runningCPU = static_cast<int>(mStore->mStoreOption->mWorkerThreads +
+                                    mStore->mStoreOption->mEnableWal + i);
+    }
+    mPageEvictors.push_back(std::make_unique<PageEvictor>(
+        mStore, threadName, runningCPU, mNumBfs, mBufferPool, mNumPartitions, mPartitionsMask,
+        mPartitions, clockBegin, clockEnd, evictorsPerNode ? node : PageEvictor::kAllNumaNodes));
   }
 
   for (auto i = 0u; i < mPageEvictors.size(); ++i) {
@@ -102,6 +217,30 @@ void BufferManager::StartPageEvictors() {
   }
 }
 
+void BufferManager::StartCheckpointer() {
+  if (mStore->mStoreOption->mCheckpointIntervalMs == 0 || mCheckpointer != nullptr) {
+    return;
+  }
+  mCheckpointLsns.resize(mStore->mWalFds.size(), 0);
+  mCheckpointer = std::make_unique<Checkpointer>(mStore, mCheckpointLsns);
+  mCheckpointer->Start();
+}
+
+void BufferManager::StopCheckpointer() {
+  if (mCheckpointer == nullptr) {
+    return;
+  }
+  mCheckpointer->Stop();
+  auto checkpointLsns = mCheckpointer->GetCheckpointLsns();
+  for (uint64_t walId = 0; walId < mCheckpointLsns.size(); walId++) {
+    mCheckpointLsns[walId] = std::max(mCheckpointLsns[walId], checkpointLsns[walId]);
+  }
+  mCheckpointer = nullptr;
+}
+
+constexpr char kKeyMaxPageId[] = "max_pid";
+constexpr char kKeyCheckpointLsn[] = "checkpoint_lsn";
+
 StringMap BufferManager::Serialize() {
   // TODO: correctly serialize ranges of used pages
   StringMap map;
@@ -109,12 +248,17 @@ StringMap BufferManager::Serialize() {
   for (uint64_t i = 0; i < mNumPartitions; i++) {
     maxPageId = std::max<PID>(GetPartition(i).mNextPageId, maxPageId);
   }
-  map["max_pid"] = std::to_string(maxPageId);
+  map[kKeyMaxPageId] = std::to_string(maxPageId);
+  map[kKeyCheckpointLsn] = utils::JoinNumbers(mCheckpointLsns);
   return map;
 }
 
 void BufferManager::Deserialize(StringMap map) {
-  PID maxPageId = std::stoull(map["max_pid"]);
+  if (map.contains(kKeyCheckpointLsn)) {
+    mCheckpointLsns = utils::SplitNumbers(map[kKeyCheckpointLsn]);
+  }
+
+  PID maxPageId = std::stoull(map[kKeyMaxPageId]);
   maxPageId = (maxPageId + (mNumPartitions - 1)) & ~(mNumPartitions - 1);
   for (uint64_t i = 0; i < mNumPartitions; i++) {
     GetPartition(i).mNextPageId = maxPageId + i;
@@ -131,6 +275,8 @@ Result<void> BufferManager::CheckpointAllBufferFrames() {
     Log::Info("CheckpointAllBufferFrames finished, timeElasped={:.6f}s", elaspedNs / 1000000000.0);
   });
 
+  StopCheckpointer();
+
   LS_DEBUG_EXECUTE(mStore, "skip_CheckpointAllBufferFrames", {
     Log::Error("CheckpointAllBufferFrames skipped due to debug flag");
     return std::unexpected(utils::Error::General("skipped due to debug flag"));
@@ -149,13 +295,15 @@ Result<void> BufferManager::CheckpointAllBufferFrames() {
     auto batchSize = 0u;
 
     // the aio itself
-    utils::AsyncIo aio(batchCapacity);
+    utils::AsyncIo aio(batchCapacity, mStore->mStoreOption->mIoBackend);
+    aio.RegisterBuffers({iovec{buffer, pageSize * batchCapacity}});
+    aio.RegisterFiles({mStore->mPageFd});
 
     for (uint64_t i = begin; i < end;) {
       // collect a batch of pages for async write
       for (; batchSize < batchCapacity && i < end; i++) {
         auto& bf = *reinterpret_cast<BufferFrame*>(&mBufferPool[i * bufferFrameSize]);
-        if (!bf.IsFree()) {
+        if (!bf.IsFree() && bf.IsDirty()) {
           auto* tmpBuffer = buffer + batchSize * pageSize;
           auto pageOffset = bf.mHeader.mPageId * pageSize;
           mStore->mTreeRegistry->Checkpoint(bf.mPage.mBTreeId, bf, tmpBuffer);
@@ -178,6 +326,10 @@ Result<void> BufferManager::CheckpointAllBufferFrames() {
     }
   });
 
+  // all the logged changes are persisted
+  if (!mStore->mCRManager->mGroupCommitters.empty()) {
+    mCheckpointLsns = mStore->mCRManager->WalSizes();
+  }
   return {};
 }
 
@@ -197,9 +349,35 @@ Result<void> BufferManager::CheckpointBufferFrame(BufferFrame& bf) {
 }
 
 void BufferManager::RecoverFromDisk() {
-  auto recovery = std::make_unique<leanstore::cr::Recovery>(
-      mStore, 0, mStore->mCRManager->mGroupCommitter->mWalSize);
-  recovery->Run();
+  // the WAL files grow after the WAL sizes in the meta file are persisted, recovery scans them to
+  // the last complete WalEntry
+  auto walSizes = mStore->mCRManager->WalSizes();
+  for (uint64_t walId = 0; walId < walSizes.size(); walId++) {
+    struct stat st;
+    if (fstat(mStore->mWalFds[walId], &st) == 0) {
+      walSizes[walId] = std::max<uint64_t>(walSizes[walId], st.st_size);
+    }
+  }
+  mCheckpointLsns.resize(walSizes.size(), 0);
+  Log::Info("Recover from checkpoint, checkpointLsn={}, walSize={}",
+            utils::JoinNumbers(mCheckpointLsns), utils::JoinNumbers(walSizes));
+  auto recovery = std::make_unique<leanstore::cr::Recovery>(mStore, mCheckpointLsns, walSizes);
+  if (recovery->Run()) {
+    Log::Fatal("Failed to recover from disk, storeDir={}", mStore->mStoreOption->mStoreDir);
+  }
+
+  // new WalEntries are appended after the recovered ones
+  auto recoveredWalSizes = recovery->WalFileSizes();
+  for (uint64_t walId = 0; walId < recoveredWalSizes.size(); walId++) {
+    mStore->mCRManager->mGroupCommitters[walId]->mWalSize = recoveredWalSizes[walId];
+  }
+
+  // the recovered transactions may start after the transaction timestamp persisted in the meta
+  // file, they are visible to the transactions started afterwards
+  if (mStore->mUsrTso.load() <= recovery->MaxTxId()) {
+    mStore->mUsrTso = recovery->MaxTxId() + 1;
+    mStore->mCRManager->mGlobalWmkInfo.mWmkOfAllTx = mStore->mUsrTso.load();
+  }
 }
 
 uint64_t BufferManager::ConsumedPages() {
@@ -213,7 +391,7 @@ uint64_t BufferManager::ConsumedPages() {
 }
 
 BufferFrame& BufferManager::AllocNewPageMayJump(TREEID treeId) {
-  Partition& partition = RandomPartition();
+  Partition& partition = FreeBfPartition();
   BufferFrame& freeBf = partition.mFreeBfList.PopFrontMayJump();
   memset((void*)&freeBf, 0, mStore->mStoreOption->mBufferFrameSize);
   new (&freeBf) BufferFrame();
@@ -247,6 +425,10 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
     // Resolve swip from hot state
     auto* bf = &swipInNode.AsBufferFrame();
     nodeGuard.JumpIfModifiedByOthers();
+    COUNTERS_BLOCK() {
+      PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferHotHits, 1);
+      recordNumaHit(*bf);
+    }
     return bf;
   }
 
@@ -259,6 +441,10 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
     BMExclusiveGuard bfXGuard(bfGuard);               // child
     bf->mHeader.mState = State::kHot;
     swipInNode.MarkHOT();
+    COUNTERS_BLOCK() {
+      PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferCoolHits, 1);
+      recordNumaHit(*bf);
+    }
     return bf;
   }
 
@@ -281,8 +467,8 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
 
   // Create an IO frame to read page from disk.
   if (!frameHandler) {
-    // 1. Randomly get a buffer frame from partitions
-    BufferFrame& bf = RandomPartition().mFreeBfList.PopFrontMayJump();
+    // 1. Get a free buffer frame, preferably on the NUMA node of the worker
+    BufferFrame& bf = FreeBfPartition().mFreeBfList.PopFrontMayJump();
     LS_DCHECK(!bf.mHeader.mLatch.IsLockedExclusively());
     LS_DCHECK(bf.mHeader.mState == State::kFree);
 
@@ -293,45 +479,60 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
     JumpScoped<std::unique_lock<std::mutex>> ioFrameGuard(ioFrame.mMutex);
     inflightIOGuard->unlock();
 
-    // 3. Read page at pageId to the target buffer frame
-    ReadPageSync(pageId, &bf.mPage);
-    LS_DLOG("Read page from disk, pageId={}, btreeId={}", pageId, bf.mPage.mBTreeId);
-
-    // 4. Intialize the buffer frame header
-    LS_DCHECK(!bf.mHeader.mIsBeingWrittenBack);
-    bf.mHeader.mFlushedPsn = bf.mPage.mPsn;
-    bf.mHeader.mState = State::kLoaded;
-    bf.mHeader.mPageId = pageId;
-    if (mStore->mStoreOption->mEnableBufferCrcCheck) {
-      bf.mHeader.mCrc = bf.mPage.CRC();
-    }
+    // 3. Read page at pageId to the target buffer frame, the job is parked during the read if
+    // possible. The parked read publishes the buffer frame as ready in the IO frame, it's then
+    // installed below like by any other resolver waiting for the IO frame.
+    if (cr::WorkerThread::CanPark()) {
+      ioFrameGuard->release(); // unlocked by the parked read
+      readPageParked(pageId, bf, ioFrame, partition);
 
-    // 5. Publish the buffer frame
-    JUMPMU_TRY() {
+      // the IO frame may have been consumed by another resolver meanwhile
+      inflightIOGuard->lock();
       nodeGuard.JumpIfModifiedByOthers();
-      ioFrameGuard->unlock();
-      JumpScoped<std::unique_lock<std::mutex>> inflightIOGuard(partition.mInflightIOMutex);
-      BMExclusiveUpgradeIfNeeded swipXGuard(nodeGuard);
-
-      swipInNode.MarkHOT(&bf);
-      bf.mHeader.mState = State::kHot;
-
-      if (ioFrame.mNumReaders.fetch_add(-1) == 1) {
-        partition.mInflightIOs.Remove(pageId);
+      frameHandler = partition.mInflightIOs.Lookup(pageId);
+      if (!frameHandler) {
+        inflightIOGuard->unlock();
+        jumpmu::Jump();
+      }
+    } else {
+      ReadPageSync(pageId, &bf.mPage);
+      COUNTERS_BLOCK() {
+        PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferMisses, 1);
       }
+      LS_DLOG("Read page from disk, pageId={}, btreeId={}", pageId, bf.mPage.mBTreeId);
 
-      JUMPMU_RETURN & bf;
-    }
-    JUMPMU_CATCH() {
-      // Change state to ready if contention is encountered
-      inflightIOGuard->lock();
-      ioFrame.mBf = &bf;
-      ioFrame.mState = IOFrame::State::kReady;
-      inflightIOGuard->unlock();
-      if (ioFrameGuard->owns_lock()) {
+      // 4. Intialize the buffer frame header
+      initReadFrame(pageId, bf);
+
+      // 5. Publish the buffer frame
+      JUMPMU_TRY() {
+        nodeGuard.JumpIfModifiedByOthers();
+        ioFrame.mIsReadDone = true;
         ioFrameGuard->unlock();
+        JumpScoped<std::unique_lock<std::mutex>> inflightIOGuard(partition.mInflightIOMutex);
+        BMExclusiveUpgradeIfNeeded swipXGuard(nodeGuard);
+
+        swipInNode.MarkHOT(&bf);
+        bf.mHeader.mState = State::kHot;
+
+        if (ioFrame.mNumReaders.fetch_add(-1) == 1) {
+          partition.mInflightIOs.Remove(pageId);
+        }
+
+        JUMPMU_RETURN & bf;
+      }
+      JUMPMU_CATCH() {
+        // Change state to ready if contention is encountered
+        inflightIOGuard->lock();
+        ioFrame.mBf = &bf;
+        ioFrame.mState = IOFrame::State::kReady;
+        inflightIOGuard->unlock();
+        ioFrame.mIsReadDone = true;
+        if (ioFrameGuard->owns_lock()) {
+          ioFrameGuard->unlock();
+        }
+        jumpmu::Jump();
       }
-      jumpmu::Jump();
     }
   }
 
@@ -341,9 +542,14 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
     ioFrame.mNumReaders++; // incremented while holding partition lock
     inflightIOGuard->unlock();
 
-    // wait untile the reading is finished
-    JumpScoped<std::unique_lock<std::mutex>> ioFrameGuard(ioFrame.mMutex);
-    ioFrameGuard->unlock(); // no need to hold the mutex anymore
+    // wait untile the reading is finished. A job which can't be parked must not block on the
+    // mutex, the read may be one of a job parked on the same thread, which is finished by polling
+    // it in WaitParked().
+    auto isReadDone = [&]() { return ioFrame.mIsReadDone.load(); };
+    if (!cr::WorkerThread::Park(isReadDone) && !cr::WorkerThread::WaitParked(isReadDone)) {
+      JumpScoped<std::unique_lock<std::mutex>> ioFrameGuard(ioFrame.mMutex);
+      ioFrameGuard->unlock(); // no need to hold the mutex anymore
+    }
     if (ioFrame.mNumReaders.fetch_add(-1) == 1) {
       inflightIOGuard->lock();
       if (ioFrame.mNumReaders == 0) {
@@ -398,6 +604,27 @@ BufferFrame* BufferManager::ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swi
 
 void BufferManager::ReadPageSync(PID pageId, void* pageBuffer) {
   LS_DCHECK(uint64_t(pageBuffer) % 512 == 0);
+  const int64_t pageSize = mStore->mStoreOption->mPageSize;
+  if (mStore->mStoreOption->mIoBackend == kIoUring) {
+    auto& aio = threadLocalAio();
+    if (aio.GetBackend() == kIoUring) {
+      aio.PrepareRead(mStore->mPageFd, pageBuffer, pageSize, pageId * pageSize);
+      if (auto res = aio.SubmitAll(); !res) {
+        Log::Fatal("Failed to submit page read, pageId={}, error={}", pageId,
+                   res.error().ToString());
+      }
+      if (auto res = aio.WaitAllCompletions(); !res) {
+        Log::Fatal("Failed to wait page read, pageId={}, error={}", pageId,
+                   res.error().ToString());
+      }
+      if (aio.GetCompletedResult(0) == pageSize) {
+        decompressIfNeeded(pageId, pageBuffer);
+        return;
+      }
+      // a short read or a failed read (negative result) is retried by the pread path below
+    }
+  }
+
   int64_t bytesLeft = mStore->mStoreOption->mPageSize;
   while (bytesLeft > 0) {
     auto totalRead = mStore->mStoreOption->mPageSize - bytesLeft;
@@ -424,6 +651,206 @@ void BufferManager::ReadPageSync(PID pageId, void* pageBuffer) {
 
     bytesLeft -= bytesRead;
   }
+  decompressIfNeeded(pageId, pageBuffer);
+}
+
+void BufferManager::decompressIfNeeded(PID pageId, void* pageBuffer) {
+  if (!PageCompression::IsCompressed(pageBuffer)) {
+    return;
+  }
+  if (!PageCompression::Decompress(pageBuffer, mStore->mStoreOption->mPageSize)) {
+    Log::Fatal("Failed to decompress page, pageId={}, file={}", pageId, mStore->GetDbFilePath());
+  }
+}
+
+void BufferManager::initReadFrame(PID pageId, BufferFrame& bf) {
+  LS_DCHECK(!bf.mHeader.mIsBeingWrittenBack);
+  bf.mHeader.mFlushedPsn = bf.mPage.mPsn;
+  bf.mHeader.mState = State::kLoaded;
+  bf.mHeader.mPageId = pageId;
+  if (mStore->mStoreOption->mEnableBufferCrcCheck) {
+    bf.mHeader.mCrc = bf.mPage.CRC();
+  }
+}
+
+void BufferManager::readPageParked(PID pageId, BufferFrame& bf, IOFrame& ioFrame,
+                                   Partition& partition) {
+  const int64_t pageSize = mStore->mStoreOption->mPageSize;
+  auto& aio = jobAio();
+  aio.SetEventFd(cr::WorkerThread::IoEventFd());
+  aio.PrepareRead(mStore->mPageFd, &bf.mPage, pageSize, pageId * pageSize);
+  if (auto res = aio.SubmitAll(); !res) {
+    Log::Fatal("Failed to submit page read, pageId={}, error={}", pageId, res.error().ToString());
+  }
+
+  // the read is finished by whoever polls it first on this thread, the worker thread or a job
+  // waiting for the IO frame in WorkerThread::WaitParked()
+  bool isDone = false;
+  [[maybe_unused]] auto parked = cr::WorkerThread::Park([&]() {
+    if (isDone) {
+      return true;
+    }
+    auto res = aio.PollAll();
+    if (!res) {
+      Log::Fatal("Failed to poll page reads, error={}", res.error().ToString());
+    }
+    if (!res.value()) {
+      return false;
+    }
+
+    // short read or read error, handled by ReadPageSync()
+    if (aio.GetCompletedResult(0) == pageSize) {
+      decompressIfNeeded(pageId, &bf.mPage);
+    } else {
+      ReadPageSync(pageId, &bf.mPage);
+    }
+    COUNTERS_BLOCK() {
+      PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferMisses, 1);
+    }
+    LS_DLOG("Read page from disk, pageId={}, btreeId={}", pageId, bf.mPage.mBTreeId);
+    initReadFrame(pageId, bf);
+
+    std::unique_lock<std::mutex> inflightIOGuard(partition.mInflightIOMutex);
+    ioFrame.mBf = &bf;
+    ioFrame.mState = IOFrame::State::kReady;
+    inflightIOGuard.unlock();
+    ioFrame.mIsReadDone = true;
+    ioFrame.mMutex.unlock();
+    isDone = true;
+    return true;
+  });
+  LS_DCHECK(parked);
+}
+
+uint64_t BufferManager::ReadAhead(HybridGuard& nodeGuard, const std::vector<Swip*>& swips) {
+  LS_DCHECK(nodeGuard.mState == GuardState::kOptimisticShared);
+  struct ReadAheadPage {
+    Swip* mSwip;
+    PID mPageId;
+    BufferFrame* mBf;
+    IOFrame* mIoFrame;
+  };
+
+  // 1. Collect the evicted children, the swips are read optimistically
+  const uint64_t maxPages = mStore->mStoreOption->mMaxScanReadAheadPages;
+  std::vector<ReadAheadPage> pages;
+  pages.reserve(swips.size());
+  for (auto* swip : swips) {
+    if (pages.size() >= maxPages) {
+      break;
+    }
+    if (swip->IsEvicted()) {
+      pages.push_back({swip, swip->AsPageId(), nullptr, nullptr});
+    }
+  }
+  JUMPMU_TRY() {
+    nodeGuard.JumpIfModifiedByOthers();
+  }
+  JUMPMU_CATCH() {
+    return 0;
+  }
+
+  // 2. Register the pages as inflight IOs, pages already being read by others are skipped, so are
+  // the rest once the free buffer frames run out
+  uint64_t numPages = 0;
+  for (auto& page : pages) {
+    BufferFrame* bf = nullptr;
+    Partition* freeBfPartition = &FreeBfPartition();
+    JUMPMU_TRY() {
+      bf = &freeBfPartition->mFreeBfList.PopFrontMayJump();
+    }
+    JUMPMU_CATCH() {
+      break;
+    }
+
+    Partition& partition = GetPartition(page.mPageId);
+    std::unique_lock<std::mutex> inflightIOGuard(partition.mInflightIOMutex);
+    if (partition.mInflightIOs.Lookup(page.mPageId)) {
+      inflightIOGuard.unlock();
+      freeBfPartition->mFreeBfList.PushFront(*bf);
+      continue;
+    }
+    IOFrame& ioFrame = partition.mInflightIOs.Insert(page.mPageId);
+    ioFrame.mState = IOFrame::State::kReading;
+    ioFrame.mNumReaders = 1;
+    ioFrame.mMutex.lock();
+    page.mBf = bf;
+    page.mIoFrame = &ioFrame;
+    pages[numPages++] = page;
+  }
+  pages.resize(numPages);
+  if (pages.empty()) {
+    return 0;
+  }
+
+  // 3. Read all the pages with one batch
+  const int64_t pageSize = mStore->mStoreOption->mPageSize;
+  auto& aio = jobAio();
+  for (auto& page : pages) {
+    aio.PrepareRead(mStore->mPageFd, &page.mBf->mPage, pageSize, page.mPageId * pageSize);
+  }
+  if (auto res = aio.SubmitAll(); !res) {
+    Log::Fatal("Failed to submit read-ahead, numPages={}, error={}", pages.size(),
+               res.error().ToString());
+  }
+
+  // not parked, the IO frames are locked until the pages are published below, a job parked with
+  // them would block the other jobs of this thread resolving the same pages. A failed read only
+  // fails its own page.
+  if (auto res = aio.WaitAllCompletions(); !res) {
+    Log::Fatal("Failed to wait read-ahead, numPages={}, error={}", pages.size(),
+               res.error().ToString());
+  }
+
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (aio.GetCompletedResult(i) == pageSize) {
+      continue;
+    }
+    // short read or read error (negative result), retried by ReadPageSync()
+    for (auto& page : pages) {
+      if (&page.mBf->mPage == aio.GetCompletedData(i)) {
+        ReadPageSync(page.mPageId, &page.mBf->mPage);
+      }
+    }
+  }
+
+  // 4. Intialize the buffer frame headers
+  for (auto& page : pages) {
+    decompressIfNeeded(page.mPageId, &page.mBf->mPage);
+    initReadFrame(page.mPageId, *page.mBf);
+  }
+
+  // 5. Publish the buffer frames as hot children of the node, or leave them ready in the IO frames
+  // for the next resolver if the node has been modified meanwhile
+  bool published = false;
+  JUMPMU_TRY() {
+    BMExclusiveUpgradeIfNeeded nodeXGuard(nodeGuard);
+    for (auto& page : pages) {
+      page.mSwip->MarkHOT(page.mBf);
+      page.mBf->mHeader.mState = State::kHot;
+    }
+    published = true;
+  }
+  JUMPMU_CATCH() {
+  }
+
+  for (auto& page : pages) {
+    Partition& partition = GetPartition(page.mPageId);
+    auto& ioFrame = *page.mIoFrame;
+    std::unique_lock<std::mutex> inflightIOGuard(partition.mInflightIOMutex);
+    if (published) {
+      if (ioFrame.mNumReaders.fetch_add(-1) == 1) {
+        partition.mInflightIOs.Remove(page.mPageId);
+      }
+    } else {
+      ioFrame.mBf = page.mBf;
+      ioFrame.mState = IOFrame::State::kReady;
+    }
+    inflightIOGuard.unlock();
+    ioFrame.mIsReadDone = true;
+    ioFrame.mMutex.unlock();
+  }
+  return pages.size();
 }
 
 BufferFrame& BufferManager::ReadPageSync(PID pageId) {
@@ -464,10 +891,59 @@ void BufferManager::StopPageEvictors() {
   mPageEvictors.clear();
 }
 
+utils::AsyncIo& BufferManager::threadLocalAio() {
+  // a thread may outlive the buffer manager, the cached ring is only valid if it is created by this
+  // instance
+  thread_local uint64_t tlsInstanceId = 0;
+  thread_local utils::AsyncIo* tlsAio = nullptr;
+  if (tlsInstanceId == mInstanceId) {
+    return *tlsAio;
+  }
+
+  // only the page file is registered like jobAio(), registering the buffer pool would pin it once
+  // for every thread doing page IO
+  auto aio = std::make_unique<utils::AsyncIo>(1, mStore->mStoreOption->mIoBackend);
+  aio->RegisterFiles({mStore->mPageFd});
+
+  tlsInstanceId = mInstanceId;
+  tlsAio = aio.get();
+  std::unique_lock<std::mutex> guard(mIoRingsMutex);
+  mIoRings.emplace_back(std::move(aio));
+  return *tlsAio;
+}
+
+utils::AsyncIo& BufferManager::jobAio() {
+  // the rings are cached by the worker context of the job slot, which is unique in the process
+  thread_local uint64_t tlsInstanceId = 0;
+  thread_local std::vector<std::pair<cr::WorkerContext*, utils::AsyncIo*>> tlsAios;
+  if (tlsInstanceId != mInstanceId) {
+    tlsInstanceId = mInstanceId;
+    tlsAios.clear();
+  }
+
+  auto* workerCtx = cr::WorkerContext::InWorker() ? &cr::WorkerContext::My() : nullptr;
+  for (auto& [ctx, aio] : tlsAios) {
+    if (ctx == workerCtx) {
+      return *aio;
+    }
+  }
+
+  // only the page file is registered, registering the buffer pool for every job slot would pin it
+  // once per ring
+  const uint64_t maxBatchSize = std::max<uint64_t>(mStore->mStoreOption->mMaxScanReadAheadPages, 1);
+  auto aio = std::make_unique<utils::AsyncIo>(maxBatchSize, mStore->mStoreOption->mIoBackend);
+  aio->RegisterFiles({mStore->mPageFd});
+  tlsAios.emplace_back(workerCtx, aio.get());
+  std::unique_lock<std::mutex> guard(mIoRingsMutex);
+  mIoRings.emplace_back(std::move(aio));
+  return *tlsAios.back().second;
+}
+
 BufferManager::~BufferManager() {
+  StopCheckpointer();
   StopPageEvictors();
-  uint64_t totalMemSize = mStore->mStoreOption->mBufferFrameSize * (mNumBfs + mNumSaftyBfs);
-  munmap(mBufferPool, totalMemSize);
+  mIoRings.clear();
+  munmap(mBufferPool, mBufferPoolMemSize);
 }
 
 void BufferManager::DoWithBufferFrameIf(std::function<bool(BufferFrame& bf)> condition,
@@ -3,13 +3,21 @@
 #include "leanstore/Exceptions.hpp"
 #include "leanstore/Units.hpp"
 #include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/buffer-manager/Checkpointer.hpp"
 #include "leanstore/buffer-manager/PageEvictor.hpp"
 #include "leanstore/buffer-manager/Partition.hpp"
 #include "leanstore/buffer-manager/Swip.hpp"
+#include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
+#include "leanstore/utils/Numa.hpp"
 #include "leanstore/utils/RandomGenerator.hpp"
 #include "leanstore/utils/Result.hpp"
 
+#include <algorithm>
 #include <expected>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include <libaio.h>
 #include <sys/mman.h>
@@ -54,6 +62,11 @@ public:
   // total number of dram buffer frames
   uint64_t mNumBfs;
 
+  //! The size of the memory mapped for the buffer pool, and the size of the memory pages backing
+  //! it, see StoreOption::mHugePageSize.
+  uint64_t mBufferPoolMemSize;
+  uint64_t mBufferPoolPageSize;
+
   //! For cooling and inflight io
   uint64_t mNumPartitions;
 
@@ -61,9 +74,34 @@ public:
 
   std::vector<std::unique_ptr<Partition>> mPartitions;
 
+  //! The number of NUMA nodes the buffer pool is spread over, 1 unless StoreOption::mEnableNuma.
+  //! The buffer frames [n * mNumBfsPerNumaNode, (n + 1) * mNumBfsPerNumaNode) are on node n, the
+  //! last node also takes the remainder.
+  uint64_t mNumNumaNodes = 1;
+
+  uint64_t mNumBfsPerNumaNode;
+
   //! All the page evictor threads.
   std::vector<std::unique_ptr<PageEvictor>> mPageEvictors;
 
+  //! The fuzzy checkpointer thread, nullptr if disabled.
+  std::unique_ptr<Checkpointer> mCheckpointer;
+
+  //! The WAL offsets, one for each WAL file, from which recovery starts to redo, all the changes
+  //! logged before them are persisted in the page file. Advanced by the checkpointer and
+  //! CheckpointAllBufferFrames().
+  std::vector<uint64_t> mCheckpointLsns;
+
+  //! Unique among all the buffer managers ever created in the process, identifies the owner of the
+  //! io rings cached by threads.
+  const uint64_t mInstanceId;
+
+  //! The io rings used by ReadPageSync() and writePage(), one for each thread that has done page
+  //! IO, and those of the job slots used by readPageParked().
+  //! Owned here so that they are released together with the buffer pool and page file.
+  std::mutex mIoRingsMutex;
+  std::vector<std::unique_ptr<utils::AsyncIo>> mIoRings;
+
   BufferManager(leanstore::LeanStore* store);
 
   ~BufferManager();
@@ -85,6 +123,38 @@ public:
     return GetPartition(partId);
   }
 
+  //! Get the NUMA node of the partition.
+  uint64_t GetNumaNodeOfPartition(uint64_t partitionId) {
+    return partitionId % mNumNumaNodes;
+  }
+
+  //! Randomly pick a partition on the NUMA node.
+  Partition& RandomPartitionOfNumaNode(uint64_t node) {
+    const uint64_t numPartitionsOfNode =
+        (mNumPartitions - node + mNumNumaNodes - 1) / mNumNumaNodes;
+    auto nth = utils::RandomGenerator::Rand<uint64_t>(0, numPartitionsOfNode);
+    return GetPartition(node + nth * mNumNumaNodes);
+  }
+
+  //! Pick a partition to take a free buffer frame from. Prefers a partition on the NUMA node of the
+  //! current thread if it has free buffer frames, a random partition otherwise.
+  Partition& FreeBfPartition() {
+    if (mNumNumaNodes > 1) {
+      auto& localPartition = RandomPartitionOfNumaNode(utils::tlsNumaNode % mNumNumaNodes);
+      if (localPartition.mFreeBfList.mSize > 0) {
+        return localPartition;
+      }
+    }
+    return RandomPartition();
+  }
+
+  //! Get the NUMA node the buffer frame is bound to.
+  uint64_t GetNumaNode(const BufferFrame& bf) {
+    const uint64_t bfId = (reinterpret_cast<const uint8_t*>(&bf) - mBufferPool) /
+                          mStore->mStoreOption->mBufferFrameSize;
+    return std::min(bfId / mNumBfsPerNumaNode, mNumNumaNodes - 1);
+  }
+
   //! Randomly pick a buffer frame.
   BufferFrame& RandomBufferFrame() {
     auto bfId = utils::RandomGenerator::Rand<uint64_t>(0, mNumBfs);
@@ -100,6 +170,14 @@ public:
   //! from disk if the swip is evicted. Called by worker threads.
   BufferFrame* ResolveSwipMayJump(HybridGuard& nodeGuard, Swip& swipInNode);
 
+  //! Read the evicted pages of the swips in the node ahead of time with one batch of async reads,
+  //! so that resolving them later does not wait for IO. Swips not evicted or already being read are
+  //! skipped, so are the rest once the free buffer frames run out. The pages are published as hot
+  //! children of the node, or left in the inflight IO frames for the next resolver if the node is
+  //! modified meanwhile. Returns the number of pages read. Called by worker threads.
+  //! REQUIRES: nodeGuard is optimistic, swips point into the node.
+  uint64_t ReadAhead(HybridGuard& nodeGuard, const std::vector<Swip*>& swips);
+
   // Pre: bf is exclusively locked
   // ATTENTION: this function unlocks it !!
   void ReclaimPage(BufferFrame& bf);
@@ -108,6 +186,7 @@ public:
   //! stored in one file (mPageFd), page id (pageId) determines the offset of
   //! the pageId-th page in the underlying file:
   //!   - offset of pageId-th page: pageId * pageSize
+  //!   - compressed pages are decompressed to the destination
   void ReadPageSync(PID pageId, void* destination);
 
   //! Reads the page at pageId, returns the buffer frame containing that page.
@@ -127,12 +206,19 @@ public:
 
   void StopPageEvictors();
 
+  //! Starts the fuzzy checkpointer if mCheckpointIntervalMs is set.
+  void StartCheckpointer();
+
+  //! Stops the fuzzy checkpointer, mCheckpointLsns are advanced to its last checkpoint.
+  void StopCheckpointer();
+
   //! Checkpoints a buffer frame to disk. The buffer frame content is copied to
   //! a tmp memory buffer, swips in the tmp memory buffer are changed to page
   //! IDs, then the tmp memory buffer is written to the disk.
   [[nodiscard]] Result<void> CheckpointBufferFrame(BufferFrame& bf);
 
-  //! Checkpoints all the buffer frames.
+  //! Checkpoints all the dirty buffer frames, clean ones are skipped. Called on shutdown, after
+  //! the transaction workers are stopped.
   [[nodiscard]] Result<void> CheckpointAllBufferFrames();
 
   void RecoverFromDisk();
@@ -148,8 +234,50 @@ public:
                            std::function<void(BufferFrame& bf)> action);
 
 private:
+  //! The io ring of the current thread, created on first use with the page file registered.
+  utils::AsyncIo& threadLocalAio();
+
+  //! The io ring of the job running on the current thread, see StoreOption::mJobsPerWorker. Each
+  //! job slot has its own ring, so that the page reads of a parked job are polled alone. Large
+  //! enough for a batch of StoreOption::mMaxScanReadAheadPages reads.
+  utils::AsyncIo& jobAio();
+
+  //! Read the page into bf with the io ring of the current job, parking the job until the read is
+  //! done. The read is finished by the park predicate: the buffer frame is initialized and
+  //! published as ready in ioFrame, then the locked ioFrame.mMutex is unlocked. So a job on the
+  //! same thread waiting for ioFrame can finish it in cr::WorkerThread::WaitParked().
+  //! REQUIRES: cr::WorkerThread::CanPark(), ioFrame.mMutex locked.
+  void readPageParked(PID pageId, BufferFrame& bf, IOFrame& ioFrame, Partition& partition);
+
+  //! Intialize the header of the buffer frame the page is just read into.
+  void initReadFrame(PID pageId, BufferFrame& bf);
+
+  //! Decompresses the page read from the page file in place if it's compressed, see
+  //! StoreOption::mEnablePageCompression.
+  void decompressIfNeeded(PID pageId, void* pageBuffer);
+
+  //! Maps the memory of the buffer pool, with explicit huge pages if configured.
+  void allocBufferPool();
+
+  //! Spreads the buffer pool over the NUMA nodes with StoreOption::mEnableNuma, binds the buffer
+  //! frames of each node to its memory.
+  void initNumaNodes();
+
+  //! Records the swip resolved to the buffer frame in the per NUMA node counters, should be called
+  //! in a COUNTERS_BLOCK().
+  void recordNumaHit(const BufferFrame& bf) {
+    if (mNumNumaNodes <= 1) {
+      return;
+    }
+    auto node = GetNumaNode(bf);
+    PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferNumaHits[node], 1);
+    if (node != utils::tlsNumaNode) {
+      PerfCounterAddLocal(&cr::tlsPerfCounters.mBufferNumaRemoteHits[node], 1);
+    }
+  }
+
   Result<void> writePage(PID pageId, void* buffer) {
-    utils::AsyncIo aio(1);
+    auto& aio = threadLocalAio();
     const auto pageSize = mStore->mStoreOption->mPageSize;
     DEBUG_BLOCK() {
       auto* page [[maybe_unused]] = reinterpret_cast<Page*>(buffer);
@@ -0,0 +1,215 @@
+#include "leanstore/buffer-manager/Checkpointer.hpp"
+
+#include "leanstore/buffer-manager/BMPlainGuard.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/buffer-manager/TreeRegistry.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/GroupCommitter.hpp"
+#include "leanstore/utils/Defer.hpp"
+#include "leanstore/utils/JumpMU.hpp"
+#include "leanstore/utils/Log.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include <unistd.h>
+
+namespace leanstore::storage {
+
+Checkpointer::Checkpointer(leanstore::LeanStore* store,
+                           const std::vector<uint64_t>& checkpointLsns)
+    : utils::UserThread(store, "Checkpointer"),
+      mStore(store),
+      mCheckpointLsns(checkpointLsns.size()),
+      mWriteBuffer(store->mStoreOption->mPageSize * store->mStoreOption->mBufferWriteBatchSize),
+      mAio(store->mStoreOption->mBufferWriteBatchSize, store->mStoreOption->mIoBackend),
+      mNumWrittenPages(0) {
+  mAio.RegisterBuffers(
+      {iovec{mWriteBuffer.Get(),
+             store->mStoreOption->mPageSize * store->mStoreOption->mBufferWriteBatchSize}});
+  mAio.RegisterFiles({store->mPageFd});
+  for (uint64_t walId = 0; walId < checkpointLsns.size(); walId++) {
+    mCheckpointLsns[walId].store(checkpointLsns[walId]);
+  }
+}
+
+std::vector<uint64_t> Checkpointer::GetCheckpointLsns() const {
+  std::vector<uint64_t> checkpointLsns;
+  checkpointLsns.reserve(mCheckpointLsns.size());
+  for (auto& checkpointLsn : mCheckpointLsns) {
+    checkpointLsns.push_back(checkpointLsn.load());
+  }
+  return checkpointLsns;
+}
+
+void Checkpointer::runImpl() {
+  const auto interval = std::chrono::milliseconds(mStore->mStoreOption->mCheckpointIntervalMs);
+  while (mKeepRunning) {
+    {
+      std::unique_lock guard(mSleepMutex);
+      mSleepCv.wait_for(guard, interval, [&]() { return !mKeepRunning; });
+    }
+    if (!mKeepRunning) {
+      break;
+    }
+
+    if (checkpointRound()) {
+      mStore->SerializeCheckpointLsn(GetCheckpointLsns());
+    }
+  }
+}
+
+bool Checkpointer::checkpointRound() {
+  // changes logged before this point are already applied to the in-memory pages
+  auto walSizes = currentWalSizes();
+  auto startAt = std::chrono::steady_clock::now();
+  mRoundStartedAt = startAt;
+  mNumWrittenPages = 0;
+
+  collectDirtyBfs();
+  LS_DLOG("Checkpoint round started, walSize={}, dirtyBfs={}", utils::JoinNumbers(walSizes),
+          mDirtyBfs.size());
+
+  // frames being written by the page evictors are retried until they are clean
+  std::vector<std::pair<PID, BufferFrame*>> busyBfs;
+  while (!mDirtyBfs.empty()) {
+    for (auto& [pageId, bf] : mDirtyBfs) {
+      if (!mKeepRunning) {
+        return false;
+      }
+
+      auto result = copyPage(pageId, *bf);
+      if (result == CopyResult::kBusy) {
+        busyBfs.emplace_back(pageId, bf);
+        continue;
+      }
+      if (mBatchBfs.size() == mStore->mStoreOption->mBufferWriteBatchSize && !flushBatch()) {
+        return false;
+      }
+    }
+    if (!flushBatch()) {
+      return false;
+    }
+
+    mDirtyBfs.swap(busyBfs);
+    busyBfs.clear();
+    if (!mDirtyBfs.empty()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // the written pages are durable before the checkpoint LSNs advance
+  if (fdatasync(mStore->mPageFd) != 0) {
+    Log::Error("Checkpointer failed to sync the page file, errno={}", errno);
+    return false;
+  }
+
+  for (uint64_t walId = 0; walId < walSizes.size() && walId < mCheckpointLsns.size(); walId++) {
+    mCheckpointLsns[walId].store(walSizes[walId]);
+  }
+  auto elaspedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - startAt)
+                       .count();
+  Log::Info("Checkpoint round finished, checkpointLsn={}, writtenPages={}, timeElasped={:.6f}s",
+            utils::JoinNumbers(walSizes), mNumWrittenPages, elaspedUs / 1000000.0);
+  return true;
+}
+
+void Checkpointer::collectDirtyBfs() {
+  auto& bufferManager = *mStore->mBufferManager;
+  const auto bufferFrameSize = mStore->mStoreOption->mBufferFrameSize;
+  mDirtyBfs.clear();
+  for (uint64_t i = 0; i < bufferManager.mNumBfs; i++) {
+    auto* bf = reinterpret_cast<BufferFrame*>(&bufferManager.mBufferPool[i * bufferFrameSize]);
+    if (!bf->IsFree() && bf->IsDirty()) {
+      mDirtyBfs.emplace_back(bf->mHeader.mPageId, bf);
+    }
+  }
+
+  // write in page id order, sequential for the page file
+  std::sort(mDirtyBfs.begin(), mDirtyBfs.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+}
+
+Checkpointer::CopyResult Checkpointer::copyPage(PID pageId, BufferFrame& bf) {
+  const auto pageSize = mStore->mStoreOption->mPageSize;
+  auto* dest = mWriteBuffer.Get() + mBatchBfs.size() * pageSize;
+  JUMPMU_TRY() {
+    BMOptimisticGuard optimisticGuard(bf.mHeader.mLatch);
+    if (bf.IsFree() || bf.mHeader.mPageId != pageId || !bf.IsDirty()) {
+      optimisticGuard.JumpIfModifiedByOthers();
+      JUMPMU_RETURN CopyResult::kSkipped;
+    }
+    if (bf.mHeader.mIsBeingWrittenBack) {
+      optimisticGuard.JumpIfModifiedByOthers();
+      JUMPMU_RETURN CopyResult::kBusy;
+    }
+
+    BMExclusiveGuard exclusiveGuard(optimisticGuard);
+    bf.mHeader.mIsBeingWrittenBack.store(true, std::memory_order_release);
+    mStore->mTreeRegistry->Checkpoint(bf.mPage.mBTreeId, bf, dest);
+    mAio.PrepareWrite(mStore->mPageFd, dest, pageSize, pageId * pageSize);
+    mBatchBfs.emplace_back(&bf, bf.mPage.mPsn);
+    JUMPMU_RETURN CopyResult::kCopied;
+  }
+  JUMPMU_CATCH() {
+  }
+
+  // modified by others, it is still dirty
+  return CopyResult::kBusy;
+}
+
+bool Checkpointer::flushBatch() {
+  if (mBatchBfs.empty()) {
+    return true;
+  }
+  SCOPED_DEFER(mBatchBfs.clear());
+
+  bool succeed = true;
+  if (auto res = mAio.SubmitAll(); !res) {
+    Log::Error("Checkpointer failed to submit aio, error={}", res.error().ToString());
+    succeed = false;
+  } else if (auto res = mAio.WaitAll(); !res) {
+    Log::Error("Checkpointer failed to wait aio, error={}", res.error().ToString());
+    succeed = false;
+  }
+
+  for (auto& [bf, flushedPsn] : mBatchBfs) {
+    JUMPMU_TRY() {
+      BMOptimisticGuard optimisticGuard(bf->mHeader.mLatch);
+      BMExclusiveGuard exclusiveGuard(optimisticGuard);
+      if (succeed && bf->mHeader.mFlushedPsn < flushedPsn) {
+        bf->mHeader.mFlushedPsn = flushedPsn;
+      }
+      bf->mHeader.mIsBeingWrittenBack = false;
+    }
+    JUMPMU_CATCH() {
+      bf->mHeader.mIsBeingWrittenBack.store(false, std::memory_order_release);
+    }
+  }
+
+  mNumWrittenPages += mBatchBfs.size();
+  throttle();
+  return succeed;
+}
+
+void Checkpointer::throttle() {
+  const auto maxPagesPerSec = mStore->mStoreOption->mCheckpointMaxPagesPerSec;
+  if (maxPagesPerSec == 0) {
+    return;
+  }
+
+  auto expectedUs = mNumWrittenPages * 1000000 / maxPagesPerSec;
+  auto elaspedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - mRoundStartedAt)
+                       .count();
+  if (static_cast<uint64_t>(elaspedUs) < expectedUs) {
+    std::this_thread::sleep_for(std::chrono::microseconds(expectedUs - elaspedUs));
+  }
+}
+
+std::vector<uint64_t> Checkpointer::currentWalSizes() {
+  return mStore->mCRManager->WalSizes();
+}
+
+} // namespace leanstore::storage
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/Units.hpp"
+#include "leanstore/buffer-manager/BufferFrame.hpp"
+#include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/UserThread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace leanstore::storage {
+
+//! Fuzzy checkpointer, flushes dirty buffer frames in the background without stopping the world.
+//!
+//! Each round remembers the WAL sizes when it starts, then writes all the dirty frames in page id
+//! order, with the write rate limited by mCheckpointMaxPagesPerSec. Changes logged before the round
+//! started are in memory at that time, once the round is finished they are all on disk (written by
+//! the round itself or by the page evictors), the remembered WAL sizes become the checkpoint LSNs
+//! from which recovery starts to redo.
+class Checkpointer : public utils::UserThread {
+public:
+  leanstore::LeanStore* mStore;
+
+  //! The WAL offsets, one for each WAL file, before which all the changes are persisted in the
+  //! page file.
+  std::vector<std::atomic<uint64_t>> mCheckpointLsns;
+
+private:
+  enum class CopyResult : uint8_t {
+    kCopied,
+
+    //! The frame no longer holds the collected page, or the page is clean.
+    kSkipped,
+
+    //! The frame is being written by a page evictor, the page may get dirty again before the
+    //! write finishes, should be retried.
+    kBusy,
+  };
+
+  //! Dirty frames of the current round, sorted by page id.
+  std::vector<std::pair<PID, BufferFrame*>> mDirtyBfs;
+
+  //! Frames in the current write batch, and the psn of the page when it was copied.
+  std::vector<std::pair<BufferFrame*, uint64_t>> mBatchBfs;
+
+  utils::AlignedBuffer<512> mWriteBuffer;
+
+  utils::AsyncIo mAio;
+
+  //! Start time and number of pages written in the current round, for rate limiting.
+  std::chrono::steady_clock::time_point mRoundStartedAt;
+  uint64_t mNumWrittenPages;
+
+  //! The checkpointer sleeps on it between rounds, notified by Stop().
+  std::mutex mSleepMutex;
+  std::condition_variable mSleepCv;
+
+public:
+  Checkpointer(leanstore::LeanStore* store, const std::vector<uint64_t>& checkpointLsns);
+
+  ~Checkpointer() override {
+    Stop();
+  }
+
+  // no copy and assign
+  Checkpointer(const Checkpointer&) = delete;
+  Checkpointer& operator=(const Checkpointer&) = delete;
+
+  std::vector<uint64_t> GetCheckpointLsns() const;
+
+  //! Stops the checkpointer, wakes it up if it is sleeping between rounds.
+  void Stop() override {
+    {
+      std::unique_lock guard(mSleepMutex);
+      mKeepRunning = false;
+    }
+    mSleepCv.notify_all();
+    UserThread::Stop();
+  }
+
+protected:
+  void runImpl() override;
+
+private:
+  //! Runs a checkpoint round, advances mCheckpointLsns when all the dirty frames are written.
+  //! Returns false if the round is interrupted by Stop() or failed.
+  bool checkpointRound();
+
+  //! Collects the dirty frames of the buffer pool, sorted by page id.
+  void collectDirtyBfs();
+
+  //! Copies the page of a dirty frame to the next slot of the write buffer, the swips in the copy
+  //! are changed to page ids. The frame is marked being written back until flushBatch().
+  CopyResult copyPage(PID pageId, BufferFrame& bf);
+
+  //! Writes the pages in the write buffer, marks the frames flushed. Returns false if the writes
+  //! failed.
+  bool flushBatch();
+
+  //! Sleeps the checkpointer to keep the write rate below the limit.
+  void throttle();
+
+  std::vector<uint64_t> currentWalSizes();
+};
+
+} // namespace leanstore::storage
@@ -9,6 +9,7 @@
 #include "leanstore/sync/HybridLatch.hpp"
 #include "leanstore/utils/Log.hpp"
 
+#include <algorithm>
 #include <utility>
 
 namespace leanstore::storage {
@@ -163,6 +164,14 @@ public:
     cr::WorkerContext::My().mLogging.UpdateSysTxWrittern(sysTxId);
   }
 
+  //! Sync the global sequence number of a WalEntry to the page, for pages modified together with
+  //! the page the WalEntry is written to, e.g. the parent and the new left of a split. Later
+  //! WalEntries of the page are ordered after it.
+  void SyncGsn(uint64_t gsn) {
+    LS_DCHECK(mBf != nullptr);
+    mBf->mPage.mGSN = std::max(mBf->mPage.mGSN, gsn);
+  }
+
   //! Check remote dependency
   //! TODO: don't sync on temporary table pages like history trees
   void CheckRemoteDependency() {
@@ -186,8 +195,12 @@ public:
     const auto pageId = mBf->mHeader.mPageId;
     const auto treeId = mBf->mPage.mBTreeId;
     walSize = ((walSize - 1) / 8 + 1) * 8;
-    auto handler = cr::WorkerContext::My().mLogging.ReserveWALEntryComplex<WT, Args...>(
-        sizeof(WT) + walSize, pageId, mBf->mPage.mPsn, treeId, std::forward<Args>(args)...);
+    auto& logging = cr::WorkerContext::My().mLogging;
+    const auto prevGsn = mBf->mPage.mGSN;
+    mBf->mPage.mGSN = logging.NextGsn(prevGsn);
+    auto handler = logging.ReserveWALEntryComplex<WT, Args...>(
+        sizeof(WT) + walSize, pageId, mBf->mPage.mPsn, mBf->mPage.mGSN, prevGsn, treeId,
+        std::forward<Args>(args)...);
 
     return handler;
   }
@@ -311,6 +324,10 @@ public:
     mRefGuard.SyncSystemTxId(sysTxId);
   }
 
+  void SyncGsn(uint64_t gsn) {
+    mRefGuard.SyncGsn(gsn);
+  }
+
   ~ExclusiveGuardedBufferFrame() {
     if (!mRefGuard.mKeepAlive && mRefGuard.mGuard.mState == GuardState::kPessimisticExclusive) {
       mRefGuard.Reclaim();
@@ -0,0 +1,52 @@
+#include "leanstore/buffer-manager/PageCompression.hpp"
+
+#include "leanstore/utils/Misc.hpp"
+
+#include <cstring>
+#include <vector>
+
+#include <lz4.h>
+
+namespace leanstore::storage {
+
+uint64_t PageCompression::Compress(const void* image, uint64_t pageSize, void* dest) {
+  // the compressed page has to save at least one unit of write, otherwise it's written as it is
+  auto* header = reinterpret_cast<CompressedPageHeader*>(dest);
+  auto* payload = reinterpret_cast<char*>(dest) + sizeof(CompressedPageHeader);
+  const int64_t maxCompressedSize = pageSize - kAlignment - sizeof(CompressedPageHeader);
+  if (maxCompressedSize <= 0) {
+    return 0;
+  }
+  auto compressedSize = LZ4_compress_default(reinterpret_cast<const char*>(image), payload,
+                                             pageSize, maxCompressedSize);
+  if (compressedSize <= 0) {
+    return 0;
+  }
+
+  header->mMagic = CompressedPageHeader::kMagic;
+  header->mCompressedSize = compressedSize;
+  header->mPageSize = pageSize;
+  const uint64_t totalSize = sizeof(CompressedPageHeader) + compressedSize;
+  const uint64_t writeSize = utils::AlignUp(totalSize, kAlignment);
+  std::memset(reinterpret_cast<uint8_t*>(dest) + totalSize, 0, writeSize - totalSize);
+  return writeSize;
+}
+
+bool PageCompression::Decompress(void* page, uint64_t pageSize) {
+  thread_local std::vector<char> tlsCompressed;
+  auto* header = reinterpret_cast<CompressedPageHeader*>(page);
+  if (header->mPageSize != pageSize ||
+      header->mCompressedSize > pageSize - sizeof(CompressedPageHeader)) {
+    return false;
+  }
+
+  const uint32_t compressedSize = header->mCompressedSize;
+  tlsCompressed.resize(compressedSize);
+  std::memcpy(tlsCompressed.data(), reinterpret_cast<char*>(page) + sizeof(CompressedPageHeader),
+              compressedSize);
+  auto rawSize = LZ4_decompress_safe(tlsCompressed.data(), reinterpret_cast<char*>(page),
+                                     compressedSize, pageSize);
+  return rawSize == static_cast<int>(pageSize);
+}
+
+} // namespace leanstore::storage
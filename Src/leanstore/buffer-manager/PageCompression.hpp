@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace leanstore::storage {
+
+//! The header of a compressed page in the page file, written in place of the page header, followed
+//! by the LZ4 compressed page. The magic number is never a valid Page::mGSN, which tells compressed
+//! pages apart from the uncompressed ones.
+struct CompressedPageHeader {
+  static constexpr uint64_t kMagic = 0xC0DEC0DE4C5A3401ull;
+
+  uint64_t mMagic;
+
+  //! Size of the compressed page after the header.
+  uint32_t mCompressedSize;
+
+  //! Size of the page before compression.
+  uint32_t mPageSize;
+};
+
+//! LZ4 compression of pages written to the page file, see StoreOption::mEnablePageCompression.
+class PageCompression {
+public:
+  //! Pages are written in units of the O_DIRECT alignment.
+  static constexpr uint64_t kAlignment = 512;
+
+  //! Compresses the page image to dest, which has room for pageSize bytes. Returns the number of
+  //! bytes to write, aligned to kAlignment, or 0 if the compressed page is not smaller than the
+  //! page itself.
+  static uint64_t Compress(const void* image, uint64_t pageSize, void* dest);
+
+  //! Whether the page read from the page file is compressed.
+  static bool IsCompressed(const void* page) {
+    return reinterpret_cast<const CompressedPageHeader*>(page)->mMagic ==
+           CompressedPageHeader::kMagic;
+  }
+
+  //! Decompresses the compressed page in place. Returns false if the page is corrupted.
+  static bool Decompress(void* page, uint64_t pageSize);
+};
+
+} // namespace leanstore::storage
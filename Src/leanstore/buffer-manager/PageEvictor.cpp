@@ -2,9 +2,12 @@
 
 #include "leanstore/buffer-manager/BufferManager.hpp"
 #include "leanstore/buffer-manager/TreeRegistry.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
 #include "leanstore/utils/Defer.hpp"
 #include "leanstore/utils/Log.hpp"
+#include "leanstore/utils/Numa.hpp"
 
+#include <algorithm>
 #include <mutex>
 
 namespace leanstore::storage {
@@ -12,8 +15,15 @@ namespace leanstore::storage {
 using Time = decltype(std::chrono::high_resolution_clock::now());
 
 void PageEvictor::runImpl() {
+  if (mNumaNode != kAllNumaNodes) {
+    utils::PinThisThreadToNumaNode(mNumaNode);
+    utils::tlsNumaNode = mNumaNode;
+  }
+
   while (mKeepRunning) {
-    auto& targetPartition = mStore->mBufferManager->RandomPartition();
+    auto& targetPartition = mNumaNode == kAllNumaNodes
+                                ? mStore->mBufferManager->RandomPartition()
+                                : mStore->mBufferManager->RandomPartitionOfNumaNode(mNumaNode);
     if (!targetPartition.NeedMoreFreeBfs()) {
       continue;
     }
@@ -38,7 +48,7 @@ void PageEvictor::PickBufferFramesToCool(Partition& targetPartition) {
   // the required level can not be achieved
   uint64_t failedAttempts = 0;
   if (targetPartition.NeedMoreFreeBfs() && failedAttempts < 10) {
-    randomBufferFramesToCoolOrEvict();
+    pickCoolCandidates();
     while (mCoolCandidateBfs.size() > 0) {
       auto* coolCandidate = mCoolCandidateBfs.back();
       mCoolCandidateBfs.pop_back();
@@ -162,15 +172,50 @@ void PageEvictor::PickBufferFramesToCool(Partition& targetPartition) {
   }
 }
 
+void PageEvictor::pickCoolCandidates() {
+  switch (mStore->mStoreOption->mEvictionPolicy) {
+  case EvictionPolicy::kEvictionClock: {
+    clockSweepBufferFramesToCoolOrEvict();
+    break;
+  }
+  default: {
+    randomBufferFramesToCoolOrEvict();
+    break;
+  }
+  }
+}
+
 void PageEvictor::randomBufferFramesToCoolOrEvict() {
   mCoolCandidateBfs.clear();
+  const auto bfSize = mStore->mStoreOption->mBufferFrameSize;
   for (auto i = 0u; i < mStore->mStoreOption->mBufferFrameRecycleBatchSize; i++) {
-    auto* randomBf = &mStore->mBufferManager->RandomBufferFrame();
+    // a page evictor bound to a NUMA node only recycles the buffer frames of its node
+    auto* randomBf =
+        mNumaNode == kAllNumaNodes
+            ? &mStore->mBufferManager->RandomBufferFrame()
+            : reinterpret_cast<BufferFrame*>(
+                  &mBufferPool[utils::RandomGenerator::Rand<uint64_t>(mClockBegin, mClockEnd) *
+                               bfSize]);
     DoNotOptimize(randomBf->mHeader.mState);
     mCoolCandidateBfs.push_back(randomBf);
   }
 }
 
+void PageEvictor::clockSweepBufferFramesToCoolOrEvict() {
+  mCoolCandidateBfs.clear();
+  const auto bfSize = mStore->mStoreOption->mBufferFrameSize;
+  const auto batchSize = std::min<uint64_t>(mStore->mStoreOption->mBufferFrameRecycleBatchSize,
+                                            mClockEnd - mClockBegin);
+  for (auto i = 0u; i < batchSize; i++) {
+    auto* bf = reinterpret_cast<BufferFrame*>(&mBufferPool[mClockHand * bfSize]);
+    DoNotOptimize(bf->mHeader.mState);
+    mCoolCandidateBfs.push_back(bf);
+    if (++mClockHand == mClockEnd) {
+      mClockHand = mClockBegin;
+    }
+  }
+}
+
 void PageEvictor::PrepareAsyncWriteBuffer(Partition& targetPartition) {
   LS_DLOG("Phase2: PrepareAsyncWriteBuffer begins");
   SCOPED_DEFER(LS_DLOG("Phase2: PrepareAsyncWriteBuffer ended, "
@@ -232,7 +277,13 @@ void PageEvictor::PrepareAsyncWriteBuffer(Partition& targetPartition) {
       }
 
       // TODO: preEviction callback according to TREEID
-      mAsyncWriteBuffer.Add(*cooledBf);
+      if (mStore->mStoreOption->mEnablePageCompression &&
+          mStore->mTreeRegistry->PrepareCompression(cooledBf->mPage.mBTreeId, *cooledBf,
+                                                    mCompressionImage.Get())) {
+        mAsyncWriteBuffer.AddCompressed(*cooledBf, mCompressionImage.Get());
+      } else {
+        mAsyncWriteBuffer.Add(*cooledBf);
+      }
       LS_DLOG("COOLed buffer frame is added to async write buffer, "
               "pageId={}, bufferSize={}",
               cooledBf->mHeader.mPageId, mAsyncWriteBuffer.GetPendingRequests());
@@ -281,6 +332,7 @@ void PageEvictor::FlushAndRecycleBufferFrames(Partition& targetPartition) {
           // For recovery, so much has to be done here...
           writtenBf.mHeader.mFlushedPsn = flushedPsn;
           writtenBf.mHeader.mIsBeingWrittenBack = false;
+          COUNTER_INC(&mPerfCounters.mBufferWrittenBack);
         }
         JUMPMU_CATCH() {
           writtenBf.mHeader.mCrc = 0;
@@ -323,6 +375,7 @@ void PageEvictor::evictFlushedBf(BufferFrame& cooledBf, BMOptimisticGuard& optim
   LS_DCHECK(parentHandler.mChildSwip.IsCool());
 
   parentHandler.mChildSwip.Evict(cooledBf.mHeader.mPageId);
+  COUNTER_INC(&mPerfCounters.mBufferEvicted);
 
   // Reclaim buffer frame
   cooledBf.Reset();
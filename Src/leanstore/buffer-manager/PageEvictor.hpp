@@ -1,15 +1,18 @@
 #pragma once
 
 #include "leanstore/LeanStore.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
 #include "leanstore/buffer-manager/AsyncWriteBuffer.hpp"
 #include "leanstore/buffer-manager/BMPlainGuard.hpp"
 #include "leanstore/buffer-manager/BufferFrame.hpp"
 #include "leanstore/buffer-manager/FreeList.hpp"
 #include "leanstore/buffer-manager/Partition.hpp"
 #include "leanstore/buffer-manager/Swip.hpp"
+#include "leanstore/utils/Misc.hpp"
 #include "leanstore/utils/UserThread.hpp"
 
 #include <cstdint>
+#include <limits>
 
 #include <fcntl.h>
 #include <sys/resource.h>
@@ -65,15 +68,33 @@ public:
 
   const int mFD;
 
+  //! The slice [mClockBegin, mClockEnd) of the buffer pool owned by the page evictor, and the
+  //! position of its CLOCK hand, see EvictionPolicy::kEvictionClock. The slice is within the
+  //! buffer frames of mNumaNode if the page evictor is bound to a NUMA node.
+  const uint64_t mClockBegin;
+  const uint64_t mClockEnd;
+  uint64_t mClockHand;
+
+  //! The NUMA node served by the page evictor, kAllNumaNodes if it serves all the partitions.
+  static constexpr uint64_t kAllNumaNodes = std::numeric_limits<uint64_t>::max();
+  const uint64_t mNumaNode;
+
   std::vector<BufferFrame*> mCoolCandidateBfs;  // input of phase 1
   std::vector<BufferFrame*> mEvictCandidateBfs; // output of phase 1
   AsyncWriteBuffer mAsyncWriteBuffer;           // output of phase 2
   FreeBfList mFreeBfList;                       // output of phase 3
 
+  //! The leaf image to be compressed, see StoreOption::mEnablePageCompression.
+  utils::AlignedBuffer<512> mCompressionImage;
+
+  //! The buffer manager counters of the page evictor, updated by the page evictor only.
+  PerfCounters mPerfCounters{};
+
 public:
-  PageEvictor(leanstore::LeanStore* store, const std::string& threadName, uint64_t runningCPU,
+  PageEvictor(leanstore::LeanStore* store, const std::string& threadName, int runningCPU,
               uint64_t numBfs, uint8_t* bfs, uint64_t numPartitions, uint64_t partitionMask,
-              std::vector<std::unique_ptr<Partition>>& partitions)
+              std::vector<std::unique_ptr<Partition>>& partitions, uint64_t clockBegin,
+              uint64_t clockEnd, uint64_t numaNode = kAllNumaNodes)
       : utils::UserThread(store, threadName, runningCPU),
         mStore(store),
         mNumBfs(numBfs),
@@ -82,11 +103,17 @@ public:
         mPartitionsMask(partitionMask),
         mPartitions(partitions),
         mFD(store->mPageFd),
+        mClockBegin(clockBegin),
+        mClockEnd(clockEnd),
+        mClockHand(clockBegin),
+        mNumaNode(numaNode),
         mCoolCandidateBfs(),
         mEvictCandidateBfs(),
         mAsyncWriteBuffer(store->mPageFd, store->mStoreOption->mPageSize,
-                          mStore->mStoreOption->mBufferWriteBatchSize),
-        mFreeBfList() {
+                          mStore->mStoreOption->mBufferWriteBatchSize,
+                          mStore->mStoreOption->mIoBackend),
+        mFreeBfList(),
+        mCompressionImage(mStore->mStoreOption->mPageSize) {
     mCoolCandidateBfs.reserve(mStore->mStoreOption->mBufferFrameRecycleBatchSize);
     mEvictCandidateBfs.reserve(mStore->mStoreOption->mBufferFrameRecycleBatchSize);
   }
@@ -104,7 +131,7 @@ public:
   }
 
 public:
-  //! Randomly picks a batch of buffer frames from the whole memory, gather the
+  //! Picks a batch of buffer frames with the eviction policy, gather the
   //! cool buffer frames for the next round to evict, cools the hot buffer
   //! frames if all their children are evicted.
   //!
@@ -131,12 +158,22 @@ public:
   //! Writes all picked pages, push free BufferFrames to target partition.
   void FlushAndRecycleBufferFrames(Partition& targetPartition);
 
+  PerfCounters* GetPerfCounters() {
+    return &mPerfCounters;
+  }
+
 protected:
   void runImpl() override;
 
 private:
+  //! Picks a batch of cool candidates with StoreOption::mEvictionPolicy.
+  void pickCoolCandidates();
+
   void randomBufferFramesToCoolOrEvict();
 
+  //! Advances the CLOCK hand over the next batch of buffer frames in the slice of the page evictor.
+  void clockSweepBufferFramesToCoolOrEvict();
+
   void evictFlushedBf(BufferFrame& cooledBf, BMOptimisticGuard& optimisticGuard,
                       Partition& targetPartition);
 };
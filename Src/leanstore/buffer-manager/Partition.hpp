@@ -21,6 +21,11 @@ struct IOFrame {
 
   std::mutex mMutex;
 
+  //! Set once the page is read, right before mMutex is unlocked by the reader. Jobs waiting for
+  //! the read poll it instead of locking mMutex, which may be held by a job parked on the same
+  //! thread, see cr::WorkerThread::WaitParked().
+  std::atomic<bool> mIsReadDone = false;
+
   State mState = State::kUndefined;
 
   BufferFrame* mBf = nullptr;
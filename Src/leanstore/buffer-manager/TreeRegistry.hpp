@@ -64,6 +64,12 @@ public:
     Log::Fatal("BufferManagedTree::Checkpoint is unimplemented");
   }
 
+  //! Writes the image of the page to be compressed to dest, the page with its unused bytes zeroed.
+  //! Returns false if the page is not worth compressing.
+  virtual bool PrepareCompression(BufferFrame&, void*) {
+    return false;
+  }
+
   virtual void undo(const uint8_t*, const uint64_t) {
     Log::Fatal("BufferManagedTree::undo is unimplemented");
   }
@@ -192,6 +198,15 @@ public:
     return nullptr;
   }
 
+  inline BufferManagedTree* GetTree(TREEID treeId) {
+    std::shared_lock sharedGuard(mMutex);
+    auto it = mTrees.find(treeId);
+    if (it != mTrees.end()) {
+      return std::get<0>(it->second).get();
+    }
+    return nullptr;
+  }
+
   inline void IterateChildSwips(TREEID treeId, BufferFrame& bf,
                                 std::function<bool(Swip&)> callback) {
     std::shared_lock sharedGuard(mMutex);
@@ -234,6 +249,17 @@ public:
     return tree->Checkpoint(bf, dest);
   }
 
+  // Pre: bf is exclusive latched
+  inline bool PrepareCompression(TREEID treeId, BufferFrame& bf, void* dest) {
+    std::shared_lock sharedGuard(mMutex);
+    auto it = mTrees.find(treeId);
+    if (it == mTrees.end()) {
+      Log::Fatal("BufferManagedTree not find, address={}, treeId={}", (void*)&bf, treeId);
+    }
+    auto& [tree, treeName] = it->second;
+    return tree->PrepareCompression(bf, dest);
+  }
+
   // Recovery / SI
   inline void undo(TREEID treeId, const uint8_t* walEntry, uint64_t tts) {
     auto it = mTrees.find(treeId);
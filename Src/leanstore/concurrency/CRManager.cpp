@@ -2,21 +2,32 @@
 
 #include "leanstore/LeanStore.hpp"
 #include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/concurrency/GarbageCollector.hpp"
 #include "leanstore/concurrency/GroupCommitter.hpp"
 #include "leanstore/concurrency/HistoryStorage.hpp"
 #include "leanstore/concurrency/WorkerContext.hpp"
 #include "leanstore/concurrency/WorkerThread.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
 #include "leanstore/utils/Log.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/Numa.hpp"
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 
 namespace leanstore::cr {
 
-CRManager::CRManager(leanstore::LeanStore* store) : mStore(store), mGroupCommitter(nullptr) {
+CRManager::CRManager(leanstore::LeanStore* store) : mStore(store) {
   auto* storeOption = store->mStoreOption;
-  // start all worker threads
-  mWorkerCtxs.resize(storeOption->mWorkerThreads);
+  // start all worker threads, each of them has a worker context for every job slot. The contexts
+  // of the first slots take the worker ids [0, mWorkerThreads), the garbage collector takes the
+  // last worker id if enabled
+  const uint64_t jobsPerWorker = std::max<uint64_t>(storeOption->mJobsPerWorker, 1);
+  const bool enableGcService = storeOption->mEnableGc && storeOption->mEnableGcService;
+  mWorkerCtxs.resize(storeOption->mWorkerThreads * jobsPerWorker + (enableGcService ? 1 : 0));
+  mWorkerPerfCounters.resize(storeOption->mWorkerThreads);
+  mWorkerPerfOpTraces.resize(storeOption->mWorkerThreads);
   mWorkerThreads.reserve(storeOption->mWorkerThreads);
   for (uint64_t workerId = 0; workerId < storeOption->mWorkerThreads; workerId++) {
     auto workerThread = std::make_unique<WorkerThread>(store, workerId, workerId);
@@ -27,16 +38,51 @@ CRManager::CRManager(leanstore::LeanStore* store) : mStore(store), mGroupCommitt
       WorkerContext::sTlsWorkerCtx = std::make_unique<WorkerContext>(workerId, mWorkerCtxs, mStore);
       WorkerContext::sTlsWorkerCtxRaw = WorkerContext::sTlsWorkerCtx.get();
       mWorkerCtxs[workerId] = WorkerContext::sTlsWorkerCtx.get();
+      mWorkerPerfCounters[workerId] = WorkerContext::sTlsWorkerCtx->GetPerfCounters();
+      mWorkerPerfOpTraces[workerId] = &tlsPerfOpTraces;
+      utils::tlsNumaNode = utils::CurrentNumaNode();
+      if (jobsPerWorker == 1) {
+        return;
+      }
+
+      workerThread->AddJobSlot(mWorkerCtxs[workerId]);
+      for (uint64_t slot = 1; slot < jobsPerWorker; slot++) {
+        auto slotWorkerId = slot * storeOption->mWorkerThreads + workerId;
+        mJobWorkerCtxs.emplace_back(
+            std::make_unique<WorkerContext>(slotWorkerId, mWorkerCtxs, mStore));
+        mWorkerCtxs[slotWorkerId] = mJobWorkerCtxs.back().get();
+        workerThread->AddJobSlot(mWorkerCtxs[slotWorkerId]);
+      }
     });
     workerThread->Wait();
     mWorkerThreads.emplace_back(std::move(workerThread));
   }
 
-  // start group commit thread
+  // the garbage collector is served by the group committers like the workers, it's started after
+  // the history storage is set up
+  if (enableGcService) {
+    mGarbageCollector = std::make_unique<GarbageCollector>(mStore, mWorkerCtxs);
+  }
+
+  // start group commit threads, each of them writes a WAL file for a subset of the workers
   if (mStore->mStoreOption->mEnableWal) {
-    const int cpu = storeOption->mWorkerThreads;
-    mGroupCommitter = std::make_unique<GroupCommitter>(mStore, mStore->mWalFd, mWorkerCtxs, cpu);
-    mGroupCommitter->Start();
+    const auto numWalFiles = mStore->mWalFds.size();
+    std::vector<std::vector<WorkerContext*>> workerCtxsOfWal(numWalFiles);
+    for (uint64_t workerId = 0; workerId < mWorkerCtxs.size(); workerId++) {
+      workerCtxsOfWal[workerId % numWalFiles].push_back(mWorkerCtxs[workerId]);
+    }
+    for (uint64_t walId = 0; walId < numWalFiles; walId++) {
+      const int cpu = storeOption->mWorkerThreads + walId;
+      mGroupCommitters.emplace_back(std::make_unique<GroupCommitter>(
+          mStore, walId, std::move(workerCtxsOfWal[walId]), cpu));
+    }
+    for (uint64_t workerId = 0; workerId < mWorkerCtxs.size(); workerId++) {
+      mWorkerCtxs[workerId]->mLogging.mGroupCommitter =
+          mGroupCommitters[workerId % numWalFiles].get();
+    }
+    for (auto& groupCommitter : mGroupCommitters) {
+      groupCommitter->Start();
+    }
   }
 
   // create history storage for each worker
@@ -46,10 +92,22 @@ CRManager::CRManager(leanstore::LeanStore* store) : mStore(store), mGroupCommitt
     mWorkerThreads[0]->SetJob([&]() { setupHistoryStorage4EachWorker(); });
     mWorkerThreads[0]->Wait();
   }
+
+  if (mGarbageCollector != nullptr) {
+    mGarbageCollector->Start();
+  }
 }
 
 void CRManager::Stop() {
-  mGroupCommitter->Stop();
+  // versions may still be purged until the garbage collector stops, which needs the group
+  // committers to flush its WAL
+  if (mGarbageCollector != nullptr) {
+    mGarbageCollector->Stop();
+  }
+
+  for (auto& groupCommitter : mGroupCommitters) {
+    groupCommitter->Stop();
+  }
 
   for (auto& workerThread : mWorkerThreads) {
     workerThread->Stop();
@@ -62,7 +120,9 @@ CRManager::~CRManager() {
 }
 
 void CRManager::setupHistoryStorage4EachWorker() {
-  for (uint64_t i = 0; i < mStore->mStoreOption->mWorkerThreads; i++) {
+  // the garbage collector generates no version
+  const uint64_t numWorkerCtxs = mWorkerCtxs.size() - (mGarbageCollector != nullptr ? 1 : 0);
+  for (uint64_t i = 0; i < numWorkerCtxs; i++) {
     // setup update tree
     std::string updateBtreeName = std::format("_history_tree_{}_updates", i);
     auto res = storage::btree::BasicKV::Create(
@@ -88,19 +148,67 @@ void CRManager::setupHistoryStorage4EachWorker() {
 }
 
 constexpr char kKeyWalSize[] = "wal_size";
+constexpr char kKeyWalCompression[] = "wal_compression";
 constexpr char kKeyGlobalUsrTso[] = "global_user_tso";
 constexpr char kKeyGlobalSysTso[] = "global_system_tso";
 
+std::vector<uint64_t> CRManager::WalSizes() {
+  std::vector<uint64_t> walSizes;
+  walSizes.reserve(mGroupCommitters.size());
+  for (auto& groupCommitter : mGroupCommitters) {
+    walSizes.push_back(groupCommitter->mWalSize.load(std::memory_order_acquire));
+  }
+  return walSizes;
+}
+
+void CRManager::AggregatePerfCounters(PerfCounters& result) {
+  // PerfCounters is an aggregate of counters and histograms of counters
+  static_assert(sizeof(PerfCounters) % sizeof(CounterType) == 0);
+  constexpr auto kNumCounters = sizeof(PerfCounters) / sizeof(CounterType);
+  auto* dest = reinterpret_cast<CounterType*>(&result);
+  std::vector<PerfCounters*> allPerfCounters(mWorkerPerfCounters);
+  if (mGarbageCollector != nullptr) {
+    allPerfCounters.push_back(mGarbageCollector->GetPerfCounters());
+  }
+  for (auto* perfCounters : allPerfCounters) {
+    auto* src = reinterpret_cast<CounterType*>(perfCounters);
+    for (uint64_t i = 0; i < kNumCounters; i++) {
+      auto value = atomic_load_explicit(&src[i], std::memory_order_relaxed);
+      atomic_fetch_add_explicit(&dest[i], value, std::memory_order_relaxed);
+    }
+  }
+}
+
+void CRManager::CollectPerfOpTraces(std::vector<PerfOpTrace>& result) {
+  for (auto* perfOpTraces : mWorkerPerfOpTraces) {
+    perfOpTraces->Collect(result);
+  }
+}
+
 StringMap CRManager::Serialize() {
   StringMap map;
-  map[kKeyWalSize] = std::to_string(mGroupCommitter->mWalSize);
+  map[kKeyWalSize] = utils::JoinNumbers(WalSizes());
+  map[kKeyWalCompression] = std::to_string(mStore->mStoreOption->mEnableWalCompression);
   map[kKeyGlobalUsrTso] = std::to_string(mStore->mUsrTso.load());
   map[kKeyGlobalSysTso] = std::to_string(mStore->mSysTso.load());
   return map;
 }
 
 void CRManager::Deserialize(StringMap map) {
-  mGroupCommitter->mWalSize = std::stoull(map[kKeyWalSize]);
+  auto walSizes = utils::SplitNumbers(map[kKeyWalSize]);
+  if (walSizes.size() != mGroupCommitters.size()) {
+    Log::Fatal("Number of WAL files changed, walFilesInMeta={}, numWalFiles={}", walSizes.size(),
+               mGroupCommitters.size());
+  }
+  // stores created before the WAL compression is supported have uncompressed WAL files
+  bool walCompressed = map.contains(kKeyWalCompression) && map[kKeyWalCompression] == "1";
+  if (walCompressed != mStore->mStoreOption->mEnableWalCompression) {
+    Log::Fatal("WAL compression changed, walCompressionInMeta={}, enableWalCompression={}",
+               walCompressed, mStore->mStoreOption->mEnableWalCompression);
+  }
+  for (uint64_t walId = 0; walId < walSizes.size(); walId++) {
+    mGroupCommitters[walId]->mWalSize = walSizes[walId];
+  }
   mStore->mUsrTso = std::stoull(map[kKeyGlobalUsrTso]);
   mStore->mSysTso = std::stoull(map[kKeyGlobalSysTso]);
 
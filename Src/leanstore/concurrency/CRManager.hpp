@@ -3,6 +3,7 @@
 #include "leanstore/Units.hpp"
 #include "leanstore/concurrency/WorkerContext.hpp"
 #include "leanstore/concurrency/WorkerThread.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
 
 #include <memory>
 #include <vector>
@@ -15,6 +16,7 @@ namespace cr {
 
 struct WaterMarkInfo;
 class GroupCommitter;
+class GarbageCollector;
 
 //! Manages a fixed number of worker threads and group committer threads.
 class CRManager {
@@ -28,14 +30,30 @@ public:
   //! All the thread-local worker references
   std::vector<WorkerContext*> mWorkerCtxs;
 
+  //! The worker contexts of the job slots other than the first one on each worker thread, see
+  //! StoreOption::mJobsPerWorker.
+  std::vector<std::unique_ptr<WorkerContext>> mJobWorkerCtxs;
+
+  //! The thread-local PerfCounters of each worker thread, shared by all the job slots of the
+  //! thread. Read by the metrics exposer without synchronization, the counters are atomic.
+  std::vector<PerfCounters*> mWorkerPerfCounters;
+
+  //! The thread-local sampled leanstore-c API calls of each worker thread, read without
+  //! synchronization like mWorkerPerfCounters.
+  std::vector<PerfOpTraceRing*> mWorkerPerfOpTraces;
+
   WaterMarkInfo mGlobalWmkInfo;
 
-  //! The group committer thread, created and started if WAL is enabled when the
-  //! CRManager instance is created.
+  //! The group committer threads, one for each WAL file, created and started if WAL is enabled
+  //! when the CRManager instance is created. Worker i is served by group committer i % size().
   ///
-  //! NOTE: It should be created after all the worker threads are created and
+  //! NOTE: They should be created after all the worker threads are created and
   //! started.
-  std::unique_ptr<GroupCommitter> mGroupCommitter;
+  std::vector<std::unique_ptr<GroupCommitter>> mGroupCommitters;
+
+  //! The garbage collector thread, created if StoreOption::mEnableGcService is set. Its worker
+  //! context is the last one in mWorkerCtxs, after the ones of all the job slots.
+  std::unique_ptr<GarbageCollector> mGarbageCollector;
 
 public:
   CRManager(leanstore::LeanStore* store);
@@ -49,9 +67,19 @@ public:
   //! Deserialize the state of the CRManager from a StringMap.
   void Deserialize(StringMap map);
 
-  //! Stop all the worker threads and the group committer thread.
+  //! Stop all the worker threads, the garbage collector and the group committer threads.
   void Stop();
 
+  //! Size of each WAL file, i.e. the offset of the next WalEntry written to it.
+  std::vector<uint64_t> WalSizes();
+
+  //! Sums up the PerfCounters of all the worker threads and the garbage collector to the given
+  //! counters.
+  void AggregatePerfCounters(PerfCounters& result);
+
+  //! Appends the sampled leanstore-c API calls of all the worker threads to result.
+  void CollectPerfOpTraces(std::vector<PerfOpTrace>& result);
+
 private:
   void setupHistoryStorage4EachWorker();
 };
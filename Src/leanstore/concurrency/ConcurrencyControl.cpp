@@ -175,10 +175,9 @@ bool ConcurrencyControl::VisibleForAll(TXID txId) {
   return txId < mStore->mCRManager->mGlobalWmkInfo.mWmkOfAllTx.load();
 }
 
-// TODO: smooth purge, we should not let the system hang on this, as a quick
-// fix, it should be enough if we purge in small batches
 void ConcurrencyControl::GarbageCollection() {
-  if (!mStore->mStoreOption->mEnableGc) {
+  // versions are purged by the GarbageCollector instead of the workers
+  if (!mStore->mStoreOption->mEnableGc || mStore->mStoreOption->mEnableGcService) {
     return;
   }
 
@@ -187,24 +186,35 @@ void ConcurrencyControl::GarbageCollection() {
 
   updateGlobalTxWatermarks();
   updateLocalWatermarks();
+  auto numPurged = purgeVersions(WorkerContext::My().mWorkerId, 0);
+  COUNTERS_BLOCK() {
+    atomic_fetch_add(&tlsPerfCounters.mGcVersionsPurged, numPurged);
+  }
+}
+
+uint64_t ConcurrencyControl::purgeVersions(WORKERID workerId, uint64_t limit) {
+  auto onRemoveVersion = [&](const TXID versionTxId, const TREEID treeId,
+                             const uint8_t* versionData, uint64_t versionSize [[maybe_unused]],
+                             const bool calledBefore) {
+    mStore->mTreeRegistry->GarbageCollect(treeId, versionData, workerId, versionTxId,
+                                          calledBefore);
+  };
 
   // remove versions that are nolonger needed by any transaction
+  uint64_t numPurged = 0;
   if (mCleanedWmkOfShortTx <= mLocalWmkOfAllTx) {
     LS_DLOG("Garbage collect history tree, workerId={}, fromTxId={}, toTxId(mLocalWmkOfAllTx)={}",
-            WorkerContext::My().mWorkerId, 0, mLocalWmkOfAllTx);
-    mHistoryStorage.PurgeVersions(
-        0, mLocalWmkOfAllTx,
-        [&](const TXID versionTxId, const TREEID treeId, const uint8_t* versionData,
-            uint64_t versionSize [[maybe_unused]], const bool calledBefore) {
-          mStore->mTreeRegistry->GarbageCollect(treeId, versionData, WorkerContext::My().mWorkerId,
-                                                versionTxId, calledBefore);
-        },
-        0);
+            workerId, 0, mLocalWmkOfAllTx);
+    numPurged = mHistoryStorage.PurgeVersions(0, mLocalWmkOfAllTx, onRemoveVersion, limit);
+    if (limit != 0 && numPurged >= limit) {
+      // the rest are purged in the next round, before moving any tombstone to graveyard
+      return numPurged;
+    }
     mCleanedWmkOfShortTx = mLocalWmkOfAllTx + 1;
   } else {
     LS_DLOG("Skip garbage collect history tree, workerId={}, "
             "mCleanedWmkOfShortTx={}, mLocalWmkOfAllTx={}",
-            WorkerContext::My().mWorkerId, mCleanedWmkOfShortTx, mLocalWmkOfAllTx);
+            workerId, mCleanedWmkOfShortTx, mLocalWmkOfAllTx);
   }
 
   // move tombstones to graveyard
@@ -212,20 +222,16 @@ void ConcurrencyControl::GarbageCollection() {
       mCleanedWmkOfShortTx <= mLocalWmkOfShortTx) {
     LS_DLOG("Garbage collect graveyard, workerId={}, fromTxId={}, "
             "toTxId(mLocalWmkOfShortTx)={}",
-            WorkerContext::My().mWorkerId, mCleanedWmkOfShortTx, mLocalWmkOfShortTx);
-    mHistoryStorage.VisitRemovedVersions(
-        mCleanedWmkOfShortTx, mLocalWmkOfShortTx,
-        [&](const TXID versionTxId, const TREEID treeId, const uint8_t* versionData, uint64_t,
-            const bool calledBefore) {
-          mStore->mTreeRegistry->GarbageCollect(treeId, versionData, WorkerContext::My().mWorkerId,
-                                                versionTxId, calledBefore);
-        });
+            workerId, mCleanedWmkOfShortTx, mLocalWmkOfShortTx);
+    mHistoryStorage.VisitRemovedVersions(mCleanedWmkOfShortTx, mLocalWmkOfShortTx,
+                                         onRemoveVersion);
     mCleanedWmkOfShortTx = mLocalWmkOfShortTx + 1;
   } else {
     LS_DLOG("Skip garbage collect graveyard, workerId={}, "
             "mCleanedWmkOfShortTx={}, mLocalWmkOfShortTx={}",
-            WorkerContext::My().mWorkerId, mCleanedWmkOfShortTx, mLocalWmkOfShortTx);
+            workerId, mCleanedWmkOfShortTx, mLocalWmkOfShortTx);
   }
+  return numPurged;
 }
 
 ConcurrencyControl& ConcurrencyControl::Other(WORKERID otherWorkerId) {
@@ -240,7 +246,7 @@ ConcurrencyControl& ConcurrencyControl::Other(WORKERID otherWorkerId) {
 // watermarks can be garbage collected.
 //
 // Called by the worker thread that is committing a transaction before garbage
-// collection.
+// collection, or by the GarbageCollector before each round.
 void ConcurrencyControl::updateGlobalTxWatermarks() {
   if (!mStore->mStoreOption->mEnableGc) {
     LS_DLOG("Skip updating global watermarks, GC is disabled");
@@ -248,7 +254,7 @@ void ConcurrencyControl::updateGlobalTxWatermarks() {
   }
 
   auto meetGcProbability =
-      mStore->mStoreOption->mEnableEagerGc ||
+      mStore->mStoreOption->mEnableEagerGc || mStore->mStoreOption->mEnableGcService ||
       utils::RandomGenerator::RandU64(0, WorkerContext::My().mAllWorkers.size()) == 0;
   auto performGc = meetGcProbability && mStore->mCRManager->mGlobalWmkInfo.mGlobalMutex.try_lock();
   if (!performGc) {
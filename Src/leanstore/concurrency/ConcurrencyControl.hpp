@@ -210,6 +210,7 @@ public:
 
   //! Garbage collect the version storage. It's called at the end of each transaction. It updates
   //! the global and local watermarks, and removes the unused versions from the version storage.
+  //! Skipped if StoreOption::mEnableGcService is set, the GarbageCollector does it instead.
   void GarbageCollection();
 
   //! Get the version storge in other worker thread.
@@ -221,6 +222,14 @@ private:
 
   //! Update local watermarks of the current worker thread before GC.
   void updateLocalWatermarks();
+
+  //! Purges the versions in mHistoryStorage below the local watermarks, and moves the tombstones
+  //! only visible for long-running transactions to graveyard. workerId is the worker generated the
+  //! versions. Purging stops at about limit versions if limit is not 0, see
+  //! HistoryStorage::PurgeVersions(). Returns the number of purged remove and update versions.
+  uint64_t purgeVersions(WORKERID workerId, uint64_t limit);
+
+  friend class GarbageCollector;
 };
 
 } // namespace leanstore::cr
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "leanstore/concurrency/GarbageCollector.hpp"
+
+#include "leanstore/concurrency/ConcurrencyControl.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
+#include "leanstore/utils/Defer.hpp"
+#include "leanstore/utils/Log.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace leanstore::cr {
+
+//! The garbage collector sleeps for this interval after a round purges nothing.
+constexpr auto kIdleInterval = std::chrono::milliseconds(1);
+
+GarbageCollector::GarbageCollector(leanstore::LeanStore* store,
+                                   std::vector<WorkerContext*>& workerCtxs)
+    : UserThread(store, "GarbageCollect"),
+      mStore(store),
+      mWorkerCtxs(workerCtxs),
+      mWorkerCtx(std::make_unique<WorkerContext>(workerCtxs.size() - 1, workerCtxs, store)) {
+  mWorkerCtxs.back() = mWorkerCtx.get();
+}
+
+void GarbageCollector::runImpl() {
+  WorkerContext::sTlsWorkerCtxRaw = mWorkerCtx.get();
+  SCOPED_DEFER(WorkerContext::sTlsWorkerCtxRaw = nullptr);
+
+  restartThrottle();
+  while (mKeepRunning) {
+    if (gcRound() > 0) {
+      continue;
+    }
+
+    // restart the rate limiting after idle, the idle time is not a credit for the next burst
+    std::this_thread::sleep_for(kIdleInterval);
+    restartThrottle();
+  }
+}
+
+uint64_t GarbageCollector::gcRound() {
+  mWorkerCtx->mCc.updateGlobalTxWatermarks();
+
+  // the last worker context is the garbage collector itself
+  uint64_t numPurged = 0;
+  for (uint64_t workerId = 0; workerId + 1 < mWorkerCtxs.size() && mKeepRunning; workerId++) {
+    numPurged += purgeVersionsOf(workerId);
+    throttle();
+  }
+  return numPurged;
+}
+
+uint64_t GarbageCollector::purgeVersionsOf(WORKERID workerId) {
+  COUNTER_INC(&mPerfCounters.mGcExecuted);
+  COUNTER_TIMER_SCOPED(&mPerfCounters.mGcTotalLatNs);
+
+  // trees read the watermarks from the context of the current thread when the versions are purged,
+  // they should be the ones of the worker generated the versions
+  auto& cc = mWorkerCtxs[workerId]->mCc;
+  cc.updateLocalWatermarks();
+  mWorkerCtx->mCc.mLocalWmkOfAllTx = cc.mLocalWmkOfAllTx;
+  mWorkerCtx->mCc.mLocalWmkOfShortTx = cc.mLocalWmkOfShortTx;
+
+  auto numPurged = cc.purgeVersions(workerId, mStore->mStoreOption->mGcBatchSize);
+  LS_DLOG("Garbage collected, workerId={}, numPurged={}, mLocalWmkOfAllTx={}", workerId, numPurged,
+          cc.mLocalWmkOfAllTx);
+  COUNTERS_BLOCK() {
+    atomic_fetch_add(&mPerfCounters.mGcVersionsPurged, numPurged);
+  }
+  mNumPurgedVersions += numPurged;
+  return numPurged;
+}
+
+void GarbageCollector::throttle() {
+  const auto maxVersionsPerSec = mStore->mStoreOption->mGcMaxVersionsPerSec;
+  if (maxVersionsPerSec == 0) {
+    return;
+  }
+
+  // no foreground load to leave the resources to, the versions purged so far are not counted
+  // against the workers started later
+  if (mStore->GetUsrTxTs() == mThrottleStartedUsrTxTs) {
+    restartThrottle();
+    return;
+  }
+
+  auto expectedUs = mNumPurgedVersions * 1000000 / maxVersionsPerSec;
+  auto elaspedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - mThrottleStartedAt)
+                       .count();
+  if (static_cast<uint64_t>(elaspedUs) < expectedUs) {
+    std::this_thread::sleep_for(std::chrono::microseconds(expectedUs - elaspedUs));
+  }
+}
+
+void GarbageCollector::restartThrottle() {
+  mThrottleStartedAt = std::chrono::steady_clock::now();
+  mThrottleStartedUsrTxTs = mStore->GetUsrTxTs();
+  mNumPurgedVersions = 0;
+}
+
+} // namespace leanstore::cr
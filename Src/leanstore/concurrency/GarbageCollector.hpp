@@ -0,0 +1,82 @@
+#pragma once
+
+#include "leanstore/leanstore-c/PerfCounters.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/utils/UserThread.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace leanstore::cr {
+
+//! MVCC garbage collection service, see StoreOption::mEnableGcService. It takes the garbage
+//! collection off the commit path of the workers.
+//!
+//! Each round updates the global watermarks once, then purges the history of every worker below
+//! the watermarks of that worker. About mGcBatchSize remove and update versions are purged from a
+//! worker before moving on to the next one, so that a worker with a long history doesn't delay the
+//! others. Update versions are purged a whole history leaf at a time. The purge rate is limited by
+//! mGcMaxVersionsPerSec while user transactions are running, an idle store is purged at full speed.
+//!
+//! The garbage collector has a worker context of its own, it's the last one in the worker contexts
+//! of the CRManager. Trees modified during garbage collection see it as the last writer, and the
+//! system transactions it runs are logged to its WAL buffer.
+class GarbageCollector : public utils::UserThread {
+public:
+  leanstore::LeanStore* mStore;
+
+  //! All the worker contexts, including the one of the garbage collector.
+  std::vector<WorkerContext*>& mWorkerCtxs;
+
+  //! The worker context of the garbage collector thread.
+  std::unique_ptr<WorkerContext> mWorkerCtx;
+
+  //! Batches executed and versions purged by the garbage collector.
+  PerfCounters mPerfCounters{};
+
+private:
+  //! Start time, user transaction timestamp and number of versions purged since the rate limiting
+  //! was restarted.
+  std::chrono::steady_clock::time_point mThrottleStartedAt;
+  TXID mThrottleStartedUsrTxTs = 0;
+  uint64_t mNumPurgedVersions = 0;
+
+public:
+  //! Creates the garbage collector, its worker context takes the last slot of workerCtxs.
+  GarbageCollector(leanstore::LeanStore* store, std::vector<WorkerContext*>& workerCtxs);
+
+  ~GarbageCollector() override {
+    Stop();
+  }
+
+  // no copy and assign
+  GarbageCollector(const GarbageCollector&) = delete;
+  GarbageCollector& operator=(const GarbageCollector&) = delete;
+
+  PerfCounters* GetPerfCounters() {
+    return &mPerfCounters;
+  }
+
+protected:
+  void runImpl() override;
+
+private:
+  //! Runs a garbage collection round on all the workers. Returns the number of purged versions.
+  uint64_t gcRound();
+
+  //! Purges a batch of versions generated by the given worker. Returns the number of purged
+  //! versions.
+  uint64_t purgeVersionsOf(WORKERID workerId);
+
+  //! Sleeps the garbage collector to keep the purge rate below the limit, if user transactions
+  //! were started since the rate limiting was restarted.
+  void throttle();
+
+  //! Restarts the rate limiting, the versions purged before are not counted anymore.
+  void restartThrottle();
+};
+
+} // namespace leanstore::cr
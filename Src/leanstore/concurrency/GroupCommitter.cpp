@@ -1,45 +1,157 @@
 #include "leanstore/concurrency/GroupCommitter.hpp"
 
 #include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/WalEntry.hpp"
 #include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
+#include "leanstore/utils/Defer.hpp"
 
 #include <algorithm>
 #include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <cstring>
 #include <ctime>
 #include <format>
 
+#include <lz4.h>
+
 namespace leanstore::cr {
 
 //! The alignment of the WAL record
 constexpr size_t kAligment = 4096;
 
+//! The batch window is this fraction of the average flush latency, waiting longer than a flush
+//! doesn't pay off.
+constexpr uint64_t kBatchWindowDivisor = 2;
+
+//! Transactions waiting for other group committers are rechecked at this interval in case the
+//! notification from them is missed.
+constexpr auto kPendingTxsRecheckInterval = std::chrono::microseconds(100);
+
 void GroupCommitter::runImpl() {
   TXID minFlushedSysTx = std::numeric_limits<TXID>::max();
   TXID minFlushedUsrTx = std::numeric_limits<TXID>::max();
   std::vector<uint64_t> numRfaTxs(mWorkerCtxs.size(), 0);
   std::vector<WalFlushReq> walFlushReqCopies(mWorkerCtxs.size());
+  const auto maxBatchWindow =
+      std::chrono::microseconds(mStore->mStoreOption->mMaxGroupCommitWindowUs);
 
   while (mKeepRunning) {
+    auto seenNotifies = mNumNotifies.load(std::memory_order_seq_cst);
+
     // phase 1
-    collectWalRecords(minFlushedSysTx, minFlushedUsrTx, numRfaTxs, walFlushReqCopies);
+    mBatchBytes = 0;
+    auto numActiveWorkers =
+        collectWalRecords(minFlushedSysTx, minFlushedUsrTx, numRfaTxs, walFlushReqCopies);
 
     // phase 2
+    bool flushed = false;
     if (!mAIo.IsEmpty()) {
+      auto startAt = std::chrono::steady_clock::now();
       flushWalRecords();
+      auto flushLatNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - startAt)
+                            .count();
+      mAvgFlushLatNs = NextAvgFlushLatNs(mAvgFlushLatNs, flushLatNs);
+      COUNTER_HIST_RECORD(&mPerfCounters.mGroupCommitFlushLatNs, flushLatNs);
+      COUNTER_HIST_RECORD(&mPerfCounters.mGroupCommitBatchBytes, mBatchBytes);
+      flushed = true;
     }
 
     // phase 3
-    determineCommitableTx(minFlushedSysTx, minFlushedUsrTx, numRfaTxs, walFlushReqCopies);
+    auto numCommitted =
+        determineCommitableTx(minFlushedSysTx, minFlushedUsrTx, numRfaTxs, walFlushReqCopies);
+    if (numCommitted > 0) {
+      COUNTER_HIST_RECORD(&mPerfCounters.mGroupCommitBatchTxs, numCommitted);
+    }
+
+    // Nothing changed since the last round, all the queued transactions are committed in this
+    // round unless they wait for other group committers. Sleep until a worker publishes new wal
+    // records.
+    if (numActiveWorkers == 0) {
+      if (mHasPendingTxs.load(std::memory_order_acquire)) {
+        waitNotifies(seenNotifies, 1, kPendingTxsRecheckInterval);
+      } else {
+        waitNotifies(seenNotifies, 1);
+      }
+      continue;
+    }
+
+    // Wait for the active workers to publish more wal records, so that they are flushed together.
+    if (flushed) {
+      waitNotifies(mNumNotifies.load(std::memory_order_seq_cst), numActiveWorkers,
+                   BatchWindow(mAvgFlushLatNs, maxBatchWindow));
+    }
+  }
+}
+
+uint64_t GroupCommitter::NextAvgFlushLatNs(uint64_t avgFlushLatNs, uint64_t flushLatNs) {
+  return avgFlushLatNs == 0 ? flushLatNs : (avgFlushLatNs * 7 + flushLatNs) / 8;
+}
+
+std::chrono::nanoseconds GroupCommitter::BatchWindow(uint64_t avgFlushLatNs,
+                                                     std::chrono::microseconds maxBatchWindow) {
+  if (maxBatchWindow.count() <= 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::min<std::chrono::nanoseconds>(
+      std::chrono::nanoseconds(avgFlushLatNs / kBatchWindowDivisor), maxBatchWindow);
+}
+
+void GroupCommitter::waitNotifies(uint64_t seenNotifies, uint64_t numNotifies,
+                                  std::chrono::nanoseconds timeout) {
+  auto isNotified = [&]() {
+    return !mKeepRunning ||
+           mNumNotifies.load(std::memory_order_seq_cst) - seenNotifies >= numNotifies;
+  };
+  if (isNotified() || timeout.count() <= 0) {
+    return;
+  }
+
+  mIsSleeping.store(true, std::memory_order_seq_cst);
+  SCOPED_DEFER(mIsSleeping.store(false, std::memory_order_seq_cst));
+  std::unique_lock guard(mSleepMutex);
+  if (timeout == std::chrono::nanoseconds::max()) {
+    mSleepCv.wait(guard, isNotified);
+  } else {
+    mSleepCv.wait_for(guard, timeout, isNotified);
+  }
+}
+
+uint64_t GroupCommitter::frameBufferSize(leanstore::LeanStore* store, uint64_t numWorkers) {
+  if (!store->mStoreOption->mEnableWalCompression) {
+    return 0;
+  }
+
+  // the partial block, and at most 2 frames for each worker when its ring buffer wraps around
+  auto walBufferSize = store->mStoreOption->mWalBufferSize;
+  auto maxFrameSize = sizeof(WalFrameHeader) + LZ4_compressBound(walBufferSize);
+  return utils::AlignUp(kAligment + numWorkers * 2 * maxFrameSize, kAligment);
+}
+
+void GroupCommitter::registerIoResources() {
+  std::vector<iovec> walBuffers;
+  walBuffers.reserve(mWorkerCtxs.size() + 1);
+  for (auto* workerCtx : mWorkerCtxs) {
+    walBuffers.push_back(iovec{workerCtx->mLogging.mWalBuffer, workerCtx->mLogging.mWalBufferSize});
+  }
+  if (mStore->mStoreOption->mEnableWalCompression) {
+    walBuffers.push_back(iovec{mFrameBuffer.Get(), frameBufferSize(mStore, mWorkerCtxs.size())});
   }
+  mAIo.RegisterBuffers(walBuffers);
+  mAIo.RegisterFiles({mWalFd});
 }
 
-void GroupCommitter::collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUsrTx,
-                                       std::vector<uint64_t>& numRfaTxs,
-                                       std::vector<WalFlushReq>& walFlushReqCopies) {
+uint64_t GroupCommitter::collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUsrTx,
+                                           std::vector<uint64_t>& numRfaTxs,
+                                           std::vector<WalFlushReq>& walFlushReqCopies) {
   minFlushedSysTx = std::numeric_limits<TXID>::max();
   minFlushedUsrTx = std::numeric_limits<TXID>::max();
+  uint64_t numActiveWorkers = 0;
+  if (mStore->mStoreOption->mEnableWalCompression) {
+    rewindFrameBuffer();
+  }
 
   for (auto workerId = 0u; workerId < mWorkerCtxs.size(); workerId++) {
     auto& logging = mWorkerCtxs[workerId]->mLogging;
@@ -58,6 +170,7 @@ void GroupCommitter::collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUs
       // no transaction log write since last round group commit, skip.
       continue;
     }
+    numActiveWorkers++;
 
     if (reqCopy.mSysTxWrittern > 0) {
       minFlushedSysTx = std::min(minFlushedSysTx, reqCopy.mSysTxWrittern);
@@ -78,9 +191,13 @@ void GroupCommitter::collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUs
     }
   }
 
+  if (mStore->mStoreOption->mEnableWalCompression) {
+    prepareFrameWrite();
+  }
   if (!mAIo.IsEmpty() && mStore->mStoreOption->mEnableWalFsync) {
     mAIo.PrepareFsync(mWalFd);
   }
+  return numActiveWorkers;
 }
 
 void GroupCommitter::flushWalRecords() {
@@ -104,9 +221,22 @@ void GroupCommitter::flushWalRecords() {
   }
 }
 
-void GroupCommitter::determineCommitableTx(TXID minFlushedSysTx, TXID minFlushedUsrTx,
-                                           const std::vector<uint64_t>& numRfaTxs,
-                                           const std::vector<WalFlushReq>& walFlushReqCopies) {
+uint64_t GroupCommitter::determineCommitableTx(TXID minFlushedSysTx, TXID minFlushedUsrTx,
+                                               const std::vector<uint64_t>& numRfaTxs,
+                                               const std::vector<WalFlushReq>& walFlushReqCopies) {
+  // transactions with remote dependencies may depend on the workers of other group committers
+  mMinFlushedSysTx.store(minFlushedSysTx, std::memory_order_release);
+  mMinFlushedUsrTx.store(minFlushedUsrTx, std::memory_order_release);
+  auto& groupCommitters = mStore->mCRManager->mGroupCommitters;
+  for (auto& groupCommitter : groupCommitters) {
+    minFlushedSysTx =
+        std::min(minFlushedSysTx, groupCommitter->mMinFlushedSysTx.load(std::memory_order_acquire));
+    minFlushedUsrTx =
+        std::min(minFlushedUsrTx, groupCommitter->mMinFlushedUsrTx.load(std::memory_order_acquire));
+  }
+
+  uint64_t numCommitted = 0;
+  bool hasPendingTxs = false;
   for (WORKERID workerId = 0; workerId < mWorkerCtxs.size(); workerId++) {
     auto& logging = mWorkerCtxs[workerId]->mLogging;
     const auto& reqCopy = walFlushReqCopies[workerId];
@@ -133,6 +263,8 @@ void GroupCommitter::determineCommitableTx(TXID minFlushedSysTx, TXID minFlushed
       if (i > 0) {
         logging.mTxToCommit.erase(logging.mTxToCommit.begin(), logging.mTxToCommit.begin() + i);
       }
+      numCommitted += i;
+      hasPendingTxs |= !logging.mTxToCommit.empty();
     }
 
     // commit transactions without remote dependency
@@ -152,6 +284,7 @@ void GroupCommitter::determineCommitableTx(TXID minFlushedSysTx, TXID minFlushed
         logging.mRfaTxToCommit.erase(logging.mRfaTxToCommit.begin(),
                                      logging.mRfaTxToCommit.begin() + i);
       }
+      numCommitted += i;
     }
 
     // Has committed transaction
@@ -169,17 +302,80 @@ void GroupCommitter::determineCommitableTx(TXID minFlushedSysTx, TXID minFlushed
   }
 
   mGlobalMinFlushedSysTx.store(minFlushedSysTx, std::memory_order_release);
+  mHasPendingTxs.store(hasPendingTxs, std::memory_order_release);
+
+  // wake up the group committers waiting for the transactions flushed in this round
+  for (auto& groupCommitter : groupCommitters) {
+    if (groupCommitter.get() != this && groupCommitter->mHasPendingTxs.load()) {
+      groupCommitter->Notify();
+    }
+  }
+  return numCommitted;
 }
 
 void GroupCommitter::append(uint8_t* buf, uint64_t lower, uint64_t upper) {
+  if (mStore->mStoreOption->mEnableWalCompression) {
+    appendFrame(buf, lower, upper);
+    return;
+  }
+
   auto lowerAligned = utils::AlignDown(lower, kAligment);
   auto upperAligned = utils::AlignUp(upper, kAligment);
   auto* bufAligned = buf + lowerAligned;
   auto countAligned = upperAligned - lowerAligned;
-  auto offsetAligned = utils::AlignDown(mWalSize, kAligment);
+  auto walSize = mWalSize.load(std::memory_order_relaxed);
+  auto offsetAligned = utils::AlignDown(walSize, kAligment);
 
   mAIo.PrepareWrite(mWalFd, bufAligned, countAligned, offsetAligned);
-  mWalSize += upper - lower;
+  mBatchBytes += upper - lower;
+  mWalSize.store(walSize + upper - lower, std::memory_order_release);
 };
 
+void GroupCommitter::appendFrame(uint8_t* buf, uint64_t lower, uint64_t upper) {
+  auto* frame = mFrameBuffer.Get() + mFrameBytes;
+  auto* payload = frame + sizeof(WalFrameHeader);
+  auto* src = reinterpret_cast<const char*>(buf + lower);
+  auto rawSize = static_cast<int>(upper - lower);
+  auto payloadSize = LZ4_compress_default(src, reinterpret_cast<char*>(payload), rawSize,
+                                          LZ4_compressBound(rawSize));
+  if (payloadSize <= 0 || payloadSize >= rawSize) {
+    // not compressible, store the wal entries as is
+    std::memcpy(payload, src, rawSize);
+    payloadSize = rawSize;
+  }
+
+  new (frame) WalFrameHeader(rawSize, payloadSize);
+  mFrameBytes += sizeof(WalFrameHeader) + payloadSize;
+  mBatchBytes += rawSize;
+}
+
+void GroupCommitter::rewindFrameBuffer() {
+  auto walSize = mWalSize.load(std::memory_order_relaxed);
+  auto partialSize = walSize % kAligment;
+  if (mFrameBytes == 0 && partialSize > 0) {
+    // the first round after the store is reopened
+    auto offsetAligned = utils::AlignDown(walSize, kAligment);
+    if (pread(mWalFd, mFrameBuffer.Get(), kAligment, offsetAligned) < 0) {
+      Log::Error("Failed to read the last WAL block, walId={}, offset={}, errno={}, error={}",
+                 mWalId, offsetAligned, errno, strerror(errno));
+    }
+  } else if (partialSize > 0) {
+    std::memmove(mFrameBuffer.Get(), mFrameBuffer.Get() + mFrameBytes - partialSize, partialSize);
+  }
+  mFrameBytes = partialSize;
+}
+
+void GroupCommitter::prepareFrameWrite() {
+  auto walSize = mWalSize.load(std::memory_order_relaxed);
+  auto partialSize = walSize % kAligment;
+  if (mFrameBytes == partialSize) {
+    return;
+  }
+
+  auto offsetAligned = utils::AlignDown(walSize, kAligment);
+  mAIo.PrepareWrite(mWalFd, mFrameBuffer.Get(), utils::AlignUp(mFrameBytes, kAligment),
+                    offsetAligned);
+  mWalSize.store(offsetAligned + mFrameBytes, std::memory_order_release);
+}
+
 } // namespace leanstore::cr
\ No newline at end of file
@@ -2,11 +2,19 @@
 
 #include "leanstore/LeanStore.hpp"
 #include "leanstore/Units.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
 #include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/Misc.hpp"
 #include "leanstore/utils/UserThread.hpp"
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <libaio.h>
 #include <pthread.h>
@@ -19,46 +27,147 @@ class WorkerContext;
 class WalFlushReq;
 
 //! The group committer thread is responsible for committing transactions in batches. It collects
-//! wal records from all the worker threads, writes them to the wal file with libaio, and determines
-//! the commitable transactions based on the min flushed GSN and min flushed transaction ID.
+//! wal records from the worker threads it serves, writes them to its own wal file with libaio, and
+//! determines the commitable transactions based on the min flushed system and user transaction ID.
+//!
+//! With StoreOption::mNumWalFiles > 1, the WAL is striped over several files, each written by a
+//! group committer serving a subset of the workers. Transactions with remote dependencies are
+//! committed with the min flushed transaction IDs of all the group committers.
+//!
+//! The group committer sleeps when no worker has published new wal records since the last round,
+//! workers wake it up with Notify() when they commit or run out of wal buffer. After a flush, it
+//! waits a batch window for more workers to publish their records, the window is adapted to the
+//! observed flush latency and capped by mMaxGroupCommitWindowUs.
+//!
+//! With StoreOption::mEnableWalCompression, the wal records collected from each worker are
+//! compressed into a WalFrameHeader prefixed frame, all the frames of a round are written with a
+//! single aligned write.
 class GroupCommitter : public leanstore::utils::UserThread {
 public:
   leanstore::LeanStore* mStore;
 
+  //! ID of the WAL file written by this group committer.
+  const uint64_t mWalId;
+
   //! File descriptor of the underlying WAL file.
   const int32_t mWalFd;
 
-  //! Start file offset of the next WalEntry.
-  uint64_t mWalSize;
+  //! Start file offset of the next WalEntry. Read by the checkpointer to determine the checkpoint
+  //! LSN.
+  std::atomic<uint64_t> mWalSize;
 
   //! The minimum flushed system transaction ID among all worker threads. User transactions whose
   //! max observed system transaction ID not larger than it can be committed safely.
   std::atomic<TXID> mGlobalMinFlushedSysTx;
 
-  //! All the workers.
-  std::vector<WorkerContext*>& mWorkerCtxs;
+  //! The min flushed system and user transaction ID of the workers served by this group committer
+  //! in the last round, read by the other group committers.
+  std::atomic<TXID> mMinFlushedSysTx;
+  std::atomic<TXID> mMinFlushedUsrTx;
+
+  //! Whether there are transactions with remote dependencies waiting for the other group
+  //! committers to flush, they notify this group committer after flushing.
+  std::atomic<bool> mHasPendingTxs;
 
-  //! The libaio wrapper.
+  //! The workers served by this group committer.
+  std::vector<WorkerContext*> mWorkerCtxs;
+
+  //! The async IO wrapper, libaio or io_uring.
   utils::AsyncIo mAIo;
 
+  //! Batch sizes and flush latencies of the group commit rounds.
+  PerfCounters mPerfCounters{};
+
+private:
+  //! Number of Notify() calls, the group committer sleeps until it changes.
+  std::atomic<uint64_t> mNumNotifies = 0;
+
+  //! Whether the group committer is sleeping or going to sleep.
+  std::atomic<bool> mIsSleeping = false;
+
+  std::mutex mSleepMutex;
+
+  std::condition_variable mSleepCv;
+
+  //! Moving average of the flush latency in nanoseconds.
+  uint64_t mAvgFlushLatNs = 0;
+
+  //! WAL bytes appended in the current round.
+  uint64_t mBatchBytes = 0;
+
+  //! The compressed frames to write in the current round. It starts with the last partial block
+  //! of the WAL file, so that the frames are appended with aligned writes.
+  utils::AlignedBuffer<512> mFrameBuffer;
+
+  //! Number of bytes in mFrameBuffer, including the partial block.
+  uint64_t mFrameBytes = 0;
+
 public:
-  GroupCommitter(leanstore::LeanStore* store, int32_t walFd, std::vector<WorkerContext*>& workers,
+  GroupCommitter(leanstore::LeanStore* store, uint64_t walId, std::vector<WorkerContext*> workers,
                  int cpu)
       : UserThread(store, "GroupCommitter", cpu),
         mStore(store),
-        mWalFd(walFd),
+        mWalId(walId),
+        mWalFd(store->mWalFds[walId]),
         mWalSize(0),
         mGlobalMinFlushedSysTx(0),
-        mWorkerCtxs(workers),
-        mAIo(workers.size() * 2 + 2) {
+        mMinFlushedSysTx(std::numeric_limits<TXID>::max()),
+        mMinFlushedUsrTx(std::numeric_limits<TXID>::max()),
+        mHasPendingTxs(false),
+        mWorkerCtxs(std::move(workers)),
+        mAIo(mWorkerCtxs.size() * 2 + 2, store->mStoreOption->mIoBackend),
+        mFrameBuffer(frameBufferSize(store, mWorkerCtxs.size())) {
+    registerIoResources();
   }
 
   virtual ~GroupCommitter() override = default;
 
+  //! Stops the group committer, wakes it up if it is sleeping.
+  void Stop() override {
+    mKeepRunning = false;
+    Notify();
+    UserThread::Stop();
+  }
+
+  //! Wakes up the group committer if it is sleeping. Called by workers after they queue
+  //! transactions to commit, or when they wait for free space in the wal ring buffer.
+  void Notify() {
+    mNumNotifies.fetch_add(1, std::memory_order_seq_cst);
+    if (mIsSleeping.load(std::memory_order_seq_cst)) {
+      std::unique_lock guard(mSleepMutex);
+      mSleepCv.notify_one();
+    }
+  }
+
+  PerfCounters* GetPerfCounters() {
+    return &mPerfCounters;
+  }
+
+  //! Moving average of the flush latency after a flush of flushLatNs, the first flush initializes
+  //! it.
+  static uint64_t NextAvgFlushLatNs(uint64_t avgFlushLatNs, uint64_t flushLatNs);
+
+  //! How long to wait for more wal records after a flush, half of the average flush latency capped
+  //! by maxBatchWindow. 0 if batching is disabled, i.e. maxBatchWindow is 0.
+  static std::chrono::nanoseconds BatchWindow(uint64_t avgFlushLatNs,
+                                              std::chrono::microseconds maxBatchWindow);
+
 protected:
   virtual void runImpl() override;
 
 private:
+  //! Size of mFrameBuffer, enough for the frames of all the wal records of the workers. 0 if the
+  //! WAL compression is disabled.
+  static uint64_t frameBufferSize(leanstore::LeanStore* store, uint64_t numWorkers);
+
+  //! Registers the WAL file and the WAL buffers of all the workers to the io_uring instance.
+  void registerIoResources();
+
+  //! Sleeps until Notify() is called numNotifies times after the given notify count was observed,
+  //! or the timeout expires, or the group committer is stopped.
+  void waitNotifies(uint64_t seenNotifies, uint64_t numNotifies,
+                    std::chrono::nanoseconds timeout = std::chrono::nanoseconds::max());
+
   //! Phase 1: collect wal records from all the worker threads. Collected wal records are written to
   //! libaio IOCBs.
   //!
@@ -66,22 +175,25 @@ private:
   //! @param[out] minFlushedUsrTx the min flushed user transaction ID
   //! @param[out] numRfaTxs number of transactions without dependency
   //! @param[out] walFlushReqCopies snapshot of the flush requests
-  void collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUsrTx,
-                         std::vector<uint64_t>& numRfaTxs,
-                         std::vector<WalFlushReq>& walFlushReqCopies);
+  //! @return number of workers which published new wal flush requests since the last round
+  uint64_t collectWalRecords(TXID& minFlushedSysTx, TXID& minFlushedUsrTx,
+                             std::vector<uint64_t>& numRfaTxs,
+                             std::vector<WalFlushReq>& walFlushReqCopies);
 
   //! Phase 2: write all the collected wal records to the wal file with libaio.
   void flushWalRecords();
 
-  //! Phase 3: determine the commitable transactions based on minFlushedGSN and minFlushedTxId.
+  //! Phase 3: determine the commitable transactions based on minFlushedSysTx and minFlushedUsrTx,
+  //! combined with the ones of the other group committers.
   //!
   //! @param[in] minFlushedSysTx the min flushed system transaction ID
   //! @param[in] minFlushedUsrTx the min flushed user transaction ID
   //! @param[in] numRfaTxs number of transactions without dependency
   //! @param[in] walFlushReqCopies snapshot of the flush requests
-  void determineCommitableTx(TXID minFlushedSysTx, TXID minFlushedUsrTx,
-                             const std::vector<uint64_t>& numRfaTxs,
-                             const std::vector<WalFlushReq>& walFlushReqCopies);
+  //! @return number of transactions committed
+  uint64_t determineCommitableTx(TXID minFlushedSysTx, TXID minFlushedUsrTx,
+                                 const std::vector<uint64_t>& numRfaTxs,
+                                 const std::vector<WalFlushReq>& walFlushReqCopies);
 
   //! Append a wal entry to libaio IOCBs.
   //!
@@ -89,6 +201,16 @@ private:
   //! @param[in] lower the begin offset of the wal entry in the buffer
   //! @param[in] upper the end offset of the wal entry in the buffer
   void append(uint8_t* buf, uint64_t lower, uint64_t upper);
+
+  //! Compresses the wal entries in [lower, upper) of the buffer to a frame in mFrameBuffer.
+  void appendFrame(uint8_t* buf, uint64_t lower, uint64_t upper);
+
+  //! Keeps only the last partial block of the WAL file in mFrameBuffer before collecting the
+  //! frames of a new round. The block is read from the WAL file in the first round.
+  void rewindFrameBuffer();
+
+  //! Appends the frames collected in the current round to libaio IOCBs.
+  void prepareFrameWrite();
 };
 
 } // namespace leanstore::cr
@@ -124,80 +124,94 @@ bool HistoryStorage::GetVersion(TXID newerTxId, COMMANDID newerCommandId,
   return false;
 }
 
-void HistoryStorage::PurgeVersions(TXID fromTxId, TXID toTxId,
-                                   RemoveVersionCallback onRemoveVersion,
-                                   [[maybe_unused]] const uint64_t limit) {
+uint64_t HistoryStorage::PurgeVersions(TXID fromTxId, TXID toTxId,
+                                       RemoveVersionCallback onRemoveVersion,
+                                       const uint64_t limit) {
   auto keySize = sizeof(toTxId);
   uint8_t keyBuffer[utils::tlsStore->mStoreOption->mPageSize];
-  utils::Fold(keyBuffer, fromTxId);
-  Slice key(keyBuffer, keySize);
+  Slice key;
 
   uint8_t payload[utils::tlsStore->mStoreOption->mPageSize];
   uint16_t payloadSize;
-  uint64_t versionsRemoved = 0;
+  volatile uint64_t versionsRemoved = 0;
+  auto limitReached = [&]() { return limit != 0 && versionsRemoved >= limit; };
 
-  // purge remove versions
+  // purge remove versions, restarted from the beginning of the range on jumps, the history may be
+  // modified by its worker concurrently if purged by the GarbageCollector
   auto* btree = mRemoveIndex;
-  JUMPMU_TRY() {
-  restartrem: {
-    auto xIter = btree->GetExclusiveIterator();
-    xIter.SetExitLeafCallback([&](leanstore::storage::GuardedBufferFrame<BTreeNode>& guardedLeaf) {
-      if (guardedLeaf->FreeSpaceAfterCompaction() >= BTreeNode::UnderFullSize()) {
-        xIter.SetCleanUpCallback([&, toMerge = guardedLeaf.mBf] {
-          JUMPMU_TRY() {
-            TXID sysTxId = btree->mStore->AllocSysTxTs();
-            btree->TryMergeMayJump(sysTxId, *toMerge);
-          }
-          JUMPMU_CATCH() {
-          }
-        });
-      }
-    });
-    for (xIter.SeekToFirstGreaterEqual(key); xIter.Valid(); xIter.SeekToFirstGreaterEqual(key)) {
-      // finished if we are out of the transaction range
-      xIter.AssembleKey();
-      TXID curTxId;
-      utils::Unfold(xIter.Key().data(), curTxId);
-      if (curTxId < fromTxId || curTxId > toTxId) {
-        break;
-      }
+  while (true) {
+    JUMPMU_TRY() {
+      utils::Fold(keyBuffer, fromTxId);
+      key = Slice(keyBuffer, sizeof(TXID));
+    restartrem: {
+      auto xIter = btree->GetExclusiveIterator();
+      xIter.SetExitLeafCallback(
+          [&](leanstore::storage::GuardedBufferFrame<BTreeNode>& guardedLeaf) {
+            if (guardedLeaf->FreeSpaceAfterCompaction() >= BTreeNode::UnderFullSize()) {
+              xIter.SetCleanUpCallback([&, toMerge = guardedLeaf.mBf] {
+                JUMPMU_TRY() {
+                  TXID sysTxId = btree->mStore->AllocSysTxTs();
+                  btree->TryMergeMayJump(sysTxId, *toMerge);
+                }
+                JUMPMU_CATCH() {
+                }
+              });
+            }
+          });
+      for (xIter.SeekToFirstGreaterEqual(key); xIter.Valid();
+           xIter.SeekToFirstGreaterEqual(key)) {
+        // the rest are left for the next round if the limit is reached
+        if (limitReached()) {
+          break;
+        }
 
-      auto& versionContainer = *reinterpret_cast<VersionMeta*>(xIter.MutableVal().Data());
-      const TREEID treeId = versionContainer.mTreeId;
-      const bool calledBefore = versionContainer.mCalledBefore;
-      versionContainer.mCalledBefore = true;
+        // finished if we are out of the transaction range
+        xIter.AssembleKey();
+        TXID curTxId;
+        utils::Unfold(xIter.Key().data(), curTxId);
+        if (curTxId < fromTxId || curTxId > toTxId) {
+          break;
+        }
 
-      // set the next key to be seeked
-      keySize = xIter.Key().size();
-      std::memcpy(keyBuffer, xIter.Key().data(), keySize);
-      key = Slice(keyBuffer, keySize + 1);
+        auto& versionContainer = *reinterpret_cast<VersionMeta*>(xIter.MutableVal().Data());
+        const TREEID treeId = versionContainer.mTreeId;
+        const bool calledBefore = versionContainer.mCalledBefore;
+        versionContainer.mCalledBefore = true;
 
-      // get the remove version
-      payloadSize = xIter.Val().size() - sizeof(VersionMeta);
-      std::memcpy(payload, versionContainer.mPayload, payloadSize);
+        // set the next key to be seeked
+        keySize = xIter.Key().size();
+        std::memcpy(keyBuffer, xIter.Key().data(), keySize);
+        key = Slice(keyBuffer, keySize + 1);
 
-      // remove the version from history
-      xIter.RemoveCurrent();
-      versionsRemoved = versionsRemoved + 1;
-      xIter.Reset();
+        // get the remove version
+        payloadSize = xIter.Val().size() - sizeof(VersionMeta);
+        std::memcpy(payload, versionContainer.mPayload, payloadSize);
 
-      onRemoveVersion(curTxId, treeId, payload, payloadSize, calledBefore);
-      goto restartrem;
+        // remove the version from history
+        xIter.RemoveCurrent();
+        versionsRemoved = versionsRemoved + 1;
+        xIter.Reset();
+
+        onRemoveVersion(curTxId, treeId, payload, payloadSize, calledBefore);
+        goto restartrem;
+      }
+    }
+      JUMPMU_BREAK;
+    }
+    JUMPMU_CATCH() {
     }
-  }
-  }
-  JUMPMU_CATCH() {
-    UNREACHABLE();
   }
 
-  // purge update versions
+  // purge update versions, a whole leaf at a time once all its versions are in the range
   btree = mUpdateIndex;
   utils::Fold(keyBuffer, fromTxId);
+  key = Slice(keyBuffer, sizeof(TXID));
 
-  // Attention: no cross worker gc in sync
+  // Attention: the history of a worker is purged by one thread at a time, either the worker itself
+  // or the GarbageCollector
   Session* volatile session = &mUpdateSession;
-  volatile bool shouldTry = true;
-  if (fromTxId == 0 && session->mLeftMostBf != nullptr) {
+  volatile bool shouldTry = !limitReached();
+  if (shouldTry && fromTxId == 0 && session->mLeftMostBf != nullptr) {
     JUMPMU_TRY() {
       leanstore::storage::BufferFrame* bf = session->mLeftMostBf;
 
@@ -226,7 +240,7 @@ void HistoryStorage::PurgeVersions(TXID fromTxId, TXID toTxId,
     }
   }
 
-  while (shouldTry) {
+  while (shouldTry && !limitReached()) {
     JUMPMU_TRY() {
       auto xIter = btree->GetExclusiveIterator();
       // check whether the page can be merged when exit a leaf
@@ -268,7 +282,7 @@ void HistoryStorage::PurgeVersions(TXID fromTxId, TXID toTxId,
 
             // purge the whole page if it is in the range
             if (fromTxId <= txIdInFirstKey && txIdInLastKey <= toTxId) {
-              versionsRemoved += guardedLeaf->mNumSlots;
+              versionsRemoved = versionsRemoved + guardedLeaf->mNumSlots;
               guardedLeaf->Reset();
               isFullPagePurged = true;
             }
@@ -284,9 +298,9 @@ void HistoryStorage::PurgeVersions(TXID fromTxId, TXID toTxId,
       JUMPMU_BREAK;
     }
     JUMPMU_CATCH() {
-      UNREACHABLE();
     }
   }
+  return versionsRemoved;
 }
 
 void HistoryStorage::VisitRemovedVersions(TXID fromTxId, TXID toTxId,
@@ -90,7 +90,13 @@ public:
   bool GetVersion(TXID newerTxId, COMMANDID newerCommandId, const bool isRemoveCommand,
                   std::function<void(const uint8_t*, uint64_t)> cb);
 
-  void PurgeVersions(TXID fromTxId, TXID toTxId, RemoveVersionCallback cb, const uint64_t limit);
+  //! Purges the versions generated by transactions in [fromTxId, toTxId]. Each remove version is
+  //! passed to cb before it's purged. Update versions are purged a whole leaf at a time, a leaf is
+  //! kept until all its versions are in the range. If limit is not 0, purging stops once limit
+  //! versions are purged, which may be exceeded by the versions of the last purged leaf. Returns
+  //! the number of purged remove and update versions.
+  uint64_t PurgeVersions(TXID fromTxId, TXID toTxId, RemoveVersionCallback cb,
+                         const uint64_t limit);
 
   void VisitRemovedVersions(TXID fromTxId, TXID toTxId, RemoveVersionCallback cb);
 };
@@ -1,8 +1,10 @@
 #include "leanstore/concurrency/Logging.hpp"
 
 #include "leanstore/Exceptions.hpp"
+#include "leanstore/concurrency/GroupCommitter.hpp"
 #include "leanstore/concurrency/WalEntry.hpp"
 #include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/concurrency/WorkerThread.hpp"
 #include "leanstore/utils/Log.hpp"
 #include "leanstore/utils/ToJson.hpp"
 
@@ -38,6 +40,7 @@ void Logging::ReserveContiguousBuffer(uint32_t bytesRequired) {
 
     if (flushed - mWalBuffered < bytesRequired) {
       // wait for group commit thread to commit the written wal entries
+      NotifyGroupCommitter();
       continue;
     }
     return;
@@ -99,6 +102,26 @@ void Logging::SubmitWALEntryComplex(uint64_t totalSize) {
           WorkerContext::My().mActiveTx.mStartTs, utils::ToJsonString(mActiveWALEntryComplex));
 }
 
+void Logging::NotifyGroupCommitter() {
+  if (mGroupCommitter != nullptr) {
+    mGroupCommitter->Notify();
+  }
+}
+
+void Logging::WaitToCommit(const TXID commitTs) {
+  COUNTER_INC(&tlsPerfCounters.mTxCommitWait);
+  auto isCommitted = [&]() { return commitTs <= mSignaledCommitTs.load(); };
+  if (isCommitted() || WorkerThread::Park(isCommitted)) {
+    return;
+  }
+
+  // not in a job slot, sleep until the group committer signals a new commit timestamp
+  for (auto signaled = mSignaledCommitTs.load(); commitTs > signaled;
+       signaled = mSignaledCommitTs.load()) {
+    mSignaledCommitTs.wait(signaled);
+  }
+}
+
 void Logging::publishWalBufferedOffset() {
   mWalFlushReq.UpdateAttribute(&WalFlushReq::mWalBuffered, mWalBuffered);
 }
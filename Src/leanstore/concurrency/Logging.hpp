@@ -17,6 +17,7 @@ namespace leanstore::cr {
 //! forward declarations
 class WalEntry;
 class WalEntryComplex;
+class GroupCommitter;
 
 //! Used to sync wal flush request between group committer and worker.
 struct WalFlushReq {
@@ -81,6 +82,10 @@ public:
 
   storage::OptimisticGuarded<WalFlushReq> mWalFlushReq;
 
+  //! The group committer which flushes the wal ring buffer, notified when the worker waits for it.
+  //! nullptr when WAL is disabled.
+  GroupCommitter* mGroupCommitter = nullptr;
+
   //! The ring buffer of the current worker thread. All the wal entries of the current worker are
   //! writtern to this ring buffer firstly, then flushed to disk by the group commit thread.
   alignas(512) uint8_t* mWalBuffer;
@@ -91,6 +96,9 @@ public:
   //! Used to track the write order of wal entries.
   LID mLsnClock = 0;
 
+  //! The max global sequence number assigned by the worker, see NextGsn().
+  uint64_t mGsnClock = 0;
+
   //! The maximum writtern system transaction ID in the worker.
   TXID mSysTxWrittern = 0;
 
@@ -107,13 +115,15 @@ public:
 public:
   void UpdateSignaledCommitTs(const LID signaledCommitTs) {
     mSignaledCommitTs.store(signaledCommitTs, std::memory_order_release);
+    mSignaledCommitTs.notify_all();
   }
 
-  void WaitToCommit(const TXID commitTs) {
-    COUNTER_INC(&tlsPerfCounters.mTxCommitWait);
-    while (!(commitTs <= mSignaledCommitTs.load())) {
-    }
-  }
+  //! Notifies the group committer that there are transactions to commit or wal buffer to reclaim.
+  void NotifyGroupCommitter();
+
+  //! Waits until the transaction is committed by the group committer. The job is parked if it runs
+  //! in a job slot, otherwise the worker thread sleeps on mSignaledCommitTs.
+  void WaitToCommit(const TXID commitTs);
 
   void ReserveContiguousBuffer(uint32_t requestedSize);
 
@@ -126,12 +136,21 @@ public:
 
   template <typename T, typename... Args>
   WalPayloadHandler<T> ReserveWALEntryComplex(uint64_t payloadSize, PID pageId, LID psn,
-                                              TREEID treeId, Args&&... args);
+                                              uint64_t gsn, uint64_t prevGsn, TREEID treeId,
+                                              Args&&... args);
 
   //! Submits wal record to group committer when it is ready to flush to disk.
   //! @param totalSize size of the wal record to be flush.
   void SubmitWALEntryComplex(uint64_t totalSize);
 
+  //! Assigns the global sequence number to a WalEntry of the page, larger than all the numbers
+  //! assigned to the page and by the worker before. WalEntries of a page are written to different
+  //! WAL files by different workers, recovery replays them in this order.
+  uint64_t NextGsn(uint64_t pageGsn) {
+    mGsnClock = std::max(mGsnClock, pageGsn) + 1;
+    return mGsnClock;
+  }
+
   void UpdateSysTxWrittern(TXID sysTxId) {
     mSysTxWrittern = std::max(mSysTxWrittern, sysTxId);
   }
@@ -9,7 +9,8 @@ namespace leanstore::cr {
 
 template <typename T, typename... Args>
 WalPayloadHandler<T> Logging::ReserveWALEntryComplex(uint64_t payloadSize, PID pageId, LID psn,
-                                                     TREEID treeId, Args&&... args) {
+                                                     uint64_t gsn, uint64_t prevGsn, TREEID treeId,
+                                                     Args&&... args) {
   // write transaction start on demand
   auto prevLsn = mPrevLSN;
   if (!ActiveTx().mHasWrote) {
@@ -26,9 +27,9 @@ WalPayloadHandler<T> Logging::ReserveWALEntryComplex(uint64_t payloadSize, PID p
   auto entrySize = sizeof(WalEntryComplex) + payloadSize;
   ReserveContiguousBuffer(entrySize);
 
-  mActiveWALEntryComplex =
-      new (entryPtr) WalEntryComplex(entryLSN, prevLsn, entrySize, WorkerContext::My().mWorkerId,
-                                     ActiveTx().mStartTs, psn, pageId, treeId);
+  mActiveWALEntryComplex = new (entryPtr)
+      WalEntryComplex(entryLSN, prevLsn, entrySize, WorkerContext::My().mWorkerId,
+                      ActiveTx().mStartTs, psn, gsn, prevGsn, pageId, treeId);
 
   auto* payloadPtr = mActiveWALEntryComplex->mPayload;
   auto walPayload = new (payloadPtr) T(std::forward<Args>(args)...);
@@ -9,10 +9,24 @@
 #include "leanstore/sync/HybridGuard.hpp"
 #include "leanstore/utils/Defer.hpp"
 #include "leanstore/utils/Log.hpp"
+#include "leanstore/utils/Parallelize.hpp"
+#include "leanstore/utils/UserThread.hpp"
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdint>
 #include <expected>
+#include <format>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <tuple>
 #include <utility>
+#include <vector>
+
+#include <lz4.h>
 
 namespace leanstore::cr {
 
@@ -20,10 +34,197 @@ using namespace leanstore::storage;
 using namespace leanstore::utils;
 using namespace leanstore::storage::btree;
 
+namespace {
+
+//! Number of WalEntries analyzed in a batch, their pages are read in parallel before the batch is
+//! analyzed.
+constexpr uint64_t kAnalysisBatchSize = 4096;
+
+//! Max bytes of WalEntries buffered in the redo threads before they are replayed.
+constexpr uint64_t kMaxPendingRedoBytes = 64 << 20;
+
+//! A pool of threads replaying WalEntryComplex. The entries of a page are always dispatched to
+//! the same thread, so they are replayed in the WAL order. Entries are copied and buffered until
+//! Flush(), which replays all of them and waits for the threads to finish. Flush() returns the
+//! first error of the round.
+class RedoThreads {
+public:
+  using RedoFunc = std::function<Result<void>(BufferFrame& bf, WalEntryComplex* complexEntry)>;
+
+private:
+  struct Queue {
+    //! Copied WalEntries.
+    std::vector<uint8_t> mBytes;
+
+    //! The buffer frame and the offset in mBytes of each WalEntry.
+    std::vector<std::pair<BufferFrame*, uint64_t>> mEntries;
+  };
+
+  LeanStore* mStore;
+
+  RedoFunc mRedoFunc;
+
+  std::vector<Queue> mQueues;
+
+  std::vector<std::thread> mThreads;
+
+  std::mutex mMutex;
+
+  std::condition_variable mCv;
+
+  //! Incremented by Flush() to start a new round of replaying.
+  uint64_t mRound = 0;
+
+  //! Number of threads still replaying the current round.
+  uint64_t mNumBusy = 0;
+
+  bool mStopped = false;
+
+  uint64_t mPendingBytes = 0;
+
+  //! The first error of the current round.
+  Result<void> mResult;
+
+public:
+  RedoThreads(LeanStore* store, uint64_t numThreads, RedoFunc redoFunc)
+      : mStore(store),
+        mRedoFunc(std::move(redoFunc)),
+        mQueues(numThreads) {
+    for (uint64_t i = 0; i < numThreads; i++) {
+      mThreads.emplace_back(&RedoThreads::run, this, i);
+    }
+  }
+
+  ~RedoThreads() {
+    {
+      std::unique_lock guard(mMutex);
+      mStopped = true;
+    }
+    mCv.notify_all();
+    for (auto& thread : mThreads) {
+      thread.join();
+    }
+  }
+
+  void Add(BufferFrame& bf, const WalEntryComplex* complexEntry) {
+    auto& queue = mQueues[complexEntry->mPageId % mQueues.size()];
+    auto pos = queue.mBytes.size();
+    auto* src = reinterpret_cast<const uint8_t*>(complexEntry);
+    queue.mBytes.insert(queue.mBytes.end(), src, src + complexEntry->mSize);
+    queue.mEntries.emplace_back(&bf, pos);
+    mPendingBytes += complexEntry->mSize;
+  }
+
+  uint64_t PendingBytes() const {
+    return mPendingBytes;
+  }
+
+  Result<void> Flush() {
+    if (mPendingBytes == 0) {
+      return {};
+    }
+    std::unique_lock guard(mMutex);
+    mNumBusy = mThreads.size();
+    mRound++;
+    mCv.notify_all();
+    mCv.wait(guard, [&]() { return mNumBusy == 0; });
+    mPendingBytes = 0;
+    return std::exchange(mResult, Result<void>{});
+  }
+
+private:
+  void run(uint64_t threadId) {
+    tlsStore = mStore;
+    uint64_t round = 0;
+    while (true) {
+      {
+        std::unique_lock guard(mMutex);
+        mCv.wait(guard, [&]() { return mStopped || mRound != round; });
+        if (mStopped) {
+          return;
+        }
+        round = mRound;
+      }
+
+      auto& queue = mQueues[threadId];
+      Result<void> result;
+      for (auto& [bf, pos] : queue.mEntries) {
+        result = mRedoFunc(*bf, reinterpret_cast<WalEntryComplex*>(&queue.mBytes[pos]));
+        if (!result) {
+          break;
+        }
+      }
+      queue.mEntries.clear();
+      queue.mBytes.clear();
+
+      std::unique_lock guard(mMutex);
+      if (!result && mResult) {
+        mResult = std::move(result);
+      }
+      if (--mNumBusy == 0) {
+        mCv.notify_all();
+      }
+    }
+  }
+};
+
+bool IsMultiPageEntry(const WalEntryComplex* complexEntry) {
+  auto type = reinterpret_cast<const WalPayload*>(complexEntry->mPayload)->mType;
+  return type == WalPayload::Type::kWalSplitRoot || type == WalPayload::Type::kWalSplitNonRoot;
+}
+
+//! Whether the WalEntry is completely written. The WAL files are written in aligned blocks, the
+//! bytes after the last WalEntry flushed before a crash are zeros or left over from a torn write.
+bool IsCompleteWalEntry(const WalEntry* walEntry) {
+  switch (walEntry->mType) {
+  case WalEntry::Type::kTxAbort: {
+    return reinterpret_cast<const WalTxAbort*>(walEntry)->mTxId != 0;
+  }
+  case WalEntry::Type::kTxFinish: {
+    return reinterpret_cast<const WalTxFinish*>(walEntry)->mTxId != 0;
+  }
+  case WalEntry::Type::kCarriageReturn: {
+    return reinterpret_cast<const WalCarriageReturn*>(walEntry)->mSize >=
+           sizeof(WalCarriageReturn);
+  }
+  case WalEntry::Type::kComplex: {
+    auto* complexEntry = reinterpret_cast<const WalEntryComplex*>(walEntry);
+    return complexEntry->mCrc32 == complexEntry->ComputeCRC32();
+  }
+  default: {
+    return false;
+  }
+  }
+}
+
+//! The pages other than the one a multi-page WalEntry is written to, their GSNs are synced to the
+//! GSN of the WalEntry.
+std::vector<PID> OtherPagesOf(const WalEntryComplex* complexEntry) {
+  auto* walPayload = reinterpret_cast<const WalPayload*>(complexEntry->mPayload);
+  switch (walPayload->mType) {
+  case WalPayload::Type::kWalSplitRoot: {
+    auto* wal = reinterpret_cast<const WalSplitRoot*>(walPayload);
+    return {wal->mNewLeft, wal->mNewRoot};
+  }
+  case WalPayload::Type::kWalSplitNonRoot: {
+    auto* wal = reinterpret_cast<const WalSplitNonRoot*>(walPayload);
+    return {wal->mParentPageId, wal->mNewLeft};
+  }
+  default: {
+    return {};
+  }
+  }
+}
+
+} // namespace
+
 bool Recovery::Run() {
   bool error(false);
 
-  analysis();
+  if (auto res = analysis(); !res) {
+    Log::Error("[Recovery] analysis failed, error={}", res.error().ToString());
+    return true;
+  }
   Log::Info("[Recovery] resolved page size: {}", mResolvedPages.size());
   for (auto it = mResolvedPages.begin(); it != mResolvedPages.end(); ++it) {
     if (it->second->IsFree()) {
@@ -43,10 +244,13 @@ bool Recovery::Run() {
   // print dirty page table
   Log::Info("[Recovery] dirty page table size: {}", mDirtyPageTable.size());
   for (auto it = mDirtyPageTable.begin(); it != mDirtyPageTable.end(); ++it) {
-    LS_DLOG("Dirty page table after analysis, pageId: {}, offset: {}", it->first, it->second);
+    LS_DLOG("Dirty page table after analysis, pageId: {}, gsn: {}", it->first, it->second);
   }
 
-  redo();
+  if (auto res = redo(); !res) {
+    Log::Error("[Recovery] redo failed, error={}", res.error().ToString());
+    return true;
+  }
 
   undo();
 
@@ -57,48 +261,135 @@ Result<void> Recovery::analysis() {
   Log::Info("[Recovery] analysis phase begins");
   SCOPED_DEFER(Log::Info("[Recovery] analysis phase ends"))
 
+  for (uint64_t walId = 0; walId < mWalSizes.size(); walId++) {
+    if (auto res = mWalReaders[walId]->Init(); !res) {
+      return res;
+    }
+    mWalSizes[walId] = mWalReaders[walId]->Size();
+    if (auto res = analyzeWalFile(walId); !res) {
+      return res;
+    }
+  }
+
+  // merge the WAL files, entries of a page are ordered by GSN
+  std::sort(mRedoPositions.begin(), mRedoPositions.end(), [](const auto& lhs, const auto& rhs) {
+    return std::tie(lhs.mGsn, lhs.mWalId, lhs.mOffset) <
+           std::tie(rhs.mGsn, rhs.mWalId, rhs.mOffset);
+  });
+  return {};
+}
+
+Result<void> Recovery::analyzeWalFile(uint64_t walId) {
+  //! The fields of a WalEntry needed by the analysis.
+  struct AnalysisEntry {
+    WalEntry::Type mType;
+    TXID mTxId;
+    PID mPageId;
+    uint64_t mPsn;
+    uint64_t mGsn;
+
+    //! Offset of the WalEntry.
+    uint64_t mStartOffset;
+
+    //! Offset right after the WalEntry.
+    uint64_t mOffset;
+  };
+
   // asume that each WalEntry is smaller than the page size
   utils::AlignedBuffer<512> alignedBuffer(mStore->mStoreOption->mPageSize);
   uint8_t* walEntryPtr = alignedBuffer.Get();
-  for (auto offset = mWalStartOffset; offset < mWalSize;) {
-    auto startOffset = offset;
-    if (auto res = readWalEntry(offset, walEntryPtr); !res) {
-      return std::unexpected(std::move(res.error()));
-    }
-    auto* walEntry = reinterpret_cast<WalEntry*>(walEntryPtr);
-    switch (walEntry->mType) {
-    case WalEntry::Type::kTxAbort: {
-      auto* wal = reinterpret_cast<WalTxAbort*>(walEntryPtr);
-      LS_DCHECK(mActiveTxTable.find(wal->mTxId) != mActiveTxTable.end());
-      mActiveTxTable[wal->mTxId] = offset;
-      continue;
-    }
-    case WalEntry::Type::kTxFinish: {
-      auto* wal = reinterpret_cast<WalTxFinish*>(walEntryPtr);
-      LS_DCHECK(mActiveTxTable.find(wal->mTxId) != mActiveTxTable.end());
-      mActiveTxTable.erase(wal->mTxId);
-      continue;
-    }
-    case WalEntry::Type::kCarriageReturn: {
-      // do nothing
-      continue;
-    }
-    case WalEntry::Type::kComplex: {
-      auto* wal = reinterpret_cast<WalEntryComplex*>(walEntryPtr);
-      mActiveTxTable[wal->mTxId] = offset;
-      auto& bf = resolvePage(wal->mPageId);
-      if (wal->mPsn >= bf.mPage.mPsn &&
-          mDirtyPageTable.find(wal->mPageId) == mDirtyPageTable.end()) {
-        // record the first WalEntry that makes the page dirty
-        auto pageId = wal->mPageId;
-        mDirtyPageTable.emplace(pageId, offset);
+  std::vector<AnalysisEntry> batch;
+  std::vector<PID> pageIds;
+  std::set<PID> pageIdSet;
+  batch.reserve(kAnalysisBatchSize);
+
+  const auto walStartOffset = mWalStartOffsets[walId];
+  auto walSize = mWalSizes[walId];
+  for (auto offset = walStartOffset; offset < walSize;) {
+    // collect a batch of WalEntries and the pages they touch
+    batch.clear();
+    pageIds.clear();
+    pageIdSet.clear();
+    while (offset < walSize && batch.size() < kAnalysisBatchSize) {
+      auto startOffset = offset;
+      auto res = readWalEntry(walId, offset, walEntryPtr);
+      if (!res || !IsCompleteWalEntry(reinterpret_cast<WalEntry*>(walEntryPtr))) {
+        // the WalEntries after the last flush before the crash are lost, the WAL file ends here
+        Log::Info("[Recovery] WAL file ends at an incomplete WalEntry, walId={}, offset={}, "
+                  "fileSize={}, error={}",
+                  walId, startOffset, walSize, res ? "none" : res.error().ToString());
+        walSize = startOffset;
+        mWalSizes[walId] = startOffset;
+        break;
+      }
+      auto* walEntry = reinterpret_cast<WalEntry*>(walEntryPtr);
+      switch (walEntry->mType) {
+      case WalEntry::Type::kTxAbort: {
+        auto* wal = reinterpret_cast<WalTxAbort*>(walEntryPtr);
+        batch.push_back({walEntry->mType, wal->mTxId, 0, 0, 0, startOffset, offset});
+        break;
+      }
+      case WalEntry::Type::kTxFinish: {
+        auto* wal = reinterpret_cast<WalTxFinish*>(walEntryPtr);
+        batch.push_back({walEntry->mType, wal->mTxId, 0, 0, 0, startOffset, offset});
+        break;
+      }
+      case WalEntry::Type::kCarriageReturn: {
+        // do nothing
+        break;
+      }
+      case WalEntry::Type::kComplex: {
+        auto* wal = reinterpret_cast<WalEntryComplex*>(walEntryPtr);
+        batch.push_back({walEntry->mType, wal->mTxId, wal->mPageId, wal->mPsn, wal->mGsn,
+                         startOffset, offset});
+        if (mResolvedPages.find(wal->mPageId) == mResolvedPages.end() &&
+            pageIdSet.insert(wal->mPageId).second) {
+          pageIds.push_back(wal->mPageId);
+        }
+        break;
+      }
+      default: {
+        break;
+      }
       }
-      continue;
-    }
-    default: {
-      Log::Fatal("Unrecognized WalEntry type: {}, offset={}, walFd={}",
-                 static_cast<uint8_t>(walEntry->mType), startOffset, mStore->mWalFd);
     }
+
+    // read the pages of the batch in parallel
+    resolvePages(pageIds);
+
+    for (const auto& entry : batch) {
+      switch (entry.mType) {
+      case WalEntry::Type::kTxAbort: {
+        // transactions may start before the checkpoint
+        LS_DCHECK(walStartOffset > 0 || mActiveTxTable.find(entry.mTxId) != mActiveTxTable.end());
+        mMaxTxId = std::max(mMaxTxId, entry.mTxId);
+        mActiveTxTable[entry.mTxId] = entry.mOffset;
+        break;
+      }
+      case WalEntry::Type::kTxFinish: {
+        LS_DCHECK(walStartOffset > 0 || mActiveTxTable.find(entry.mTxId) != mActiveTxTable.end());
+        mActiveTxTable.erase(entry.mTxId);
+        mMaxTxId = std::max(mMaxTxId, entry.mTxId);
+        break;
+      }
+      case WalEntry::Type::kComplex: {
+        mActiveTxTable[entry.mTxId] = entry.mOffset;
+        mMaxTxId = std::max(mMaxTxId, entry.mTxId);
+        mRedoPositions.push_back({entry.mGsn, entry.mPageId, walId, entry.mStartOffset});
+        auto& bf = resolvePage(entry.mPageId);
+        if (entry.mPsn >= bf.mPage.mPsn) {
+          // record the first WalEntry that makes the page dirty, WAL files are not in GSN order
+          auto [it, inserted] = mDirtyPageTable.emplace(entry.mPageId, entry.mGsn);
+          if (!inserted) {
+            it->second = std::min(it->second, entry.mGsn);
+          }
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+      }
     }
   }
   return {};
@@ -112,107 +403,141 @@ Result<void> Recovery::redo() {
   utils::AlignedBuffer<512> alignedBuffer(mStore->mStoreOption->mPageSize);
   auto* complexEntry = reinterpret_cast<WalEntryComplex*>(alignedBuffer.Get());
 
-  for (auto offset = mWalStartOffset; offset < mWalSize;) {
-    auto startOffset = offset;
-    auto res = nextWalComplexToRedo(offset, complexEntry);
-    if (!res) {
-      // met error
-      Log::Error("[Recovery] failed to get next WalComplex, offset={}, error={}", startOffset,
-                 res.error().ToString());
-      return std::unexpected(res.error());
-    }
+  {
+    RedoThreads redoThreads(mStore, mNumThreads, [this](BufferFrame& bf, WalEntryComplex* entry) {
+      return redoEntry(bf, entry);
+    });
+
+    // The GSN each page is replayed to. The WAL files are flushed independently, the tail of one
+    // of them may be lost in the crash while the later WalEntries of the same pages in the other
+    // files are durable. Those WalEntries belong to uncommitted transactions, a page is replayed
+    // up to its first missing WalEntry.
+    std::map<PID, uint64_t> replayedGsns;
+    std::set<PID> stoppedPages;
+    auto replayedGsnOf = [&](PID pageId) -> uint64_t& {
+      return replayedGsns.try_emplace(pageId, resolvePage(pageId).mPage.mGSN).first->second;
+    };
+
+    for (const auto& position : mRedoPositions) {
+      // skip if the page is not dirty
+      auto it = mDirtyPageTable.find(position.mPageId);
+      if (it == mDirtyPageTable.end() || position.mGsn < it->second) {
+        continue;
+      }
+      if (stoppedPages.contains(position.mPageId)) {
+        continue;
+      }
 
-    if (!res.value()) {
-      // no more complex entry to redo
-      break;
-    }
+      auto offset = position.mOffset;
+      if (auto res = readWalEntry(position.mWalId, offset, alignedBuffer.Get()); !res) {
+        Log::Error("[Recovery] failed to read WalComplex, walId={}, offset={}, error={}",
+                   position.mWalId, position.mOffset, res.error().ToString());
+        return std::unexpected(res.error());
+      }
 
-    // get a buffer frame for the corresponding dirty page
-    auto& bf = resolvePage(complexEntry->mPageId);
-    SCOPED_DEFER(bf.mHeader.mKeepInMemory = false);
+      // get a buffer frame for the corresponding dirty page
+      const PID pageId = complexEntry->mPageId;
+      const uint64_t gsn = complexEntry->mGsn;
+      const uint64_t prevGsn = complexEntry->mPrevGsn;
+      auto& bf = resolvePage(pageId);
+      auto& replayedGsn = replayedGsnOf(pageId);
+      if (prevGsn > replayedGsn) {
+        Log::Info("[Recovery] stop replaying page at a lost WalEntry, pageId={}, gsn={}, "
+                  "prevGsn={}",
+                  pageId, replayedGsn, prevGsn);
+        stoppedPages.insert(pageId);
+        continue;
+      }
 
-    auto* walPayload = reinterpret_cast<WalPayload*>(complexEntry->mPayload);
-    switch (walPayload->mType) {
-    case WalPayload::Type::kWalInsert: {
-      redoInsert(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalTxInsert: {
-      redoTxInsert(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalUpdate: {
-      redoUpdate(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalTxUpdate: {
-      redoTxUpdate(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalRemove: {
-      redoRemove(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalTxRemove: {
-      redoTxRemove(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalInitPage: {
-      redoInitPage(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalSplitRoot: {
-      redoSplitRoot(bf, complexEntry);
-      break;
-    }
-    case WalPayload::Type::kWalSplitNonRoot: {
-      redoSplitNonRoot(bf, complexEntry);
-      break;
-    }
-    default: {
-      LS_DCHECK(false, "Unhandled WalPayload::Type: {}",
-                std::to_string(static_cast<uint64_t>(walPayload->mType)));
-    }
-    }
-  }
+      // splits touch pages of other redo threads, replay them after all the entries before
+      if (IsMultiPageEntry(complexEntry)) {
+        auto otherPages = OtherPagesOf(complexEntry);
+        if (std::ranges::any_of(otherPages, [&](PID id) { return stoppedPages.contains(id); })) {
+          Log::Info("[Recovery] stop replaying page at a split of a stopped page, pageId={}, "
+                    "gsn={}",
+                    pageId, gsn);
+          stoppedPages.insert(pageId);
+          continue;
+        }
+        if (auto res = redoThreads.Flush(); !res) {
+          return res;
+        }
+        if (auto res = redoEntry(bf, complexEntry); !res) {
+          return res;
+        }
+        replayedGsn = std::max(replayedGsn, gsn);
+        for (auto otherPageId : otherPages) {
+          auto& otherGsn = replayedGsnOf(otherPageId);
+          otherGsn = std::max(otherGsn, gsn);
+        }
+        continue;
+      }
 
-  // Write all the resolved pages to disk
-  for (auto it = mResolvedPages.begin(); it != mResolvedPages.end(); it++) {
-    auto res = mStore->mBufferManager->WritePageSync(*it->second);
-    if (!res) {
+      redoThreads.Add(bf, complexEntry);
+      replayedGsn = std::max(replayedGsn, gsn);
+      if (redoThreads.PendingBytes() >= kMaxPendingRedoBytes) {
+        if (auto res = redoThreads.Flush(); !res) {
+          return res;
+        }
+      }
+    }
+    if (auto res = redoThreads.Flush(); !res) {
       return res;
     }
   }
 
-  return {};
+  // Write all the resolved pages to disk
+  return writeResolvedPages();
 }
 
-Result<bool> Recovery::nextWalComplexToRedo(uint64_t& offset, WalEntryComplex* complexEntry) {
-  auto* buff = reinterpret_cast<uint8_t*>(complexEntry);
-  while (offset < mWalSize) {
-    // read a WalEntry
-    if (auto res = readWalEntry(offset, buff); !res) {
-      return std::unexpected(res.error());
-    }
-
-    // skip if not a complex entry
-    auto* walEntry = reinterpret_cast<WalEntry*>(buff);
-    if (walEntry->mType != WalEntry::Type::kComplex) {
-      continue;
-    }
-
-    // skip if the page is not dirty
-    if (mDirtyPageTable.find(complexEntry->mPageId) == mDirtyPageTable.end() ||
-        offset < mDirtyPageTable[complexEntry->mPageId]) {
-      continue;
-    }
-
-    // found a complex entry to redo
-    return true;
+Result<void> Recovery::redoEntry(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
+  bf.mPage.mGSN = std::max<uint64_t>(bf.mPage.mGSN, complexEntry->mGsn);
+  auto* walPayload = reinterpret_cast<WalPayload*>(complexEntry->mPayload);
+  switch (walPayload->mType) {
+  case WalPayload::Type::kWalInsert: {
+    redoInsert(bf, complexEntry);
+    break;
   }
-
-  // no more complex entry to redo
-  return false;
+  case WalPayload::Type::kWalTxInsert: {
+    redoTxInsert(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalUpdate: {
+    redoUpdate(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalTxUpdate: {
+    return redoTxUpdate(bf, complexEntry);
+  }
+  case WalPayload::Type::kWalRemove: {
+    redoRemove(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalTxRemove: {
+    return redoTxRemove(bf, complexEntry);
+  }
+  case WalPayload::Type::kWalInitPage: {
+    redoInitPage(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalSplitRoot: {
+    redoSplitRoot(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalSplitNonRoot: {
+    redoSplitNonRoot(bf, complexEntry);
+    break;
+  }
+  case WalPayload::Type::kWalBulkLoad: {
+    redoBulkLoad(bf, complexEntry);
+    break;
+  }
+  default: {
+    LS_DCHECK(false, "Unhandled WalPayload::Type: {}",
+              std::to_string(static_cast<uint64_t>(walPayload->mType)));
+  }
+  }
+  return {};
 }
 
 void Recovery::redoInsert(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
@@ -240,14 +565,19 @@ void Recovery::redoUpdate(storage::BufferFrame& bf [[maybe_unused]],
   Log::Fatal("Unsupported");
 }
 
-void Recovery::redoTxUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
+Result<void> Recovery::redoTxUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
   auto* wal = reinterpret_cast<WalTxUpdate*>(complexEntry->mPayload);
   HybridGuard guard(&bf.mHeader.mLatch);
   GuardedBufferFrame<BTreeNode> guardedNode(mStore->mBufferManager.get(), std::move(guard), &bf);
   auto* updateDesc = wal->GetUpdateDesc();
   auto key = wal->GetKey();
   auto slotId = guardedNode->LowerBound<true>(key);
-  LS_DCHECK(slotId != -1, "Key not found in WalTxUpdate");
+  if (slotId == -1) {
+    return std::unexpected(utils::Error::General(
+        std::format("updated key not found in page, pageId={}, gsn={}, key={}",
+                    static_cast<PID>(complexEntry->mPageId),
+                    static_cast<uint64_t>(complexEntry->mGsn), key.ToString())));
+  }
 
   auto* mutRawVal = guardedNode->ValData(slotId);
   LS_DCHECK(Tuple::From(mutRawVal)->mFormat == TupleFormat::kChained,
@@ -269,6 +599,7 @@ void Recovery::redoTxUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEn
 
   // 3. replace with the new value
   BasicKV::CopyToValue(*updateDesc, buff, chainedTuple->mPayload);
+  return {};
 }
 
 void Recovery::redoRemove(storage::BufferFrame& bf [[maybe_unused]],
@@ -276,13 +607,18 @@ void Recovery::redoRemove(storage::BufferFrame& bf [[maybe_unused]],
   Log::Fatal("Unsupported");
 }
 
-void Recovery::redoTxRemove(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
+Result<void> Recovery::redoTxRemove(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
   auto* wal = reinterpret_cast<WalTxRemove*>(complexEntry->mPayload);
   HybridGuard guard(&bf.mHeader.mLatch);
   GuardedBufferFrame<BTreeNode> guardedNode(mStore->mBufferManager.get(), std::move(guard), &bf);
   auto key = wal->RemovedKey();
   auto slotId = guardedNode->LowerBound<true>(key);
-  LS_DCHECK(slotId != -1, "Key not found, key={}", key.ToString());
+  if (slotId == -1) {
+    return std::unexpected(utils::Error::General(
+        std::format("removed key not found in page, pageId={}, gsn={}, key={}",
+                    static_cast<PID>(complexEntry->mPageId),
+                    static_cast<uint64_t>(complexEntry->mGsn), key.ToString())));
+  }
 
   auto* mutRawVal = guardedNode->ValData(slotId);
   LS_DCHECK(Tuple::From(mutRawVal)->mFormat == TupleFormat::kChained,
@@ -297,6 +633,7 @@ void Recovery::redoTxRemove(storage::BufferFrame& bf, WalEntryComplex* complexEn
   chainedTuple->mTxId = complexEntry->mTxId;
   chainedTuple->mCommandId ^= wal->mPrevCommandId;
   chainedTuple->mIsTombstone = true;
+  return {};
 }
 
 void Recovery::redoInitPage(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
@@ -351,6 +688,10 @@ void Recovery::redoSplitRoot(storage::BufferFrame& bf, WalEntryComplex* complexE
   xGuardedNewRoot->mRightMostChildSwip = xGuardedOldRoot.bf();
   xGuardedOldRoot->Split(xGuardedNewRoot, xGuardedNewLeft, sepInfo);
   xGuardedMeta->mRightMostChildSwip = xGuardedNewRoot.bf();
+
+  // the new pages are synced to the GSN of the split
+  newLeftBf.mPage.mGSN = std::max<uint64_t>(newLeftBf.mPage.mGSN, complexEntry->mGsn);
+  newRootBf.mPage.mGSN = std::max<uint64_t>(newRootBf.mPage.mGSN, complexEntry->mGsn);
 }
 
 void Recovery::redoSplitNonRoot(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
@@ -385,20 +726,40 @@ void Recovery::redoSplitNonRoot(storage::BufferFrame& bf, WalEntryComplex* compl
   const uint16_t spaceNeededForSeparator = guardedParent->SpaceNeeded(sepInfo.mSize, sizeof(Swip));
   xGuardedParent->RequestSpaceFor(spaceNeededForSeparator);
   xGuardedChild->Split(xGuardedParent, xGuardedNewLeft, sepInfo);
+
+  // the parent and the new left are synced to the GSN of the split
+  parentBf.mPage.mGSN = std::max<uint64_t>(parentBf.mPage.mGSN, complexEntry->mGsn);
+  newLeftBf.mPage.mGSN = std::max<uint64_t>(newLeftBf.mPage.mGSN, complexEntry->mGsn);
+}
+
+void Recovery::redoBulkLoad(storage::BufferFrame& bf, WalEntryComplex* complexEntry) {
+  auto* wal = reinterpret_cast<WalBulkLoad*>(complexEntry->mPayload);
+
+  // the loaded pages are persisted before the wal is written, point the meta node to the root
+  auto metaGuard = HybridGuard(&bf.mHeader.mLatch);
+  auto guardedMeta =
+      GuardedBufferFrame<BTreeNode>(mStore->mBufferManager.get(), std::move(metaGuard), &bf);
+  auto xGuardedMeta = ExclusiveGuardedBufferFrame<BTreeNode>(std::move(guardedMeta));
+  xGuardedMeta->mRightMostChildSwip.Evict(wal->mRootPageId);
+
+  auto* btree = dynamic_cast<BTreeGeneric*>(mStore->mTreeRegistry->GetTree(complexEntry->mTreeId));
+  if (btree != nullptr) {
+    btree->mHeight = wal->mHeight;
+  }
 }
 
 //! Read a WalEntry from the WAL file
-Result<void> Recovery::readWalEntry(uint64_t& offset, uint8_t* dest) {
+Result<void> Recovery::readWalEntry(uint64_t walId, uint64_t& offset, uint8_t* dest) {
   // read the WalEntry
   auto walEntrySize = sizeof(WalEntry);
-  if (auto res = readFromWalFile(offset, walEntrySize, dest); !res) {
+  if (auto res = readFromWalFile(walId, offset, walEntrySize, dest); !res) {
     return std::unexpected(res.error());
   }
 
   switch (reinterpret_cast<WalEntry*>(dest)->mType) {
   case leanstore::cr::WalEntry::Type::kTxAbort: {
     auto left = sizeof(WalTxAbort) - walEntrySize;
-    auto res = readFromWalFile(offset + walEntrySize, left, dest + walEntrySize);
+    auto res = readFromWalFile(walId, offset + walEntrySize, left, dest + walEntrySize);
     if (!res) {
       return std::unexpected(res.error());
     }
@@ -407,7 +768,7 @@ Result<void> Recovery::readWalEntry(uint64_t& offset, uint8_t* dest) {
   }
   case leanstore::cr::WalEntry::Type::kTxFinish: {
     auto left = sizeof(WalTxFinish) - walEntrySize;
-    auto res = readFromWalFile(offset + walEntrySize, left, dest + walEntrySize);
+    auto res = readFromWalFile(walId, offset + walEntrySize, left, dest + walEntrySize);
     if (!res) {
       return std::unexpected(res.error());
     }
@@ -416,7 +777,7 @@ Result<void> Recovery::readWalEntry(uint64_t& offset, uint8_t* dest) {
   }
   case leanstore::cr::WalEntry::Type::kCarriageReturn: {
     auto left = sizeof(WalCarriageReturn) - walEntrySize;
-    auto res = readFromWalFile(offset + walEntrySize, left, dest + walEntrySize);
+    auto res = readFromWalFile(walId, offset + walEntrySize, left, dest + walEntrySize);
     if (!res) {
       return std::unexpected(res.error());
     }
@@ -426,14 +787,19 @@ Result<void> Recovery::readWalEntry(uint64_t& offset, uint8_t* dest) {
   case leanstore::cr::WalEntry::Type::kComplex: {
     // read the body of WalEntryComplex
     auto left = sizeof(WalEntryComplex) - walEntrySize;
-    auto res = readFromWalFile(offset + walEntrySize, left, dest + walEntrySize);
+    auto res = readFromWalFile(walId, offset + walEntrySize, left, dest + walEntrySize);
     if (!res) {
       return std::unexpected(res.error());
     }
 
-    // read the payload of WalEntryComplex
-    left = reinterpret_cast<WalEntryComplex*>(dest)->mSize - sizeof(WalEntryComplex);
-    res = readFromWalFile(offset + sizeof(WalEntryComplex), left, dest + sizeof(WalEntryComplex));
+    // read the payload of WalEntryComplex, all the WalEntries are smaller than the page size
+    auto entrySize = reinterpret_cast<WalEntryComplex*>(dest)->mSize;
+    if (entrySize < sizeof(WalEntryComplex) || entrySize > mStore->mStoreOption->mPageSize) {
+      return std::unexpected(utils::Error::FileRead("wal", EIO, "corrupted WalEntryComplex"));
+    }
+    left = entrySize - sizeof(WalEntryComplex);
+    res = readFromWalFile(walId, offset + sizeof(WalEntryComplex), left,
+                          dest + sizeof(WalEntryComplex));
     if (!res) {
       return std::unexpected(res.error());
     }
@@ -459,23 +825,225 @@ storage::BufferFrame& Recovery::resolvePage(PID pageId) {
   return bf;
 }
 
-// TODO(zz-jason): refactor with aio
-Result<void> Recovery::readFromWalFile(int64_t offset, size_t nbytes, void* destination) {
-  auto fileName = mStore->GetWalFilePath();
-  FILE* fp = fopen(fileName.c_str(), "rb");
-  if (fp == nullptr) {
-    return std::unexpected(utils::Error::FileOpen(fileName, errno, strerror(errno)));
+void Recovery::resolvePages(const std::vector<PID>& pageIds) {
+  auto numThreads = std::min<uint64_t>(mNumThreads, pageIds.size());
+  if (numThreads <= 1) {
+    for (auto pageId : pageIds) {
+      resolvePage(pageId);
+    }
+    return;
   }
-  SCOPED_DEFER(fclose(fp));
 
-  if (fseek(fp, offset, SEEK_SET) != 0) {
-    return std::unexpected(utils::Error::FileSeek(fileName, errno, strerror(errno)));
+  std::vector<BufferFrame*> bfs(pageIds.size(), nullptr);
+  Parallelize::Range(numThreads, pageIds.size(), [&](uint64_t, uint64_t begin, uint64_t end) {
+    for (auto i = begin; i < end; i++) {
+      bfs[i] = &mStore->mBufferManager->ReadPageSync(pageIds[i]);
+      // prevent the buffer frame from being evicted by buffer frame providers
+      bfs[i]->mHeader.mKeepInMemory = true;
+    }
+  });
+  for (uint64_t i = 0; i < pageIds.size(); i++) {
+    mResolvedPages.emplace(pageIds[i], bfs[i]);
   }
+}
 
-  if (fread(destination, 1, nbytes, fp) != nbytes) {
-    return std::unexpected(utils::Error::FileRead(fileName, errno, strerror(errno)));
+Result<void> Recovery::writeResolvedPages() {
+  std::vector<BufferFrame*> bfs;
+  bfs.reserve(mResolvedPages.size());
+  for (auto& [pageId, bf] : mResolvedPages) {
+    bfs.push_back(bf);
   }
 
+  auto numThreads = std::min<uint64_t>(mNumThreads, bfs.size());
+  if (numThreads == 0) {
+    return {};
+  }
+
+  std::mutex errorMutex;
+  Result<void> result{};
+  Parallelize::Range(numThreads, bfs.size(), [&](uint64_t, uint64_t begin, uint64_t end) {
+    for (auto i = begin; i < end; i++) {
+      auto res = mStore->mBufferManager->WritePageSync(*bfs[i]);
+      if (!res) {
+        std::unique_lock guard(errorMutex);
+        result = std::move(res);
+        return;
+      }
+    }
+  });
+  return result;
+}
+
+Result<void> WalReader::Init() {
+  if (!mCompressed) {
+    return {};
+  }
+
+  mFrames.clear();
+  auto offset = mStartOffset;
+  auto fileOffset = mStartOffset;
+  while (fileOffset < mWalSize) {
+    WalFrameHeader header;
+    if (fileOffset + sizeof(WalFrameHeader) > mWalSize) {
+      header.mMagic = 0;
+    } else if (auto res = readFile(fileOffset, sizeof(WalFrameHeader), &header); !res) {
+      return res;
+    }
+    if (header.mMagic != WalFrameHeader::kMagic ||
+        fileOffset + sizeof(WalFrameHeader) + header.mPayloadSize > mWalSize) {
+      // the frames after the last flush before the crash are lost, the WAL file ends here
+      Log::Info("[Recovery] WAL file ends at an incomplete frame, offset={}, fileSize={}",
+                fileOffset, mWalSize);
+      mWalSize = fileOffset;
+      break;
+    }
+    mFrames.push_back(
+        Frame{offset, fileOffset, header.mRawSize, header.mPayloadSize, header.mCrc32});
+    offset += header.mRawSize;
+    fileOffset += sizeof(WalFrameHeader) + header.mPayloadSize;
+  }
+  mCurrentFrame = mFrames.size();
+  mSize = offset;
+  return {};
+}
+
+Result<void> WalReader::Read(uint64_t offset, uint64_t size, void* destination) {
+  if (!mCompressed) {
+    return readFile(offset, size, destination);
+  }
+
+  auto* dest = reinterpret_cast<uint8_t*>(destination);
+  while (size > 0) {
+    if (auto res = loadFrame(offset); !res) {
+      return res;
+    }
+
+    const auto& frame = mFrames[mCurrentFrame];
+    auto offsetInFrame = offset - frame.mOffset;
+    auto nbytes = std::min<uint64_t>(size, frame.mRawSize - offsetInFrame);
+    std::memcpy(dest, mFrameBuffer.data() + offsetInFrame, nbytes);
+    dest += nbytes;
+    offset += nbytes;
+    size -= nbytes;
+  }
+  return {};
+}
+
+Result<void> WalReader::loadFrame(uint64_t offset) {
+  if (mCurrentFrame < mFrames.size() && mFrames[mCurrentFrame].mOffset <= offset &&
+      offset < mFrames[mCurrentFrame].mOffset + mFrames[mCurrentFrame].mRawSize) {
+    return {};
+  }
+  if (offset < mStartOffset || offset >= mSize) {
+    return std::unexpected(utils::Error::FileRead("wal", EIO, "read beyond the WAL file"));
+  }
+
+  // the last frame starting at or before the offset
+  auto it = std::upper_bound(mFrames.begin(), mFrames.end(), offset,
+                             [](uint64_t val, const Frame& frame) { return val < frame.mOffset; });
+  auto frameIdx = static_cast<uint64_t>(std::prev(it) - mFrames.begin());
+  const auto& frame = mFrames[frameIdx];
+
+  mCurrentFrame = mFrames.size();
+  mPayloadBuffer.resize(frame.mPayloadSize);
+  auto res = readFile(frame.mFileOffset + sizeof(WalFrameHeader), frame.mPayloadSize,
+                      mPayloadBuffer.data());
+  if (!res) {
+    return res;
+  }
+  if (utils::CRC(mPayloadBuffer.data(), frame.mPayloadSize) != frame.mCrc32) {
+    return std::unexpected(utils::Error::FileRead("wal", EIO, "WAL frame CRC32 mismatch"));
+  }
+
+  mFrameBuffer.resize(frame.mRawSize);
+  if (frame.mPayloadSize == frame.mRawSize) {
+    std::memcpy(mFrameBuffer.data(), mPayloadBuffer.data(), frame.mRawSize);
+  } else {
+    auto rawSize = LZ4_decompress_safe(reinterpret_cast<const char*>(mPayloadBuffer.data()),
+                                       reinterpret_cast<char*>(mFrameBuffer.data()),
+                                       frame.mPayloadSize, frame.mRawSize);
+    if (rawSize != static_cast<int>(frame.mRawSize)) {
+      return std::unexpected(utils::Error::FileRead("wal", EIO, "failed to decompress WAL frame"));
+    }
+  }
+  mCurrentFrame = frameIdx;
+  return {};
+}
+
+Result<void> WalReader::readFile(uint64_t offset, uint64_t size, void* destination) {
+  auto* dest = reinterpret_cast<uint8_t*>(destination);
+  while (size > 0) {
+    auto chunkId = offset / kChunkSize;
+    if (auto res = loadChunk(chunkId); !res) {
+      return std::unexpected(std::move(res.error()));
+    }
+
+    auto offsetInChunk = offset - chunkId * kChunkSize;
+    if (offsetInChunk >= mChunkBytes[mCurrent]) {
+      return std::unexpected(utils::Error::FileRead("wal", EIO, "read beyond the WAL file"));
+    }
+    auto nbytes = std::min(size, mChunkBytes[mCurrent] - offsetInChunk);
+    std::memcpy(dest, mBuffers[mCurrent].Get() + offsetInChunk, nbytes);
+    dest += nbytes;
+    offset += nbytes;
+    size -= nbytes;
+  }
+  return {};
+}
+
+Result<void> WalReader::loadChunk(uint64_t chunkId) {
+  if (mChunkIds[mCurrent] == chunkId) {
+    return {};
+  }
+
+  auto next = 1 - mCurrent;
+  if (mReadingAhead) {
+    if (auto res = waitReadAhead(); !res) {
+      return res;
+    }
+  }
+
+  if (mChunkIds[next] != chunkId) {
+    // not sequential, read the chunk synchronously
+    mAio.PrepareRead(mWalFd, mBuffers[next].Get(), kChunkSize, chunkId * kChunkSize);
+    mReadingAhead = true;
+    mChunkIds[next] = chunkId;
+    if (auto res = mAio.SubmitAll(); !res) {
+      return std::unexpected(std::move(res.error()));
+    }
+    if (auto res = waitReadAhead(); !res) {
+      return res;
+    }
+  }
+  mCurrent = next;
+
+  // read ahead the next chunk into the other buffer
+  auto nextChunkId = chunkId + 1;
+  if (nextChunkId * kChunkSize < mWalSize) {
+    mAio.PrepareRead(mWalFd, mBuffers[1 - mCurrent].Get(), kChunkSize, nextChunkId * kChunkSize);
+    mChunkIds[1 - mCurrent] = nextChunkId;
+    mReadingAhead = true;
+    if (auto res = mAio.SubmitAll(); !res) {
+      return std::unexpected(std::move(res.error()));
+    }
+  }
+  return {};
+}
+
+Result<void> WalReader::waitReadAhead() {
+  mReadingAhead = false;
+  auto next = 1 - mCurrent;
+  if (auto res = mAio.WaitAll(); !res) {
+    mChunkIds[next] = kInvalidChunk;
+    return std::unexpected(std::move(res.error()));
+  }
+
+  auto result = mAio.GetCompletedResult(0);
+  if (result < 0) {
+    mChunkIds[next] = kInvalidChunk;
+    return std::unexpected(utils::Error::FileRead("wal", -result, strerror(-result)));
+  }
+  mChunkBytes[next] = result;
   return {};
 }
 
@@ -4,11 +4,16 @@
 #include "leanstore/Units.hpp"
 #include "leanstore/buffer-manager/BufferFrame.hpp"
 #include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/utils/AsyncIo.hpp"
+#include "leanstore/utils/Misc.hpp"
 #include "leanstore/utils/Result.hpp"
 
+#include <algorithm>
 #include <cstring>
 #include <expected>
 #include <map>
+#include <memory>
+#include <vector>
 
 #include <unistd.h>
 
@@ -21,31 +26,179 @@ class WalEntryComplex;
 
 namespace leanstore::cr {
 
+//! Reads the WAL file sequentially in large chunks with async IO. While the current chunk is
+//! parsed, the next one is read ahead.
+//!
+//! A compressed WAL file is read as if the WalEntries are not compressed. Init() indexes the frames
+//! after the start offset, WalEntries are addressed by their offsets in the decompressed WAL, which
+//! starts from the start offset. Frames are decompressed on demand when they are read.
+class WalReader {
+public:
+  static constexpr uint64_t kChunkSize = 4 << 20;
+
+private:
+  //! A WAL frame after the start offset.
+  struct Frame {
+    //! Offset of the first WalEntry of the frame in the decompressed WAL.
+    uint64_t mOffset;
+
+    //! Offset of the frame in the WAL file.
+    uint64_t mFileOffset;
+
+    uint32_t mRawSize;
+
+    uint32_t mPayloadSize;
+
+    uint32_t mCrc32;
+  };
+
+  int32_t mWalFd;
+
+  uint64_t mStartOffset;
+
+  uint64_t mWalSize;
+
+  //! Whether the WAL file consists of compressed frames.
+  bool mCompressed;
+
+  //! Frames after the start offset, ordered by offset.
+  std::vector<Frame> mFrames;
+
+  //! Index of the frame decompressed in mFrameBuffer, mFrames.size() if there is none.
+  uint64_t mCurrentFrame;
+
+  //! The decompressed WalEntries of the current frame, and the payload it is decompressed from.
+  std::vector<uint8_t> mFrameBuffer;
+  std::vector<uint8_t> mPayloadBuffer;
+
+  //! End offset of the WalEntries, the decompressed size for a compressed WAL file.
+  uint64_t mSize;
+
+  utils::AsyncIo mAio;
+
+  //! Two chunk buffers, one holds the chunk being parsed, the other is filled by the read ahead.
+  utils::AlignedBuffer<512> mBuffers[2];
+
+  //! Id of the chunk in each buffer, kInvalidChunk if the buffer is empty.
+  uint64_t mChunkIds[2];
+
+  //! Number of valid bytes in each buffer.
+  uint64_t mChunkBytes[2];
+
+  //! Index of the buffer holding the current chunk.
+  uint64_t mCurrent;
+
+  //! Whether a read ahead of the next chunk is in flight.
+  bool mReadingAhead;
+
+  static constexpr uint64_t kInvalidChunk = ~0ull;
+
+public:
+  WalReader(int32_t walFd, uint64_t startOffset, uint64_t walSize, IoBackend backend,
+            bool compressed)
+      : mWalFd(walFd),
+        mStartOffset(startOffset),
+        mWalSize(walSize),
+        mCompressed(compressed),
+        mCurrentFrame(0),
+        mSize(walSize),
+        mAio(1, backend),
+        mBuffers{utils::AlignedBuffer<512>(kChunkSize), utils::AlignedBuffer<512>(kChunkSize)},
+        mChunkIds{kInvalidChunk, kInvalidChunk},
+        mChunkBytes{0, 0},
+        mCurrent(0),
+        mReadingAhead(false) {
+  }
+
+  // no copy and assign
+  WalReader& operator=(const WalReader&) = delete;
+  WalReader(const WalReader&) = delete;
+
+  //! Indexes the frames of a compressed WAL file, must be called before Read().
+  Result<void> Init();
+
+  //! End offset of the WalEntries.
+  uint64_t Size() const {
+    return mSize;
+  }
+
+  //! End offset of the WAL file content, the incomplete frames at the tail are excluded by Init().
+  uint64_t FileSize() const {
+    return mWalSize;
+  }
+
+  //! Copies the WalEntries in [offset, offset + size) to the destination.
+  Result<void> Read(uint64_t offset, uint64_t size, void* destination);
+
+private:
+  //! Copies the WAL file content in [offset, offset + size) to the destination.
+  Result<void> readFile(uint64_t offset, uint64_t size, void* destination);
+
+  //! Decompresses the frame containing the offset to mFrameBuffer.
+  Result<void> loadFrame(uint64_t offset);
+
+  //! Makes the current buffer hold the chunk, and starts reading ahead the next one.
+  Result<void> loadChunk(uint64_t chunkId);
+
+  //! Waits the in-flight read ahead, the result is written to the other buffer.
+  Result<void> waitReadAhead();
+};
+
 class Recovery {
 private:
+  //! Position of a WalEntryComplex in the WAL files.
+  struct WalPosition {
+    uint64_t mGsn;
+    PID mPageId;
+    uint64_t mWalId;
+    uint64_t mOffset;
+  };
+
   leanstore::LeanStore* mStore;
 
-  //! The offset of WAL in the underlying data file.
-  uint64_t mWalStartOffset;
+  //! The offset of WAL to start from in each WAL file.
+  std::vector<uint64_t> mWalStartOffsets;
 
-  //! Size of the written WAL file.
-  uint64_t mWalSize;
+  //! Size of each written WAL file, replaced by the decompressed size when the WAL files are
+  //! indexed if they are compressed.
+  std::vector<uint64_t> mWalSizes;
 
-  //! Stores the dirty page ID and the offset to the first WalEntry that caused that page to become
+  //! Stores the dirty page ID and the GSN of the first WalEntry that caused that page to become
   //! dirty.
   std::map<PID, uint64_t> mDirtyPageTable;
 
-  //! Stores the active transaction and the offset to the last created WalEntry.
+  //! Stores the active transaction and the offset to the last created WalEntry. All the WalEntries
+  //! of a transaction are in the WAL file of its worker.
   std::map<TXID, uint64_t> mActiveTxTable;
 
+  //! The largest transaction ID in the WAL files after the start offsets.
+  TXID mMaxTxId = 0;
+
+  //! Positions of all the WalEntryComplex after the start offsets, sorted by GSN after the
+  //! analysis phase. WalEntries of a page are replayed in this order no matter which WAL file they
+  //! are written to.
+  std::vector<WalPosition> mRedoPositions;
+
   //! Stores all the pages read from disk during the recovery process.
   std::map<PID, storage::BufferFrame*> mResolvedPages;
 
+  //! Number of threads to read pages and redo WAL entries, same as the worker threads.
+  uint64_t mNumThreads;
+
+  //! Reads each WAL file in large chunks.
+  std::vector<std::unique_ptr<WalReader>> mWalReaders;
+
 public:
-  Recovery(leanstore::LeanStore* store, uint64_t offset, uint64_t size)
+  Recovery(leanstore::LeanStore* store, std::vector<uint64_t> offsets, std::vector<uint64_t> sizes)
       : mStore(store),
-        mWalStartOffset(offset),
-        mWalSize(size) {
+        mWalStartOffsets(std::move(offsets)),
+        mWalSizes(std::move(sizes)),
+        mNumThreads(std::max<uint64_t>(store->mStoreOption->mWorkerThreads, 1)) {
+    for (uint64_t walId = 0; walId < mWalSizes.size(); walId++) {
+      mWalReaders.push_back(std::make_unique<WalReader>(
+          store->mWalFds[walId], mWalStartOffsets[walId], mWalSizes[walId],
+          store->mStoreOption->mIoBackend, store->mStoreOption->mEnableWalCompression));
+    }
   }
 
   ~Recovery() = default;
@@ -71,19 +224,48 @@ public:
   //! at crash time.
   bool Run();
 
+  //! The largest transaction ID replayed by Run().
+  TXID MaxTxId() const {
+    return mMaxTxId;
+  }
+
+  //! Sizes of the WAL files after Run(), the incomplete WalEntries at their tails are excluded.
+  //! New WalEntries are appended after them.
+  std::vector<uint64_t> WalFileSizes() const {
+    std::vector<uint64_t> walFileSizes(mWalSizes.size());
+    for (uint64_t walId = 0; walId < mWalSizes.size(); walId++) {
+      walFileSizes[walId] = mStore->mStoreOption->mEnableWalCompression
+                                ? mWalReaders[walId]->FileSize()
+                                : mWalSizes[walId];
+    }
+    return walFileSizes;
+  }
+
 private:
   //! During the analysis phase, the DPT and TT are restored to their state at the time of the
   //! crash. The logfile is scanned from the beginning or the last checkpoint, and all transactions
   //! for which we encounter begin transaction entries are added to the TT. Whenever an End Log
   //! entry is found, the corresponding transaction is removed.
+  ///
+  //! WAL files are scanned one after another, the WalEntryComplex positions of all of them are
+  //! merged by GSN for the redo phase.
   Result<void> analysis();
 
+  //! Analyzes a WAL file from its start offset.
+  Result<void> analyzeWalFile(uint64_t walId);
+
   //! During the redo phase, the DPT is used to find the set of pages in the buffer pool that were
   //! dirty at the time of the crash. All these pages are read from disk and redone from the first
   //! log record that makes them dirty.
+  ///
+  //! WalEntries are dispatched to the redo threads by page id, the entries of a page are replayed
+  //! by the same thread in the GSN order. Splits touch pages owned by other threads, they are
+  //! replayed alone after all the entries before them. A page is replayed until the previous GSN
+  //! of its next WalEntry is not replayed, i.e. the previous WalEntry is lost.
   Result<void> redo();
 
-  Result<bool> nextWalComplexToRedo(uint64_t& offset, WalEntryComplex* walEntryPtr);
+  //! Replays a WalEntryComplex on the page it belongs to.
+  Result<void> redoEntry(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
   void redoInsert(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
@@ -91,11 +273,13 @@ private:
 
   void redoUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
-  void redoTxUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
+  //! Fails if the updated key is not in the page.
+  Result<void> redoTxUpdate(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
   void redoRemove(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
-  void redoTxRemove(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
+  //! Fails if the removed key is not in the page.
+  Result<void> redoTxRemove(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
   void redoInitPage(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
@@ -103,6 +287,8 @@ private:
 
   void redoSplitNonRoot(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
 
+  void redoBulkLoad(storage::BufferFrame& bf, WalEntryComplex* complexEntry);
+
   //! During the undo phase, the TT is used to undo the transactions still active at crash time. In
   //! the case of an aborted transaction, it’s possible to traverse the log file in reverse order
   //! using the previous sequence numbers, undoing all actions taken within the specific
@@ -113,10 +299,20 @@ private:
   //! Return the buffer frame containing the required dirty page
   storage::BufferFrame& resolvePage(PID pageId);
 
+  //! Reads the pages not resolved yet in parallel, used to prefetch the pages of a batch of
+  //! WalEntries before they are analyzed.
+  void resolvePages(const std::vector<PID>& pageIds);
+
+  //! Writes all the resolved pages back to disk in parallel.
+  Result<void> writeResolvedPages();
+
   //! Read a WalEntry from the WAL file to the destination buffer.
-  Result<void> readWalEntry(uint64_t& offset, uint8_t* dest);
+  Result<void> readWalEntry(uint64_t walId, uint64_t& offset, uint8_t* dest);
 
-  Result<void> readFromWalFile(int64_t entryOffset, size_t entrySize, void* destination);
+  Result<void> readFromWalFile(uint64_t walId, int64_t entryOffset, size_t entrySize,
+                               void* destination) {
+    return mWalReaders[walId]->Read(entryOffset, entrySize, destination);
+  }
 };
 
 } // namespace leanstore::cr
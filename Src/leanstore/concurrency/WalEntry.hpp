@@ -101,6 +101,15 @@ public:
   //! Page sequence number of the WalEntry.
   uint64_t mPsn;
 
+  //! Global sequence number of the WalEntry. Increases with the WalEntries of the same page, and
+  //! with the WalEntries of the same worker. Used to merge the WAL files during recovery.
+  uint64_t mGsn;
+
+  //! GSN of the page before the WalEntry, i.e. the GSN of the previous WalEntry of the page.
+  //! Recovery stops replaying a page when it's larger than the GSN replayed so far, the previous
+  //! WalEntry was written to another WAL file and lost in the crash.
+  uint64_t mPrevGsn;
+
   //! The page ID of the WalEntry, used to identify the btree node together with
   //! btree ID
   PID mPageId;
@@ -116,7 +125,7 @@ public:
   WalEntryComplex() = default;
 
   WalEntryComplex(LID lsn, LID prevLsn, uint64_t size, WORKERID workerId, TXID txid, LID psn,
-                  PID pageId, TREEID treeId)
+                  uint64_t gsn, uint64_t prevGsn, PID pageId, TREEID treeId)
       : WalEntry(Type::kComplex),
         mCrc32(0),
         mLsn(lsn),
@@ -125,6 +134,8 @@ public:
         mWorkerId(workerId),
         mTxId(txid),
         mPsn(psn),
+        mGsn(gsn),
+        mPrevGsn(prevGsn),
         mPageId(pageId),
         mTreeId(treeId) {
   }
@@ -146,6 +157,42 @@ public:
   }
 };
 
+//! Header of a WAL frame. With StoreOption::mEnableWalCompression, the WalEntries collected by the
+//! group committer from a worker in a round are compressed with LZ4 and written to the WAL file as
+//! a frame, the header is followed by the compressed WalEntries.
+class __attribute__((packed)) WalFrameHeader {
+public:
+  static constexpr uint32_t kMagic = 0x464c4157; // "WALF"
+
+  uint32_t mMagic;
+
+  //! Crc of the frame payload.
+  uint32_t mCrc32;
+
+  //! Size of the WalEntries in the frame before compression.
+  uint32_t mRawSize;
+
+  //! Size of the frame payload. Equals to mRawSize if the WalEntries are not compressible, they are
+  //! stored as is.
+  uint32_t mPayloadSize;
+
+  //! The frame payload.
+  uint8_t mPayload[];
+
+  WalFrameHeader() = default;
+
+  WalFrameHeader(uint32_t rawSize, uint32_t payloadSize)
+      : mMagic(kMagic),
+        mCrc32(utils::CRC(mPayload, payloadSize)),
+        mRawSize(rawSize),
+        mPayloadSize(payloadSize) {
+  }
+
+  bool IsCompressed() const {
+    return mPayloadSize < mRawSize;
+  }
+};
+
 // -----------------------------------------------------------------------------
 // WalEntry
 // -----------------------------------------------------------------------------
@@ -185,6 +232,8 @@ const char kTxId[] = "mTxId";
 const char kWorkerId[] = "mWorkerId";
 const char kPrevLsn[] = "mPrevLsn";
 const char kPsn[] = "mPsn";
+const char kGsn[] = "mGsn";
+const char kPrevGsn[] = "mPrevGsn";
 const char kTreeId[] = "mTreeId";
 const char kPageId[] = "mPageId";
 
@@ -13,6 +13,7 @@
 #include "leanstore/utils/Log.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <mutex>
 
@@ -21,6 +22,7 @@ namespace leanstore::cr {
 thread_local std::unique_ptr<WorkerContext> WorkerContext::sTlsWorkerCtx = nullptr;
 thread_local WorkerContext* WorkerContext::sTlsWorkerCtxRaw = nullptr;
 thread_local PerfCounters tlsPerfCounters;
+thread_local PerfOpTraceRing tlsPerfOpTraces;
 
 WorkerContext::WorkerContext(uint64_t workerId, std::vector<WorkerContext*>& allWorkers,
                              leanstore::LeanStore* store)
@@ -51,7 +53,7 @@ void WorkerContext::StartTx(TxMode mode, IsolationLevel level, bool isReadOnly)
             prevTx.mStartTs, TxStatUtil::ToString(prevTx.mState));
   SCOPED_DEFER({
     LS_DLOG("Start transaction, workerId={}, startTs={}, globalMinFlushedSysTx={}", mWorkerId,
-            mActiveTx.mStartTs, mStore->mCRManager->mGroupCommitter->mGlobalMinFlushedSysTx.load());
+            mActiveTx.mStartTs, mLogging.mGroupCommitter->mGlobalMinFlushedSysTx.load());
   });
 
   mActiveTx.Start(mode, level);
@@ -61,7 +63,7 @@ void WorkerContext::StartTx(TxMode mode, IsolationLevel level, bool isReadOnly)
   }
 
   //! Reset the max observed system transaction id
-  mActiveTx.mMaxObservedSysTxId = mStore->mCRManager->mGroupCommitter->mGlobalMinFlushedSysTx;
+  mActiveTx.mMaxObservedSysTxId = mLogging.mGroupCommitter->mGlobalMinFlushedSysTx;
 
   // Init wal and group commit related transaction information
   mLogging.mTxWalBegin = mLogging.mWalBuffered;
@@ -140,6 +142,7 @@ void WorkerContext::CommitTx() {
     std::unique_lock<std::mutex> g(mLogging.mRfaTxToCommitMutex);
     mLogging.mRfaTxToCommit.push_back(mActiveTx);
   }
+  mLogging.NotifyGroupCommitter();
 
   // Cleanup versions in history tree
   mCc.GarbageCollection();
@@ -150,7 +153,17 @@ void WorkerContext::CommitTx() {
           mWorkerId, mActiveTx.mStartTs, mActiveTx.mCommitTs, mActiveTx.mMaxObservedSysTxId,
           mActiveTx.mHasRemoteDependency);
 
+  [[maybe_unused]] std::chrono::steady_clock::time_point startAt;
+  COUNTERS_BLOCK() {
+    startAt = std::chrono::steady_clock::now();
+  }
   mLogging.WaitToCommit(mActiveTx.mCommitTs);
+  COUNTERS_BLOCK() {
+    auto latNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     std::chrono::steady_clock::now() - startAt)
+                     .count();
+    COUNTER_HIST_RECORD(&tlsPerfCounters.mTxCommitLatNs, latNs);
+  }
 }
 
 //! TODO(jian.z): revert changes made in-place on the btree process of a transaction abort:
@@ -2,12 +2,23 @@
 
 #include "leanstore/LeanStore.hpp"
 #include "leanstore/Units.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/sync/HybridLatch.hpp"
+#include "leanstore/utils/JumpMU.hpp"
 #include "leanstore/utils/UserThread.hpp"
 
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <ucontext.h>
+#include <unistd.h>
 
 namespace leanstore::cr {
 
@@ -20,6 +31,12 @@ namespace leanstore::cr {
 //!                         original job sender
 //! -> ( jobSet,  jobDone): the original job sender is wake up, clear the job, notify other
 //!                         job senders.
+//!
+//! Jobs can also be queued with AddJob() without waiting for the previous ones. When the worker
+//! thread has more than one job slot (StoreOption::mJobsPerWorker), each queued job runs on its own
+//! stack and worker context, a job waiting for a page read is parked with Park() and the worker
+//! thread runs the jobs in the other slots meanwhile. When all the running jobs are parked, the
+//! worker thread sleeps until a page read of a job completes or a new job is added.
 class WorkerThread : public utils::UserThread {
 public:
   enum JobStatus : uint8_t {
@@ -43,18 +60,72 @@ public:
   //! Whether the current job is done.
   JobStatus mJobStatus;
 
+  //! The jobs added by AddJob() and not started yet, guarded by mMutex.
+  std::deque<std::function<void()>> mJobQueue;
+
+  //! The number of jobs added by AddJob() and not finished yet, guarded by mMutex.
+  uint64_t mNumQueuedJobs;
+
+private:
+  //! A queued job running on its own stack, so that it can be parked in the middle.
+  struct JobSlot {
+    //! The worker context of the jobs running in the slot.
+    WorkerContext* mWorkerCtx = nullptr;
+
+    //! The running job, nullptr if the slot is free.
+    std::function<void()> mJob = nullptr;
+
+    //! Whether the parked job can be resumed, nullptr if the job is not parked.
+    std::function<bool()> mIsReady = nullptr;
+
+    bool mIsFinished = false;
+
+    ucontext_t mContext;
+
+    std::unique_ptr<uint8_t[]> mStack;
+
+    //! The jump points and stack objects of the parked job.
+    jumpmu::JumpContext mJumpContext;
+  };
+
+  static constexpr uint64_t kJobStackSize = 1 << 20;
+
+  //! The longest sleep when all the running jobs are parked. Parked jobs may wait for others than
+  //! their own page reads, e.g. the group committer, which don't wake up the worker thread.
+  static constexpr int64_t kIdleWaitNs = 100 * 1000;
+
+  //! The worker thread running on the current thread.
+  inline static thread_local WorkerThread* sTlsWorkerThread = nullptr;
+
+  //! Empty if queued jobs are not interleaved.
+  std::vector<std::unique_ptr<JobSlot>> mJobSlots;
+
+  //! The slot of the running job, nullptr when the scheduler is running.
+  JobSlot* mCurrentSlot = nullptr;
+
+  //! The context of the scheduler to switch back to when the running job is parked or finished.
+  ucontext_t mSchedulerContext;
+
+  //! Signaled by the completed page reads of the jobs and by AddJob(), the worker thread sleeps on
+  //! it when all the running jobs are parked. -1 if there is no job slot.
+  int mIoEventFd = -1;
+
 public:
   //! Constructor.
   WorkerThread(LeanStore* store, WORKERID workerId, int cpu)
       : utils::UserThread(store, "Worker" + std::to_string(workerId), cpu),
         mWorkerId(workerId),
         mJob(nullptr),
-        mJobStatus(kJobIsEmpty) {
+        mJobStatus(kJobIsEmpty),
+        mNumQueuedJobs(0) {
   }
 
   //! Destructor.
   ~WorkerThread() override {
     Stop();
+    if (mIoEventFd >= 0) {
+      close(mIoEventFd);
+    }
   }
 
   //! Stop the worker thread.
@@ -69,22 +140,95 @@ public:
   //! API for the job sender.
   void Wait();
 
+  //! Queue a job to the worker thread without waiting for the previous jobs.
+  //! API for the job sender.
+  void AddJob(std::function<void()> job);
+
+  //! Wait until all the jobs added by AddJob() are done.
+  //! API for the job sender.
+  void WaitJobs();
+
+  //! Add a slot to interleave queued jobs, the jobs in the slot run in workerCtx.
+  //! REQUIRES: called on the worker thread before any job is added by AddJob().
+  void AddJobSlot(WorkerContext* workerCtx);
+
+  //! Park the current job until isReady() returns true, the worker thread runs the jobs in the
+  //! other slots meanwhile. isReady() is polled by the worker thread, or by a job in WaitParked().
+  //! Returns false without parking if CanPark() is false.
+  static bool Park(std::function<bool()> isReady);
+
+  //! Whether the caller is a queued job in a job slot and holds no pessimistic latch, i.e. Park()
+  //! is allowed. A parked job holding a latch would block the jobs in the other slots waiting for
+  //! it, and with them the worker thread.
+  static bool CanPark() {
+    return inJobSlot() && storage::HybridLatch::NumLockedByThisThread() == 0;
+  }
+
+  //! Wait until isDone() returns true without parking, for a queued job which can't be parked. The
+  //! parked jobs in the other slots are polled meanwhile, which is how the page reads they wait for
+  //! are finished, see BufferManager::ResolveSwipMayJump(). Returns false without waiting if the
+  //! caller is not a queued job in a job slot.
+  static bool WaitParked(const std::function<bool()>& isDone);
+
+  //! The eventfd to signal when a page read of the current job completes, -1 if the caller is not a
+  //! queued job in a job slot.
+  static int IoEventFd() {
+    return inJobSlot() ? sTlsWorkerThread->mIoEventFd : -1;
+  }
+
 protected:
   //! The main loop of the worker thread.
   void runImpl() override;
+
+private:
+  static bool inJobSlot() {
+    return sTlsWorkerThread != nullptr && sTlsWorkerThread->mCurrentSlot != nullptr;
+  }
+
+  //! Run the queued jobs until the queue is empty and all the job slots are free.
+  void runQueuedJobs();
+
+  //! Poll the parked jobs except the running one, returns whether any of them is ready.
+  bool pollParkedJobs();
+
+  //! Sleep until mIoEventFd is signaled, at most kIdleWaitNs.
+  void waitIoEvent();
+
+  //! Pop the next queued job, nullptr if there is none.
+  std::function<void()> popJob();
+
+  //! Mark a queued job done, notify the job senders waiting in WaitJobs().
+  void finishJob();
+
+  //! Switch to the job in the slot until it is parked or finished.
+  void resume(JobSlot& slot);
+
+  //! The entry point of the job stacks.
+  static void runSlotJob();
 };
 
 inline void WorkerThread::runImpl() {
+  sTlsWorkerThread = this;
   while (mKeepRunning) {
     // wait until there is a job
     std::unique_lock guard(mMutex);
-    mCv.wait(guard, [&]() { return !mKeepRunning || (mJobStatus == kJobIsSet); });
+    mCv.wait(guard, [&]() {
+      return !mKeepRunning || (mJobStatus == kJobIsSet) || !mJobQueue.empty();
+    });
 
     // check thread status
     if (!mKeepRunning) {
       break;
     }
 
+    // run the queued jobs if there is no job set by SetJob(), all the job slots are free again
+    // when it returns
+    if (mJobStatus != kJobIsSet) {
+      guard.unlock();
+      runQueuedJobs();
+      continue;
+    }
+
     // execute the job
     mJob();
 
@@ -134,4 +278,178 @@ inline void WorkerThread::Wait() {
   mCv.notify_all();
 }
 
+inline void WorkerThread::AddJob(std::function<void()> job) {
+  std::unique_lock guard(mMutex);
+  mJobQueue.emplace_back(std::move(job));
+  mNumQueuedJobs++;
+
+  guard.unlock();
+  mCv.notify_all();
+
+  // wake up the worker thread if it's waiting for the parked jobs
+  if (mIoEventFd >= 0) {
+    uint64_t one = 1;
+    [[maybe_unused]] auto ret = write(mIoEventFd, &one, sizeof(one));
+  }
+}
+
+inline void WorkerThread::WaitJobs() {
+  std::unique_lock guard(mMutex);
+  mCv.wait(guard, [&]() { return mNumQueuedJobs == 0; });
+}
+
+inline void WorkerThread::AddJobSlot(WorkerContext* workerCtx) {
+  auto slot = std::make_unique<JobSlot>();
+  slot->mWorkerCtx = workerCtx;
+  slot->mStack = std::make_unique_for_overwrite<uint8_t[]>(kJobStackSize);
+  mJobSlots.emplace_back(std::move(slot));
+  if (mIoEventFd < 0) {
+    mIoEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  }
+}
+
+inline std::function<void()> WorkerThread::popJob() {
+  std::unique_lock guard(mMutex);
+  if (mJobQueue.empty()) {
+    return nullptr;
+  }
+  auto job = std::move(mJobQueue.front());
+  mJobQueue.pop_front();
+  return job;
+}
+
+inline void WorkerThread::finishJob() {
+  std::unique_lock guard(mMutex);
+  mNumQueuedJobs--;
+
+  guard.unlock();
+  mCv.notify_all();
+}
+
+inline void WorkerThread::runQueuedJobs() {
+  // queued jobs are not interleaved, run them one after another on the thread stack
+  if (mJobSlots.empty()) {
+    for (auto job = popJob(); job != nullptr; job = popJob()) {
+      job();
+      finishJob();
+    }
+    return;
+  }
+
+  // round robin over the job slots, a parked job is resumed once it is ready, a free slot takes
+  // the next queued job
+  while (true) {
+    bool hasRunningJobs = false;
+    bool hasResumedJobs = false;
+    for (auto& slot : mJobSlots) {
+      if (slot->mJob == nullptr) {
+        slot->mJob = popJob();
+        if (slot->mJob == nullptr) {
+          continue;
+        }
+        slot->mIsFinished = false;
+        getcontext(&slot->mContext);
+        slot->mContext.uc_stack.ss_sp = slot->mStack.get();
+        slot->mContext.uc_stack.ss_size = kJobStackSize;
+        slot->mContext.uc_link = &mSchedulerContext;
+        makecontext(&slot->mContext, &WorkerThread::runSlotJob, 0);
+      } else if (!slot->mIsReady()) {
+        hasRunningJobs = true;
+        continue;
+      }
+
+      resume(*slot);
+      hasResumedJobs = true;
+      if (!slot->mIsFinished) {
+        hasRunningJobs = true;
+        continue;
+      }
+      slot->mJob = nullptr;
+      finishJob();
+    }
+
+    if (hasResumedJobs) {
+      continue;
+    }
+    std::unique_lock guard(mMutex);
+    if (!mJobQueue.empty()) {
+      continue;
+    }
+    if (!hasRunningJobs) {
+      return;
+    }
+
+    // all the running jobs are parked and none of them is ready
+    guard.unlock();
+    waitIoEvent();
+  }
+}
+
+inline bool WorkerThread::pollParkedJobs() {
+  bool hasReadyJobs = false;
+  for (auto& slot : mJobSlots) {
+    if (slot.get() != mCurrentSlot && slot->mIsReady != nullptr && slot->mIsReady()) {
+      hasReadyJobs = true;
+    }
+  }
+  return hasReadyJobs;
+}
+
+inline void WorkerThread::waitIoEvent() {
+  pollfd pfd{mIoEventFd, POLLIN, 0};
+  timespec timeout{0, kIdleWaitNs};
+  if (ppoll(&pfd, 1, &timeout, nullptr) > 0) {
+    uint64_t numEvents;
+    [[maybe_unused]] auto ret = read(mIoEventFd, &numEvents, sizeof(numEvents));
+  }
+}
+
+inline void WorkerThread::resume(JobSlot& slot) {
+  mCurrentSlot = &slot;
+  WorkerContext::sTlsWorkerCtxRaw = slot.mWorkerCtx;
+  jumpmu::RestoreContext(slot.mJumpContext);
+  swapcontext(&mSchedulerContext, &slot.mContext);
+
+  // the job is parked or finished, its jump points have been saved by Park()
+  mCurrentSlot = nullptr;
+  WorkerContext::sTlsWorkerCtxRaw = WorkerContext::sTlsWorkerCtx.get();
+}
+
+inline void WorkerThread::runSlotJob() {
+  auto* slot = sTlsWorkerThread->mCurrentSlot;
+  slot->mJob();
+  slot->mIsFinished = true;
+  // returns to mSchedulerContext via uc_link
+}
+
+inline bool WorkerThread::Park(std::function<bool()> isReady) {
+  if (!CanPark()) {
+    return false;
+  }
+
+  auto* self = sTlsWorkerThread;
+  auto* slot = self->mCurrentSlot;
+  slot->mIsReady = std::move(isReady);
+  jumpmu::SaveContext(slot->mJumpContext);
+  swapcontext(&slot->mContext, &self->mSchedulerContext);
+
+  // resumed by the worker thread once isReady() returned true
+  slot->mIsReady = nullptr;
+  return true;
+}
+
+inline bool WorkerThread::WaitParked(const std::function<bool()>& isDone) {
+  if (!inJobSlot()) {
+    return false;
+  }
+
+  auto* self = sTlsWorkerThread;
+  while (!isDone()) {
+    if (!self->pollParkedJobs()) {
+      self->waitIoEvent();
+    }
+  }
+  return true;
+}
+
 } // namespace leanstore::cr
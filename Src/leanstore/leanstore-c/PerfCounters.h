@@ -2,6 +2,7 @@
 #define LEANSTORE_PERF_COUNTERS_H
 
 #include <stdatomic.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -10,6 +11,107 @@ extern "C" {
 //! The counter type.
 typedef atomic_ullong CounterType;
 
+//! Number of buckets of a PerfHistogram, enough for all the uint64_t values.
+#define LEANSTORE_PERF_HIST_BUCKETS 256
+
+//! The max number of NUMA nodes the per-node counters are recorded for.
+#define LEANSTORE_PERF_MAX_NUMA_NODES 8
+
+//! Histogram of latencies or sizes. Values below 4 have their own buckets, each power of two above
+//! is split into 4 buckets, so the relative error of a percentile is below 25%.
+typedef struct PerfHistogram {
+  CounterType mBuckets[LEANSTORE_PERF_HIST_BUCKETS];
+} PerfHistogram;
+
+//! The bucket of a value in PerfHistogram.
+static inline uint64_t PerfHistBucket(uint64_t value) {
+  if (value < 4) {
+    return value;
+  }
+  uint64_t msb = 63 - __builtin_clzll(value);
+  return (msb - 1) * 4 + ((value >> (msb - 2)) & 3);
+}
+
+//! The largest value of a bucket in PerfHistogram.
+static inline uint64_t PerfHistBucketUpperBound(uint64_t bucket) {
+  if (bucket < 4) {
+    return bucket;
+  }
+  uint64_t msb = bucket / 4 + 1;
+  uint64_t upper = (4 + bucket % 4 + 1) << (msb - 2);
+  return upper == 0 ? UINT64_MAX : upper - 1;
+}
+
+//! Adds to a counter only updated by the thread owning it, cheaper than an atomic add. Readers on
+//! other threads still see the counter atomically.
+static inline void PerfCounterAddLocal(CounterType* counter, uint64_t value) {
+  atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + value,
+                        memory_order_relaxed);
+}
+
+//! Records a value to the histogram.
+static inline void PerfHistRecord(PerfHistogram* hist, uint64_t value) {
+  atomic_fetch_add_explicit(&hist->mBuckets[PerfHistBucket(value)], 1, memory_order_relaxed);
+}
+
+//! The value at the percentile in [0, 100] of the histogram, i.e. the upper bound of the bucket
+//! the percentile falls in. 0 if the histogram is empty.
+static inline uint64_t PerfHistPercentile(const PerfHistogram* hist, double percentile) {
+  uint64_t total = 0;
+  for (int i = 0; i < LEANSTORE_PERF_HIST_BUCKETS; i++) {
+    total += atomic_load_explicit(&hist->mBuckets[i], memory_order_relaxed);
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t rank = (uint64_t)(total * percentile / 100.0);
+  rank = rank == 0 ? 1 : (rank > total ? total : rank);
+  uint64_t cumulated = 0;
+  for (int i = 0; i < LEANSTORE_PERF_HIST_BUCKETS; i++) {
+    cumulated += atomic_load_explicit(&hist->mBuckets[i], memory_order_relaxed);
+    if (cumulated >= rank) {
+      return PerfHistBucketUpperBound(i);
+    }
+  }
+  return PerfHistBucketUpperBound(LEANSTORE_PERF_HIST_BUCKETS - 1);
+}
+
+//! The leanstore-c API calls traced with StoreOption::mEnableTimeMeasure.
+typedef enum PerfOpType {
+  kPerfOpBasicKvInsert = 0,
+  kPerfOpBasicKvLookup,
+  kPerfOpBasicKvRemove,
+  kPerfOpBasicKvIterSeekToFirst,
+  kPerfOpBasicKvIterSeekToFirstGreaterEqual,
+  kPerfOpBasicKvIterSeekToLast,
+  kPerfOpBasicKvIterSeekToLastLessEqual,
+  kPerfOpBasicKvIterNext,
+  kPerfOpBasicKvIterPrev,
+  kPerfOpTypes,
+} PerfOpType;
+
+//! A sampled leanstore-c API call.
+typedef struct PerfOpTrace {
+  //! The PerfOpType of the call.
+  uint64_t mOpType;
+
+  //! The worker thread executed the call.
+  uint64_t mWorkerId;
+
+  //! Latency of the call in the worker thread, in nanoseconds.
+  uint64_t mLatNs;
+
+  //! Number of btree nodes traversed, i.e. swips resolved, including the restarted traversals.
+  uint64_t mNodesTraversed;
+
+  //! Number of pages read from disk.
+  uint64_t mPageMisses;
+
+  //! Number of JumpMU jumps, i.e. restarts after optimistic latch validation failures.
+  uint64_t mJumps;
+} PerfOpTrace;
+
 //! The performance counters for each worker.
 typedef struct PerfCounters {
 
@@ -38,6 +140,48 @@ typedef struct PerfCounters {
   //! The number of long running transactions.
   CounterType mTxLongRunning;
 
+  //! Latency of waiting for the group committer to commit a transaction, in nanoseconds.
+  PerfHistogram mTxCommitLatNs;
+
+  // ---------------------------------------------------------------------------
+  // Group commit related counters, only recorded by the group committer
+  // ---------------------------------------------------------------------------
+
+  //! Number of transactions committed by a group commit round.
+  PerfHistogram mGroupCommitBatchTxs;
+
+  //! Number of WAL bytes written by a group commit round.
+  PerfHistogram mGroupCommitBatchBytes;
+
+  //! Latency of writing (and syncing) the WAL of a group commit round, in nanoseconds.
+  PerfHistogram mGroupCommitFlushLatNs;
+
+  // ---------------------------------------------------------------------------
+  // Buffer manager related counters
+  // ---------------------------------------------------------------------------
+
+  //! The number of swips resolved to hot buffer frames.
+  CounterType mBufferHotHits;
+
+  //! The number of swips resolved to cool buffer frames, which are made hot again.
+  CounterType mBufferCoolHits;
+
+  //! The number of swips resolved by reading the page from disk.
+  CounterType mBufferMisses;
+
+  //! The number of swips resolved to hot or cool buffer frames on each NUMA node, only recorded
+  //! with StoreOption::mEnableNuma.
+  CounterType mBufferNumaHits[LEANSTORE_PERF_MAX_NUMA_NODES];
+
+  //! The part of mBufferNumaHits resolved by workers on other NUMA nodes.
+  CounterType mBufferNumaRemoteHits[LEANSTORE_PERF_MAX_NUMA_NODES];
+
+  //! The number of pages evicted from the buffer pool, only recorded by page evictors.
+  CounterType mBufferEvicted;
+
+  //! The number of dirty pages written back before eviction, only recorded by page evictors.
+  CounterType mBufferWrittenBack;
+
   // ---------------------------------------------------------------------------
   // MVCC concurrency control related counters
   // ---------------------------------------------------------------------------
@@ -58,6 +202,9 @@ typedef struct PerfCounters {
   //! The total latency of MVCC garbage collection in nanoseconds.
   CounterType mGcTotalLatNs;
 
+  //! The number of remove and update versions purged by MVCC garbage collection.
+  CounterType mGcVersionsPurged;
+
   // ---------------------------------------------------------------------------
   // Contention split related counters
   // ---------------------------------------------------------------------------
@@ -74,6 +221,17 @@ typedef struct PerfCounters {
   //! The number of normal split failed.
   CounterType mSplitFailed;
 
+  // ---------------------------------------------------------------------------
+  // leanstore-c API related counters
+  // ---------------------------------------------------------------------------
+
+  //! The number of JumpMU jumps.
+  CounterType mJumps;
+
+  //! Latency of each PerfOpType in the worker thread, in nanoseconds. Only recorded with
+  //! StoreOption::mEnableTimeMeasure.
+  PerfHistogram mOpLatNs[kPerfOpTypes];
+
 } PerfCounters;
 
 #ifdef __cplusplus
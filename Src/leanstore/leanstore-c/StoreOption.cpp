@@ -14,6 +14,7 @@ static const StoreOption kDefaultStoreOption = {
     // Worker thread related options
     .mWorkerThreads = 4,
     .mWalBufferSize = 10 * 1024 * 1024,
+    .mJobsPerWorker = 1,
 
     // Buffer pool related options
     .mPageSize = 4 * 1024,
@@ -25,11 +26,23 @@ static const StoreOption kDefaultStoreOption = {
     .mBufferWriteBatchSize = 1024,
     .mEnableBufferCrcCheck = false,
     .mBufferFrameRecycleBatchSize = 64,
+    .mEvictionPolicy = EvictionPolicy::kEvictionRandom,
+    .mHugePageSize = 0,
+    .mEnableNuma = false,
     .mEnableReclaimPageIds = true,
+    .mEnablePageCompression = false,
+
+    // IO related options
+    .mIoBackend = IoBackend::kLibaio,
 
     // Logging and recovery related options
     .mEnableWal = true,
     .mEnableWalFsync = false,
+    .mNumWalFiles = 1,
+    .mEnableWalCompression = false,
+    .mMaxGroupCommitWindowUs = 1000,
+    .mCheckpointIntervalMs = 0,
+    .mCheckpointMaxPagesPerSec = 0,
 
     // Generic BTree related options
     .mEnableBulkInsert = false,
@@ -43,12 +56,16 @@ static const StoreOption kDefaultStoreOption = {
     .mBTreeHints = 1,
     .mEnableHeadOptimization = true,
     .mEnableOptimisticScan = true,
+    .mMaxScanReadAheadPages = 64,
 
     // Transaction related options
     .mEnableLongRunningTx = true,
     .mEnableFatTuple = false,
     .mEnableGc = true,
     .mEnableEagerGc = false,
+    .mEnableGcService = false,
+    .mGcBatchSize = 1024,
+    .mGcMaxVersionsPerSec = 0,
 
     // Metrics related options
     .mEnableCpuCounters = true,
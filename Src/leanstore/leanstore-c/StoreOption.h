@@ -16,6 +16,23 @@ typedef enum LogLevel {
   kError,
 } LogLevel;
 
+//! The async IO backend
+typedef enum IoBackend {
+  kLibaio = 0,
+  kIoUring,
+} IoBackend;
+
+//! The policy page evictors use to pick the buffer frames to cool or evict
+typedef enum EvictionPolicy {
+  //! Randomly sample buffer frames from the whole buffer pool.
+  kEvictionRandom = 0,
+
+  //! Sweep the buffer pool sequentially like a CLOCK hand, each page evictor owns an equal slice
+  //! of the buffer pool. The cool state serves as the reference bit: a cooled buffer frame
+  //! accessed again is hot before the hand comes back, otherwise it's evicted.
+  kEvictionClock,
+} EvictionPolicy;
+
 //! The options for creating a new store.
 typedef struct StoreOption {
   // ---------------------------------------------------------------------------
@@ -45,6 +62,11 @@ typedef struct StoreOption {
   //! The WAL buffer size for each worker (bytes).
   uint64_t mWalBufferSize;
 
+  //! The number of jobs queued by LeanStore::ExecQueued() that a worker thread interleaves. A job
+  //! waiting for a page read is parked and the worker thread runs another one meanwhile, each of
+  //! them runs in its own worker context. 1 runs the queued jobs one after another.
+  uint64_t mJobsPerWorker;
+
   // ---------------------------------------------------------------------------
   // Buffer pool related options
   // ---------------------------------------------------------------------------
@@ -76,9 +98,41 @@ typedef struct StoreOption {
   //! verified by page evictors, some of them are COOLed, some of them are EVICted.
   uint64_t mBufferFrameRecycleBatchSize;
 
+  //! The policy to pick the buffer frames to cool or evict.
+  EvictionPolicy mEvictionPolicy;
+
+  //! The size (bytes) of the memory pages backing the buffer pool:
+  //! - 0: regular pages, advised to be backed by transparent huge pages (MADV_HUGEPAGE).
+  //! - 2MB or 1GB: explicit huge pages from the kernel huge page pool (MAP_HUGETLB), which must be
+  //!   reserved in advance, e.g. via /proc/sys/vm/nr_hugepages. Falls back to 0 if there are not
+  //!   enough of them.
+  //! - any other value: regular pages without transparent huge pages (MADV_NOHUGEPAGE).
+  uint64_t mHugePageSize;
+
+  //! Whether to spread the buffer pool over the NUMA nodes. The buffer frames of each node are
+  //! bound to its memory and serve the partitions of the node, i.e. partition p is on node
+  //! p % numNodes. New pages are allocated in a partition of the worker's node, and page evictors
+  //! are pinned to the node they serve. Ignored on machines with a single NUMA node.
+  bool mEnableNuma;
+
   //! Whether to reclaim unused free page ids
   bool mEnableReclaimPageIds;
 
+  //! Whether to compress the leaves written back by page evictors with LZ4. Unused bytes of a
+  //! leaf are compacted away before compression, the compressed page is written at the start of
+  //! its slot in the page file, and the file system blocks left in the slot are punched out. Pages
+  //! are decompressed transparently on load, whether or not the option is enabled. Saves space and
+  //! read bandwidth only when mPageSize is larger than the file system block size.
+  bool mEnablePageCompression;
+
+  // ---------------------------------------------------------------------------
+  // IO related options
+  // ---------------------------------------------------------------------------
+
+  //! The async IO backend for page reads and writes and WAL writes, libaio by default. Falls back
+  //! to libaio if io_uring is not available.
+  IoBackend mIoBackend;
+
   // ---------------------------------------------------------------------------
   // Logging and recovery related options
   // ---------------------------------------------------------------------------
@@ -89,6 +143,29 @@ typedef struct StoreOption {
   //! Whether to execute fsync after each WAL write.
   bool mEnableWalFsync;
 
+  //! The number of WAL files, each of them is written by its own group committer serving a subset
+  //! of the workers. The first one is db.wal, the others are db.wal.1, db.wal.2, ... in the store
+  //! directory, they can be symlinks to files on other devices. Must not change after the store is
+  //! created.
+  uint64_t mNumWalFiles;
+
+  //! Whether to compress the WAL with LZ4. Each batch of WAL entries collected by the group
+  //! committer from a worker is written as a compressed frame, recovery decompresses the frames
+  //! transparently. Must not change after the store is created.
+  bool mEnableWalCompression;
+
+  //! Max time (microseconds) the group committer waits for more transactions after a WAL flush, so
+  //! they are flushed together. The actual window adapts to the observed flush latency. 0 disables
+  //! batching, every round flushes immediately.
+  uint64_t mMaxGroupCommitWindowUs;
+
+  //! Interval (milliseconds) between two rounds of the fuzzy checkpointer, which flushes dirty
+  //! pages in the background and advances the checkpoint LSN recovery starts from. 0 disables it.
+  uint64_t mCheckpointIntervalMs;
+
+  //! Max number of pages written per second by the fuzzy checkpointer. 0 means unlimited.
+  uint64_t mCheckpointMaxPagesPerSec;
+
   // ---------------------------------------------------------------------------
   // Generic BTree related options
   // ---------------------------------------------------------------------------
@@ -120,7 +197,7 @@ typedef struct StoreOption {
   //! Whether to enable btree hints optimization. Available options:
   //! 0: disabled
   //! 1: serial
-  //! 2: AVX512
+  //! 2: SIMD, with the best of AVX-512, AVX2 and SSE4.2 supported by the cpu, falls back to serial
   int64_t mBTreeHints;
 
   //! Whether to enable heads optimization in LowerBound search.
@@ -130,6 +207,11 @@ typedef struct StoreOption {
   //! not changed
   bool mEnableOptimisticScan;
 
+  //! The maximum number of evicted leaves BasicKV::ScanAsc() and ScanDesc() read ahead with one
+  //! batch of async reads. The read-ahead depth starts small and is doubled on every leaf the scan
+  //! moves to. 0 disables read-ahead.
+  uint64_t mMaxScanReadAheadPages;
+
   // ---------------------------------------------------------------------------
   // Transaction related options
   // ---------------------------------------------------------------------------
@@ -148,6 +230,22 @@ typedef struct StoreOption {
   //! each transaction commit and abort.
   bool mEnableEagerGc;
 
+  //! Whether to garbage collect the versions of all the workers in a dedicated GarbageCollector
+  //! thread instead of on the workers after their transactions commit. mEnableEagerGc is ignored
+  //! once enabled.
+  bool mEnableGcService;
+
+  //! The number of remove and update versions the GarbageCollector purges from the history of one
+  //! worker before it moves on to the next worker, exceeded by at most one history leaf. 0 means
+  //! no limit.
+  uint64_t mGcBatchSize;
+
+  //! The maximum number of remove and update versions the GarbageCollector purges per second while
+  //! user transactions are running, it sleeps once exceeded to leave the CPU and the latches to
+  //! the workers. The cap is fixed, it doesn't scale with the number of running transactions, it's
+  //! lifted when no user transaction is started. 0 means no limit.
+  uint64_t mGcMaxVersionsPerSec;
+
   // ---------------------------------------------------------------------------
   // Metrics related options
   // ---------------------------------------------------------------------------
@@ -155,7 +253,8 @@ typedef struct StoreOption {
   //! Whether to enable cpu counters.
   bool mEnableCpuCounters;
 
-  //! Whether to enable time measure.
+  //! Whether to measure the latency of the leanstore-c API calls in the worker threads, and to
+  //! trace a sample of them, see GetPerfSnapshot().
   bool mEnableTimeMeasure;
 
   //! Whether to enable perf events.
@@ -6,14 +6,20 @@
 #include "leanstore/Slice.hpp"
 #include "leanstore/btree/BasicKV.hpp"
 #include "leanstore/btree/core/PessimisticSharedIterator.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
 #include "leanstore/telemetry/MetricsHttpExposer.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <utility>
+#include <vector>
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -66,6 +72,19 @@ struct LeanStoreHandle {
   std::unique_ptr<leanstore::LeanStore> mStore;
 };
 
+// The global http metrics exposer, and the store whose metrics it exposes, i.e. the latest created
+// store that is not destroyed yet.
+static leanstore::telemetry::MetricsHttpExposer* sGlobalMetricsHttpExposer = nullptr;
+static leanstore::LeanStore* sGlobalMetricsStore = nullptr;
+static std::mutex sGlobalMetricsHttpExposerMutex;
+
+static void setGlobalMetricsStore(leanstore::LeanStore* store) {
+  sGlobalMetricsStore = store;
+  if (sGlobalMetricsHttpExposer != nullptr) {
+    sGlobalMetricsHttpExposer->SetExposedStore(store);
+  }
+}
+
 LeanStoreHandle* CreateLeanStore(StoreOption* option) {
   auto res = leanstore::LeanStore::Open(option);
   if (!res) {
@@ -74,13 +93,68 @@ LeanStoreHandle* CreateLeanStore(StoreOption* option) {
   }
   LeanStoreHandle* handle = new LeanStoreHandle();
   handle->mStore = std::move(res.value());
+
+  std::unique_lock guard{sGlobalMetricsHttpExposerMutex};
+  setGlobalMetricsStore(handle->mStore.get());
   return handle;
 }
 
 void DestroyLeanStore(LeanStoreHandle* handle) {
+  {
+    std::unique_lock guard{sGlobalMetricsHttpExposerMutex};
+    if (handle != nullptr && sGlobalMetricsStore == handle->mStore.get()) {
+      setGlobalMetricsStore(nullptr);
+    }
+  }
   delete handle;
 }
 
+//! Executes the API call on the worker. With StoreOption::mEnableTimeMeasure, its latency in the
+//! worker is recorded to the PerfCounters of the worker thread, and one of every
+//! PerfOpTraceRing::kSampleInterval calls is traced, see GetPerfSnapshot().
+template <typename Fn>
+static void execTraced(leanstore::LeanStore* store, uint64_t workerId, PerfOpType opType,
+                       Fn&& fn) {
+  if (!store->mStoreOption->mEnableTimeMeasure) {
+    store->ExecSync(workerId, std::forward<Fn>(fn));
+    return;
+  }
+
+  store->ExecSync(workerId, [&]() {
+    auto& counters = leanstore::cr::tlsPerfCounters;
+    auto& traces = leanstore::cr::tlsPerfOpTraces;
+    auto load = [](const CounterType& counter) {
+      return atomic_load_explicit(&counter, std::memory_order_relaxed);
+    };
+    auto numResolved = [&]() {
+      return load(counters.mBufferHotHits) + load(counters.mBufferCoolHits) +
+             load(counters.mBufferMisses);
+    };
+    const bool sampled = traces.ShouldSample();
+    const uint64_t resolvedBefore = sampled ? numResolved() : 0;
+    const uint64_t missesBefore = load(counters.mBufferMisses);
+    const uint64_t jumpsBefore = load(counters.mJumps);
+    auto startedAt = std::chrono::steady_clock::now();
+
+    fn();
+
+    uint64_t latNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - startedAt)
+                         .count();
+    PerfHistRecord(&counters.mOpLatNs[opType], latNs);
+    if (sampled) {
+      traces.Record(PerfOpTrace{
+          .mOpType = static_cast<uint64_t>(opType),
+          .mWorkerId = workerId,
+          .mLatNs = latNs,
+          .mNodesTraversed = numResolved() - resolvedBefore,
+          .mPageMisses = load(counters.mBufferMisses) - missesBefore,
+          .mJumps = load(counters.mJumps) - jumpsBefore,
+      });
+    }
+  });
+}
+
 //------------------------------------------------------------------------------
 // BasicKV API
 //------------------------------------------------------------------------------
@@ -121,7 +195,7 @@ void DestroyBasicKV(BasicKvHandle* handle) {
 
 bool BasicKvInsert(BasicKvHandle* handle, uint64_t workerId, StringSlice key, StringSlice val) {
   bool succeed{false};
-  handle->mStore->ExecSync(workerId, [&]() {
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvInsert, [&]() {
     auto opCode = handle->mBtree->Insert(leanstore::Slice(key.mData, key.mSize),
                                          leanstore::Slice(val.mData, val.mSize));
     succeed = (opCode == leanstore::OpCode::kOK);
@@ -131,7 +205,7 @@ bool BasicKvInsert(BasicKvHandle* handle, uint64_t workerId, StringSlice key, St
 
 bool BasicKvLookup(BasicKvHandle* handle, uint64_t workerId, StringSlice key, String** val) {
   bool found = false;
-  handle->mStore->ExecSync(workerId, [&]() {
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvLookup, [&]() {
     // copy value out to a thread-local buffer to reduce memory allocation
     auto copyValueOut = [&](leanstore::Slice valSlice) {
       // set the found flag
@@ -159,7 +233,7 @@ bool BasicKvLookup(BasicKvHandle* handle, uint64_t workerId, StringSlice key, St
 
 bool BasicKvRemove(BasicKvHandle* handle, uint64_t workerId, StringSlice key) {
   bool succeed{false};
-  handle->mStore->ExecSync(workerId, [&]() {
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvRemove, [&]() {
     auto opCode = handle->mBtree->Remove(leanstore::Slice(key.mData, key.mSize));
     succeed = (opCode == leanstore::OpCode::kOK);
   });
@@ -207,12 +281,13 @@ void DestroyBasicKvIter(BasicKvIterHandle* handle) {
 //------------------------------------------------------------------------------
 
 void BasicKvIterSeekToFirst(BasicKvIterHandle* handle, uint64_t workerId) {
-  handle->mStore->ExecSync(workerId, [&]() { handle->mIterator.SeekToFirst(); });
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterSeekToFirst,
+             [&]() { handle->mIterator.SeekToFirst(); });
 }
 
 void BasicKvIterSeekToFirstGreaterEqual(BasicKvIterHandle* handle, uint64_t workerId,
                                         StringSlice key) {
-  handle->mStore->ExecSync(workerId, [&]() {
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterSeekToFirstGreaterEqual, [&]() {
     handle->mIterator.SeekToFirstGreaterEqual(leanstore::Slice(key.mData, key.mSize));
   });
 }
@@ -224,7 +299,8 @@ bool BasicKvIterHasNext(BasicKvIterHandle* handle, uint64_t workerId) {
 }
 
 void BasicKvIterNext(BasicKvIterHandle* handle, uint64_t workerId) {
-  handle->mStore->ExecSync(workerId, [&]() { handle->mIterator.Next(); });
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterNext,
+             [&]() { handle->mIterator.Next(); });
 }
 
 //------------------------------------------------------------------------------
@@ -232,11 +308,12 @@ void BasicKvIterNext(BasicKvIterHandle* handle, uint64_t workerId) {
 //------------------------------------------------------------------------------
 
 void BasicKvIterSeekToLast(BasicKvIterHandle* handle, uint64_t workerId) {
-  handle->mStore->ExecSync(workerId, [&]() { handle->mIterator.SeekToLast(); });
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterSeekToLast,
+             [&]() { handle->mIterator.SeekToLast(); });
 }
 
 void BasicKvIterSeekToLastLessEqual(BasicKvIterHandle* handle, uint64_t workerId, StringSlice key) {
-  handle->mStore->ExecSync(workerId, [&]() {
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterSeekToLastLessEqual, [&]() {
     handle->mIterator.SeekToLastLessEqual(leanstore::Slice(key.mData, key.mSize));
   });
 }
@@ -248,7 +325,8 @@ bool BasicKvIterHasPrev(BasicKvIterHandle* handle, uint64_t workerId) {
 }
 
 void BasicKvIterPrev(BasicKvIterHandle* handle, uint64_t workerId) {
-  handle->mStore->ExecSync(workerId, [&]() { handle->mIterator.Prev(); });
+  execTraced(handle->mStore, workerId, kPerfOpBasicKvIterPrev,
+             [&]() { handle->mIterator.Prev(); });
 }
 
 //------------------------------------------------------------------------------
@@ -275,12 +353,10 @@ StringSlice BasicKvIterVal(BasicKvIterHandle* handle) {
 // Interfaces for metrics
 //------------------------------------------------------------------------------
 
-static leanstore::telemetry::MetricsHttpExposer* sGlobalMetricsHttpExposer = nullptr;
-static std::mutex sGlobalMetricsHttpExposerMutex;
-
 void StartMetricsHttpExposer(int32_t port) {
   std::unique_lock guard{sGlobalMetricsHttpExposerMutex};
   sGlobalMetricsHttpExposer = new leanstore::telemetry::MetricsHttpExposer(port);
+  sGlobalMetricsHttpExposer->SetExposedStore(sGlobalMetricsStore);
   sGlobalMetricsHttpExposer->Start();
 }
 
@@ -290,4 +366,28 @@ void StopMetricsHttpExposer() {
     delete sGlobalMetricsHttpExposer;
     sGlobalMetricsHttpExposer = nullptr;
   }
-}
\ No newline at end of file
+}
+
+PerfSnapshot* GetPerfSnapshot(LeanStoreHandle* handle) {
+  if (handle == nullptr) {
+    return nullptr;
+  }
+
+  auto* snapshot = new PerfSnapshot();
+  auto* crManager = handle->mStore->mCRManager;
+  crManager->AggregatePerfCounters(snapshot->mCounters);
+
+  std::vector<PerfOpTrace> traces;
+  crManager->CollectPerfOpTraces(traces);
+  snapshot->mNumTraces = traces.size();
+  snapshot->mTraces = new PerfOpTrace[traces.size()];
+  std::copy(traces.begin(), traces.end(), snapshot->mTraces);
+  return snapshot;
+}
+
+void DestroyPerfSnapshot(PerfSnapshot* snapshot) {
+  if (snapshot != nullptr) {
+    delete[] snapshot->mTraces;
+    delete snapshot;
+  }
+}
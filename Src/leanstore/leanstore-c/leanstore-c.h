@@ -1,6 +1,7 @@
 #ifndef LEANSTORE_C_H
 #define LEANSTORE_C_H
 
+#include "leanstore/leanstore-c/PerfCounters.h"
 #include "leanstore/leanstore-c/StoreOption.h"
 
 #include <stdbool.h>
@@ -160,12 +161,37 @@ StringSlice BasicKvIterVal(BasicKvIterHandle* handle);
 // Interfaces for metrics
 //------------------------------------------------------------------------------
 
-//! Start the global http metrics exposer
+//! Start the global http metrics exposer. The metrics of the latest created store are exposed at
+//! /metrics in Prometheus text format.
 void StartMetricsHttpExposer(int32_t port);
 
 //! Stop the global http metrics exposer
 void StopMetricsHttpExposer();
 
+//! PerfSnapshot is a point-in-time copy of the performance counters and traces of a store
+typedef struct PerfSnapshot {
+  //! The counters summed up over all the worker threads, including the latency histograms of the
+  //! API calls in mOpLatNs
+  PerfCounters mCounters;
+
+  //! The number of traces in mTraces
+  uint64_t mNumTraces;
+
+  //! The latest sampled API calls of all the worker threads, in no particular order
+  PerfOpTrace* mTraces;
+} PerfSnapshot;
+
+//! Get the performance counters and the sampled API call traces of a store, without blocking the
+//! worker threads. Latencies and traces of the API calls are only recorded with
+//! StoreOption::mEnableTimeMeasure. The nodes traversed, page misses and jumps of the traces are
+//! only counted if the store is built with ENABLE_PERF_COUNTERS.
+//! @return the snapshot, which should be destroyed by the caller with DestroyPerfSnapshot(), or
+//!         NULL if handle is NULL
+PerfSnapshot* GetPerfSnapshot(LeanStoreHandle* handle);
+
+//! Destroy a snapshot returned by GetPerfSnapshot()
+void DestroyPerfSnapshot(PerfSnapshot* snapshot);
+
 #ifdef __cplusplus
 }
 #endif
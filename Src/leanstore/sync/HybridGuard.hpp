@@ -6,7 +6,6 @@
 #include "leanstore/utils/Log.hpp"
 
 #include <atomic>
-#include <shared_mutex>
 
 #include <unistd.h>
 
@@ -51,7 +50,7 @@ public:
   HybridGuard(HybridLatch& latch, GuardState state)
       : mLatch(&latch),
         mState(state),
-        mVersion(latch.mVersion.load()) {
+        mVersion(latch.GetOptimisticVersion()) {
   }
 
   // Move constructor
@@ -73,11 +72,12 @@ public:
 
 public:
   void JumpIfModifiedByOthers() {
-    LS_DCHECK(mState == GuardState::kOptimisticShared || mVersion == mLatch->mVersion.load());
-    if (mState == GuardState::kOptimisticShared && mVersion != mLatch->mVersion.load()) {
+    LS_DCHECK(mState == GuardState::kOptimisticShared ||
+              mVersion == mLatch->GetOptimisticVersion());
+    if (mState == GuardState::kOptimisticShared && mVersion != mLatch->GetOptimisticVersion()) {
       LS_DLOG("JumpIfModifiedByOthers, mVersion(expected)={}, "
               "mLatch->mVersion(actual)={}",
-              mVersion, mLatch->mVersion.load());
+              mVersion, mLatch->GetOptimisticVersion());
       jumpmu::Jump();
     }
   }
@@ -102,17 +102,17 @@ public:
 
   inline void ToOptimisticSpin() {
     LS_DCHECK(mState == GuardState::kUninitialized && mLatch != nullptr);
-    mVersion = mLatch->mVersion.load();
+    mVersion = mLatch->GetOptimisticVersion();
     while (HasExclusiveMark(mVersion)) {
       mEncounteredContention = true;
-      mVersion = mLatch->mVersion.load();
+      mVersion = mLatch->GetOptimisticVersion();
     }
     mState = GuardState::kOptimisticShared;
   }
 
   inline void ToOptimisticOrJump() {
     LS_DCHECK(mState == GuardState::kUninitialized && mLatch != nullptr);
-    mVersion = mLatch->mVersion.load();
+    mVersion = mLatch->GetOptimisticVersion();
     if (HasExclusiveMark(mVersion)) {
       mEncounteredContention = true;
       jumpmu::Jump();
@@ -125,7 +125,7 @@ public:
       return;
     }
     LS_DCHECK(mState == GuardState::kUninitialized || mLatch != nullptr);
-    mVersion = mLatch->mVersion.load();
+    mVersion = mLatch->GetOptimisticVersion();
     if (HasExclusiveMark(mVersion)) {
       lockShared();
       mEncounteredContention = true;
@@ -136,7 +136,7 @@ public:
 
   inline void ToOptimisticOrExclusive() {
     LS_DCHECK(mState == GuardState::kUninitialized && mLatch != nullptr);
-    mVersion = mLatch->mVersion.load();
+    mVersion = mLatch->GetOptimisticVersion();
     if (HasExclusiveMark(mVersion)) {
       lockExclusive();
       mEncounteredContention = true;
@@ -152,15 +152,11 @@ public:
     }
 
     if (mState == GuardState::kOptimisticShared) {
-      const uint64_t newVersion = mVersion + kLatchExclusiveBit;
-      uint64_t expected = mVersion;
-      // changed from try_lock because of possible retries b/c lots of readers
-      mLatch->mMutex.lock();
-      if (!mLatch->mVersion.compare_exchange_strong(expected, newVersion)) {
-        mLatch->mMutex.unlock();
+      // wait for the shared holders instead of jumping, there may be lots of readers
+      if (!mLatch->LockExclusivelyIfUnchanged(mVersion)) {
         jumpmu::Jump();
       }
-      mVersion = newVersion;
+      mVersion = mLatch->GetOptimisticVersion();
       mState = GuardState::kPessimisticExclusive;
     } else {
       lockExclusive();
@@ -173,9 +169,7 @@ public:
       return;
     }
     if (mState == GuardState::kOptimisticShared) {
-      mLatch->mMutex.lock_shared();
-      if (mLatch->mVersion.load() != mVersion) {
-        mLatch->mMutex.unlock_shared();
+      if (!mLatch->LockSharedIfUnchanged(mVersion)) {
         jumpmu::Jump();
       }
       mState = GuardState::kPessimisticShared;
@@ -187,28 +181,17 @@ public:
   // For buffer management
   inline void TryToExclusiveMayJump() {
     LS_DCHECK(mState == GuardState::kOptimisticShared);
-    const uint64_t newVersion = mVersion + kLatchExclusiveBit;
-    uint64_t expected = mVersion;
-
-    if (!mLatch->mMutex.try_lock()) {
-      jumpmu::Jump();
-    }
-    if (!mLatch->mVersion.compare_exchange_strong(expected, newVersion)) {
-      mLatch->mMutex.unlock();
+    if (!mLatch->TryLockExclusivelyIfUnchanged(mVersion)) {
       jumpmu::Jump();
     }
 
-    mVersion = newVersion;
+    mVersion = mLatch->GetOptimisticVersion();
     mState = GuardState::kPessimisticExclusive;
   }
 
   inline void TryToSharedMayJump() {
     LS_DCHECK(mState == GuardState::kOptimisticShared);
-    if (!mLatch->mMutex.try_lock_shared()) {
-      jumpmu::Jump();
-    }
-    if (mLatch->mVersion.load() != mVersion) {
-      mLatch->mMutex.unlock_shared();
+    if (!mLatch->LockSharedIfUnchanged(mVersion)) {
       jumpmu::Jump();
     }
     mState = GuardState::kPessimisticShared;
@@ -216,32 +199,28 @@ public:
 
 private:
   inline void lockExclusive() {
-    mLatch->mMutex.lock();
-    LS_DCHECK(!HasExclusiveMark(mLatch->mVersion));
-    mVersion = mLatch->mVersion.load() + kLatchExclusiveBit;
-    mLatch->mVersion.store(mVersion, std::memory_order_release);
+    mLatch->LockExclusively();
+    mVersion = mLatch->GetOptimisticVersion();
     mState = GuardState::kPessimisticExclusive;
   }
 
   inline void unlockExclusive() {
-    LS_DCHECK(HasExclusiveMark(mLatch->mVersion));
-    mVersion += kLatchExclusiveBit;
-    mLatch->mVersion.store(mVersion, std::memory_order_release);
-    LS_DCHECK(!HasExclusiveMark(mLatch->mVersion));
-    mLatch->mMutex.unlock();
+    mLatch->UnlockExclusively();
+    mVersion = mLatch->GetOptimisticVersion();
+    LS_DCHECK(!HasExclusiveMark(mVersion));
     mState = GuardState::kOptimisticShared;
   }
 
   inline void lockShared() {
-    mLatch->mMutex.lock_shared();
-    LS_DCHECK(!HasExclusiveMark(mLatch->mVersion));
-    mVersion = mLatch->mVersion.load();
+    mLatch->LockShared();
+    mVersion = mLatch->GetOptimisticVersion();
+    LS_DCHECK(!HasExclusiveMark(mVersion));
     mState = GuardState::kPessimisticShared;
   }
 
   inline void unlockShared() {
-    LS_DCHECK(!HasExclusiveMark(mLatch->mVersion));
-    mLatch->mMutex.unlock_shared();
+    LS_DCHECK(!mLatch->IsLockedExclusively());
+    mLatch->UnlockShared();
     mState = GuardState::kOptimisticShared;
   }
 };
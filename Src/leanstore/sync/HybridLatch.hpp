@@ -3,8 +3,11 @@
 #include "leanstore/utils/Log.hpp"
 
 #include <atomic>
-#include <shared_mutex>
+#include <bit>
+#include <climits>
 
+#include <linux/futex.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 namespace leanstore::storage {
@@ -31,42 +34,210 @@ inline bool HasExclusiveMark(uint64_t version) {
 //!   mode, the version number is used to detech latch contention.
 //! - pessimistic shared: in shared mode, for high-contention scenarios.
 //! - pessimistic exclusive: in exclusive mode, for high-contention scenarios.
-class alignas(64) HybridLatch {
+//!
+//! The whole latch is a single 64-bit word:
+//! - bits [0, 48): the optimistic version, the lowest bit is the exclusive bit.
+//!   Locking and unlocking exclusively both increase the version by one.
+//! - bits [48, 63): the number of pessimistic shared holders, which doesn't
+//!   change the version, so they don't invalidate optimistic readers.
+//! - bit 63: set by threads parked on the latch, they are woken up by the
+//!   unlock which makes the latch available.
+//!
+//! Contended lockers spin for a while and then park on a futex, which waits on
+//! the upper 32 bits of the word: version bits [32, 48), the shared holders and
+//! the parked bit. A version carry into bit 32 thus also ends a futex wait,
+//! which is harmless as parked threads reload and retry.
+//!
+//! Each thread counts the pessimistic latches it holds, a job holding any of
+//! them must not be parked, see cr::WorkerThread::CanPark().
+class HybridLatch {
 private:
-  //! The optimistic version.
-  std::atomic<uint64_t> mVersion = 0;
+  static constexpr uint64_t kVersionMask = (1ull << 48) - 1;
+  static constexpr uint64_t kSharedUnit = 1ull << 48;
+  static constexpr uint64_t kSharedMask = ((1ull << 15) - 1) << 48;
+  static constexpr uint64_t kParkedBit = 1ull << 63;
+  static constexpr uint64_t kSpinCount = 128;
 
-  //! The pessimistic shared mutex.
-  std::shared_mutex mMutex;
+  //! The latch word, see the class comment for the layout.
+  std::atomic<uint64_t> mState = 0;
+
+  //! Number of pessimistic latches held by the current thread.
+  inline static thread_local uint64_t sTlsNumLocked = 0;
 
   friend class HybridGuard;
   friend class ScopedHybridGuard;
 
 public:
-  HybridLatch(uint64_t version = 0) : mVersion(version) {
+  HybridLatch(uint64_t version = 0) : mState(version & kVersionMask) {
   }
 
   void LockExclusively() {
-    mMutex.lock();
-    mVersion.fetch_add(kLatchExclusiveBit, std::memory_order_release);
+    for (uint64_t i = 0;; i++) {
+      auto state = mState.load();
+      if (!HasExclusiveMark(state) && (state & kSharedMask) == 0) {
+        if (mState.compare_exchange_weak(state, nextVersion(state))) {
+          break;
+        }
+        continue;
+      }
+      if (i >= kSpinCount) {
+        park(state);
+      }
+    }
+    sTlsNumLocked++;
     LS_DCHECK(IsLockedExclusively());
   }
 
+  //! Locks the latch exclusively without waiting, returns false if it's locked
+  //! by others.
+  bool TryLockExclusively() {
+    auto state = mState.load();
+    if (HasExclusiveMark(state) || (state & kSharedMask) != 0 ||
+        !mState.compare_exchange_strong(state, nextVersion(state))) {
+      return false;
+    }
+    sTlsNumLocked++;
+    return true;
+  }
+
+  //! Locks the latch exclusively if its version is still the optimistic one,
+  //! waits for the shared holders to leave. Returns false if the version has
+  //! been changed by others.
+  bool LockExclusivelyIfUnchanged(uint64_t version) {
+    LS_DCHECK(!HasExclusiveMark(version));
+    for (uint64_t i = 0;; i++) {
+      auto state = mState.load();
+      if ((state & kVersionMask) != version) {
+        return false;
+      }
+      if ((state & kSharedMask) == 0) {
+        if (mState.compare_exchange_weak(state, nextVersion(state))) {
+          sTlsNumLocked++;
+          return true;
+        }
+        continue;
+      }
+      if (i >= kSpinCount) {
+        park(state);
+      }
+    }
+  }
+
+  //! Like LockExclusivelyIfUnchanged(), but returns false instead of waiting
+  //! for the shared holders.
+  bool TryLockExclusivelyIfUnchanged(uint64_t version) {
+    LS_DCHECK(!HasExclusiveMark(version));
+    auto state = mState.load();
+    if ((state & kVersionMask) != version || (state & kSharedMask) != 0 ||
+        !mState.compare_exchange_strong(state, nextVersion(state))) {
+      return false;
+    }
+    sTlsNumLocked++;
+    return true;
+  }
+
   void UnlockExclusively() {
     LS_DCHECK(IsLockedExclusively());
-    mVersion.fetch_add(kLatchExclusiveBit, std::memory_order_release);
-    mMutex.unlock();
+    auto state = mState.load();
+    while (!mState.compare_exchange_weak(state, nextVersion(state) & ~kParkedBit)) {
+    }
+    sTlsNumLocked--;
+    if ((state & kParkedBit) != 0) {
+      wakeAll();
+    }
+  }
+
+  void LockShared() {
+    for (uint64_t i = 0;; i++) {
+      auto state = mState.load();
+      if (!HasExclusiveMark(state)) {
+        LS_DCHECK((state & kSharedMask) != kSharedMask);
+        if (mState.compare_exchange_weak(state, state + kSharedUnit)) {
+          sTlsNumLocked++;
+          return;
+        }
+        continue;
+      }
+      if (i >= kSpinCount) {
+        park(state);
+      }
+    }
+  }
+
+  //! Locks the latch in shared mode if its version is still the optimistic
+  //! one, never waits since the version is changed by every exclusive holder.
+  //! Returns false if the version has been changed by others.
+  bool LockSharedIfUnchanged(uint64_t version) {
+    LS_DCHECK(!HasExclusiveMark(version));
+    auto state = mState.load();
+    while ((state & kVersionMask) == version) {
+      LS_DCHECK((state & kSharedMask) != kSharedMask);
+      if (mState.compare_exchange_weak(state, state + kSharedUnit)) {
+        sTlsNumLocked++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void UnlockShared() {
+    auto state = mState.load();
+    uint64_t newState;
+    do {
+      LS_DCHECK((state & kSharedMask) != 0);
+      newState = state - kSharedUnit;
+      if ((newState & kSharedMask) == 0) {
+        newState &= ~kParkedBit;
+      }
+    } while (!mState.compare_exchange_weak(state, newState));
+    sTlsNumLocked--;
+    if ((state & kParkedBit) != 0 && (newState & kParkedBit) == 0) {
+      wakeAll();
+    }
   }
 
   uint64_t GetOptimisticVersion() {
-    return mVersion.load();
+    return mState.load() & kVersionMask;
   }
 
   bool IsLockedExclusively() {
-    return HasExclusiveMark(mVersion.load());
+    return HasExclusiveMark(mState.load());
+  }
+
+  //! Number of pessimistic latches, shared or exclusive, held by the current thread.
+  static uint64_t NumLockedByThisThread() {
+    return sTlsNumLocked;
+  }
+
+private:
+  //! Returns the state with the version increased by one, the version wraps
+  //! around within its bits.
+  static uint64_t nextVersion(uint64_t state) {
+    return (state & ~kVersionMask) | ((state + 1) & kVersionMask);
+  }
+
+  //! Marks the latch as parked and sleeps until the latch word is changed by
+  //! an unlock. Returns immediately if the latch is no longer in the observed
+  //! state, the caller should reload and retry.
+  void park(uint64_t state) {
+    if ((state & kParkedBit) == 0 && !mState.compare_exchange_strong(state, state | kParkedBit)) {
+      return;
+    }
+    auto expected = static_cast<uint32_t>((state | kParkedBit) >> 32);
+    syscall(SYS_futex, futexWord(), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+  }
+
+  void wakeAll() {
+    syscall(SYS_futex, futexWord(), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  //! The upper 32 bits of the latch word, version bits [32, 48) included.
+  uint32_t* futexWord() {
+    static_assert(std::endian::native == std::endian::little);
+    return reinterpret_cast<uint32_t*>(&mState) + 1;
   }
 };
 
-static_assert(sizeof(HybridLatch) == 64, "");
+static_assert(sizeof(HybridLatch) == 8, "");
 
-} // namespace leanstore::storage
\ No newline at end of file
+} // namespace leanstore::storage
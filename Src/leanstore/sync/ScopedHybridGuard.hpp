@@ -6,7 +6,6 @@
 
 #include <atomic>
 #include <functional>
-#include <shared_mutex>
 
 #include <sys/mman.h>
 #include <unistd.h>
@@ -230,7 +229,7 @@ inline void ScopedHybridGuard::Unlock() {
 
 inline void ScopedHybridGuard::lockOptimisticOrJump() {
   LS_DCHECK(mLatchMode == LatchMode::kOptimisticOrJump && mLatch != nullptr);
-  mVersionOnLock = mLatch->mVersion.load();
+  mVersionOnLock = mLatch->GetOptimisticVersion();
   if (HasExclusiveMark(mVersionOnLock)) {
     mEncounteredContention = true;
     LS_DLOG("lockOptimisticOrJump() failed, target latch, latch={}, version={}", (void*)&mLatch,
@@ -241,10 +240,10 @@ inline void ScopedHybridGuard::lockOptimisticOrJump() {
 
 inline void ScopedHybridGuard::lockOptimisticSpin() {
   LS_DCHECK(mLatchMode == LatchMode::kOptimisticSpin && mLatch != nullptr);
-  mVersionOnLock = mLatch->mVersion.load();
+  mVersionOnLock = mLatch->GetOptimisticVersion();
   while (HasExclusiveMark(mVersionOnLock)) {
     mEncounteredContention = true;
-    mVersionOnLock = mLatch->mVersion.load();
+    mVersionOnLock = mLatch->GetOptimisticVersion();
   }
 }
 
@@ -256,7 +255,7 @@ inline void ScopedHybridGuard::unlockOptimisticOrJump() {
 }
 
 inline void ScopedHybridGuard::jumpIfModifiedByOthers() {
-  auto curVersion = mLatch->mVersion.load();
+  auto curVersion = mLatch->GetOptimisticVersion();
   if (mVersionOnLock != curVersion) {
     mEncounteredContention = true;
     LS_DLOG("jumpIfModifiedByOthers() failed, target latch, latch={}, "
@@ -268,12 +267,12 @@ inline void ScopedHybridGuard::jumpIfModifiedByOthers() {
 
 inline void ScopedHybridGuard::lockPessimisticShared() {
   LS_DCHECK(mLatchMode == LatchMode::kPessimisticShared && mLatch != nullptr);
-  mLatch->mMutex.lock_shared();
+  mLatch->LockShared();
 }
 
 inline void ScopedHybridGuard::unlockPessimisticShared() {
   LS_DCHECK(mLatchMode == LatchMode::kPessimisticShared && mLatch != nullptr);
-  mLatch->mMutex.unlock_shared();
+  mLatch->UnlockShared();
 }
 
 inline void ScopedHybridGuard::lockPessimisticExclusive() {
@@ -1,12 +1,88 @@
 #include "leanstore/telemetry/MetricsHttpExposer.hpp"
 
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/buffer-manager/PageEvictor.hpp"
+#include "leanstore/buffer-manager/Partition.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/GroupCommitter.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
+
+#include <format>
+#include <iterator>
+#include <string>
+#include <string_view>
+
 namespace leanstore::telemetry {
 
+namespace {
+
+void writeHeader(std::string& out, std::string_view name, std::string_view type,
+                 std::string_view help) {
+  std::format_to(std::back_inserter(out), "# HELP {} {}\n# TYPE {} {}\n", name, help, name, type);
+}
+
+//! Writes a sample, labels are in the form of `key="value"`, empty if none.
+void writeSample(std::string& out, std::string_view name, std::string_view labels,
+                 uint64_t value) {
+  if (labels.empty()) {
+    std::format_to(std::back_inserter(out), "{} {}\n", name, value);
+  } else {
+    std::format_to(std::back_inserter(out), "{}{{{}}} {}\n", name, labels, value);
+  }
+}
+
+uint64_t load(const CounterType& counter) {
+  return atomic_load_explicit(&counter, std::memory_order_relaxed);
+}
+
+void writeCounter(std::string& out, std::string_view name, std::string_view help,
+                  uint64_t value) {
+  writeHeader(out, name, "counter", help);
+  writeSample(out, name, "", value);
+}
+
+//! Writes the samples of a PerfHistogram as a Prometheus histogram. Every bucket with a finite
+//! upper bound is written, empty or not, so that all the scrapes have the same series. The last
+//! reachable bucket is unbounded, it's only counted by +Inf. The exact sum is not recorded, it's
+//! estimated with the upper bounds.
+void writeHistogram(std::string& out, std::string_view name, std::string_view labels,
+                    const PerfHistogram& hist) {
+  static const uint64_t kNumFiniteBuckets = PerfHistBucket(UINT64_MAX);
+  const std::string_view sep = labels.empty() ? "" : ",";
+  const auto braced = labels.empty() ? std::string() : std::format("{{{}}}", labels);
+  uint64_t count = 0;
+  double sum = 0;
+  for (uint64_t i = 0; i < kNumFiniteBuckets; i++) {
+    auto numValues = load(hist.mBuckets[i]);
+    auto upperBound = PerfHistBucketUpperBound(i);
+    count += numValues;
+    sum += static_cast<double>(upperBound) * numValues;
+    std::format_to(std::back_inserter(out), "{}_bucket{{{}{}le=\"{}\"}} {}\n", name, labels, sep,
+                   upperBound, count);
+  }
+  for (uint64_t i = kNumFiniteBuckets; i < LEANSTORE_PERF_HIST_BUCKETS; i++) {
+    auto numValues = load(hist.mBuckets[i]);
+    count += numValues;
+    sum += static_cast<double>(UINT64_MAX) * numValues;
+  }
+  std::format_to(std::back_inserter(out), "{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, sep,
+                 count);
+  std::format_to(std::back_inserter(out), "{}_sum{} {}\n", name, braced, sum);
+  std::format_to(std::back_inserter(out), "{}_count{} {}\n", name, braced, count);
+}
+
+} // namespace
+
 MetricsHttpExposer::MetricsHttpExposer(int32_t port)
     : UserThread(nullptr, "MetricsExposer"),
       mPort(port) {
   mServer.new_task_queue = [] { return new httplib::ThreadPool(1); };
 
+  mServer.Get("/metrics", [&](const httplib::Request& req, httplib::Response& res) {
+    handleMetrics(req, res);
+  });
+
   mServer.Get("/heap",
               [&](const httplib::Request& req, httplib::Response& res) { handleHeap(req, res); });
 
@@ -15,4 +91,133 @@ MetricsHttpExposer::MetricsHttpExposer(int32_t port)
   });
 }
 
-} // namespace leanstore::telemetry
\ No newline at end of file
+void MetricsHttpExposer::handleMetrics(const httplib::Request& req [[maybe_unused]],
+                                       httplib::Response& res) {
+  std::unique_lock guard(mExposedStoreMutex);
+  if (mExposedStore == nullptr) {
+    res.set_content("", kContentType);
+    return;
+  }
+  auto* store = mExposedStore;
+  std::string out;
+
+  // transaction, concurrency control and split counters of all the workers
+  PerfCounters workers{};
+  store->mCRManager->AggregatePerfCounters(workers);
+  writeCounter(out, "leanstore_tx_committed_total", "Transactions committed.",
+               load(workers.mTxCommitted));
+  writeCounter(out, "leanstore_tx_aborted_total", "Transactions aborted.",
+               load(workers.mTxAborted));
+  writeCounter(out, "leanstore_tx_commit_wait_total",
+               "Transactions waited for the group committer to commit.",
+               load(workers.mTxCommitWait));
+  writeCounter(out, "leanstore_tx_with_remote_dependencies_total",
+               "Transactions depending on the WAL of other workers.",
+               load(workers.mTxWithRemoteDependencies));
+  writeCounter(out, "leanstore_tx_without_remote_dependencies_total",
+               "Transactions depending only on the WAL of their own worker.",
+               load(workers.mTxWithoutRemoteDependencies));
+  writeCounter(out, "leanstore_tx_short_running_total", "Short running transactions.",
+               load(workers.mTxShortRunning));
+  writeCounter(out, "leanstore_tx_long_running_total", "Long running transactions.",
+               load(workers.mTxLongRunning));
+  writeHeader(out, "leanstore_tx_commit_latency_ns", "histogram",
+              "Latency of waiting for the group committer to commit a transaction.");
+  writeHistogram(out, "leanstore_tx_commit_latency_ns", "", workers.mTxCommitLatNs);
+
+  writeCounter(out, "leanstore_lcb_executed_total", "LCB queries executed.",
+               load(workers.mLcbExecuted));
+  writeCounter(out, "leanstore_lcb_latency_ns_total", "Total latency of LCB queries.",
+               load(workers.mLcbTotalLatNs));
+  writeCounter(out, "leanstore_gc_executed_total", "MVCC garbage collections executed.",
+               load(workers.mGcExecuted));
+  writeCounter(out, "leanstore_gc_latency_ns_total", "Total latency of MVCC garbage collections.",
+               load(workers.mGcTotalLatNs));
+  writeCounter(out, "leanstore_gc_versions_purged_total",
+               "Versions purged by MVCC garbage collections.",
+               load(workers.mGcVersionsPurged));
+  writeCounter(out, "leanstore_split_succeed_total", "Node splits succeeded.",
+               load(workers.mSplitSucceed));
+  writeCounter(out, "leanstore_split_failed_total", "Node splits failed.",
+               load(workers.mSplitFailed));
+  writeCounter(out, "leanstore_contention_split_succeed_total",
+               "Contention splits succeeded.", load(workers.mContentionSplitSucceed));
+  writeCounter(out, "leanstore_contention_split_failed_total", "Contention splits failed.",
+               load(workers.mContentionSplitFailed));
+
+  // buffer pool
+  auto& bufferManager = *store->mBufferManager;
+  uint64_t numEvicted = 0;
+  uint64_t numWrittenBack = 0;
+  for (auto& pageEvictor : bufferManager.mPageEvictors) {
+    numEvicted += load(pageEvictor->GetPerfCounters()->mBufferEvicted);
+    numWrittenBack += load(pageEvictor->GetPerfCounters()->mBufferWrittenBack);
+  }
+  writeCounter(out, "leanstore_buffer_hot_hits_total", "Swips resolved to hot buffer frames.",
+               load(workers.mBufferHotHits));
+  writeCounter(out, "leanstore_buffer_cool_hits_total", "Swips resolved to cool buffer frames.",
+               load(workers.mBufferCoolHits));
+  writeCounter(out, "leanstore_buffer_misses_total", "Swips resolved by reading from disk.",
+               load(workers.mBufferMisses));
+  writeCounter(out, "leanstore_buffer_evicted_total", "Pages evicted by the page evictors.",
+               numEvicted);
+  writeCounter(out, "leanstore_buffer_written_back_total",
+               "Dirty pages written back by the page evictors.", numWrittenBack);
+
+  if (bufferManager.mNumNumaNodes > 1) {
+    writeHeader(out, "leanstore_buffer_numa_hits_total", "counter",
+                "Swips resolved to buffer frames on each NUMA node.");
+    for (uint64_t i = 0; i < bufferManager.mNumNumaNodes; i++) {
+      writeSample(out, "leanstore_buffer_numa_hits_total", std::format("node=\"{}\"", i),
+                  load(workers.mBufferNumaHits[i]));
+    }
+    writeHeader(out, "leanstore_buffer_numa_remote_hits_total", "counter",
+                "Swips resolved to buffer frames on each NUMA node by workers on other nodes.");
+    for (uint64_t i = 0; i < bufferManager.mNumNumaNodes; i++) {
+      writeSample(out, "leanstore_buffer_numa_remote_hits_total", std::format("node=\"{}\"", i),
+                  load(workers.mBufferNumaRemoteHits[i]));
+    }
+  }
+
+  writeHeader(out, "leanstore_buffer_frames", "gauge", "Buffer frames in the buffer pool.");
+  writeSample(out, "leanstore_buffer_frames", "", bufferManager.mNumBfs);
+  writeHeader(out, "leanstore_buffer_free_frames", "gauge",
+              "Free buffer frames of each partition.");
+  for (uint64_t i = 0; i < bufferManager.mPartitions.size(); i++) {
+    writeSample(out, "leanstore_buffer_free_frames", std::format("partition=\"{}\"", i),
+                bufferManager.mPartitions[i]->mFreeBfList.mSize.load(std::memory_order_relaxed));
+  }
+
+  // WAL and group commit of each WAL file
+  auto& groupCommitters = store->mCRManager->mGroupCommitters;
+  // the size of the WAL file, it starts from the recovered size after a restart
+  writeHeader(out, "leanstore_wal_size_bytes", "gauge", "Size of the WAL file.");
+  for (auto& groupCommitter : groupCommitters) {
+    writeSample(out, "leanstore_wal_size_bytes", std::format("wal=\"{}\"", groupCommitter->mWalId),
+                groupCommitter->mWalSize.load(std::memory_order_relaxed));
+  }
+  struct {
+    std::string_view mName;
+    std::string_view mHelp;
+    PerfHistogram PerfCounters::*mHist;
+  } groupCommitHists[] = {
+      {"leanstore_group_commit_batch_txs", "Transactions committed by a group commit round.",
+       &PerfCounters::mGroupCommitBatchTxs},
+      {"leanstore_group_commit_batch_bytes", "WAL bytes written by a group commit round.",
+       &PerfCounters::mGroupCommitBatchBytes},
+      {"leanstore_group_commit_flush_latency_ns",
+       "Latency of writing the WAL of a group commit round.",
+       &PerfCounters::mGroupCommitFlushLatNs},
+  };
+  for (auto& [name, help, hist] : groupCommitHists) {
+    writeHeader(out, name, "histogram", help);
+    for (auto& groupCommitter : groupCommitters) {
+      writeHistogram(out, name, std::format("wal=\"{}\"", groupCommitter->mWalId),
+                     groupCommitter->GetPerfCounters()->*hist);
+    }
+  }
+
+  res.set_content(out, kContentType);
+}
+
+} // namespace leanstore::telemetry
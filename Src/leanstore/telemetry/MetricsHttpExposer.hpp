@@ -11,9 +11,18 @@
 // #include <httplib.h>
 #include "httplib.h"
 
+#include <mutex>
+#include <string>
+
 #include <fcntl.h>
 #include <unistd.h>
 
+namespace leanstore {
+
+class LeanStore;
+
+} // namespace leanstore
+
 namespace leanstore::telemetry {
 
 const std::string kContentType("text/plain; version=0.0.4; charset=utf-8");
@@ -26,9 +35,22 @@ private:
   //! The port to expose metrics
   int32_t mPort;
 
+  //! Guards mExposedStore, held while the metrics of the store are collected.
+  std::mutex mExposedStoreMutex;
+
+  //! The store whose metrics are exposed at /metrics, nullptr if none.
+  LeanStore* mExposedStore = nullptr;
+
 public:
   MetricsHttpExposer(int32_t port);
 
+  //! Sets the store whose metrics are exposed, nullptr to stop exposing. Waits for the ongoing
+  //! /metrics request, the previous store can be destroyed after it returns.
+  void SetExposedStore(LeanStore* store) {
+    std::unique_lock guard(mExposedStoreMutex);
+    mExposedStore = store;
+  }
+
   ~MetricsHttpExposer() override {
     mServer.stop();
   }
@@ -41,6 +63,15 @@ protected:
   }
 
 private:
+  //! Exposes the metrics of the store in Prometheus text format:
+  //! - PerfCounters summed up over all the worker threads, nothing is locked, the counters are
+  //!   only recorded if the store is built with ENABLE_PERF_COUNTERS,
+  //! - buffer pool hits and misses, pages evicted and written back by the page evictors, free
+  //!   buffer frames of each partition,
+  //! - WAL bytes written and group commit batch sizes and flush latencies of each WAL file.
+  //! Rates like evictions or WAL bytes per second are left to rate() of Prometheus.
+  void handleMetrics(const httplib::Request& req, httplib::Response& res);
+
   void handleHeap(const httplib::Request& req [[maybe_unused]], httplib::Response& res) {
 #ifdef ENABLE_PROFILING
     // get the profiling time in seconds from the query
@@ -1,31 +1,61 @@
 #pragma once
 
+#include "leanstore/leanstore-c/StoreOption.h"
 #include "leanstore/utils/Error.hpp"
 #include "leanstore/utils/Log.hpp"
 #include "leanstore/utils/Result.hpp"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdint>
 #include <cstring>
 #include <expected>
 #include <format>
+#include <optional>
 #include <vector>
 
 #include <fcntl.h>
 #include <libaio.h>
+#include <liburing.h>
+#include <sys/uio.h>
 
 namespace leanstore::utils {
 
 constexpr size_t kAlignment = 512;
 
+//! Batched asynchronous IO on top of libaio or io_uring. Requests are collected with Prepare*(),
+//! sent to the kernel with SubmitAll() and reaped with WaitAll(), or polled with PollAll().
+//!
+//! With io_uring, buffers and files registered via RegisterBuffers() and RegisterFiles() are used
+//! as fixed buffers and fixed files, which saves the per-request page pinning and file lookup in
+//! the kernel. Registration is best effort: requests on memory or files that are not registered,
+//! or a failed registration, fall back to the plain read/write opcodes. When the io_uring instance
+//! can not be created, e.g. it is disabled by the kernel, libaio is used instead.
+//!
+//! An eventfd set via SetEventFd() is signaled on every completion, so that a thread can sleep
+//! until any of several instances has completed requests.
 class AsyncIo {
 public:
-  AsyncIo(uint64_t maxBatchSize)
-      : mMaxReqs(maxBatchSize),
+  AsyncIo(uint64_t maxBatchSize, IoBackend backend = kLibaio)
+      : mBackend(backend),
+        mMaxReqs(maxBatchSize),
         mNumReqs(0),
+        mNumInflight(0),
+        mNumPolled(0),
         mIocbs(maxBatchSize),
         mIocbPtrs(maxBatchSize),
-        mIoEvents(maxBatchSize) {
+        mIoEvents(maxBatchSize),
+        mCompletions(maxBatchSize) {
+    if (mBackend == kIoUring) {
+      std::memset(&mRing, 0, sizeof(mRing));
+      auto ret = io_uring_queue_init(mMaxReqs, &mRing, 0);
+      if (ret == 0) {
+        return;
+      }
+      Log::Warn("io_uring_queue_init failed, fallback to libaio, error={}", ret);
+      mBackend = kLibaio;
+    }
+
     for (uint64_t i = 0; i < maxBatchSize; i++) {
       mIocbPtrs[i] = &mIocbs[i];
     }
@@ -38,12 +68,83 @@ public:
   }
 
   ~AsyncIo() {
+    if (mBackend == kIoUring) {
+      io_uring_queue_exit(&mRing);
+      return;
+    }
+
     auto ret = io_destroy(mAioCtx);
     if (ret < 0) {
       Log::Fatal("io_destroy failed, error={}", ret);
     }
   }
 
+  // no copy and assign
+  AsyncIo(const AsyncIo&) = delete;
+  AsyncIo& operator=(const AsyncIo&) = delete;
+
+  IoBackend GetBackend() const {
+    return mBackend;
+  }
+
+  //! Registers memory regions as io_uring fixed buffers. Each region is split into pieces of at
+  //! most 1GB, the kernel limit of a single fixed buffer. No-op for libaio.
+  void RegisterBuffers(const std::vector<iovec>& regions) {
+    if (mBackend != kIoUring || regions.empty()) {
+      return;
+    }
+
+    constexpr size_t kMaxFixedBufferSize = 1ull << 30;
+    std::vector<iovec> buffers;
+    for (const auto& region : regions) {
+      auto* base = reinterpret_cast<uint8_t*>(region.iov_base);
+      for (size_t offset = 0; offset < region.iov_len; offset += kMaxFixedBufferSize) {
+        buffers.push_back(
+            iovec{base + offset, std::min(kMaxFixedBufferSize, region.iov_len - offset)});
+      }
+    }
+
+    auto ret = io_uring_register_buffers(&mRing, buffers.data(), buffers.size());
+    if (ret < 0) {
+      Log::Warn("io_uring_register_buffers failed, numBuffers={}, error={}", buffers.size(), ret);
+      return;
+    }
+    mFixedBuffers = std::move(buffers);
+  }
+
+  //! Registers files as io_uring fixed files. No-op for libaio.
+  void RegisterFiles(const std::vector<int32_t>& fds) {
+    if (mBackend != kIoUring || fds.empty()) {
+      return;
+    }
+
+    auto ret = io_uring_register_files(&mRing, fds.data(), fds.size());
+    if (ret < 0) {
+      Log::Warn("io_uring_register_files failed, numFiles={}, error={}", fds.size(), ret);
+      return;
+    }
+    mFixedFds = fds;
+  }
+
+  //! Signals eventFd on the completion of the requests prepared afterwards, -1 to stop signaling.
+  void SetEventFd(int32_t eventFd) {
+    if (eventFd == mEventFd) {
+      return;
+    }
+    if (mBackend == kIoUring) {
+      if (mEventFd >= 0) {
+        io_uring_unregister_eventfd(&mRing);
+      }
+      if (eventFd >= 0) {
+        if (auto ret = io_uring_register_eventfd(&mRing, eventFd); ret < 0) {
+          Log::Warn("io_uring_register_eventfd failed, error={}", ret);
+          eventFd = -1;
+        }
+      }
+    }
+    mEventFd = eventFd;
+  }
+
   size_t GetNumRequests() {
     return mNumReqs;
   }
@@ -59,27 +160,98 @@ public:
   void PrepareRead(int32_t fd, void* buf, size_t count, uint64_t offset) {
     LS_DCHECK((reinterpret_cast<uint64_t>(buf) & (kAlignment - 1)) == 0);
     LS_DCHECK(!IsFull());
+    if (mBackend == kIoUring) {
+      auto* sqe = getSqe();
+      if (sqe == nullptr) {
+        return;
+      }
+      auto bufIdx = fixedBufferIndex(buf, count);
+      if (bufIdx >= 0) {
+        io_uring_prep_read_fixed(sqe, fd, buf, count, offset, bufIdx);
+      } else {
+        io_uring_prep_read(sqe, fd, buf, count, offset);
+      }
+      prepareFixedFile(sqe, fd);
+      io_uring_sqe_set_data(sqe, buf);
+      mNumReqs++;
+      return;
+    }
+
     auto slot = mNumReqs++;
     io_prep_pread(&mIocbs[slot], fd, buf, count, offset);
     mIocbs[slot].data = buf;
+    if (mEventFd >= 0) {
+      io_set_eventfd(&mIocbs[slot], mEventFd);
+    }
   }
 
   void PrepareWrite(int32_t fd, void* buf, size_t count, uint64_t offset) {
     LS_DCHECK((reinterpret_cast<uint64_t>(buf) & (kAlignment - 1)) == 0);
     LS_DCHECK(!IsFull());
+    if (mBackend == kIoUring) {
+      auto* sqe = getSqe();
+      if (sqe == nullptr) {
+        return;
+      }
+      auto bufIdx = fixedBufferIndex(buf, count);
+      if (bufIdx >= 0) {
+        io_uring_prep_write_fixed(sqe, fd, buf, count, offset, bufIdx);
+      } else {
+        io_uring_prep_write(sqe, fd, buf, count, offset);
+      }
+      prepareFixedFile(sqe, fd);
+      io_uring_sqe_set_data(sqe, buf);
+      mNumReqs++;
+      return;
+    }
+
     auto slot = mNumReqs++;
     io_prep_pwrite(&mIocbs[slot], fd, buf, count, offset);
     mIocbs[slot].data = buf;
+    if (mEventFd >= 0) {
+      io_set_eventfd(&mIocbs[slot], mEventFd);
+    }
   }
 
   // Even for direct IO, fsync is still needed to flush file metadata.
   void PrepareFsync(int32_t fd) {
     LS_DCHECK(!IsFull());
+    if (mBackend == kIoUring) {
+      auto* sqe = getSqe();
+      if (sqe == nullptr) {
+        return;
+      }
+      io_uring_prep_fsync(sqe, fd, 0);
+      prepareFixedFile(sqe, fd);
+      // fsync must not start before the writes prepared before it have completed
+      sqe->flags |= IOSQE_IO_DRAIN;
+      io_uring_sqe_set_data(sqe, nullptr);
+      mNumReqs++;
+      return;
+    }
+
     auto slot = mNumReqs++;
     io_prep_fsync(&mIocbs[slot], fd);
   }
 
+  //! Submits the prepared requests. Also fails if a request could not be prepared because the
+  //! io_uring submission queue had no free entry, the other requests are submitted nevertheless.
   Result<uint64_t> SubmitAll() {
+    if (mBackend == kIoUring) {
+      int ret = IsEmpty() ? 0 : io_uring_submit(&mRing);
+      if (ret < 0) {
+        return std::unexpected(utils::Error::ErrorAio(
+            ret, std::format("io_uring_submit({}, {})", (void*)&mRing, mNumReqs)));
+      }
+      mNumInflight += ret;
+      if (mPrepareError) {
+        auto error = std::move(*mPrepareError);
+        mPrepareError.reset();
+        return std::unexpected(std::move(error));
+      }
+      return ret;
+    }
+
     if (IsEmpty()) {
       return 0;
     }
@@ -96,26 +268,79 @@ public:
   }
 
   Result<uint64_t> WaitAll(timespec* timeout = nullptr) {
+    return waitAll(timeout, true);
+  }
+
+  //! Like WaitAll(), but a failed request is only reported by its completion result, as with
+  //! PollAll(), so that the caller can handle every request on its own. Only fails if waiting for
+  //! the completions fails.
+  Result<uint64_t> WaitAllCompletions(timespec* timeout = nullptr) {
+    return waitAll(timeout, false);
+  }
+
+  //! Reaps the completed requests without blocking. Returns true once all the submitted requests
+  //! have completed, the completions are then available like after WaitAll(). Unlike WaitAll(), a
+  //! failed request is only reported by its completion result.
+  Result<bool> PollAll() {
     if (IsEmpty()) {
-      return 0;
+      return true;
     }
 
-    int ret = io_getevents(mAioCtx, mNumReqs, mNumReqs, &mIoEvents[0], timeout);
-    if (ret < 0) {
-      return std::unexpected(utils::Error::ErrorAio(ret, "io_getevents"));
+    if (mBackend == kIoUring) {
+      io_uring_cqe* cqe = nullptr;
+      unsigned head;
+      unsigned numReaped = 0;
+      io_uring_for_each_cqe(&mRing, head, cqe) {
+        if (mNumPolled + numReaped < mCompletions.size()) {
+          mCompletions[mNumPolled + numReaped] = {io_uring_cqe_get_data(cqe), cqe->res};
+        }
+        numReaped++;
+      }
+      io_uring_cq_advance(&mRing, numReaped);
+      mNumPolled += numReaped;
+      mNumInflight -= std::min<size_t>(numReaped, mNumInflight);
+    } else {
+      timespec noWait{0, 0};
+      int ret = io_getevents(mAioCtx, 0, mNumReqs - mNumPolled, &mIoEvents[mNumPolled], &noWait);
+      if (ret < 0) {
+        return std::unexpected(utils::Error::ErrorAio(ret, "io_getevents"));
+      }
+      mNumPolled += ret;
+    }
+
+    if (mNumPolled < mNumReqs) {
+      return false;
     }
 
     // reset pending requests, allowing new writes
+    mNumPolled = 0;
     mNumReqs = 0;
-
-    // return requests completed
-    return ret;
+    return true;
   }
 
+  //! The libaio event of the i-th completed request in the last WaitAll().
+  //! REQUIRES: the libaio backend.
   const io_event* GetIoEvent(size_t i) const {
+    LS_DCHECK(mBackend == kLibaio);
     return &mIoEvents[i];
   }
 
+  //! The buffer of the i-th completed request in the last WaitAll(), nullptr for fsync.
+  void* GetCompletedData(size_t i) const {
+    if (mBackend == kIoUring) {
+      return mCompletions[i].mData;
+    }
+    return mIoEvents[i].data;
+  }
+
+  //! Bytes transferred by the i-th completed request in the last WaitAll(), or the negative errno.
+  int64_t GetCompletedResult(size_t i) const {
+    if (mBackend == kIoUring) {
+      return mCompletions[i].mResult;
+    }
+    return static_cast<int64_t>(mIoEvents[i].res);
+  }
+
   Result<int32_t> Create4DirectIo(const char* file) {
     int flags = O_TRUNC | O_CREAT | O_RDWR | O_DIRECT;
     auto fd = open(file, flags, 0666);
@@ -126,12 +351,151 @@ public:
   }
 
 private:
+  //! Returns a free io_uring submission queue entry. When the queue is full the pending entries
+  //! are submitted to make room. Returns nullptr if there is still none, the error is then
+  //! reported by the next SubmitAll().
+  io_uring_sqe* getSqe() {
+    auto* sqe = io_uring_get_sqe(&mRing);
+    if (sqe != nullptr) {
+      return sqe;
+    }
+
+    auto ret = io_uring_submit(&mRing);
+    if (ret > 0) {
+      mNumInflight += ret;
+    }
+    sqe = io_uring_get_sqe(&mRing);
+    if (sqe == nullptr && !mPrepareError) {
+      mPrepareError = utils::Error::ErrorAio(ret < 0 ? ret : -EBUSY, "io_uring_get_sqe");
+    }
+    return sqe;
+  }
+
+  Result<uint64_t> waitAll(timespec* timeout, bool failOnRequestError) {
+    if (IsEmpty()) {
+      return 0;
+    }
+
+    if (mBackend == kIoUring) {
+      return waitAllIoUring(timeout, failOnRequestError);
+    }
+
+    int ret = io_getevents(mAioCtx, mNumReqs, mNumReqs, &mIoEvents[0], timeout);
+    if (ret < 0) {
+      return std::unexpected(utils::Error::ErrorAio(ret, "io_getevents"));
+    }
+
+    // reset pending requests, allowing new writes
+    mNumReqs = 0;
+
+    // return requests completed
+    return ret;
+  }
+
+  //! Index of the fixed buffer containing [buf, buf+count), -1 if there is none.
+  int fixedBufferIndex(const void* buf, size_t count) const {
+    auto* begin = reinterpret_cast<const uint8_t*>(buf);
+    for (size_t i = 0; i < mFixedBuffers.size(); i++) {
+      auto* base = reinterpret_cast<const uint8_t*>(mFixedBuffers[i].iov_base);
+      if (base <= begin && begin + count <= base + mFixedBuffers[i].iov_len) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  //! Replaces the fd of the prepared request with its fixed file index if it is registered.
+  void prepareFixedFile(io_uring_sqe* sqe, int32_t fd) {
+    for (size_t i = 0; i < mFixedFds.size(); i++) {
+      if (mFixedFds[i] == fd) {
+        sqe->fd = i;
+        sqe->flags |= IOSQE_FIXED_FILE;
+        return;
+      }
+    }
+  }
+
+  Result<uint64_t> waitAllIoUring(timespec* timeout, bool failOnRequestError) {
+    __kernel_timespec kernelTimeout;
+    if (timeout != nullptr) {
+      kernelTimeout.tv_sec = timeout->tv_sec;
+      kernelTimeout.tv_nsec = timeout->tv_nsec;
+    }
+
+    // completions of requests timed out in the previous round are reaped first and counted in
+    // this round, the completion queue is as large as twice the submission queue
+    uint64_t numDone = 0;
+    int failed = 0;
+    while (numDone < mNumInflight) {
+      io_uring_cqe* cqe = nullptr;
+      auto ret = timeout == nullptr ? io_uring_wait_cqe(&mRing, &cqe)
+                                    : io_uring_wait_cqe_timeout(&mRing, &cqe, &kernelTimeout);
+      if (ret == -ETIME) {
+        break;
+      }
+      if (ret < 0) {
+        return std::unexpected(utils::Error::ErrorAio(ret, "io_uring_wait_cqe"));
+      }
+
+      unsigned head;
+      unsigned numReaped = 0;
+      io_uring_for_each_cqe(&mRing, head, cqe) {
+        if (cqe->res < 0 && failed == 0) {
+          failed = cqe->res;
+        }
+        if (numDone + numReaped < mCompletions.size()) {
+          mCompletions[numDone + numReaped] = {io_uring_cqe_get_data(cqe), cqe->res};
+        }
+        numReaped++;
+      }
+      io_uring_cq_advance(&mRing, numReaped);
+      numDone += numReaped;
+    }
+
+    // reset pending requests, allowing new writes
+    mNumInflight -= std::min(numDone, mNumInflight);
+    mNumReqs = 0;
+
+    if (failOnRequestError && failed < 0) {
+      return std::unexpected(utils::Error::ErrorAio(failed, "io_uring_cqe"));
+    }
+
+    // return requests completed
+    return std::min<uint64_t>(numDone, mCompletions.size());
+  }
+
+  IoBackend mBackend;
   size_t mMaxReqs;
   size_t mNumReqs;
+
+  //! Number of io_uring requests submitted but not reaped yet.
+  size_t mNumInflight;
+
+  //! Number of requests reaped by PollAll() since the last time all of them completed.
+  size_t mNumPolled;
+
+  // libaio
   io_context_t mAioCtx;
   std::vector<iocb> mIocbs;
   std::vector<iocb*> mIocbPtrs;
   std::vector<io_event> mIoEvents;
+
+  // io_uring
+  struct Completion {
+    void* mData;
+    int64_t mResult;
+  };
+
+  io_uring mRing;
+  std::vector<Completion> mCompletions;
+  std::vector<iovec> mFixedBuffers;
+  std::vector<int32_t> mFixedFds;
+
+  //! The eventfd signaled on completions, -1 if not set.
+  int32_t mEventFd = -1;
+
+  //! Set when a request could not be prepared, returned by the next SubmitAll().
+  std::optional<utils::Error> mPrepareError;
 };
 
-} // namespace leanstore::utils
\ No newline at end of file
+} // namespace leanstore::utils
@@ -2,14 +2,98 @@
 
 #include "leanstore/leanstore-c/PerfCounters.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
 #ifdef ENABLE_PERF_COUNTERS
 #include <chrono>
 #endif
 
 namespace leanstore {
 
+//! The latest sampled leanstore-c API calls of a thread. Written by the thread itself, read by
+//! others without locking, each slot is guarded by a sequence number like a seqlock.
+class PerfOpTraceRing {
+public:
+  //! Number of traces kept.
+  static constexpr uint64_t kCapacity = 64;
+
+  //! One of every kSampleInterval calls is traced.
+  static constexpr uint64_t kSampleInterval = 64;
+
+private:
+  static constexpr uint64_t kNumFields = sizeof(PerfOpTrace) / sizeof(uint64_t);
+
+  static_assert(sizeof(PerfOpTrace) % sizeof(uint64_t) == 0);
+
+  using Fields = std::array<uint64_t, kNumFields>;
+
+  struct Slot {
+    //! Odd while the slot is being written.
+    std::atomic<uint64_t> mSeq = 0;
+
+    std::atomic<uint64_t> mFields[kNumFields] = {};
+  };
+
+  //! Number of calls seen by ShouldSample(), only accessed by the owner thread.
+  uint64_t mNumCalls = 0;
+
+  //! Number of traces ever recorded.
+  std::atomic<uint64_t> mNumTraces = 0;
+
+  Slot mSlots[kCapacity];
+
+public:
+  //! Whether the current call should be traced.
+  bool ShouldSample() {
+    return mNumCalls++ % kSampleInterval == 0;
+  }
+
+  //! Records a trace, overwrites the oldest one if the ring is full. Called by the owner thread.
+  void Record(const PerfOpTrace& trace) {
+    auto numTraces = mNumTraces.load(std::memory_order_relaxed);
+    auto& slot = mSlots[numTraces % kCapacity];
+    auto seq = slot.mSeq.load(std::memory_order_relaxed);
+    slot.mSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto fields = std::bit_cast<Fields>(trace);
+    for (uint64_t i = 0; i < kNumFields; i++) {
+      slot.mFields[i].store(fields[i], std::memory_order_relaxed);
+    }
+    slot.mSeq.store(seq + 2, std::memory_order_release);
+    mNumTraces.store(numTraces + 1, std::memory_order_release);
+  }
+
+  //! Appends the recorded traces to result, those being written concurrently are skipped.
+  void Collect(std::vector<PerfOpTrace>& result) const {
+    auto numSlots = std::min(mNumTraces.load(std::memory_order_acquire), kCapacity);
+    for (uint64_t i = 0; i < numSlots; i++) {
+      auto& slot = mSlots[i];
+      auto seq = slot.mSeq.load(std::memory_order_acquire);
+      if (seq % 2 == 1) {
+        continue;
+      }
+
+      Fields fields;
+      for (uint64_t j = 0; j < kNumFields; j++) {
+        fields[j] = slot.mFields[j].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (slot.mSeq.load(std::memory_order_relaxed) == seq) {
+        result.push_back(std::bit_cast<PerfOpTrace>(fields));
+      }
+    }
+  }
+};
+
 namespace cr {
 extern thread_local PerfCounters tlsPerfCounters;
+extern thread_local PerfOpTraceRing tlsPerfOpTraces;
 } // namespace cr
 
 //! ScopedTimer for perf counters
@@ -57,6 +141,9 @@ public:
 //! Macro to inc a counter
 #define COUNTER_INC(counter) atomic_fetch_add(counter, 1);
 
+//! Macro to record a value to a histogram
+#define COUNTER_HIST_RECORD(hist, value) PerfHistRecord(hist, value);
+
 //! Macro to declare a block of code that will be executed only if counters are enabled
 #define COUNTERS_BLOCK() if constexpr (true)
 
@@ -68,6 +155,7 @@ public:
 
 #define COUNTER_TIMER_SCOPED(counter)
 #define COUNTER_INC(counter)
+#define COUNTER_HIST_RECORD(hist, value)
 #define COUNTERS_BLOCK() if constexpr (false)
 
 #endif
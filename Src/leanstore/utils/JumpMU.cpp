@@ -1,7 +1,10 @@
 #include "leanstore/utils/JumpMU.hpp"
 
+#include "leanstore/utils/CounterUtil.hpp"
 #include "leanstore/utils/Log.hpp"
 
+#include <cstring>
+
 namespace jumpmu {
 
 __thread int tlsNumJumpPoints = 0;
@@ -27,6 +30,9 @@ void Jump() {
   }
 
   // Jump to the preset jump point
+  COUNTERS_BLOCK() {
+    PerfCounterAddLocal(&leanstore::cr::tlsPerfCounters.mJumps, 1);
+  }
   auto& jumpPoint = jumpmu::tlsJumpPoints[jumpmu::tlsNumJumpPoints - 1];
   LS_DLOG("Jump to jump point {} ({} stack objects, {} jump stack objects)",
           jumpmu::tlsNumJumpPoints - 1, jumpmu::tlsNumStackObjs,
@@ -35,4 +41,29 @@ void Jump() {
   longjmp(jumpPoint, 1);
 }
 
+void SaveContext(JumpContext& ctx) {
+  ctx.mNumJumpPoints = tlsNumJumpPoints;
+  std::memcpy(ctx.mJumpPoints, tlsJumpPoints, sizeof(jmp_buf) * tlsNumJumpPoints);
+  std::memcpy(ctx.mJumpPointNumStackObjs, tlsJumpPointNumStackObjs, sizeof(int) * tlsNumJumpPoints);
+  ctx.mNumStackObjs = tlsNumStackObjs;
+  std::memcpy(ctx.mObjs, tlsObjs, sizeof(void*) * tlsNumStackObjs);
+  std::memcpy(ctx.mObjDtors, tlsObjDtors, sizeof(tlsObjDtors[0]) * tlsNumStackObjs);
+  tlsNumJumpPoints = 0;
+  tlsNumStackObjs = 0;
+}
+
+void RestoreContext(JumpContext& ctx) {
+  LS_DCHECK(tlsNumJumpPoints == 0, "tlsNumJumpPoints={}", tlsNumJumpPoints);
+  LS_DCHECK(tlsNumStackObjs == 0, "tlsNumStackObjs={}", tlsNumStackObjs);
+  tlsNumJumpPoints = ctx.mNumJumpPoints;
+  std::memcpy(tlsJumpPoints, ctx.mJumpPoints, sizeof(jmp_buf) * ctx.mNumJumpPoints);
+  std::memcpy(tlsJumpPointNumStackObjs, ctx.mJumpPointNumStackObjs,
+              sizeof(int) * ctx.mNumJumpPoints);
+  tlsNumStackObjs = ctx.mNumStackObjs;
+  std::memcpy(tlsObjs, ctx.mObjs, sizeof(void*) * ctx.mNumStackObjs);
+  std::memcpy(tlsObjDtors, ctx.mObjDtors, sizeof(tlsObjDtors[0]) * ctx.mNumStackObjs);
+  ctx.mNumJumpPoints = 0;
+  ctx.mNumStackObjs = 0;
+}
+
 } // namespace jumpmu
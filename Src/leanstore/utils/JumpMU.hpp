@@ -20,6 +20,26 @@ extern __thread void (*tlsObjDtors[JUMPMU_STACK_OBJECTS_LIMIT])(void*);
 
 void Jump();
 
+//! The jump points and stack objects of a job parked in the middle of its execution. They refer to
+//! the stack of the job, which is kept until the job is resumed.
+struct JumpContext {
+  int mNumJumpPoints = 0;
+  jmp_buf mJumpPoints[JUMPMU_STACK_SIZE];
+  int mJumpPointNumStackObjs[JUMPMU_STACK_SIZE];
+
+  int mNumStackObjs = 0;
+  void* mObjs[JUMPMU_STACK_OBJECTS_LIMIT];
+  void (*mObjDtors[JUMPMU_STACK_OBJECTS_LIMIT])(void*);
+};
+
+//! Moves the jump points and stack objects of the current thread to ctx, the thread is left with
+//! none of them.
+void SaveContext(JumpContext& ctx);
+
+//! Moves the jump points and stack objects saved by SaveContext() back to the current thread.
+//! REQUIRES: the current thread has no jump point or stack object.
+void RestoreContext(JumpContext& ctx);
+
 inline void PopBackDestructor() {
   assert(tlsNumStackObjs > 0);
 
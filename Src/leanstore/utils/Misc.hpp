@@ -5,6 +5,8 @@
 
 #include <chrono>
 #include <cmath>
+#include <string>
+#include <vector>
 
 namespace leanstore {
 
@@ -126,6 +128,33 @@ inline std::string StringToHex(const std::string& input) {
   return ToHex((uint8_t*)input.data(), input.size());
 }
 
+//! Joins the numbers with commas, e.g. "1,2,3".
+inline std::string JoinNumbers(const std::vector<uint64_t>& numbers) {
+  std::string output;
+  for (size_t i = 0; i < numbers.size(); i++) {
+    if (i > 0) {
+      output.push_back(',');
+    }
+    output += std::to_string(numbers[i]);
+  }
+  return output;
+}
+
+//! Parses the numbers joined by JoinNumbers().
+inline std::vector<uint64_t> SplitNumbers(const std::string& input) {
+  std::vector<uint64_t> numbers;
+  size_t begin = 0;
+  while (begin < input.size()) {
+    auto end = input.find(',', begin);
+    if (end == std::string::npos) {
+      end = input.size();
+    }
+    numbers.push_back(std::stoull(input.substr(begin, end - begin)));
+    begin = end + 1;
+  }
+  return numbers;
+}
+
 template <typename T>
 std::unique_ptr<T[]> ScopedArray(size_t size) {
   return std::make_unique<T[]>(size);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "leanstore/utils/Log.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace leanstore::utils {
+
+//! The NUMA node of the thread, set when a worker thread starts, see StoreOption::mEnableNuma.
+inline thread_local uint64_t tlsNumaNode = 0;
+
+//! Parses a sysfs list like "0-3,8,10-11".
+inline std::vector<uint64_t> ParseSysfsList(const std::string& list) {
+  std::vector<uint64_t> result;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    auto dash = range.find('-');
+    uint64_t first = std::stoull(range.substr(0, dash));
+    uint64_t last = dash == std::string::npos ? first : std::stoull(range.substr(dash + 1));
+    for (auto i = first; i <= last; i++) {
+      result.push_back(i);
+    }
+  }
+  return result;
+}
+
+inline std::string ReadSysfsFile(const std::string& path) {
+  std::ifstream file(path);
+  std::string content;
+  std::getline(file, content);
+  return content;
+}
+
+//! The number of NUMA nodes of the machine, 1 if it's not a NUMA machine.
+inline uint64_t NumNumaNodes() {
+  auto nodes = ParseSysfsList(ReadSysfsFile("/sys/devices/system/node/online"));
+  return nodes.empty() ? 1 : nodes.back() + 1;
+}
+
+//! The NUMA node of the CPU the calling thread is running on.
+inline uint64_t CurrentNumaNode() {
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return 0;
+  }
+  return node;
+}
+
+//! Binds the memory range to the NUMA node, the range is shrunk to the boundaries of the memory
+//! pages of pageSize backing it. Should be called before the memory is touched.
+inline bool BindToNumaNode(void* addr, uint64_t size, uint64_t node, uint64_t pageSize) {
+  auto begin = (reinterpret_cast<uint64_t>(addr) + pageSize - 1) & ~(pageSize - 1);
+  auto end = (reinterpret_cast<uint64_t>(addr) + size) & ~(pageSize - 1);
+  if (begin >= end) {
+    return true;
+  }
+  unsigned long nodeMask = 1ul << node;
+  if (syscall(SYS_mbind, begin, end - begin, MPOL_BIND, &nodeMask, sizeof(nodeMask) * 8, 0) != 0) {
+    Log::Warn("Failed to bind memory to NUMA node, node={}, size={}, errno={}", node,
+              end - begin, errno);
+    return false;
+  }
+  return true;
+}
+
+//! Pins the calling thread to all the CPUs of the NUMA node.
+inline void PinThisThreadToNumaNode(uint64_t node) {
+  auto cpus = ParseSysfsList(
+      ReadSysfsFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"));
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &cpuset);
+  }
+  if (cpus.empty() || pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0) {
+    Log::Warn("Could not pin a thread to NUMA node {}", node);
+  }
+}
+
+} // namespace leanstore::utils
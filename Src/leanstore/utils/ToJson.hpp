@@ -18,6 +18,8 @@ const char kTxId[] = "mTxId";
 const char kWorkerId[] = "mWorkerId";
 const char kPrevLsn[] = "mPrevLsn";
 const char kPsn[] = "mPsn";
+const char kGsn[] = "mGsn";
+const char kPrevGsn[] = "mPrevGsn";
 const char kTreeId[] = "mTreeId";
 const char kPageId[] = "mPageId";
 
@@ -136,6 +138,20 @@ inline void ToJson(const leanstore::cr::WalEntryComplex* obj, rapidjson::Documen
     doc->AddMember(kPsn, member, doc->GetAllocator());
   }
 
+  // gsn
+  {
+    rapidjson::Value member;
+    member.SetUint64(obj->mGsn);
+    doc->AddMember(kGsn, member, doc->GetAllocator());
+  }
+
+  // prevGsn
+  {
+    rapidjson::Value member;
+    member.SetUint64(obj->mPrevGsn);
+    doc->AddMember(kPrevGsn, member, doc->GetAllocator());
+  }
+
   // treeId
   {
     rapidjson::Value member;
@@ -10,6 +10,7 @@
 #include <thread>
 
 #include <pthread.h>
+#include <time.h>
 
 namespace leanstore {
 
@@ -72,6 +73,17 @@ public:
     return mThread != nullptr && mThread->joinable();
   }
 
+  //! CPU time (nanoseconds) consumed by the thread so far, 0 if it's not started.
+  uint64_t CpuTimeNs() {
+    clockid_t clockId;
+    timespec ts;
+    if (!IsStarted() || pthread_getcpuclockid(mThread->native_handle(), &clockId) != 0 ||
+        clock_gettime(clockId, &ts) != 0) {
+      return 0;
+    }
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+
 protected:
   void run() {
     tlsStore = mStore;
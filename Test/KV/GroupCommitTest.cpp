@@ -0,0 +1,90 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KV/Include/Options.h"
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Db.h"
+
+using namespace atendb;
+
+static const int32_t kThreads = 8;
+static const int32_t kKeysPerThread = 500;
+
+std::string make_key(int32_t t, int32_t i) {
+  return "key-" + std::to_string(t) + "-" + std::to_string(i);
+}
+
+std::string make_value(int32_t t, int32_t i) {
+  return std::string(64 + (i % 128), 'a' + (t % 26)) + std::to_string(i);
+}
+
+int main() {
+  Options opts;
+  opts.comparator_ = new BytewiseComparator();
+  opts.group_commit_ = true;
+  opts.sync_policy_ = kSyncEveryBatch;
+  std::string db_name = "group_commit_data";
+  std::atomic<bool> passed = true;
+
+  DB* db;
+  if (!DB::Open(db_name, opts, &db)) {
+    std::cout << "Open failed." << std::endl;
+    return 1;
+  }
+
+  std::vector<std::thread> writers;
+  for (int32_t t = 0; t < kThreads; t++) {
+    writers.emplace_back([db, t, &passed]() {
+      for (int32_t i = 0; i < kKeysPerThread; i++) {
+        if (!db->Put(make_key(t, i), make_value(t, i))) {
+          std::cout << "Write failed." << make_key(t, i) << std::endl;
+          passed = false;
+        }
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+
+  for (int32_t t = 0; t < kThreads; t++) {
+    for (int32_t i = 0; i < kKeysPerThread; i++) {
+      std::string read_value;
+      auto s = db->Get(make_key(t, i), &read_value);
+      if (!s || read_value != make_value(t, i)) {
+        std::cout << "Read value failed: " << make_key(t, i) << std::endl;
+        passed = false;
+      }
+    }
+  }
+  delete db;
+
+  // Everything written by the batches must be found again after recovery.
+  opts.sync_policy_ = kSyncInterval;
+  opts.sync_interval_ms_ = 10;
+  DB* reopen_db;
+  DB::Open(db_name, opts, &reopen_db);
+  for (int32_t t = 0; t < kThreads; t++) {
+    for (int32_t i = 0; i < kKeysPerThread; i++) {
+      std::string read_value;
+      auto s = reopen_db->Get(make_key(t, i), &read_value);
+      if (!s || read_value != make_value(t, i)) {
+        std::cout << "Reread value failed: " << make_key(t, i) << std::endl;
+        passed = false;
+      }
+    }
+  }
+  delete reopen_db;
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout<< "Test passed!" << std::endl;
+
+  return 0;
+}
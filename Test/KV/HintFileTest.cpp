@@ -0,0 +1,115 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include <map>
+
+#include "KV/Include/Options.h"
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Db.h"
+
+using namespace atendb;
+
+bool check_db(DB* db,
+              const std::map<std::string, std::string>& kvs,
+              const std::map<std::string, std::string>& deleted) {
+  bool passed = true;
+  for (auto it = kvs.begin(); it != kvs.end(); ++it) {
+    std::string read_value;
+    auto s = db->Get(it->first, &read_value);
+    if (!s || it->second != read_value) {
+      std::cout << "Reread value failed: " << it->first << std::endl;
+      passed = false;
+    }
+  }
+  for (auto it = deleted.begin(); it != deleted.end(); ++it) {
+    std::string read_value;
+    if (db->Get(it->first, &read_value)) {
+      std::cout << "Deleted key is back: " << it->first << std::endl;
+      passed = false;
+    }
+  }
+  return passed;
+}
+
+bool recovered_from_hint(DB* db) {
+  std::string stats;
+  db->GetProperty("atendb.recovery-stats", &stats);
+  std::cout << stats;
+  return stats.find("from_hint: yes") != std::string::npos;
+}
+
+int main() {
+  Options opts;
+  opts.comparator_ = new BytewiseComparator();
+  opts.use_hint_file_ = true;
+  std::string db_name = "hint_data";
+  std::map<std::string, std::string> kvs, deleted;
+  bool passed = true;
+
+  DB* db;
+  DB::Open(db_name, opts, &db);
+  for (int32_t i = 0; i < 5000; i++) {
+    std::string key = "key" + std::to_string(i);
+    kvs[key] = "value" + std::to_string(i);
+    db->Put(key, kvs[key]);
+  }
+  for (int32_t i = 0; i < 5000; i += 7) {
+    std::string key = "key" + std::to_string(i);
+    db->Delete(key);
+    deleted[key] = kvs[key];
+    kvs.erase(key);
+  }
+  // Closing writes the hint file.
+  delete db;
+
+  DB::Open(db_name, opts, &db);
+  passed &= recovered_from_hint(db);
+  passed &= check_db(db, kvs, deleted);
+  delete db;
+
+  // Writes and deletes after the snapshot are replayed from the index files when the
+  // database goes away without refreshing the hint.
+  opts.use_hint_file_ = false;
+  DB::Open(db_name, opts, &db);
+  for (int32_t i = 5000; i < 6000; i++) {
+    std::string key = "key" + std::to_string(i);
+    kvs[key] = "value" + std::to_string(i);
+    db->Put(key, kvs[key]);
+  }
+  for (int32_t i = 1; i < 6000; i += 11) {
+    std::string key = "key" + std::to_string(i);
+    if (kvs.erase(key) > 0) {
+      db->Delete(key);
+      deleted[key] = "";
+    }
+  }
+  delete db;
+
+  opts.use_hint_file_ = true;
+  DB::Open(db_name, opts, &db);
+  passed &= recovered_from_hint(db);
+  passed &= check_db(db, kvs, deleted);
+  delete db;
+
+  // A corrupt hint file is ignored, the deletes are replayed from the index
+  // files.
+  std::string hint_file = db_name + "/HINT";
+  int fd = ::open(hint_file.c_str(), O_WRONLY);
+  char garbage = 0x5a;
+  pwrite(fd, &garbage, 1, 200);
+  ::close(fd);
+  DB::Open(db_name, opts, &db);
+  passed &= !recovered_from_hint(db);
+  passed &= check_db(db, kvs, deleted);
+  delete db;
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout<< "Test passed!" << std::endl;
+
+  return 0;
+}
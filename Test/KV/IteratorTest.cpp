@@ -0,0 +1,89 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <iostream>
+#include <string>
+#include <map>
+
+#include "KV/Include/Options.h"
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Db.h"
+
+using namespace atendb;
+
+// Walk "it" and compare it with the expected [begin, end) range of kvs.
+bool check_range(Iterator* it,
+                 std::map<std::string, std::string>::iterator begin,
+                 std::map<std::string, std::string>::iterator end) {
+  for (auto expect = begin; expect != end; ++expect, it->Next()) {
+    if (!it->Valid() || it->key() != expect->first ||
+        it->value() != expect->second) {
+      std::cout << "Scan mismatch at: " << expect->first << std::endl;
+      return false;
+    }
+  }
+  if (it->Valid()) {
+    std::cout << "Scan did not end: " << it->key() << std::endl;
+    return false;
+  }
+  if (!it->ok()) {
+    std::cout << "Scan read failed." << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  Options opts;
+  opts.comparator_ = new BytewiseComparator();
+  std::string db_name = "iterator_data";
+  bool passed = true;
+
+  DB* db;
+  DB::Open(db_name, opts, &db);
+  std::map<std::string, std::string> kvs;
+  for (int32_t i = 0; i < 2000; i++) {
+    std::string key = (i % 2 ? "user:" : "item:") + std::to_string(i * 7919 % 2000);
+    std::string value = "value-" + std::to_string(i);
+    db->Put(key, value);
+    kvs[key] = value;
+  }
+  // Overwrites and deletes must be resolved by the scan.
+  for (int32_t i = 0; i < 2000; i += 3) {
+    std::string key = "user:" + std::to_string(i);
+    if (kvs.count(key)) {
+      db->Put(key, "new-" + key);
+      kvs[key] = "new-" + key;
+    }
+  }
+  for (int32_t i = 0; i < 2000; i += 5) {
+    std::string key = "item:" + std::to_string(i);
+    if (kvs.count(key)) {
+      db->Delete(key);
+      kvs.erase(key);
+    }
+  }
+
+  ReadOptions read_options;
+  read_options.batch_size_ = 64;
+  Iterator* it = db->NewIterator(read_options);
+  it->SeekToFirst();
+  passed &= check_range(it, kvs.begin(), kvs.end());
+
+  it->Seek("user:5");
+  passed &= check_range(it, kvs.lower_bound("user:5"), kvs.end());
+  delete it;
+
+  read_options.prefix_ = "item:";
+  it = db->NewIterator(read_options);
+  it->SeekToFirst();
+  passed &= check_range(it, kvs.lower_bound("item:"), kvs.lower_bound("user:"));
+  delete it;
+  delete db;
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout<< "Test passed!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "KV/Include/Skiplist.h"
+
+using namespace atendb;
+
+struct Entry {
+  Entry() : key(0), value(0) { }
+  Entry(uint64_t k, uint64_t v) : key(k), value(v) { }
+
+  uint64_t key;
+  uint64_t value;
+};
+
+struct EntryComparator {
+  int operator()(const Entry& a, const Entry& b) const {
+    if (a.key < b.key) {
+      return -1;
+    }
+    return a.key > b.key ? 1 : 0;
+  }
+};
+
+typedef SkipList<Entry, EntryComparator> List;
+
+static const uint64_t kOverwrites = 1000000;
+
+// Overwriting one key must not grow the arena, "usage" is taken after the
+// first overwrites.
+bool check_flat(const char* name, size_t usage, const List& list) {
+  if (list.MemoryUsage() != usage) {
+    std::cout << name << ": memory grew from " << usage << " to "
+              << list.MemoryUsage() << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool check_value(const char* name, const List& list, uint64_t expect) {
+  Entry result;
+  if (!list.Get(Entry(7, 0), &result) || result.value != expect) {
+    std::cout << name << ": unexpected value " << result.value << std::endl;
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  bool passed = true;
+
+  {
+    List list(EntryComparator{});
+    list.Insert(Entry(7, 0));
+    size_t usage = list.MemoryUsage();
+    for (uint64_t i = 1; i <= kOverwrites; i++) {
+      list.Insert(Entry(7, i));
+    }
+    passed &= check_flat("Insert", usage, list);
+    passed &= check_value("Insert", list, kOverwrites);
+  }
+
+  {
+    List list(EntryComparator{});
+    for (uint64_t i = 0; i < 4; i++) {
+      list.InsertConcurrently(Entry(7, i));
+    }
+    size_t usage = list.MemoryUsage();
+    for (uint64_t i = 4; i <= kOverwrites; i++) {
+      list.InsertConcurrently(Entry(7, i));
+    }
+    passed &= check_flat("InsertConcurrently", usage, list);
+    passed &= check_value("InsertConcurrently", list, kOverwrites);
+
+    // A pinned iterator keeps its entry, and the entries retired while it
+    // is alive are reused once it is gone.
+    {
+      List::Iterator it(&list);
+      it.SeekToFirst();
+      const Entry& held = it.key();
+      for (uint64_t i = 0; i < 1000; i++) {
+        list.InsertConcurrently(Entry(7, kOverwrites + 1 + i));
+      }
+      if (held.value != kOverwrites || it.key().value != kOverwrites + 1000) {
+        std::cout << "Entry held by an iterator was reused" << std::endl;
+        passed = false;
+      }
+    }
+    usage = list.MemoryUsage();
+    for (uint64_t i = 0; i < kOverwrites; i++) {
+      list.InsertConcurrently(Entry(7, i));
+    }
+    passed &= check_flat("InsertConcurrently after iterator", usage, list);
+  }
+
+  {
+    // Readers and writers racing on the same key.
+    List list(EntryComparator{});
+    list.InsertConcurrently(Entry(7, 0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&list, t]() {
+        for (uint64_t i = 0; i < kOverwrites / 4; i++) {
+          list.InsertConcurrently(Entry(7, i * 4 + t));
+        }
+      });
+      threads.emplace_back([&list, &passed]() {
+        Entry result;
+        for (uint64_t i = 0; i < kOverwrites / 4; i++) {
+          if (!list.Get(Entry(7, 0), &result) || result.key != 7) {
+            passed = false;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // Entries retired while readers were pinned are reused afterwards.
+    size_t usage = list.MemoryUsage();
+    for (uint64_t i = 0; i < kOverwrites; i++) {
+      list.InsertConcurrently(Entry(7, i));
+    }
+    passed &= check_flat("Concurrent readers", usage, list);
+  }
+
+  if (!passed) {
+    return 1;
+  }
+  std::cout<< "Test passed!" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,236 @@
+#include "Bitcask.h"
+
+#include <thread>
+
+static const string kDataDir = "./BitcaskTest/";
+
+static void reset_data_dir() {
+	mkdir(kDataDir.c_str(), 0755);
+	DIR *dir = opendir(kDataDir.c_str());
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL) {
+		string name = ent->d_name;
+		if (name != "." && name != "..") {
+			remove((kDataDir + name).c_str());
+		}
+	}
+	closedir(dir);
+}
+
+static void init_store(KvStore &kv_store) {
+	kv_store.m_data_dir = kDataDir;
+	kv_store.m_max_file_bytes = 16 << 10;
+}
+
+static string make_key(int i) {
+	return "key" + to_string(i);
+}
+
+static string make_value(int i, int version) {
+	return make_key(i) + ":" + to_string(version) + ":" + string(64, 'v');
+}
+
+static bool check_store(KvStore &kv_store, const map<string, string> &kvs,
+		const map<string, string> &deleted) {
+	bool passed = true;
+	for (auto &item : kvs) {
+		string value;
+		if (kv_store.get(item.first, value) != 0 || value != item.second) {
+			cout << "Reread value failed: " << item.first << endl;
+			passed = false;
+		}
+	}
+	for (auto &item : deleted) {
+		string value;
+		if (kv_store.get(item.first, value) == 0) {
+			cout << "Deleted key is back: " << item.first << endl;
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+// 覆盖和删除之后compaction, 压缩前后以及重启后读到的数据一致
+bool test_compaction() {
+	reset_data_dir();
+	map<string, string> kvs, deleted;
+	bool passed = true;
+
+	KvStore kv_store;
+	init_store(kv_store);
+	kv_store.open();
+	for (int i = 0; i < 2000; i++) {
+		kvs[make_key(i)] = make_value(i, 0);
+		kv_store.set_no_compaction(make_key(i), kvs[make_key(i)]);
+	}
+	for (int i = 0; i < 2000; i += 2) {
+		kvs[make_key(i)] = make_value(i, 1);
+		kv_store.set_no_compaction(make_key(i), kvs[make_key(i)]);
+	}
+	for (int i = 1; i < 2000; i += 6) {
+		kv_store.rm(make_key(i));
+		deleted[make_key(i)] = kvs[make_key(i)];
+		kvs.erase(make_key(i));
+	}
+	// 再写一批, 让删除标记所在的文件也不再是活跃文件
+	for (int i = 2000; i < 2500; i++) {
+		kvs[make_key(i)] = make_value(i, 0);
+		kv_store.set_no_compaction(make_key(i), kvs[make_key(i)]);
+	}
+
+	if (kv_store.compaction() == 0) {
+		cout << "Nothing was compacted" << endl;
+		passed = false;
+	}
+	passed &= check_store(kv_store, kvs, deleted);
+	for (auto &item : kv_store.fileStats()) {
+		double ratio = (double) item.second.dead_bytes
+				/ (item.second.live_bytes + item.second.dead_bytes + 1);
+		if (item.first != kv_store.m_cur_file.m_file_name
+				&& ratio >= kv_store.m_compaction_dead_ratio) {
+			cout << "File left uncompacted: " << item.first << endl;
+			passed = false;
+		}
+	}
+	kv_store.printStats();
+	kv_store.close();
+
+	KvStore reopened;
+	init_store(reopened);
+	reopened.open();
+	passed &= check_store(reopened, kvs, deleted);
+	reopened.close();
+	return passed;
+}
+
+// 只剩删除标记的文件在没有更旧的文件后被删除
+bool test_tombstone_file_deleted() {
+	reset_data_dir();
+	map<string, string> kvs, deleted;
+	bool passed = true;
+
+	KvStore kv_store;
+	init_store(kv_store);
+	kv_store.open();
+	for (int i = 0; i < 500; i++) {
+		kv_store.set_no_compaction(make_key(i), make_value(i, 0));
+	}
+	for (int i = 0; i < 500; i++) {
+		kv_store.rm(make_key(i));
+		deleted[make_key(i)] = "";
+	}
+	for (int i = 500; i < 1000; i++) {
+		kvs[make_key(i)] = make_value(i, 0);
+		kv_store.set_no_compaction(make_key(i), kvs[make_key(i)]);
+	}
+	size_t files_before = kv_store.fileStats().size();
+
+	kv_store.compaction();
+	CompactionStats stats = kv_store.compactionStats();
+	size_t files_after = kv_store.fileStats().size();
+	if (stats.deleted_files == 0
+			|| files_after != files_before - stats.deleted_files) {
+		cout << "Files were not deleted, before:" << files_before << " after:"
+				<< files_after << " deleted_files:" << stats.deleted_files
+				<< endl;
+		passed = false;
+	}
+	for (auto &item : kv_store.fileStats()) {
+		if (item.first != kv_store.m_cur_file.m_file_name
+				&& item.second.live_bytes == item.second.tombstone_bytes) {
+			cout << "Only tombstones left in: " << item.first << endl;
+			passed = false;
+		}
+	}
+	passed &= check_store(kv_store, kvs, deleted);
+	kv_store.close();
+
+	KvStore reopened;
+	init_store(reopened);
+	reopened.open();
+	if (reopened.fileStats().size() != files_after + 1) {
+		cout << "Deleted files are back" << endl;
+		passed = false;
+	}
+	passed &= check_store(reopened, kvs, deleted);
+	reopened.close();
+	return passed;
+}
+
+// 后台compaction期间并发读写
+bool test_concurrent_compaction() {
+	reset_data_dir();
+	static const int kNumKeys = 1000;
+	static const int kNumVersions = 20;
+	std::atomic<bool> passed(true);
+
+	KvStore kv_store;
+	init_store(kv_store);
+	kv_store.open();
+	for (int i = 0; i < kNumKeys; i++) {
+		kv_store.set(make_key(i), make_value(i, 0));
+	}
+
+	std::atomic<bool> writing(true);
+	std::thread writer([&]() {
+		for (int version = 1; version <= kNumVersions; version++) {
+			for (int i = 0; i < kNumKeys; i++) {
+				kv_store.set(make_key(i), make_value(i, version));
+			}
+		}
+		writing = false;
+	});
+	vector<std::thread> readers;
+	for (int t = 0; t < 2; t++) {
+		readers.push_back(std::thread([&, t]() {
+			int i = t;
+			while (writing) {
+				string value;
+				string prefix = make_key(i) + ":";
+				if (kv_store.get(make_key(i), value) != 0
+						|| value.compare(0, prefix.size(), prefix) != 0) {
+					cout << "Concurrent read failed: " << make_key(i) << endl;
+					passed = false;
+				}
+				i = (i + 7) % kNumKeys;
+			}
+		}));
+	}
+	writer.join();
+	for (auto &reader : readers) {
+		reader.join();
+	}
+
+	// 和后台compaction串行执行
+	kv_store.compaction();
+	if (kv_store.compactionStats().compacted_files == 0) {
+		cout << "Nothing was compacted" << endl;
+		passed = false;
+	}
+	map<string, string> kvs;
+	for (int i = 0; i < kNumKeys; i++) {
+		kvs[make_key(i)] = make_value(i, kNumVersions);
+	}
+	passed = passed && check_store(kv_store, kvs, map<string, string>());
+	kv_store.printStats();
+	kv_store.close();
+
+	KvStore reopened;
+	init_store(reopened);
+	reopened.open();
+	passed = passed && check_store(reopened, kvs, map<string, string>());
+	reopened.close();
+	return passed;
+}
+
+int main() {
+	bool passed = true;
+	passed &= test_compaction();
+	passed &= test_tombstone_file_deleted();
+	passed &= test_concurrent_compaction();
+	if (!passed) {
+		return 1;
+	}
+	cout << "Test passed!" << endl;
+	return 0;
+}
@@ -0,0 +1,229 @@
+#include "KeyDir.h"
+
+#include <iostream>
+#include <map>
+
+static string make_key(int i) {
+	return "key" + to_string(i);
+}
+
+static KeyDirEntry make_entry(int i, int version) {
+	KeyDirEntry entry;
+	entry.file_id = version;
+	entry.value_pos = i;
+	entry.value_length = i * 2;
+	entry.timestamp = i + version;
+	return entry;
+}
+
+static bool same_entry(const KeyDirEntry *entry, const KeyDirEntry &expected) {
+	return entry != nullptr && entry->file_id == expected.file_id
+			&& entry->value_pos == expected.value_pos
+			&& entry->value_length == expected.value_length
+			&& entry->timestamp == expected.timestamp;
+}
+
+// keydir的内容和expected一致
+static bool check_keydir(KeyDir &keydir, const map<string, KeyDirEntry> &expected) {
+	bool passed = true;
+	if (keydir.size() != expected.size()) {
+		cout << "Size mismatch: " << keydir.size() << " != " << expected.size()
+				<< endl;
+		passed = false;
+	}
+	for (auto &item : expected) {
+		if (!same_entry(keydir.find(item.first), item.second)) {
+			cout << "Find failed: " << item.first << endl;
+			passed = false;
+		}
+	}
+	size_t visited = 0;
+	keydir.forEach([&](const char *key, uint32_t key_length, KeyDirEntry &entry) {
+		auto it = expected.find(string(key, key_length));
+		if (it == expected.end() || !same_entry(&entry, it->second)) {
+			cout << "Unexpected entry: " << string(key, key_length) << endl;
+			passed = false;
+		}
+		visited++;
+	});
+	if (visited != expected.size()) {
+		cout << "forEach visited " << visited << " of " << expected.size()
+				<< endl;
+		passed = false;
+	}
+	return passed;
+}
+
+bool test_insert() {
+	KeyDir keydir;
+	map<string, KeyDirEntry> expected;
+	for (int i = 0; i < 10000; i++) {
+		expected[make_key(i)] = make_entry(i, 0);
+		keydir.set(make_key(i), make_entry(i, 0));
+	}
+	bool passed = check_keydir(keydir, expected);
+	if (keydir.find("missing") != nullptr || keydir.find("") != nullptr) {
+		cout << "Found a missing key" << endl;
+		passed = false;
+	}
+	return passed;
+}
+
+bool test_overwrite() {
+	KeyDir keydir;
+	map<string, KeyDirEntry> expected;
+	for (int i = 0; i < 10000; i++) {
+		keydir.set(make_key(i), make_entry(i, 0));
+	}
+	KeyDirMemory before = keydir.memoryUsage();
+	for (int i = 0; i < 10000; i++) {
+		expected[make_key(i)] = make_entry(i, 1);
+		keydir.set(make_key(i), make_entry(i, 1));
+	}
+	bool passed = check_keydir(keydir, expected);
+	// 覆盖不再保存一份key
+	if (keydir.memoryUsage().key_bytes != before.key_bytes) {
+		cout << "Overwrite interned the key again" << endl;
+		passed = false;
+	}
+	return passed;
+}
+
+bool test_erase() {
+	KeyDir keydir;
+	map<string, KeyDirEntry> expected;
+	for (int i = 0; i < 10000; i++) {
+		expected[make_key(i)] = make_entry(i, 0);
+		keydir.set(make_key(i), make_entry(i, 0));
+	}
+	bool passed = true;
+	for (int i = 0; i < 10000; i += 3) {
+		expected.erase(make_key(i));
+		if (!keydir.erase(make_key(i))) {
+			cout << "Erase failed: " << make_key(i) << endl;
+			passed = false;
+		}
+		if (keydir.erase(make_key(i))) {
+			cout << "Erased twice: " << make_key(i) << endl;
+			passed = false;
+		}
+	}
+	passed &= check_keydir(keydir, expected);
+	for (int i = 0; i < 10000; i += 3) {
+		if (keydir.find(make_key(i)) != nullptr) {
+			cout << "Erased key is back: " << make_key(i) << endl;
+			passed = false;
+		}
+	}
+
+	// 删除后重新插入
+	for (int i = 0; i < 10000; i += 6) {
+		expected[make_key(i)] = make_entry(i, 2);
+		keydir.set(make_key(i), make_entry(i, 2));
+	}
+	passed &= check_keydir(keydir, expected);
+	return passed;
+}
+
+bool test_resize() {
+	KeyDir keydir;
+	map<string, KeyDirEntry> expected;
+	bool passed = true;
+	uint64_t slot_bytes = keydir.memoryUsage().slot_bytes;
+	int resizes = 0;
+	for (int i = 0; i < 100000; i++) {
+		expected[make_key(i)] = make_entry(i, 0);
+		keydir.set(make_key(i), make_entry(i, 0));
+		KeyDirMemory usage = keydir.memoryUsage();
+		if (usage.slot_bytes != slot_bytes) {
+			slot_bytes = usage.slot_bytes;
+			resizes++;
+		}
+		// 负载因子不超过0.75
+		if (usage.keys * 4 > usage.slot_bytes / sizeof(uint32_t) * 3) {
+			cout << "Load factor above 0.75 at " << usage.keys << " keys" << endl;
+			passed = false;
+			break;
+		}
+	}
+	if (resizes == 0) {
+		cout << "Never resized" << endl;
+		passed = false;
+	}
+	passed &= check_keydir(keydir, expected);
+	return passed;
+}
+
+bool test_key_compaction() {
+	KeyDir keydir;
+	map<string, KeyDirEntry> expected;
+	string padding(100, 'p');
+	for (int i = 0; i < 30000; i++) {
+		keydir.set(make_key(i) + padding, make_entry(i, 0));
+	}
+	// 删除超过1MB的key, 触发key块回收
+	for (int i = 0; i < 30000; i++) {
+		if (i % 10 == 0) {
+			expected[make_key(i) + padding] = make_entry(i, 0);
+		} else {
+			keydir.erase(make_key(i) + padding);
+		}
+	}
+	bool passed = check_keydir(keydir, expected);
+	KeyDirMemory usage = keydir.memoryUsage();
+	if (usage.dead_key_bytes >= usage.key_bytes - usage.dead_key_bytes
+			&& usage.dead_key_bytes > (1 << 20)) {
+		cout << "Dead keys were not reclaimed: " << usage.dead_key_bytes << endl;
+		passed = false;
+	}
+
+	keydir.clear();
+	passed &= check_keydir(keydir, map<string, KeyDirEntry>());
+	return passed;
+}
+
+// key_ref的块号超过16位: 每个key单独占一个小块
+bool test_many_key_blocks() {
+	KeyDir keydir(32);
+	map<string, KeyDirEntry> expected;
+	string padding(20, 'p');
+	const int kKeys = 70000;
+	for (int i = 0; i < kKeys; i++) {
+		keydir.set(make_key(i) + padding, make_entry(i, 0));
+	}
+	bool passed = true;
+	if (keydir.memoryUsage().key_bytes <= (uint64_t) 32 << 16) {
+		cout << "Fewer than 65536 key blocks" << endl;
+		passed = false;
+	}
+	// 删除的key超过1MB, 回收时按key_ref读取旧块
+	for (int i = 0; i < kKeys; i++) {
+		if (i % 10 == 0) {
+			expected[make_key(i) + padding] = make_entry(i, 0);
+		} else {
+			keydir.erase(make_key(i) + padding);
+		}
+	}
+	passed &= check_keydir(keydir, expected);
+	for (int i = 0; i < kKeys; i += 10) {
+		expected[make_key(i) + padding] = make_entry(i, 1);
+		keydir.set(make_key(i) + padding, make_entry(i, 1));
+	}
+	passed &= check_keydir(keydir, expected);
+	return passed;
+}
+
+int main() {
+	bool passed = true;
+	passed &= test_insert();
+	passed &= test_overwrite();
+	passed &= test_erase();
+	passed &= test_resize();
+	passed &= test_key_compaction();
+	passed &= test_many_key_blocks();
+	if (!passed) {
+		return 1;
+	}
+	cout << "Test passed!" << endl;
+	return 0;
+}
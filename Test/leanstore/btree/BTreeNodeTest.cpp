@@ -0,0 +1,88 @@
+#include "leanstore/btree/core/BTreeNode.hpp"
+
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/RandomGenerator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace leanstore::storage::btree::test {
+
+class BTreeNodeTest : public ::testing::Test {
+protected:
+  StoreOption* mOption;
+
+  std::unique_ptr<LeanStore> mStore;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    auto storeDirStr = "/tmp/leanstore/" + curTestName;
+    mOption = CreateStoreOption(storeDirStr.c_str());
+    mOption->mCreateFromScratch = true;
+    mOption->mWorkerThreads = 1;
+    auto res = LeanStore::Open(mOption);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  //! Random keys of keySize bytes from a small alphabet, so that many of them share heads.
+  static std::vector<std::string> sortedKeys(uint64_t numKeys, uint64_t keySize) {
+    std::set<std::string> keys;
+    while (keys.size() < numKeys) {
+      std::string key(keySize, 'a');
+      for (auto& c : key) {
+        c = 'a' + utils::RandomGenerator::Rand<int>(0, 4);
+      }
+      keys.insert(key);
+    }
+    return std::vector<std::string>(keys.begin(), keys.end());
+  }
+};
+
+//! LowerBound with all the hint and head search modes agrees with std::lower_bound.
+TEST_F(BTreeNodeTest, LowerBound) {
+  mStore->ExecSync(0, [&]() {
+    utils::AlignedBuffer<512> buffer(BTreeNode::Size());
+    for (uint64_t keySize : {1, 3, 4, 8, 16}) {
+      auto* node = BTreeNode::New(buffer.Get(), true, Slice(), Slice());
+      auto keys = sortedKeys(std::min<uint64_t>(200, 1ull << (2 * keySize)), keySize);
+      std::vector<std::string> inserted;
+      for (auto& key : keys) {
+        if (!node->CanInsert(key.size(), 0)) {
+          break;
+        }
+        node->Insert(Slice(key), Slice());
+        inserted.push_back(key);
+      }
+
+      auto probes = sortedKeys(std::min<uint64_t>(400, 1ull << (2 * keySize)), keySize);
+      probes.push_back("");
+      probes.push_back(std::string(keySize + 1, 'z'));
+      for (int64_t hints : {0, 1, 2}) {
+        for (bool headOptimization : {false, true}) {
+          mOption->mBTreeHints = hints;
+          mOption->mEnableHeadOptimization = headOptimization;
+          for (auto& probe : probes) {
+            auto expected = std::lower_bound(inserted.begin(), inserted.end(), probe) -
+                            inserted.begin();
+            bool isEqual = false;
+            EXPECT_EQ(node->LowerBound<false>(Slice(probe), &isEqual), expected)
+                << "keySize=" << keySize << ", hints=" << hints << ", probe=" << probe;
+            EXPECT_EQ(isEqual, expected < static_cast<int64_t>(inserted.size()) &&
+                                   inserted[expected] == probe);
+          }
+        }
+      }
+    }
+  });
+}
+
+} // namespace leanstore::storage::btree::test
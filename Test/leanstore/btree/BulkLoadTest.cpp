@@ -0,0 +1,117 @@
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/btree/core/BTreeBulkLoader.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace leanstore::storage::btree::test {
+
+class BulkLoadTest : public ::testing::Test {
+protected:
+  std::unique_ptr<LeanStore> mStore;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    auto storeDirStr = "/tmp/leanstore/" + curTestName;
+    auto* option = CreateStoreOption(storeDirStr.c_str());
+    option->mCreateFromScratch = true;
+    option->mWorkerThreads = 2;
+    option->mEnableEagerGc = false;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  //! Fixed width keys, in ascending order with i.
+  static std::string testKey(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key_%010d", i);
+    return buf;
+  }
+};
+
+TEST_F(BulkLoadTest, BasicKV) {
+  static constexpr int kNumKeys = 100000;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateBasicKV("bulk_load_test");
+    ASSERT_TRUE(res);
+    auto* btree = res.value();
+
+    cr::WorkerContext::My().StartTx();
+    auto loader = btree->NewBulkLoader(0.9);
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      ASSERT_TRUE(loader->Add(Slice(key), Slice(key)));
+    }
+
+    // keys out of order are rejected
+    auto key = testKey(0);
+    EXPECT_FALSE(loader->Add(Slice(key), Slice(key)));
+    ASSERT_TRUE(loader->Finish());
+    cr::WorkerContext::My().CommitTx();
+    EXPECT_GT(btree->GetHeight(), 2u);
+
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      std::string val;
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice v) { val = v.ToString(); }), OpCode::kOK);
+      EXPECT_EQ(val, key);
+    }
+    EXPECT_EQ(btree->CountEntries(), static_cast<uint64_t>(kNumKeys));
+
+    // the loaded tree serves the following writes as usual
+    auto newKey = testKey(kNumKeys);
+    EXPECT_EQ(btree->Insert(Slice(newKey), Slice(newKey)), OpCode::kOK);
+    EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kDuplicated);
+    EXPECT_EQ(btree->Remove(Slice(key)), OpCode::kOK);
+    EXPECT_EQ(btree->CountEntries(), static_cast<uint64_t>(kNumKeys));
+
+    // only empty trees can be bulk loaded, rejected before any page is written
+    auto reloader = btree->NewBulkLoader(0.9);
+    EXPECT_FALSE(reloader->Add(Slice(key), Slice(key)));
+    EXPECT_EQ(reloader->NumKeys(), 0u);
+    EXPECT_TRUE(reloader->Finish());
+    EXPECT_EQ(btree->CountEntries(), static_cast<uint64_t>(kNumKeys));
+  });
+}
+
+TEST_F(BulkLoadTest, TransactionKV) {
+  static constexpr int kNumKeys = 10000;
+  TransactionKV* btree = nullptr;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateTransactionKV("bulk_load_test");
+    ASSERT_TRUE(res);
+    btree = res.value();
+
+    cr::WorkerContext::My().StartTx();
+    auto loader = btree->NewBulkLoader(1.0);
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      ASSERT_TRUE(loader->Add(Slice(key), Slice(key)));
+    }
+    ASSERT_TRUE(loader->Finish());
+    cr::WorkerContext::My().CommitTx();
+  });
+
+  // the loaded keys are visible to the transactions of other workers
+  mStore->ExecSync(1, [&]() {
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      std::string val;
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice v) { val = v.ToString(); }), OpCode::kOK);
+      EXPECT_EQ(val, key);
+    }
+    cr::WorkerContext::My().CommitTx();
+  });
+}
+
+} // namespace leanstore::storage::btree::test
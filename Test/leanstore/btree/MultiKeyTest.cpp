@@ -0,0 +1,112 @@
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace leanstore::storage::btree::test {
+
+class MultiKeyTest : public ::testing::Test {
+protected:
+  std::unique_ptr<LeanStore> mStore;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    auto storeDirStr = "/tmp/leanstore/" + curTestName;
+    auto* option = CreateStoreOption(storeDirStr.c_str());
+    option->mCreateFromScratch = true;
+    option->mWorkerThreads = 2;
+    option->mEnableEagerGc = false;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  //! Keys in descending order, with a duplicate of the first key at the end.
+  static std::vector<std::string> testKeys(int numKeys) {
+    std::vector<std::string> keys;
+    for (int i = numKeys - 1; i >= 0; i--) {
+      keys.push_back("key_" + std::to_string(i));
+    }
+    keys.push_back(keys.front());
+    return keys;
+  }
+};
+
+TEST_F(MultiKeyTest, BasicKV) {
+  static constexpr int kNumKeys = 1000;
+  auto keyStrs = testKeys(kNumKeys);
+  std::vector<Slice> keys(keyStrs.begin(), keyStrs.end());
+  std::vector<OpCode> results(keys.size());
+
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateBasicKV("multi_key_test");
+    ASSERT_TRUE(res);
+    auto* btree = res.value();
+
+    // the duplicated key is inserted only once, values are the keys themselves
+    btree->MultiInsert(keys, keys, results);
+    for (int i = 0; i < kNumKeys; i++) {
+      EXPECT_EQ(results[i], OpCode::kOK);
+    }
+    EXPECT_EQ(results[kNumKeys], OpCode::kDuplicated);
+
+    // look up the inserted keys together with some missing ones
+    std::vector<std::string> lookupStrs = keyStrs;
+    lookupStrs.push_back("missing_key");
+    std::vector<Slice> lookupKeys(lookupStrs.begin(), lookupStrs.end());
+    std::vector<OpCode> lookupResults(lookupKeys.size());
+    std::vector<std::string> values(lookupKeys.size());
+    btree->MultiLookup(
+        lookupKeys, [&](uint64_t idx, Slice val) { values[idx] = val.ToString(); }, lookupResults);
+    for (uint64_t i = 0; i < keyStrs.size(); i++) {
+      EXPECT_EQ(lookupResults[i], OpCode::kOK);
+      EXPECT_EQ(values[i], lookupStrs[i]);
+    }
+    EXPECT_EQ(lookupResults.back(), OpCode::kNotFound);
+  });
+}
+
+TEST_F(MultiKeyTest, TransactionKV) {
+  static constexpr int kNumKeys = 1000;
+  auto keyStrs = testKeys(kNumKeys);
+  std::vector<Slice> keys(keyStrs.begin(), keyStrs.end());
+  std::vector<OpCode> results(keys.size());
+
+  TransactionKV* btree = nullptr;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateTransactionKV("multi_key_test");
+    ASSERT_TRUE(res);
+    btree = res.value();
+
+    cr::WorkerContext::My().StartTx();
+    btree->MultiInsert(keys, keys, results);
+    cr::WorkerContext::My().CommitTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      EXPECT_EQ(results[i], OpCode::kOK);
+    }
+    EXPECT_EQ(results[kNumKeys], OpCode::kDuplicated);
+  });
+
+  // the committed keys are visible to the transactions of other workers
+  mStore->ExecSync(1, [&]() {
+    std::vector<std::string> values(keys.size());
+    cr::WorkerContext::My().StartTx();
+    btree->MultiLookup(
+        keys, [&](uint64_t idx, Slice val) { values[idx] = val.ToString(); }, results);
+    cr::WorkerContext::My().CommitTx();
+    for (uint64_t i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(results[i], OpCode::kOK);
+      EXPECT_EQ(values[i], keyStrs[i]);
+    }
+  });
+}
+
+} // namespace leanstore::storage::btree::test
@@ -0,0 +1,100 @@
+#include "leanstore/utils/AsyncIo.hpp"
+
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/utils/Defer.hpp"
+#include "leanstore/utils/Misc.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstring>
+#include <format>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace leanstore::utils::test {
+
+class AsyncIoTest : public ::testing::Test {
+protected:
+  static constexpr size_t kPageSize = 4096;
+
+  static constexpr size_t kNumPages = 3;
+
+  std::string mTestDir = "/tmp/leanstore/AsyncIoTest";
+
+  void SetUp() override {
+    auto ret = system(std::format("mkdir -p {}", mTestDir).c_str());
+    EXPECT_EQ(ret, 0) << std::format(
+        "Failed to create test directory, testDir={}, errno={}, error={}", mTestDir, errno,
+        strerror(errno));
+  }
+
+  //! Creates a file of kNumPages pages, every byte of page i is i+1.
+  std::string createTestFile() {
+    auto fileName = std::format("{}/{}", mTestDir, "pages");
+    int fd = open(fileName.c_str(), O_TRUNC | O_CREAT | O_RDWR, 0666);
+    EXPECT_NE(fd, -1) << std::format("Failed to open file, fileName={}, errno={}, error={}",
+                                     fileName, errno, strerror(errno));
+    char page[kPageSize];
+    for (size_t i = 0; i < kNumPages; i++) {
+      std::memset(page, i + 1, kPageSize);
+      EXPECT_EQ(pwrite(fd, page, kPageSize, i * kPageSize), int64_t(kPageSize));
+    }
+    close(fd);
+    return fileName;
+  }
+};
+
+// A read on a write-only fd is rejected with EBADF by the kernel when it is executed, which
+// injects a failure into a single request of the batch.
+TEST_F(AsyncIoTest, FailedReadOnlyFailsItsRequest) {
+  auto fileName = createTestFile();
+  int readFd = open(fileName.c_str(), O_RDONLY);
+  int writeFd = open(fileName.c_str(), O_WRONLY);
+  ASSERT_NE(readFd, -1);
+  ASSERT_NE(writeFd, -1);
+  SCOPED_DEFER({
+    close(readFd);
+    close(writeFd);
+  });
+
+  AsyncIo aio(kNumPages, kIoUring);
+  if (aio.GetBackend() != kIoUring) {
+    GTEST_SKIP() << "io_uring is not available";
+  }
+  AlignedBuffer<kAlignment> buffer(kNumPages * kPageSize);
+  auto prepareBatch = [&]() {
+    std::memset(buffer.Get(), 0, kNumPages * kPageSize);
+    for (size_t i = 0; i < kNumPages; i++) {
+      aio.PrepareRead(i == 1 ? writeFd : readFd, buffer.Get() + i * kPageSize, kPageSize,
+                      i * kPageSize);
+    }
+    ASSERT_TRUE(aio.SubmitAll());
+  };
+
+  // WaitAll() fails the whole batch
+  prepareBatch();
+  EXPECT_FALSE(aio.WaitAll());
+
+  // WaitAllCompletions() only reports the failed request in its result
+  prepareBatch();
+  auto res = aio.WaitAllCompletions();
+  ASSERT_TRUE(res) << res.error().ToString();
+  ASSERT_EQ(res.value(), kNumPages);
+  for (size_t i = 0; i < kNumPages; i++) {
+    auto* data = reinterpret_cast<uint8_t*>(aio.GetCompletedData(i));
+    auto page = (data - buffer.Get()) / kPageSize;
+    if (page == 1) {
+      EXPECT_EQ(aio.GetCompletedResult(i), -EBADF);
+      EXPECT_EQ(data[0], 0);
+    } else {
+      EXPECT_EQ(aio.GetCompletedResult(i), int64_t(kPageSize));
+      EXPECT_EQ(data[0], page + 1);
+      EXPECT_EQ(data[kPageSize - 1], page + 1);
+    }
+  }
+}
+
+} // namespace leanstore::utils::test
@@ -71,9 +71,11 @@ protected:
     ASSERT_EQ(remove(fileName.c_str()), 0) << std::format(
         "Failed to remove file, fileName={}, errno={}, error={}", fileName, errno, strerror(errno));
   }
+
+  void writeAndVerify(IoBackend ioBackend);
 };
 
-TEST_F(AsyncWriteBufferTest, Basic) {
+void AsyncWriteBufferTest::writeAndVerify(IoBackend ioBackend) {
   auto testFile = getRandTestFile();
   auto testFd = openFile(testFile);
   SCOPED_DEFER({
@@ -83,7 +85,7 @@ TEST_F(AsyncWriteBufferTest, Basic) {
 
   auto testPageSize = 512;
   auto testMaxBatchSize = 8;
-  AsyncWriteBuffer testWriteBuffer(testFd, testPageSize, testMaxBatchSize);
+  AsyncWriteBuffer testWriteBuffer(testFd, testPageSize, testMaxBatchSize, ioBackend);
   std::vector<std::unique_ptr<BufferFrameHolder>> bfHolders;
   for (int i = 0; i < testMaxBatchSize; i++) {
     bfHolders.push_back(std::make_unique<BufferFrameHolder>(testPageSize, i));
@@ -127,4 +129,12 @@ TEST_F(AsyncWriteBufferTest, Basic) {
   }
 }
 
+TEST_F(AsyncWriteBufferTest, Basic) {
+  writeAndVerify(kLibaio);
+}
+
+TEST_F(AsyncWriteBufferTest, IoUring) {
+  writeAndVerify(kIoUring);
+}
+
 } // namespace leanstore::storage::test
\ No newline at end of file
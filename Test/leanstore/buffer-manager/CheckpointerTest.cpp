@@ -0,0 +1,155 @@
+#include "leanstore/buffer-manager/Checkpointer.hpp"
+
+#include "leanstore/buffer-manager/BufferManager.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/GroupCommitter.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace leanstore::storage::test {
+class CheckpointerTest : public ::testing::Test {
+protected:
+  std::unique_ptr<LeanStore> mStore;
+
+  CheckpointerTest() = default;
+
+  ~CheckpointerTest() = default;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    openStore("/tmp/leanstore/" + curTestName, true);
+  }
+
+  void openStore(const std::string& storeDir, bool createFromScratch) {
+    mStore = nullptr;
+    auto* option = CreateStoreOption(storeDir.c_str());
+    option->mCreateFromScratch = createFromScratch;
+    option->mWorkerThreads = 2;
+    option->mEnableEagerGc = false;
+    option->mCheckpointIntervalMs = 10;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  //! Waits until a checkpoint round started after the WAL has reached walSize is finished.
+  void waitCheckpoint(uint64_t walSize) {
+    auto& checkpointer = mStore->mBufferManager->mCheckpointer;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (checkpointer->mCheckpointLsns[0].load() < walSize &&
+           std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_GE(checkpointer->mCheckpointLsns[0].load(), walSize);
+  }
+
+  uint64_t numDirtyBfs() {
+    uint64_t numDirty = 0;
+    mStore->mBufferManager->DoWithBufferFrameIf(
+        [](BufferFrame& bf) { return !bf.IsFree() && bf.IsDirty(); },
+        [&](BufferFrame&) { numDirty++; });
+    return numDirty;
+  }
+};
+
+TEST_F(CheckpointerTest, DirtyPagesAreFlushed) {
+  auto& checkpointer = mStore->mBufferManager->mCheckpointer;
+  ASSERT_NE(checkpointer, nullptr);
+  EXPECT_TRUE(checkpointer->IsStarted());
+
+  btree::BasicKV* btree = nullptr;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateBasicKV("checkpointer_test");
+    ASSERT_TRUE(res);
+    btree = res.value();
+    for (int i = 0; i < 1000; i++) {
+      auto key = std::to_string(i);
+      EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+    }
+  });
+
+  // the checkpoint LSN catches up with the WAL once a round starts after the inserts, all the
+  // pages modified by the inserts are flushed by then
+  auto walSize = mStore->mCRManager->mGroupCommitters[0]->mWalSize.load();
+  waitCheckpoint(walSize);
+  EXPECT_EQ(numDirtyBfs(), 0u);
+
+  // the checkpointer is stopped before the shutdown checkpoint
+  mStore->mBufferManager->StopCheckpointer();
+  EXPECT_EQ(checkpointer, nullptr);
+  ASSERT_EQ(mStore->mBufferManager->mCheckpointLsns.size(), 1u);
+  EXPECT_GE(mStore->mBufferManager->mCheckpointLsns[0], walSize);
+}
+
+TEST_F(CheckpointerTest, RecoverFromPersistedCheckpoint) {
+  static constexpr int kNumKeys = 1000;
+  btree::TransactionKV* btree = nullptr;
+  auto insertKeys = [&](int begin, int end) {
+    mStore->ExecSync(0, [&]() {
+      for (int i = begin; i < end; i++) {
+        auto key = std::to_string(i);
+        cr::WorkerContext::My().StartTx();
+        EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+        cr::WorkerContext::My().CommitTx();
+      }
+    });
+  };
+
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateTransactionKV("checkpointer_test");
+    ASSERT_TRUE(res);
+  });
+
+  // the tree is recorded in the meta file on shutdown
+  std::string storeDir = mStore->mStoreOption->mStoreDir;
+  openStore(storeDir, false);
+  mStore->GetTransactionKV("checkpointer_test", &btree);
+  ASSERT_NE(btree, nullptr);
+  insertKeys(0, kNumKeys);
+  waitCheckpoint(mStore->mCRManager->mGroupCommitters[0]->mWalSize.load());
+
+  // the last checkpoint LSN is persisted in the meta file when the checkpointer is stopped
+  mStore->mBufferManager->StopCheckpointer();
+  auto checkpointLsns = mStore->mBufferManager->mCheckpointLsns;
+  ASSERT_EQ(checkpointLsns.size(), 1u);
+  EXPECT_GT(checkpointLsns[0], 0u);
+
+  // the changes after the checkpoint are only in the WAL
+  insertKeys(kNumKeys, 2 * kNumKeys);
+  EXPECT_GT(mStore->mCRManager->mGroupCommitters[0]->mWalSize.load(), checkpointLsns[0]);
+
+  // crash, the files are left as they are without the shutdown checkpoint
+  auto crashedDir = storeDir + "_crashed";
+  std::filesystem::remove_all(crashedDir);
+  std::filesystem::copy(storeDir, crashedDir, std::filesystem::copy_options::recursive);
+  openStore(crashedDir, false);
+
+  // redo starts from the persisted checkpoint LSN, the changes after it are recovered
+  EXPECT_EQ(mStore->mBufferManager->mCheckpointLsns, checkpointLsns);
+  mStore->GetTransactionKV("checkpointer_test", &btree);
+  ASSERT_NE(btree, nullptr);
+  mStore->ExecSync(0, [&]() {
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < 2 * kNumKeys; i++) {
+      auto key = std::to_string(i);
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice val) { EXPECT_EQ(val.ToString(), key); }),
+                OpCode::kOK);
+    }
+    cr::WorkerContext::My().CommitTx();
+  });
+}
+
+} // namespace leanstore::storage::test
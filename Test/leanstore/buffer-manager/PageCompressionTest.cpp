@@ -0,0 +1,88 @@
+#include "leanstore/buffer-manager/PageCompression.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/RandomGenerator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace leanstore::storage::test {
+
+class PageCompressionTest : public ::testing::Test {
+protected:
+  static constexpr uint64_t kPageSize = 4096;
+
+  std::unique_ptr<LeanStore> mStore;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    auto storeDirStr = "/tmp/leanstore/" + curTestName;
+    auto* option = CreateStoreOption(storeDirStr.c_str());
+    option->mCreateFromScratch = true;
+    option->mWorkerThreads = 1;
+    option->mNumPartitions = 1;
+    option->mBufferPoolSize = 100 * (512 + kPageSize);
+    option->mFreePct = 20;
+    option->mEnableEagerGc = false;
+    option->mEnablePageCompression = true;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+};
+
+TEST_F(PageCompressionTest, CompressAndDecompress) {
+  utils::AlignedBuffer<512> image(kPageSize);
+  utils::AlignedBuffer<512> page(kPageSize);
+
+  // a sparse page is compressed to a few units of write
+  std::memset(image.Get(), 0, kPageSize);
+  std::memcpy(image.Get() + 100, "compressed page", 15);
+  auto writeSize = PageCompression::Compress(image.Get(), kPageSize, page.Get());
+  EXPECT_GT(writeSize, 0u);
+  EXPECT_LT(writeSize, kPageSize);
+  EXPECT_EQ(writeSize % PageCompression::kAlignment, 0u);
+  EXPECT_TRUE(PageCompression::IsCompressed(page.Get()));
+  ASSERT_TRUE(PageCompression::Decompress(page.Get(), kPageSize));
+  EXPECT_FALSE(PageCompression::IsCompressed(page.Get()));
+  EXPECT_EQ(std::memcmp(page.Get(), image.Get(), kPageSize), 0);
+
+  // random bytes are not worth compressing
+  for (uint64_t i = 0; i < kPageSize; i++) {
+    image.Get()[i] = utils::RandomGenerator::Rand<int>(0, 256);
+  }
+  EXPECT_EQ(PageCompression::Compress(image.Get(), kPageSize, page.Get()), 0u);
+}
+
+TEST_F(PageCompressionTest, EvictAndLoad) {
+  static constexpr int kNumKeys = 20000;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateBasicKV("page_compression_test");
+    ASSERT_TRUE(res);
+    auto* btree = res.value();
+
+    // far more leaves than the buffer pool holds, most of them are evicted compressed
+    char key[32];
+    for (int i = 0; i < kNumKeys; i++) {
+      std::snprintf(key, sizeof(key), "key_%010d", i);
+      EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+    }
+
+    for (int i = 0; i < kNumKeys; i++) {
+      std::snprintf(key, sizeof(key), "key_%010d", i);
+      std::string val;
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice v) { val = v.ToString(); }), OpCode::kOK);
+      EXPECT_EQ(val, key);
+    }
+  });
+}
+
+} // namespace leanstore::storage::test
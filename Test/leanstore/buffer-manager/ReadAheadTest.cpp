@@ -0,0 +1,196 @@
+#include "leanstore/buffer-manager/BufferManager.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/core/BTreeNode.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace leanstore::storage::test {
+class ReadAheadTest : public ::testing::Test {
+protected:
+  static constexpr int kNumKeys = 400;
+
+  std::unique_ptr<LeanStore> mStore;
+
+  std::string mStoreDir;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    mStoreDir = "/tmp/leanstore/" + curTestName;
+    openStore(true, 16);
+
+    // large values, so that the leaves of the test keys fit in a two-level tree
+    mStore->ExecSync(0, [&]() {
+      auto res = mStore->CreateBasicKV("read_ahead_test");
+      ASSERT_TRUE(res);
+      auto* btree = res.value();
+      for (int i = 0; i < kNumKeys; i++) {
+        auto key = testKey(i);
+        auto val = testVal(i);
+        EXPECT_EQ(btree->Insert(Slice(key), Slice(val)), OpCode::kOK);
+      }
+      EXPECT_EQ(btree->mHeight.load(), 2u);
+    });
+  }
+
+  //! Reopens the store, all the tree pages except the meta node are evicted afterwards.
+  void openStore(bool createFromScratch, uint64_t maxReadAheadPages) {
+    mStore = nullptr;
+    auto* option = CreateStoreOption(mStoreDir.c_str());
+    option->mCreateFromScratch = createFromScratch;
+    option->mWorkerThreads = 2;
+    option->mEnableEagerGc = false;
+    option->mMaxScanReadAheadPages = maxReadAheadPages;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  btree::BasicKV* getBTree() {
+    btree::BasicKV* btree = nullptr;
+    mStore->GetBasicKV("read_ahead_test", &btree);
+    return btree;
+  }
+
+  //! Number of the leaves in the buffer pool, the tree has two levels.
+  static uint64_t numResidentLeaves(btree::BasicKV* btree) {
+    auto* metaNode =
+        reinterpret_cast<btree::BTreeNode*>(btree->mMetaNodeSwip.AsBufferFrame().mPage.mPayload);
+    if (!metaNode->mRightMostChildSwip.IsHot()) {
+      return 0;
+    }
+    auto* root = reinterpret_cast<btree::BTreeNode*>(
+        metaNode->mRightMostChildSwip.AsBufferFrame().mPage.mPayload);
+    uint64_t numResident = 0;
+    for (uint16_t i = 0; i <= root->mNumSlots; i++) {
+      if (!root->ChildSwipIncludingRightMost(i)->IsEvicted()) {
+        numResident++;
+      }
+    }
+    return numResident;
+  }
+
+  static std::string testKey(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key_%06d", i);
+    return buf;
+  }
+
+  static std::string testVal(int i) {
+    return testKey(i) + std::string(500, 'v');
+  }
+};
+
+TEST_F(ReadAheadTest, ScanEvictedLeaves) {
+  openStore(false, 16);
+  mStore->ExecSync(0, [&]() {
+    auto* btree = getBTree();
+    ASSERT_NE(btree, nullptr);
+    EXPECT_EQ(numResidentLeaves(btree), 0u);
+
+    int i = 0;
+    EXPECT_EQ(btree->ScanAsc(Slice(testKey(0)),
+                             [&](Slice key, Slice val) {
+                               EXPECT_EQ(key.ToString(), testKey(i));
+                               EXPECT_EQ(val.ToString(), testVal(i));
+                               i++;
+                               return true;
+                             }),
+              OpCode::kOK);
+    EXPECT_EQ(i, kNumKeys);
+  });
+
+  openStore(false, 16);
+  mStore->ExecSync(0, [&]() {
+    auto* btree = getBTree();
+    ASSERT_NE(btree, nullptr);
+
+    int i = kNumKeys - 1;
+    EXPECT_EQ(btree->ScanDesc(Slice(testKey(kNumKeys - 1)),
+                              [&](Slice key, Slice val) {
+                                EXPECT_EQ(key.ToString(), testKey(i));
+                                EXPECT_EQ(val.ToString(), testVal(i));
+                                i--;
+                                return true;
+                              }),
+              OpCode::kOK);
+    EXPECT_EQ(i, -1);
+  });
+}
+
+TEST_F(ReadAheadTest, ScanReadsSiblingsAhead) {
+  // the leaves visited by a short scan without read-ahead
+  static constexpr int kNumScanKeys = 40;
+  auto scanFirstKeys = [&](btree::BasicKV* btree) {
+    int i = 0;
+    btree->ScanAsc(Slice(testKey(0)), [&](Slice key, Slice) {
+      EXPECT_EQ(key.ToString(), testKey(i));
+      return ++i < kNumScanKeys;
+    });
+    EXPECT_EQ(i, kNumScanKeys);
+  };
+
+  uint64_t numVisitedLeaves = 0;
+  uint64_t numTotalLeaves = 0;
+  openStore(false, 0);
+  mStore->ExecSync(0, [&]() {
+    auto* btree = getBTree();
+    ASSERT_NE(btree, nullptr);
+    scanFirstKeys(btree);
+    numVisitedLeaves = numResidentLeaves(btree);
+
+    // load all the leaves
+    EXPECT_EQ(btree->ScanAsc(Slice(testKey(0)), [&](Slice, Slice) { return true; }), OpCode::kOK);
+    numTotalLeaves = numResidentLeaves(btree);
+  });
+  ASSERT_GT(numVisitedLeaves, 2u);
+  ASSERT_GT(numTotalLeaves, numVisitedLeaves + 16);
+
+  // the same scan with read-ahead loads more leaves, at most the read-ahead limit at a time
+  openStore(false, 16);
+  mStore->ExecSync(0, [&]() {
+    auto* btree = getBTree();
+    ASSERT_NE(btree, nullptr);
+    scanFirstKeys(btree);
+    auto numResident = numResidentLeaves(btree);
+    EXPECT_GT(numResident, numVisitedLeaves);
+    EXPECT_LE(numResident, numVisitedLeaves + 16);
+  });
+}
+
+TEST_F(ReadAheadTest, MultiLookupEvictedLeaves) {
+  openStore(false, 16);
+  std::vector<std::string> keyStrs;
+  for (int i = kNumKeys - 1; i >= 0; i -= 3) {
+    keyStrs.push_back(testKey(i));
+  }
+  std::vector<Slice> keys(keyStrs.begin(), keyStrs.end());
+  std::vector<std::string> values(keys.size());
+  std::vector<OpCode> results(keys.size());
+
+  mStore->ExecSync(0, [&]() {
+    auto* btree = getBTree();
+    ASSERT_NE(btree, nullptr);
+    EXPECT_EQ(numResidentLeaves(btree), 0u);
+
+    // the leaves of the keys are read ahead in batches before the lookups
+    btree->MultiLookup(keys, [&](uint64_t idx, Slice val) { values[idx] = val.ToString(); },
+                       results);
+    EXPECT_GT(numResidentLeaves(btree), 0u);
+  });
+
+  for (uint64_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(results[i], OpCode::kOK);
+    EXPECT_EQ(values[i], testVal(kNumKeys - 1 - 3 * i));
+  }
+}
+
+} // namespace leanstore::storage::test
@@ -0,0 +1,168 @@
+#include "leanstore/concurrency/GarbageCollector.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace leanstore::cr::test {
+
+class GarbageCollectorTest : public ::testing::Test {
+protected:
+  std::unique_ptr<LeanStore> mStore;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    auto storeDirStr = "/tmp/leanstore/" + curTestName;
+    auto* option = CreateStoreOption(storeDirStr.c_str());
+    option->mCreateFromScratch = true;
+    option->mWorkerThreads = 2;
+    option->mEnableGcService = true;
+    option->mGcBatchSize = 16;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+  }
+
+  static std::string testKey(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "key_%010d", i);
+    return buf;
+  }
+};
+
+TEST_F(GarbageCollectorTest, WorkerContext) {
+  auto& crManager = *mStore->mCRManager;
+  ASSERT_NE(crManager.mGarbageCollector, nullptr);
+  ASSERT_EQ(crManager.mWorkerCtxs.size(), 3u);
+  EXPECT_EQ(crManager.mWorkerCtxs.back(), crManager.mGarbageCollector->mWorkerCtx.get());
+  EXPECT_EQ(crManager.mWorkerCtxs.back()->mWorkerId, 2u);
+
+  // the garbage collector has no history of its own
+  EXPECT_EQ(crManager.mWorkerCtxs.back()->mCc.mHistoryStorage.GetRemoveIndex(), nullptr);
+  EXPECT_EQ(crManager.mWorkerCtxs.back()->mCc.mHistoryStorage.GetUpdateIndex(), nullptr);
+}
+
+TEST_F(GarbageCollectorTest, PurgeRemovedKeys) {
+  static constexpr int kNumKeys = 1000;
+  storage::btree::TransactionKV* btree = nullptr;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateTransactionKV("garbage_collector_test");
+    ASSERT_TRUE(res);
+    btree = res.value();
+
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+    }
+    cr::WorkerContext::My().CommitTx();
+
+    // the workers leave the versions to the garbage collector
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      cr::WorkerContext::My().StartTx();
+      EXPECT_EQ(btree->Remove(Slice(key)), OpCode::kOK);
+      cr::WorkerContext::My().CommitTx();
+    }
+  });
+
+  // the remove versions are purged in batches, so are the tombstones in the tree
+  auto* removeIndex = mStore->mCRManager->mWorkerCtxs[0]->mCc.mHistoryStorage.GetRemoveIndex();
+  uint64_t numRemoveVersions = 0;
+  uint64_t numTuples = 0;
+  for (int i = 0; i < 1000; i++) {
+    mStore->ExecSync(1, [&]() {
+      numRemoveVersions = removeIndex->CountEntries();
+      numTuples = btree->CountEntries();
+    });
+    if (numRemoveVersions == 0 && numTuples == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(numRemoveVersions, 0u);
+  EXPECT_EQ(numTuples, 0u);
+
+  mStore->ExecSync(1, [&]() {
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice) {}), OpCode::kNotFound);
+    }
+    cr::WorkerContext::My().CommitTx();
+  });
+}
+
+TEST_F(GarbageCollectorTest, PurgeUpdatedKeys) {
+  static constexpr int kNumKeys = 100;
+  static constexpr int kNumUpdates = 20;
+  storage::btree::TransactionKV* btree = nullptr;
+  mStore->ExecSync(0, [&]() {
+    auto res = mStore->CreateTransactionKV("garbage_collector_test");
+    ASSERT_TRUE(res);
+    btree = res.value();
+
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+    }
+    cr::WorkerContext::My().CommitTx();
+
+    // update the first byte of each value, one transaction per update
+    uint8_t updateDescBuf[UpdateDesc::Size(1)];
+    auto* updateDesc = UpdateDesc::CreateFrom(updateDescBuf);
+    updateDesc->mNumSlots = 1;
+    updateDesc->mUpdateSlots[0].mOffset = 0;
+    updateDesc->mUpdateSlots[0].mSize = 1;
+    for (int round = 0; round < kNumUpdates; round++) {
+      for (int i = 0; i < kNumKeys; i++) {
+        auto key = testKey(i);
+        cr::WorkerContext::My().StartTx();
+        EXPECT_EQ(btree->UpdatePartial(
+                      Slice(key), [&](MutableSlice val) { val.Data()[0] = 'a' + round; },
+                      *updateDesc),
+                  OpCode::kOK);
+        cr::WorkerContext::My().CommitTx();
+      }
+    }
+  });
+
+  // the update versions are purged a whole history leaf at a time, and counted against the batch
+  // size, the garbage collector keeps going until all of them are purged
+  auto* updateIndex = mStore->mCRManager->mWorkerCtxs[0]->mCc.mHistoryStorage.GetUpdateIndex();
+  uint64_t numUpdateVersions = 0;
+  for (int i = 0; i < 1000; i++) {
+    mStore->ExecSync(1, [&]() { numUpdateVersions = updateIndex->CountEntries(); });
+    if (numUpdateVersions == 0) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(numUpdateVersions, 0u);
+
+  mStore->ExecSync(1, [&]() {
+    cr::WorkerContext::My().StartTx();
+    for (int i = 0; i < kNumKeys; i++) {
+      auto key = testKey(i);
+      std::string val;
+      EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice v) { val = v.ToString(); }), OpCode::kOK);
+      EXPECT_EQ(val[0], 'a' + kNumUpdates - 1);
+    }
+    cr::WorkerContext::My().CommitTx();
+  });
+}
+
+} // namespace leanstore::cr::test
@@ -0,0 +1,400 @@
+#include "leanstore/concurrency/GroupCommitter.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/CounterUtil.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace leanstore::cr::test {
+
+class GroupCommitterTest : public ::testing::Test {
+protected:
+  std::string mStoreDir;
+
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    mStoreDir = "/tmp/leanstore/" + curTestName;
+  }
+
+  std::unique_ptr<LeanStore> openStore(bool createFromScratch, bool enableWalCompression = false,
+                                       uint64_t maxGroupCommitWindowUs = 1000) {
+    auto* option = CreateStoreOption(mStoreDir.c_str());
+    option->mCreateFromScratch = createFromScratch;
+    option->mWorkerThreads = 4;
+    option->mEnableEagerGc = false;
+    option->mNumWalFiles = 2;
+    option->mEnableWalCompression = enableWalCompression;
+    option->mMaxGroupCommitWindowUs = maxGroupCommitWindowUs;
+    auto res = LeanStore::Open(option);
+    EXPECT_TRUE(res);
+    return res ? std::move(res.value()) : nullptr;
+  }
+
+  //! Simulates a crash, the files are copied as they are without the shutdown checkpoint. The store
+  //! is opened from the copy afterwards.
+  void crash() {
+    auto crashedDir = mStoreDir + "_crashed";
+    std::filesystem::remove_all(crashedDir);
+    std::filesystem::copy(mStoreDir, crashedDir, std::filesystem::copy_options::recursive);
+    mStoreDir = crashedDir;
+  }
+
+  static uint64_t numRecorded(const PerfHistogram& hist) {
+    uint64_t total = 0;
+    for (const auto& bucket : hist.mBuckets) {
+      total += bucket;
+    }
+    return total;
+  }
+
+  //! Commits kNumTxs transactions on each worker concurrently, and checks that all of them are
+  //! committed and recorded in the commit latency histograms.
+  void commitConcurrently(LeanStore* store) {
+    static constexpr int kNumTxs = 200;
+    const auto numWorkers = store->mStoreOption->mWorkerThreads;
+    storage::btree::TransactionKV* btree = nullptr;
+    store->ExecSync(0, [&]() {
+      auto res = store->CreateTransactionKV("concurrent_commit_test");
+      ASSERT_TRUE(res);
+      btree = res.value();
+    });
+
+    std::vector<uint64_t> numCommitLats(numWorkers, 0);
+    auto collectCommitLats = [&](std::vector<uint64_t>& result) {
+      for (uint64_t workerId = 0; workerId < numWorkers; workerId++) {
+        store->ExecSync(workerId,
+                        [&]() { result[workerId] = numRecorded(tlsPerfCounters.mTxCommitLatNs); });
+      }
+    };
+    collectCommitLats(numCommitLats);
+
+    for (uint64_t workerId = 0; workerId < numWorkers; workerId++) {
+      store->ExecAsync(workerId, [&, workerId]() {
+        for (int i = 0; i < kNumTxs; i++) {
+          auto key = std::to_string(workerId) + "_" + std::to_string(i);
+          WorkerContext::My().StartTx();
+          EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+          WorkerContext::My().CommitTx();
+        }
+      });
+    }
+    store->WaitAll();
+
+    store->ExecSync(0, [&]() {
+      WorkerContext::My().StartTx();
+      for (uint64_t workerId = 0; workerId < numWorkers; workerId++) {
+        for (int i = 0; i < kNumTxs; i++) {
+          auto key = std::to_string(workerId) + "_" + std::to_string(i);
+          EXPECT_EQ(btree->Lookup(Slice(key), [&](Slice val) { EXPECT_EQ(val.ToString(), key); }),
+                    OpCode::kOK);
+        }
+      }
+      WorkerContext::My().CommitTx();
+    });
+
+    COUNTERS_BLOCK() {
+      // every commit records its latency on the worker
+      std::vector<uint64_t> numCommitLatsAfter(numWorkers, 0);
+      collectCommitLats(numCommitLatsAfter);
+      for (uint64_t workerId = 0; workerId < numWorkers; workerId++) {
+        EXPECT_GE(numCommitLatsAfter[workerId] - numCommitLats[workerId], kNumTxs);
+      }
+
+      // every group committer flushed and committed the transactions of its workers in batches
+      for (auto& groupCommitter : store->mCRManager->mGroupCommitters) {
+        auto* counters = groupCommitter->GetPerfCounters();
+        auto numFlushes = numRecorded(counters->mGroupCommitFlushLatNs);
+        EXPECT_GT(numFlushes, 0u);
+        EXPECT_EQ(numRecorded(counters->mGroupCommitBatchBytes), numFlushes);
+        auto numCommitRounds = numRecorded(counters->mGroupCommitBatchTxs);
+        EXPECT_GT(numCommitRounds, 0u);
+        EXPECT_LE(numCommitRounds, numFlushes);
+        EXPECT_GT(PerfHistPercentile(&counters->mGroupCommitFlushLatNs, 50), 0u);
+        EXPECT_LE(PerfHistPercentile(&counters->mGroupCommitFlushLatNs, 50),
+                  PerfHistPercentile(&counters->mGroupCommitFlushLatNs, 99));
+      }
+    }
+  }
+};
+
+TEST_F(GroupCommitterTest, BatchWindow) {
+  using std::chrono::microseconds;
+  using std::chrono::nanoseconds;
+
+  // disabled
+  EXPECT_EQ(GroupCommitter::BatchWindow(0, microseconds(0)), nanoseconds(0));
+  EXPECT_EQ(GroupCommitter::BatchWindow(100000, microseconds(0)), nanoseconds(0));
+
+  // nothing flushed yet, no latency observed
+  EXPECT_EQ(GroupCommitter::BatchWindow(0, microseconds(1000)), nanoseconds(0));
+
+  // half of the average flush latency
+  EXPECT_EQ(GroupCommitter::BatchWindow(20000, microseconds(1000)), nanoseconds(10000));
+  EXPECT_EQ(GroupCommitter::BatchWindow(2000000, microseconds(1000)), microseconds(1000));
+
+  // capped by the max window
+  EXPECT_EQ(GroupCommitter::BatchWindow(2000001, microseconds(1000)), microseconds(1000));
+  EXPECT_EQ(GroupCommitter::BatchWindow(100000000, microseconds(1000)), microseconds(1000));
+}
+
+TEST_F(GroupCommitterTest, AvgFlushLatency) {
+  // the first flush initializes the average
+  EXPECT_EQ(GroupCommitter::NextAvgFlushLatNs(0, 8000), 8000u);
+
+  // one eighth of a new sample is weighted in
+  EXPECT_EQ(GroupCommitter::NextAvgFlushLatNs(8000, 16000), 9000u);
+  EXPECT_EQ(GroupCommitter::NextAvgFlushLatNs(8000, 0), 7000u);
+
+  // converges to a stable latency
+  uint64_t avg = 1000000;
+  for (int i = 0; i < 200; i++) {
+    avg = GroupCommitter::NextAvgFlushLatNs(avg, 10000);
+  }
+  EXPECT_GE(avg, 10000u);
+  EXPECT_LE(avg, 10010u);
+}
+
+TEST_F(GroupCommitterTest, LatencyHistogram) {
+  // small values have their own buckets, the bounds of the other buckets grow by 1/4 of the power
+  // of two they are in
+  for (uint64_t value = 0; value < 4; value++) {
+    EXPECT_EQ(PerfHistBucket(value), value);
+    EXPECT_EQ(PerfHistBucketUpperBound(value), value);
+  }
+  EXPECT_EQ(PerfHistBucketUpperBound(PerfHistBucket(4)), 4u);
+  EXPECT_EQ(PerfHistBucketUpperBound(PerfHistBucket(8)), 9u);
+  EXPECT_EQ(PerfHistBucketUpperBound(PerfHistBucket(1000)), 1023u);
+  EXPECT_LT(PerfHistBucket(UINT64_MAX), LEANSTORE_PERF_HIST_BUCKETS);
+  EXPECT_EQ(PerfHistBucketUpperBound(PerfHistBucket(UINT64_MAX)), UINT64_MAX);
+
+  // every value is in the bucket bounded by the previous upper bound and its own one, the error
+  // is below 25%
+  for (uint64_t value = 4; value < (1ull << 40); value = value * 3 / 2 + 1) {
+    auto bucket = PerfHistBucket(value);
+    EXPECT_LE(value, PerfHistBucketUpperBound(bucket));
+    EXPECT_GT(value, PerfHistBucketUpperBound(bucket - 1));
+    EXPECT_LT(PerfHistBucketUpperBound(bucket) - value, value / 4 + 1);
+  }
+
+  PerfHistogram hist{};
+  EXPECT_EQ(PerfHistPercentile(&hist, 50), 0u);
+  for (uint64_t latNs = 1; latNs <= 1000; latNs++) {
+    PerfHistRecord(&hist, latNs * 1000);
+  }
+  EXPECT_EQ(numRecorded(hist), 1000u);
+  auto p50 = PerfHistPercentile(&hist, 50);
+  auto p99 = PerfHistPercentile(&hist, 99);
+  EXPECT_GE(p50, 500000u);
+  EXPECT_LT(p50, 500000u * 5 / 4);
+  EXPECT_GE(p99, 990000u);
+  EXPECT_LT(p99, 990000u * 5 / 4);
+  EXPECT_EQ(PerfHistPercentile(&hist, 100), PerfHistBucketUpperBound(PerfHistBucket(1000000)));
+}
+
+TEST_F(GroupCommitterTest, ConcurrentCommits) {
+  auto store = openStore(true);
+  ASSERT_NE(store, nullptr);
+  commitConcurrently(store.get());
+}
+
+TEST_F(GroupCommitterTest, ConcurrentCommitsWithoutBatchWindow) {
+  auto store = openStore(true, false, 0);
+  ASSERT_NE(store, nullptr);
+  commitConcurrently(store.get());
+}
+
+TEST_F(GroupCommitterTest, StripedWalFiles) {
+  static constexpr int kNumKeys = 100;
+  const std::string btreeName = "striped_wal_test";
+  {
+    auto store = openStore(true);
+    ASSERT_NE(store, nullptr);
+    auto& groupCommitters = store->mCRManager->mGroupCommitters;
+    ASSERT_EQ(groupCommitters.size(), 2u);
+    EXPECT_EQ(groupCommitters[0]->mWorkerCtxs.size(), 2u);
+    EXPECT_EQ(groupCommitters[1]->mWorkerCtxs.size(), 2u);
+    EXPECT_TRUE(std::filesystem::exists(store->GetWalFilePath(0)));
+    EXPECT_TRUE(std::filesystem::exists(store->GetWalFilePath(1)));
+
+    storage::btree::BasicKV* btree = nullptr;
+    store->ExecSync(0, [&]() {
+      auto res = store->CreateBasicKV(btreeName);
+      ASSERT_TRUE(res);
+      btree = res.value();
+    });
+
+    // worker 0 writes the first WAL file, worker 1 writes the second one
+    for (uint64_t workerId = 0; workerId < 2; workerId++) {
+      store->ExecSync(workerId, [&]() {
+        for (int i = 0; i < kNumKeys; i++) {
+          auto key = std::to_string(workerId) + "_" + std::to_string(i);
+          EXPECT_EQ(btree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+        }
+      });
+    }
+
+    auto walSizes = store->mCRManager->WalSizes();
+    ASSERT_EQ(walSizes.size(), 2u);
+    EXPECT_GT(walSizes[0], 0u);
+    EXPECT_GT(walSizes[1], 0u);
+  }
+
+  // reopen the store, the WAL sizes are restored for each WAL file
+  auto store = openStore(false);
+  ASSERT_NE(store, nullptr);
+  auto walSizes = store->mCRManager->WalSizes();
+  ASSERT_EQ(walSizes.size(), 2u);
+  EXPECT_GT(walSizes[0], 0u);
+  EXPECT_GT(walSizes[1], 0u);
+
+  storage::btree::BasicKV* btree = nullptr;
+  store->GetBasicKV(btreeName, &btree);
+  ASSERT_NE(btree, nullptr);
+  store->ExecSync(0, [&]() {
+    for (uint64_t workerId = 0; workerId < 2; workerId++) {
+      for (int i = 0; i < kNumKeys; i++) {
+        auto key = std::to_string(workerId) + "_" + std::to_string(i);
+        std::string value;
+        auto copyValue = [&](Slice val) { value = val.ToString(); };
+        EXPECT_EQ(btree->Lookup(Slice(key), copyValue), OpCode::kOK);
+        EXPECT_EQ(value, key);
+      }
+    }
+  });
+}
+
+TEST_F(GroupCommitterTest, CompressedWal) {
+  static constexpr int kNumKeys = 100;
+  const std::string btreeName = "compressed_wal_test";
+  const std::string value(1000, 'x');
+  {
+    auto store = openStore(true, true);
+    ASSERT_NE(store, nullptr);
+
+    storage::btree::BasicKV* btree = nullptr;
+    store->ExecSync(0, [&]() {
+      auto res = store->CreateBasicKV(btreeName);
+      ASSERT_TRUE(res);
+      btree = res.value();
+    });
+
+    for (uint64_t workerId = 0; workerId < 2; workerId++) {
+      store->ExecSync(workerId, [&]() {
+        for (int i = 0; i < kNumKeys; i++) {
+          auto key = std::to_string(workerId) + "_" + std::to_string(i);
+          EXPECT_EQ(btree->Insert(Slice(key), Slice(value)), OpCode::kOK);
+        }
+      });
+    }
+
+    // the repeated values are compressed
+    auto walSizes = store->mCRManager->WalSizes();
+    ASSERT_EQ(walSizes.size(), 2u);
+    EXPECT_GT(walSizes[0], 0u);
+    EXPECT_LT(walSizes[0], kNumKeys * value.size());
+    EXPECT_GT(walSizes[1], 0u);
+    EXPECT_LT(walSizes[1], kNumKeys * value.size());
+  }
+
+  // reopen the store, new frames are appended after the existing ones
+  auto store = openStore(false, true);
+  ASSERT_NE(store, nullptr);
+  storage::btree::BasicKV* btree = nullptr;
+  store->GetBasicKV(btreeName, &btree);
+  ASSERT_NE(btree, nullptr);
+  store->ExecSync(0, [&]() {
+    EXPECT_EQ(btree->Insert(Slice("new_key"), Slice(value)), OpCode::kOK);
+    for (uint64_t workerId = 0; workerId < 2; workerId++) {
+      for (int i = 0; i < kNumKeys; i++) {
+        auto key = std::to_string(workerId) + "_" + std::to_string(i);
+        std::string copied;
+        auto copyValue = [&](Slice val) { copied = val.ToString(); };
+        EXPECT_EQ(btree->Lookup(Slice(key), copyValue), OpCode::kOK);
+        EXPECT_EQ(copied, value);
+      }
+    }
+  });
+}
+
+TEST_F(GroupCommitterTest, RecoverCompressedWal) {
+  static constexpr int kNumKeys = 100;
+  const std::string btreeName = "recover_compressed_wal_test";
+  const std::string value(1000, 'x');
+  {
+    // the tree is recorded in the meta file on shutdown
+    auto store = openStore(true, true);
+    ASSERT_NE(store, nullptr);
+    store->ExecSync(0, [&]() { ASSERT_TRUE(store->CreateTransactionKV(btreeName)); });
+  }
+
+  auto store = openStore(false, true);
+  ASSERT_NE(store, nullptr);
+  store->mBufferManager->StopCheckpointer();
+  storage::btree::TransactionKV* btree = nullptr;
+  store->GetTransactionKV(btreeName, &btree);
+  ASSERT_NE(btree, nullptr);
+
+  // worker 0 writes the first WAL file, worker 1 writes the second one
+  for (uint64_t workerId = 0; workerId < 2; workerId++) {
+    store->ExecSync(workerId, [&]() {
+      for (int i = 0; i < kNumKeys; i++) {
+        auto key = std::to_string(workerId) + "_" + std::to_string(i);
+        WorkerContext::My().StartTx();
+        EXPECT_EQ(btree->Insert(Slice(key), Slice(value)), OpCode::kOK);
+        WorkerContext::My().CommitTx();
+      }
+    });
+  }
+
+  // crash while the last frame of the first WAL file is being written
+  auto walSizes = store->mCRManager->WalSizes();
+  auto walFileName = std::filesystem::path(store->GetWalFilePath(0)).filename();
+  crash();
+  store = nullptr;
+  std::filesystem::resize_file(std::filesystem::path(mStoreDir) / walFileName, walSizes[0] - 1);
+
+  // the compressed frames are redone, except the torn one
+  store = openStore(false, true);
+  ASSERT_NE(store, nullptr);
+  store->GetTransactionKV(btreeName, &btree);
+  ASSERT_NE(btree, nullptr);
+  store->ExecSync(0, [&]() {
+    WorkerContext::My().StartTx();
+    for (uint64_t workerId = 0; workerId < 2; workerId++) {
+      // the last transaction of worker 0 may be in the torn frame
+      auto numKeys = workerId == 0 ? kNumKeys - 1 : kNumKeys;
+      for (int i = 0; i < numKeys; i++) {
+        auto key = std::to_string(workerId) + "_" + std::to_string(i);
+        std::string copied;
+        auto copyValue = [&](Slice val) { copied = val.ToString(); };
+        EXPECT_EQ(btree->Lookup(Slice(key), copyValue), OpCode::kOK);
+        EXPECT_EQ(copied, value);
+      }
+    }
+    WorkerContext::My().CommitTx();
+  });
+
+  // new frames are appended after the recovered ones, overwriting the torn one
+  EXPECT_LT(store->mCRManager->WalSizes()[0], walSizes[0]);
+  store->ExecSync(0, [&]() {
+    WorkerContext::My().StartTx();
+    EXPECT_EQ(btree->Insert(Slice("new_key"), Slice(value)), OpCode::kOK);
+    WorkerContext::My().CommitTx();
+  });
+}
+
+} // namespace leanstore::cr::test
@@ -0,0 +1,143 @@
+#include "leanstore/concurrency/Recovery.hpp"
+
+#include "leanstore/btree/TransactionKV.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/concurrency/WorkerContext.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+
+namespace leanstore::cr::test {
+
+class RecoveryTest : public ::testing::Test {
+protected:
+  static constexpr char kBTreeName[] = "recovery_test";
+
+  std::unique_ptr<LeanStore> mStore;
+
+  std::string mStoreDir;
+
+  storage::btree::TransactionKV* mBTree = nullptr;
+
+  //! Creates the tree and reopens the store, so that the tree is in the meta file. The checkpointer
+  //! is stopped, all the later changes are only in the WAL files.
+  void SetUp() override {
+    auto* curTest = ::testing::UnitTest::GetInstance()->current_test_info();
+    auto curTestName = std::string(curTest->test_case_name()) + "_" + std::string(curTest->name());
+    mStoreDir = "/tmp/leanstore/" + curTestName;
+    openStore(mStoreDir, true);
+    mStore->ExecSync(0, [&]() {
+      auto res = mStore->CreateTransactionKV(kBTreeName);
+      ASSERT_TRUE(res);
+    });
+    openStore(mStoreDir, false);
+    mStore->mBufferManager->StopCheckpointer();
+  }
+
+  //! Workers 0 and 1 write to different WAL files.
+  void openStore(const std::string& storeDir, bool createFromScratch) {
+    mStore = nullptr;
+    auto* option = CreateStoreOption(storeDir.c_str());
+    option->mCreateFromScratch = createFromScratch;
+    option->mWorkerThreads = 2;
+    option->mNumWalFiles = 2;
+    option->mEnableEagerGc = false;
+    auto res = LeanStore::Open(option);
+    ASSERT_TRUE(res);
+    mStore = std::move(res.value());
+    mStore->GetTransactionKV(kBTreeName, &mBTree);
+  }
+
+  //! Simulates a crash, the files are copied as they are without the shutdown checkpoint. Returns
+  //! the directory of the copy.
+  std::string crash() {
+    auto crashedDir = mStoreDir + "_crashed";
+    std::filesystem::remove_all(crashedDir);
+    std::filesystem::copy(mStoreDir, crashedDir, std::filesystem::copy_options::recursive);
+    return crashedDir;
+  }
+
+  void insert(uint64_t workerId, const std::string& key) {
+    mStore->ExecSync(workerId, [&]() {
+      WorkerContext::My().StartTx();
+      EXPECT_EQ(mBTree->Insert(Slice(key), Slice(key)), OpCode::kOK);
+      WorkerContext::My().CommitTx();
+    });
+  }
+
+  void remove(uint64_t workerId, const std::string& key) {
+    mStore->ExecSync(workerId, [&]() {
+      WorkerContext::My().StartTx();
+      EXPECT_EQ(mBTree->Remove(Slice(key)), OpCode::kOK);
+      WorkerContext::My().CommitTx();
+    });
+  }
+
+  OpCode lookup(const std::string& key) {
+    OpCode result;
+    mStore->ExecSync(0, [&]() {
+      WorkerContext::My().StartTx();
+      result = mBTree->Lookup(Slice(key), [&](Slice val) { EXPECT_EQ(val.ToString(), key); });
+      WorkerContext::My().CommitTx();
+    });
+    return result;
+  }
+};
+
+TEST_F(RecoveryTest, RecoverStripedWal) {
+  // both workers write the same pages, splits included
+  static constexpr int kNumKeys = 2000;
+  ASSERT_NE(mBTree, nullptr);
+  for (int i = 0; i < kNumKeys; i++) {
+    insert(i % 2, std::to_string(i));
+  }
+  for (int i = 0; i < kNumKeys; i += 10) {
+    remove((i + 1) % 2, std::to_string(i));
+  }
+
+  openStore(crash(), false);
+  ASSERT_NE(mBTree, nullptr);
+  for (int i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(lookup(std::to_string(i)), i % 10 == 0 ? OpCode::kNotFound : OpCode::kOK);
+  }
+
+  // the recovered store keeps appending to the WAL files
+  insert(0, "new_key_0");
+  insert(1, "new_key_1");
+  EXPECT_EQ(lookup("new_key_0"), OpCode::kOK);
+  EXPECT_EQ(lookup("new_key_1"), OpCode::kOK);
+}
+
+TEST_F(RecoveryTest, StopReplayingPageAtLostWalEntry) {
+  static constexpr int kNumKeys = 10;
+  ASSERT_NE(mBTree, nullptr);
+  for (int i = 0; i < kNumKeys; i++) {
+    insert(i % 2, std::to_string(i));
+  }
+
+  // the tail of the second WAL file is lost in the crash, while the later change on the same page
+  // in the first WAL file is durable
+  auto walSizes = mStore->mCRManager->WalSizes();
+  auto walFileName = std::filesystem::path(mStore->GetWalFilePath(1)).filename();
+  insert(1, "lost_key");
+  insert(0, "key_after_lost");
+  auto crashedDir = crash();
+  std::filesystem::resize_file(std::filesystem::path(crashedDir) / walFileName, walSizes[1]);
+
+  // the page is replayed up to the lost change
+  openStore(crashedDir, false);
+  ASSERT_NE(mBTree, nullptr);
+  for (int i = 0; i < kNumKeys; i++) {
+    EXPECT_EQ(lookup(std::to_string(i)), OpCode::kOK);
+  }
+  EXPECT_EQ(lookup("lost_key"), OpCode::kNotFound);
+  EXPECT_EQ(lookup("key_after_lost"), OpCode::kNotFound);
+}
+
+} // namespace leanstore::cr::test
@@ -0,0 +1,157 @@
+#include "leanstore/concurrency/WorkerThread.hpp"
+
+#include "leanstore/sync/HybridLatch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace leanstore::cr::test {
+
+class WorkerThreadTest : public ::testing::Test {
+protected:
+  std::unique_ptr<WorkerThread> mWorkerThread;
+
+  void SetUp() override {
+    mWorkerThread = std::make_unique<WorkerThread>(nullptr, 0, -1);
+    mWorkerThread->Start();
+  }
+
+  void TearDown() override {
+    mWorkerThread->Stop();
+    mWorkerThread = nullptr;
+  }
+};
+
+TEST_F(WorkerThreadTest, QueuedJobsWithoutSlots) {
+  std::vector<int> order;
+  for (int i = 0; i < 10; i++) {
+    mWorkerThread->AddJob([&, i]() {
+      EXPECT_FALSE(WorkerThread::CanPark());
+      EXPECT_FALSE(WorkerThread::Park([]() { return true; }));
+      order.push_back(i);
+    });
+  }
+  mWorkerThread->WaitJobs();
+
+  ASSERT_EQ(order.size(), 10u);
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(order[i], i);
+  }
+}
+
+TEST_F(WorkerThreadTest, ParkedJobsAreInterleaved) {
+  static constexpr int kNumSlots = 3;
+  static constexpr int kNumJobs = 6;
+
+  // slots without worker contexts, the jobs don't run transactions
+  mWorkerThread->SetJob([&]() {
+    for (int i = 0; i < kNumSlots; i++) {
+      mWorkerThread->AddJobSlot(nullptr);
+    }
+  });
+  mWorkerThread->Wait();
+
+  std::mutex mutex;
+  std::vector<int> started;
+  std::vector<int> finished;
+  std::atomic<bool> ready[kNumJobs];
+  for (auto& r : ready) {
+    r = false;
+  }
+
+  for (int i = 0; i < kNumJobs; i++) {
+    mWorkerThread->AddJob([&, i]() {
+      EXPECT_TRUE(WorkerThread::CanPark());
+      {
+        std::unique_lock guard(mutex);
+        started.push_back(i);
+      }
+      EXPECT_TRUE(WorkerThread::Park([&, i]() { return ready[i].load(); }));
+      std::unique_lock guard(mutex);
+      finished.push_back(i);
+    });
+  }
+
+  // all the slots are taken by parked jobs
+  while (true) {
+    std::unique_lock guard(mutex);
+    if (started.size() == kNumSlots) {
+      break;
+    }
+  }
+
+  // resume the jobs in the reverse order, each finished job frees a slot for the next one
+  for (int i = kNumSlots - 1; i >= 0; i--) {
+    ready[i] = true;
+    while (true) {
+      std::unique_lock guard(mutex);
+      if (finished.size() == size_t(kNumSlots - i)) {
+        break;
+      }
+    }
+  }
+  for (int i = kNumSlots; i < kNumJobs; i++) {
+    ready[i] = true;
+  }
+  mWorkerThread->WaitJobs();
+
+  ASSERT_EQ(started.size(), size_t(kNumJobs));
+  ASSERT_EQ(finished.size(), size_t(kNumJobs));
+  for (int i = 0; i < kNumSlots; i++) {
+    EXPECT_EQ(finished[i], kNumSlots - 1 - i);
+  }
+
+  // jobs set by SetJob() still run on the thread stack
+  mWorkerThread->SetJob([&]() { EXPECT_FALSE(WorkerThread::CanPark()); });
+  mWorkerThread->Wait();
+}
+
+TEST_F(WorkerThreadTest, JobsHoldingLatchesAreNotParked) {
+  mWorkerThread->SetJob([&]() {
+    mWorkerThread->AddJobSlot(nullptr);
+    mWorkerThread->AddJobSlot(nullptr);
+  });
+  mWorkerThread->Wait();
+
+  std::atomic<bool> parked = false;
+  std::atomic<bool> ready = false;
+  std::atomic<uint64_t> numPolls = 0;
+  mWorkerThread->AddJob([&]() {
+    parked = true;
+    EXPECT_TRUE(WorkerThread::Park([&]() {
+      numPolls++;
+      return ready.load();
+    }));
+  });
+  mWorkerThread->AddJob([&]() {
+    while (!parked) {
+    }
+    storage::HybridLatch latch;
+    latch.LockExclusively();
+    EXPECT_EQ(storage::HybridLatch::NumLockedByThisThread(), 1u);
+    EXPECT_FALSE(WorkerThread::CanPark());
+    EXPECT_FALSE(WorkerThread::Park([]() { return true; }));
+
+    // the parked job is polled while waiting
+    auto numPollsBefore = numPolls.load();
+    EXPECT_TRUE(WorkerThread::WaitParked([&]() { return numPolls > numPollsBefore + 2; }));
+    latch.UnlockExclusively();
+
+    EXPECT_EQ(storage::HybridLatch::NumLockedByThisThread(), 0u);
+    EXPECT_TRUE(WorkerThread::CanPark());
+    ready = true;
+  });
+  mWorkerThread->WaitJobs();
+  EXPECT_TRUE(ready);
+
+  // not in a job slot
+  mWorkerThread->SetJob([&]() { EXPECT_FALSE(WorkerThread::WaitParked([]() { return true; })); });
+  mWorkerThread->Wait();
+}
+
+} // namespace leanstore::cr::test
@@ -0,0 +1,63 @@
+#include "leanstore/sync/HybridLatch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace leanstore::storage::test {
+
+TEST(HybridLatchTest, SharedHoldersKeepVersion) {
+  HybridLatch latch;
+  EXPECT_EQ(sizeof(latch), 8u);
+  auto version = latch.GetOptimisticVersion();
+
+  // shared holders don't invalidate optimistic readers, but block writers
+  latch.LockShared();
+  EXPECT_TRUE(latch.LockSharedIfUnchanged(version));
+  EXPECT_EQ(latch.GetOptimisticVersion(), version);
+  EXPECT_FALSE(latch.TryLockExclusively());
+  EXPECT_FALSE(latch.TryLockExclusivelyIfUnchanged(version));
+  latch.UnlockShared();
+  latch.UnlockShared();
+
+  // every exclusive holder changes the version
+  EXPECT_TRUE(latch.TryLockExclusivelyIfUnchanged(version));
+  EXPECT_TRUE(latch.IsLockedExclusively());
+  EXPECT_FALSE(latch.LockSharedIfUnchanged(version));
+  latch.UnlockExclusively();
+  EXPECT_EQ(latch.GetOptimisticVersion(), version + 2);
+  EXPECT_FALSE(latch.LockExclusivelyIfUnchanged(version));
+}
+
+TEST(HybridLatchTest, ContendedLockers) {
+  static constexpr uint64_t kNumThreads = 8;
+  static constexpr uint64_t kNumLocks = 20000;
+  HybridLatch latch;
+  uint64_t counter = 0;
+
+  std::vector<std::thread> threads;
+  for (uint64_t t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      for (uint64_t i = 0; i < kNumLocks; i++) {
+        if (t % 2 == 0) {
+          latch.LockExclusively();
+          counter++;
+          latch.UnlockExclusively();
+        } else {
+          latch.LockShared();
+          EXPECT_LE(counter, kNumThreads / 2 * kNumLocks);
+          latch.UnlockShared();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(counter, kNumThreads / 2 * kNumLocks);
+  EXPECT_EQ(latch.GetOptimisticVersion(), 2 * counter);
+}
+
+} // namespace leanstore::storage::test
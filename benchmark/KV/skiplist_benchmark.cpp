@@ -0,0 +1,123 @@
+// Copyright (c) 2018 The atendb Authors. All rights reserved.
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "KV/Include/Comparator.h"
+#include "KV/Include/Index.h"
+#include "KV/Include/Skiplist.h"
+#include "KV/Util/Random.h"
+
+namespace atendb {
+
+typedef SkipList<Index, Compare> Table;
+
+static const int32_t kPreloadKeys = 1 << 18;
+
+static BytewiseComparator comparator;
+
+// The two index layouts DBImpl can run with: one spin-locked skiplist per
+// processor selected by key hash, or a single lock-free skiplist.
+class TableLayout {
+ public:
+  explicit TableLayout(bool concurrent) :
+    concurrent_(concurrent),
+    size_(concurrent ? 1 : std::thread::hardware_concurrency()) {
+    for (uint32_t i = 0; i < size_; i++) {
+      tables_.push_back(new Table(Compare(&comparator)));
+    }
+  }
+
+  ~TableLayout() {
+    for (auto table : tables_) {
+      delete table;
+    }
+  }
+
+  void Insert(const Index& index) {
+    Table* table = tables_[Slot(index.Key())];
+    if (concurrent_) {
+      table->InsertConcurrently(index);
+    } else {
+      table->Insert(index);
+    }
+  }
+
+  bool Get(const Index& search_index, Index* result) const {
+    return tables_[Slot(search_index.Key())]->Get(search_index, result);
+  }
+
+ private:
+  uint32_t Slot(const std::string& key) const {
+    return std::hash<std::string>()(key) % size_;
+  }
+
+  const bool concurrent_;
+  const uint32_t size_;
+  std::vector<Table*> tables_;
+};
+
+static TableLayout* layout = nullptr;
+static std::atomic<uint64_t> sequence(0);
+
+static std::string MakeKey(uint64_t n) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "key%016llu", static_cast<unsigned long long>(n));
+  return std::string(buf);
+}
+
+static void BM_Insert(benchmark::State& state, bool concurrent) {
+  if (state.thread_index() == 0) {
+    layout = new TableLayout(concurrent);
+  }
+  for (auto _ : state) {
+    std::string key = MakeKey(sequence.fetch_add(1) * 2654435761u);
+    layout->Insert(Index(key, 0, 0, key.size(), 0));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete layout;
+    layout = nullptr;
+  }
+}
+
+static void BM_Lookup(benchmark::State& state, bool concurrent) {
+  if (state.thread_index() == 0) {
+    layout = new TableLayout(concurrent);
+    for (int32_t i = 0; i < kPreloadKeys; i++) {
+      std::string key = MakeKey(i);
+      layout->Insert(Index(key, 0, 0, key.size(), 0));
+    }
+  }
+  Random rnd(301 + state.thread_index());
+  Index result;
+  for (auto _ : state) {
+    Index search_index(MakeKey(rnd.Uniform(kPreloadKeys)));
+    if (!layout->Get(search_index, &result)) {
+      state.SkipWithError("preloaded key not found");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete layout;
+    layout = nullptr;
+  }
+}
+
+BENCHMARK_CAPTURE(BM_Insert, ShardedSpinLock, false)
+    ->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Insert, LockFree, true)
+    ->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Lookup, ShardedSpinLock, false)
+    ->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_CAPTURE(BM_Lookup, LockFree, true)
+    ->ThreadRange(1, 64)->UseRealTime();
+
+}  // namespace atendb
+
+BENCHMARK_MAIN();
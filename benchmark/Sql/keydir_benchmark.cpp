@@ -0,0 +1,92 @@
+#include <string>
+
+#include "benchmark/benchmark.h"
+
+#include "Sql/KeyDir.h"
+
+static const int32_t kPreloadKeys = 1 << 20;
+
+static std::string MakeKey(uint64_t n) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "key%016llu", static_cast<unsigned long long>(n));
+  return std::string(buf);
+}
+
+static KeyDirEntry MakeEntry(uint64_t n) {
+  KeyDirEntry entry;
+  entry.file_id = 3;
+  entry.value_pos = n;
+  entry.value_length = 64;
+  entry.timestamp = n;
+  return entry;
+}
+
+// Bytes/key reported by KeyDir::memoryUsage() with "keys" keys of MakeKey().
+// The slot array doubles, so the figure depends on where the key count
+// falls between two resizes.
+static void BM_Memory(benchmark::State& state) {
+  const int64_t keys = state.range(0);
+  KeyDirMemory usage;
+  for (auto _ : state) {
+    KeyDir keydir;
+    for (int64_t i = 0; i < keys; i++) {
+      keydir.set(MakeKey(i * 2654435761u), MakeEntry(i));
+    }
+    usage = keydir.memoryUsage();
+  }
+  state.counters["bytes_per_key"] =
+      static_cast<double>(usage.total_bytes) / usage.keys;
+  state.counters["key_bytes"] = MakeKey(0).size();
+}
+
+static void BM_Set(benchmark::State& state) {
+  KeyDir keydir;
+  uint64_t n = 0;
+  for (auto _ : state) {
+    keydir.set(MakeKey(n * 2654435761u), MakeEntry(n));
+    n++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Find(benchmark::State& state) {
+  KeyDir keydir;
+  for (int32_t i = 0; i < kPreloadKeys; i++) {
+    keydir.set(MakeKey(i), MakeEntry(i));
+  }
+  uint64_t n = 0;
+  for (auto _ : state) {
+    KeyDirEntry* entry = keydir.find(MakeKey(n++ * 2654435761u % kPreloadKeys));
+    if (entry == nullptr) {
+      state.SkipWithError("preloaded key not found");
+      break;
+    }
+    benchmark::DoNotOptimize(entry);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Erase(benchmark::State& state) {
+  KeyDir keydir;
+  uint64_t n = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (keydir.size() == 0) {
+      for (int32_t i = 0; i < kPreloadKeys; i++) {
+        keydir.set(MakeKey(i), MakeEntry(i));
+      }
+      n = 0;
+    }
+    state.ResumeTiming();
+    keydir.erase(MakeKey(n++ * 2654435761u % kPreloadKeys));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Memory)->Arg(1 << 16)->Arg(1 << 20)->Arg(3 << 19)
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Set);
+BENCHMARK(BM_Find);
+BENCHMARK(BM_Erase);
+
+BENCHMARK_MAIN();
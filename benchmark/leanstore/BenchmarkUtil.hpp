@@ -0,0 +1,44 @@
+#pragma once
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+namespace leanstore::storage {
+
+//! Fixed width keys, in ascending order with i.
+inline std::string MakeKey(uint64_t i) {
+  char key[32];
+  std::snprintf(key, sizeof(key), "key_%012lu", i);
+  return key;
+}
+
+//! Opens the store with the option, aborts the benchmark if it fails.
+inline std::unique_ptr<LeanStore> OpenStore(StoreOption* option) {
+  auto res = LeanStore::Open(option);
+  if (!res) {
+    std::abort();
+  }
+  return std::move(res.value());
+}
+
+//! Creates a BasicKV and inserts the keys [0, numKeys) on worker 0, each key is its own value.
+inline btree::BasicKV* CreateAndLoadBasicKV(LeanStore& store, const std::string& name,
+                                            uint64_t numKeys) {
+  btree::BasicKV* btree = nullptr;
+  store.ExecSync(0, [&]() {
+    btree = store.CreateBasicKV(name).value();
+    for (uint64_t i = 0; i < numKeys; i++) {
+      auto key = MakeKey(i);
+      btree->Insert(Slice(key), Slice(key));
+    }
+  });
+  return btree;
+}
+
+} // namespace leanstore::storage
@@ -0,0 +1,86 @@
+#include "leanstore/btree/core/BTreeNode.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/Misc.hpp"
+#include "leanstore/utils/RandomGenerator.hpp"
+#include "leanstore/utils/UserThread.hpp"
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace leanstore::storage::btree {
+
+// The store is only opened for its options, BTreeNode reads them from the thread-local store.
+static StoreOption* sOption = nullptr;
+static std::unique_ptr<LeanStore> sStore;
+
+static void openStore() {
+  if (sStore != nullptr) {
+    return;
+  }
+  sOption = CreateStoreOption("/tmp/leanstore/btree_node_benchmark");
+  sOption->mCreateFromScratch = true;
+  sOption->mWorkerThreads = 1;
+  auto res = LeanStore::Open(sOption);
+  if (!res) {
+    std::abort();
+  }
+  sStore = std::move(res.value());
+}
+
+// Args: hint mode (0: disabled, 1: serial, 2: SIMD), head optimization, key size, fill percentage
+// of the node.
+static void BM_LowerBound(benchmark::State& state) {
+  openStore();
+  utils::tlsStore = sStore.get();
+  sOption->mBTreeHints = state.range(0);
+  sOption->mEnableHeadOptimization = state.range(1) != 0;
+  const uint64_t keySize = state.range(2);
+  const double fillFactor = state.range(3) / 100.0;
+
+  // random keys sorted and inserted until the node is filled
+  std::vector<std::string> keys;
+  for (uint64_t i = 0; i < BTreeNode::Size(); i++) {
+    std::string key(keySize, 0);
+    for (auto& c : key) {
+      c = utils::RandomGenerator::Rand<int>(0, 256);
+    }
+    keys.push_back(std::move(key));
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  utils::AlignedBuffer<512> buffer(BTreeNode::Size());
+  auto* node = BTreeNode::New(buffer.Get(), true, Slice(), Slice());
+  std::vector<std::string> inserted;
+  for (auto& key : keys) {
+    if (!node->CanInsert(key.size(), 8) || node->FillFactorAfterCompaction() >= fillFactor) {
+      break;
+    }
+    node->Insert(Slice(key), Slice(key.data(), std::min<uint64_t>(8, key.size())));
+    inserted.push_back(key);
+  }
+
+  // probe the inserted keys in random order
+  std::shuffle(inserted.begin(), inserted.end(), std::mt19937(42));
+  uint64_t i = 0;
+  for (auto _ : state) {
+    auto& key = inserted[i++ % inserted.size()];
+    benchmark::DoNotOptimize(node->LowerBound<false>(Slice(key)));
+  }
+  state.counters["slots"] = node->mNumSlots;
+}
+
+BENCHMARK(BM_LowerBound)
+    ->ArgNames({"hints", "head", "keySize", "fillPct"})
+    ->ArgsProduct({{0, 1, 2}, {0, 1}, {4, 8, 16, 32}, {25, 50, 100}});
+
+} // namespace leanstore::storage::btree
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+#include "BenchmarkUtil.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/buffer-manager/BufferManager.hpp"
+#include "leanstore/buffer-manager/PageEvictor.hpp"
+#include "leanstore/concurrency/CRManager.hpp"
+#include "leanstore/leanstore-c/PerfCounters.h"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/RandomGenerator.hpp"
+#include "leanstore/utils/ScrambledZipfGenerator.hpp"
+
+#include "benchmark/benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace leanstore::storage {
+
+static constexpr uint64_t kNumKeys = 1000000;
+static constexpr uint64_t kScanLength = 1000;
+
+static uint64_t load(const CounterType& counter) {
+  return atomic_load_explicit(&counter, std::memory_order_relaxed);
+}
+
+// Args: eviction policy, workload (0: Zipfian point lookups, 1: Zipfian point lookups with one
+// scan of kScanLength keys every 100 operations). The buffer pool holds about a tenth of the
+// loaded pages.
+static void BM_Eviction(benchmark::State& state) {
+  auto* option = CreateStoreOption("/tmp/leanstore/eviction_benchmark");
+  option->mCreateFromScratch = true;
+  option->mWorkerThreads = 1;
+  option->mNumPartitions = 1;
+  option->mBufferPoolSize = 8 * 1024 * 1024;
+  option->mEnableWal = false;
+  option->mEvictionPolicy = static_cast<EvictionPolicy>(state.range(0));
+  const bool scanHeavy = state.range(1) != 0;
+  auto store = OpenStore(option);
+  auto* btree = CreateAndLoadBasicKV(*store, "eviction_benchmark", kNumKeys);
+
+  PerfCounters countersBefore{};
+  store->mCRManager->AggregatePerfCounters(countersBefore);
+  auto& pageEvictor = *store->mBufferManager->mPageEvictors[0];
+  auto evictorCpuBefore = pageEvictor.CpuTimeNs();
+  auto evictedBefore = load(pageEvictor.GetPerfCounters()->mBufferEvicted);
+
+  utils::ScrambledZipfGenerator zipf(0, kNumKeys, 0.99);
+  uint64_t numOps = 0;
+  for (auto _ : state) {
+    store->ExecSync(0, [&]() {
+      for (uint64_t i = 0; i < 100; i++) {
+        auto key = MakeKey(zipf.rand());
+        btree->Lookup(Slice(key), [](Slice val) { benchmark::DoNotOptimize(val.data()); });
+      }
+      if (scanHeavy) {
+        uint64_t scanned = 0;
+        auto startKey = MakeKey(utils::RandomGenerator::Rand<uint64_t>(0, kNumKeys));
+        btree->ScanAsc(Slice(startKey), [&](Slice, Slice) { return ++scanned < kScanLength; });
+      }
+    });
+    numOps += 100 + scanHeavy;
+  }
+
+  // the hit and miss counters are only recorded if built with ENABLE_PERF_COUNTERS
+  PerfCounters countersAfter{};
+  store->mCRManager->AggregatePerfCounters(countersAfter);
+  auto hits = load(countersAfter.mBufferHotHits) + load(countersAfter.mBufferCoolHits) -
+              load(countersBefore.mBufferHotHits) - load(countersBefore.mBufferCoolHits);
+  auto misses = load(countersAfter.mBufferMisses) - load(countersBefore.mBufferMisses);
+  state.counters["hitRatio"] = hits * 1.0 / std::max<uint64_t>(hits + misses, 1);
+  state.counters["evicted"] = load(pageEvictor.GetPerfCounters()->mBufferEvicted) - evictedBefore;
+  state.counters["evictorCpuNsPerOp"] =
+      (pageEvictor.CpuTimeNs() - evictorCpuBefore) * 1.0 / std::max<uint64_t>(numOps, 1);
+  state.SetItemsProcessed(numOps);
+}
+
+BENCHMARK(BM_Eviction)
+    ->ArgNames({"policy", "scanHeavy"})
+    ->ArgsProduct({{EvictionPolicy::kEvictionRandom, EvictionPolicy::kEvictionClock}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace leanstore::storage
+
+BENCHMARK_MAIN();
@@ -0,0 +1,90 @@
+#include "BenchmarkUtil.hpp"
+
+#include "leanstore/btree/BasicKV.hpp"
+#include "leanstore/leanstore-c/StoreOption.h"
+#include "leanstore/LeanStore.hpp"
+#include "leanstore/utils/RandomGenerator.hpp"
+
+#include "benchmark/benchmark.h"
+
+#include <memory>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace leanstore::storage {
+
+static constexpr uint64_t kNumKeys = 4000000;
+
+// Opens a counter of the data TLB read misses of the calling thread, -1 if not permitted, e.g.
+// without a hardware PMU in VMs and containers, or with a restrictive perf_event_paranoid.
+static int openDtlbMissCounter() {
+  perf_event_attr attr{};
+  attr.type = PERF_TYPE_HW_CACHE;
+  attr.size = sizeof(attr);
+  attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Args: StoreOption::mHugePageSize, 4096 for regular pages without transparent huge pages. The
+// buffer pool holds all the pages, the lookups are uniformly random so that most of them touch
+// pages far apart. dtlbMissesPerLookup is only reported if the data TLB miss counter can be
+// opened, otherwise only the throughput is.
+static void BM_HugePageLookup(benchmark::State& state) {
+  auto* option = CreateStoreOption("/tmp/leanstore/huge_page_benchmark");
+  option->mCreateFromScratch = true;
+  option->mWorkerThreads = 1;
+  option->mBufferPoolSize = 2ull * 1024 * 1024 * 1024;
+  option->mEnableWal = false;
+  option->mHugePageSize = state.range(0);
+  auto store = OpenStore(option);
+  auto* btree = CreateAndLoadBasicKV(*store, "huge_page_benchmark", kNumKeys);
+
+  int dtlbMissCounter = -1;
+  store->ExecSync(0, [&]() {
+    dtlbMissCounter = openDtlbMissCounter();
+    if (dtlbMissCounter >= 0) {
+      ioctl(dtlbMissCounter, PERF_EVENT_IOC_RESET, 0);
+      ioctl(dtlbMissCounter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  });
+
+  uint64_t numLookups = 0;
+  for (auto _ : state) {
+    store->ExecSync(0, [&]() {
+      for (uint64_t i = 0; i < 1000; i++) {
+        auto key = MakeKey(utils::RandomGenerator::Rand<uint64_t>(0, kNumKeys));
+        btree->Lookup(Slice(key), [](Slice val) { benchmark::DoNotOptimize(val.data()); });
+      }
+    });
+    numLookups += 1000;
+  }
+
+  // the counter belongs to the worker thread, but can be read from any thread
+  if (dtlbMissCounter >= 0) {
+    uint64_t dtlbMisses = 0;
+    if (read(dtlbMissCounter, &dtlbMisses, sizeof(dtlbMisses)) == sizeof(dtlbMisses)) {
+      state.counters["dtlbMissesPerLookup"] = dtlbMisses * 1.0 / numLookups;
+    }
+    close(dtlbMissCounter);
+  }
+  state.SetItemsProcessed(numLookups);
+}
+
+BENCHMARK(BM_HugePageLookup)
+    ->ArgName("hugePageSize")
+    ->Arg(4096)
+    ->Arg(0)
+    ->Arg(2 * 1024 * 1024)
+    ->Arg(1024 * 1024 * 1024)
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace leanstore::storage
+
+BENCHMARK_MAIN();